@@ -137,6 +137,7 @@ inline constexpr TargetBufferFlags getTargetBufferFlagsAt(size_t index) noexcept
 enum class BufferUsage : uint8_t {
     STATIC,      //!< content modified once, used many times
     DYNAMIC,     //!< content modified frequently, used many times
+    STREAM,      //!< content fully replaced at least once per frame, used a few times
 };
 
 /**
@@ -1029,6 +1030,26 @@ using FrameScheduledCallback = void(*)(PresentCallable callable, void* user);
 
 using FrameCompletedCallback = void(*)(void* user);
 
+/**
+ * Number of state changes requested to the backend during a frame, split between the calls that
+ * were issued to the underlying API and the ones that were elided by the backend's state cache.
+ */
+struct StateCacheStats {
+    struct Counter {
+        uint32_t issued = 0;
+        uint32_t elided = 0;
+    };
+    Counter programs;       //!< program changes
+    Counter textures;       //!< texture binds
+    Counter samplers;       //!< sampler object binds
+    Counter samplerGroups;  //!< texture units set-up of a program from the bound sampler groups
+    Counter vertexArrays;   //!< vertex array binds
+    Counter buffers;        //!< buffer binds
+    Counter bufferRanges;   //!< indexed buffer (e.g. uniform buffer) range binds
+    Counter framebuffers;   //!< framebuffer binds
+    Counter states;         //!< all other render states (capabilities, blending, depth, etc...)
+};
+
 enum class Workaround : uint16_t {
     // The EASU pass must split because shader compiler flattens early-exit branch
     SPLIT_EASU,
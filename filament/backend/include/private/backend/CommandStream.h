@@ -18,6 +18,7 @@
 #define TNT_FILAMENT_BACKEND_PRIVATE_COMMANDSTREAM_H
 
 #include "private/backend/CircularBuffer.h"
+#include "private/backend/CommandStreamRecorder.h"
 #include "private/backend/Dispatcher.h"
 #include "private/backend/Driver.h"
 
@@ -206,6 +207,7 @@ class CommandStream {
 
 public:
     CommandStream(Driver& driver, CircularBuffer& buffer) noexcept;
+    ~CommandStream() noexcept;
 
     CommandStream(CommandStream const& rhs) noexcept = delete;
     CommandStream& operator=(CommandStream const& rhs) noexcept = delete;
@@ -214,6 +216,9 @@ public:
 #define DECL_DRIVER_API(methodName, paramsDecl, params)                                         \
     inline void methodName(paramsDecl) {                                                        \
         DEBUG_COMMAND_BEGIN(methodName, false, params);                                         \
+        if (UTILS_UNLIKELY(mRecorder)) {                                                        \
+            mRecorder->record(CommandId::methodName, params);                                   \
+        }                                                                                       \
         using Cmd = COMMAND_TYPE(methodName);                                                   \
         void* const p = allocateCommand(CommandBase::align(sizeof(Cmd)));                       \
         new(p) Cmd(mDispatcher.methodName##_, APPLY(std::move, params));                        \
@@ -233,6 +238,9 @@ public:
     inline RetType methodName(paramsDecl) {                                                     \
         DEBUG_COMMAND_BEGIN(methodName, false, params);                                         \
         RetType result = mDriver.methodName##S();                                               \
+        if (UTILS_UNLIKELY(mRecorder)) {                                                        \
+            mRecorder->record(CommandId::methodName, result, params);                           \
+        }                                                                                       \
         using Cmd = COMMAND_TYPE(methodName##R);                                                \
         void* const p = allocateCommand(CommandBase::align(sizeof(Cmd)));                       \
         new(p) Cmd(mDispatcher.methodName##_, RetType(result), APPLY(std::move, params));       \
@@ -293,6 +301,9 @@ private:
 #endif
 
     bool mUsePerformanceCounter = false;
+
+    // non-null when the commands are captured to a file (see CommandStreamRecorder)
+    CommandStreamRecorder* mRecorder = nullptr;
 };
 
 void* CommandStream::allocate(size_t size, size_t alignment) noexcept {
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TNT_FILAMENT_BACKEND_PRIVATE_COMMANDSTREAMRECORDER_H
+#define TNT_FILAMENT_BACKEND_PRIVATE_COMMANDSTREAMRECORDER_H
+
+#include <backend/BufferDescriptor.h>
+#include <backend/PixelBufferDescriptor.h>
+#include <backend/Program.h>
+
+#include <utils/compiler.h>
+
+#include <type_traits>
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+namespace filament::backend {
+
+/*
+ * Identifies the asynchronous commands of the DriverApi in a capture. Synchronous calls are not
+ * captured, they either query the driver or deal with objects that can't be replayed (streams).
+ */
+enum class CommandId : uint16_t {
+#define DECL_DRIVER_API(methodName, paramsDecl, params) methodName,
+#define DECL_DRIVER_API_SYNCHRONOUS(RetType, methodName, paramsDecl, params)
+#define DECL_DRIVER_API_RETURN(RetType, methodName, paramsDecl, params) methodName,
+#include "private/backend/DriverAPI.inc"
+    COUNT
+};
+
+/*
+ * The capture file format is:
+ *
+ *   header:    CaptureHeader
+ *   commands:  { CommandId id; uint32_t size; uint8_t payload[size]; }...
+ *
+ * The payload of a command is its parameters, in order. Trivially copyable parameters are
+ * stored as is, including handles, which are remapped at replay time. Strings, buffer
+ * descriptors and programs are stored by content. Pointers are stored but never used on replay.
+ * For commands that create a handle, the handle comes first.
+ */
+struct CaptureHeader {
+    static constexpr char MAGIC[8] = { 'F', 'C', 'M', 'D', 'C', 'A', 'P', 0 };
+    static constexpr uint32_t VERSION = 1;
+    char magic[8];
+    uint32_t version;
+    // number of commands in the DriverApi, a capture can only be replayed by a build with the
+    // same DriverApi.
+    uint32_t commandCount;
+};
+
+/*
+ * CommandStreamRecorder writes the commands issued to a CommandStream to a capture file.
+ *
+ * Commands are recorded when they're issued (i.e. on the thread using the CommandStream), which
+ * is the only time when the content of buffer descriptors is guaranteed to be valid.
+ */
+class CommandStreamRecorder {
+public:
+    // Returns nullptr if the file can't be created
+    static CommandStreamRecorder* create(const char* path) noexcept;
+
+    ~CommandStreamRecorder() noexcept;
+
+    CommandStreamRecorder(CommandStreamRecorder const&) = delete;
+    CommandStreamRecorder& operator=(CommandStreamRecorder const&) = delete;
+
+    template<typename ... ARGS>
+    void record(CommandId id, ARGS const& ... args) noexcept {
+        begin(id);
+        (write(args), ...);
+        end(id);
+    }
+
+private:
+    explicit CommandStreamRecorder(FILE* file) noexcept;
+
+    void begin(CommandId id) noexcept;
+    void end(CommandId id) noexcept;
+
+    template<typename T>
+    void write(T const& value) noexcept {
+        static_assert(std::is_trivially_copyable_v<T>,
+                "this parameter type needs its own CommandStreamRecorder::write()");
+        writeBytes(&value, sizeof(T));
+    }
+
+    void write(const char* string) noexcept;
+    void write(BufferDescriptor const& data) noexcept;
+    void write(PixelBufferDescriptor const& data) noexcept;
+    void write(Program const& program) noexcept;
+
+    void writeBytes(void const* data, size_t size) noexcept;
+    void writeString(const char* string, size_t length) noexcept;
+
+    FILE* mFile;
+    CommandId mCurrentId = CommandId::COUNT;
+    std::vector<uint8_t> mCommand;
+};
+
+} // namespace filament::backend
+
+#endif // TNT_FILAMENT_BACKEND_PRIVATE_COMMANDSTREAMRECORDER_H
@@ -23,6 +23,9 @@
 #include <utils/Log.h>
 #include <utils/compiler.h>
 #include <tsl/robin_map.h>
+
+#include <algorithm>
+#include <iterator>
 #include <unordered_map>
 
 #if !defined(NDEBUG) && UTILS_HAS_RTTI
@@ -94,6 +97,27 @@ public:
         return h;
     }
 
+    /*
+     * Allocates (without constructing) count D objects at once, which is cheaper than calling
+     * allocate() count times.
+     *
+     * e.g.:
+     *  Handle<ConcreteTexture> handles[16];
+     *  allocate(handles, 16);
+     *
+     */
+    template<typename D>
+    void allocate(Handle<D>* handles, size_t count) noexcept {
+        static_assert(sizeof(Handle<D>) == sizeof(HandleBase::HandleId));
+        allocateHandles<sizeof(D)>(reinterpret_cast<HandleBase::HandleId*>(handles), count);
+#if HANDLE_TYPE_SAFETY
+        mLock.lock();
+        for (size_t i = 0; i < count; i++) {
+            mHandleTypeId[handle_cast<D*>(handles[i])] = typeid(D).name();
+        }
+        mLock.unlock();
+#endif
+    }
 
     /*
      * Destroys the object D at Handle<B> and construct a new D in its place
@@ -210,12 +234,16 @@ public:
 
 private:
 
-    // template <int P0, int P1, int P2>
+    // The pools are thread-safe, each thread allocates from its own cache of handles most of the
+    // time, which is refilled from the shared pools in batches.
+    template<size_t SIZE>
+    using Pool = utils::PoolAllocator<SIZE, 16, 0, utils::ThreadCachedFreeList>;
+
     class Allocator {
         friend class HandleAllocator;
-        utils::PoolAllocator<P0, 16>   mPool0;
-        utils::PoolAllocator<P1, 16>   mPool1;
-        utils::PoolAllocator<P2, 16>   mPool2;
+        Pool<P0> mPool0;
+        Pool<P1> mPool1;
+        Pool<P2> mPool2;
         UTILS_UNUSED_IN_RELEASE const utils::AreaPolicy::HeapArea& mArea;
     public:
         static constexpr size_t MIN_ALIGNMENT_SHIFT = 4;
@@ -237,16 +265,25 @@ private:
             if (size <= mPool1.getSize()) { mPool1.free(p); return; }
             if (size <= mPool2.getSize()) { mPool2.free(p); return; }
         }
-    };
 
+        // allocates up to count handles at once, returns how many were allocated
+        [[nodiscard]] inline size_t alloc(void** p, size_t count,
+                size_t size, size_t alignment, size_t extra) noexcept {
+            if (size <= mPool0.getSize()) return mPool0.alloc(p, count, size, 16, extra);
+            if (size <= mPool1.getSize()) return mPool1.alloc(p, count, size, 16, extra);
+            if (size <= mPool2.getSize()) return mPool2.alloc(p, count, size, 16, extra);
+            return 0;
+        }
+    };
 
 #ifndef NDEBUG
+    // the tracking policy isn't thread-safe
     using HandleArena = utils::Arena<Allocator,
             utils::LockingPolicy::SpinLock,
             utils::TrackingPolicy::DebugAndHighWatermark>;
 #else
     using HandleArena = utils::Arena<Allocator,
-            utils::LockingPolicy::SpinLock>;
+            utils::LockingPolicy::NoLock>;
 #endif
 
     // allocateHandle()/deallocateHandle() selects the pool to use at compile-time based on the
@@ -270,8 +307,19 @@ private:
         }
     }
 
+    template<size_t SIZE>
+    void allocateHandles(HandleBase::HandleId* ids, size_t count) noexcept {
+        if constexpr (SIZE <= P0) {
+            allocateHandlesInPool<P0>(ids, count);
+        } else if constexpr (SIZE <= P1) {
+            allocateHandlesInPool<P1>(ids, count);
+        } else {
+            allocateHandlesInPool<P2>(ids, count);
+        }
+    }
+
     // allocateHandleInPool()/deallocateHandleFromPool() is NOT inlined, which will cause three
-    // versions to be generated, one for each pool. Because the arena is synchronized,
+    // versions to be generated, one for each pool. Because the pools are thread-safe,
     // the code generated is not trivial (even if it's not insane either).
     template<size_t SIZE>
     UTILS_NOINLINE
@@ -284,6 +332,27 @@ private:
         }
     }
 
+    template<size_t SIZE>
+    UTILS_NOINLINE
+    void allocateHandlesInPool(HandleBase::HandleId* ids, size_t count) noexcept {
+        void* p[utils::ThreadCachedFreeList::BATCH_SIZE];
+        while (count) {
+            size_t const n = mHandleArena.alloc(p, std::min(count, std::size(p)), SIZE);
+            for (size_t i = 0; i < n; i++) {
+                ids[i] = pointerToHandle(p[i]);
+            }
+            if (UTILS_UNLIKELY(n == 0)) {
+                // the pool is empty
+                for (size_t i = 0; i < count; i++) {
+                    ids[i] = allocateHandleSlow(SIZE);
+                }
+                return;
+            }
+            ids += n;
+            count -= n;
+        }
+    }
+
     template<size_t SIZE>
     UTILS_NOINLINE
     void deallocateHandleFromPool(HandleBase::HandleId id) noexcept {
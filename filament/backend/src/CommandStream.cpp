@@ -23,6 +23,8 @@
 
 #include <functional>
 
+#include <stdlib.h>
+
 #ifdef __ANDROID__
 #include <sys/system_properties.h>
 #endif
@@ -68,6 +70,23 @@ CommandStream::CommandStream(Driver& driver, CircularBuffer& buffer) noexcept
     __system_property_get("debug.filament.perfcounters", property);
     mUsePerformanceCounter = bool(atoi(property));
 #endif
+
+    // Capturing the command stream is enabled by setting FILAMENT_CAPTURE_COMMAND_STREAM (or the
+    // debug.filament.capture property on Android) to the path of the capture file.
+    const char* capturePath = getenv("FILAMENT_CAPTURE_COMMAND_STREAM");
+#ifdef __ANDROID__
+    char capturePathProperty[PROP_VALUE_MAX];
+    if (__system_property_get("debug.filament.capture", capturePathProperty) > 0) {
+        capturePath = capturePathProperty;
+    }
+#endif
+    if (UTILS_UNLIKELY(capturePath && *capturePath)) {
+        mRecorder = CommandStreamRecorder::create(capturePath);
+    }
+}
+
+CommandStream::~CommandStream() noexcept {
+    delete mRecorder;
 }
 
 void CommandStream::execute(void* buffer) {
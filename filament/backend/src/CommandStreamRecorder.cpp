@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "private/backend/CommandStreamRecorder.h"
+
+#include <utils/Log.h>
+
+#include <string.h>
+
+using namespace utils;
+
+namespace filament::backend {
+
+CommandStreamRecorder* CommandStreamRecorder::create(const char* path) noexcept {
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        slog.e << "Couldn't create command stream capture file " << path << io::endl;
+        return nullptr;
+    }
+    CaptureHeader header{};
+    memcpy(header.magic, CaptureHeader::MAGIC, sizeof(header.magic));
+    header.version = CaptureHeader::VERSION;
+    header.commandCount = uint32_t(CommandId::COUNT);
+    fwrite(&header, sizeof(header), 1, file);
+    slog.i << "Capturing command stream to " << path << io::endl;
+    return new CommandStreamRecorder(file);
+}
+
+CommandStreamRecorder::CommandStreamRecorder(FILE* file) noexcept
+        : mFile(file) {
+    mCommand.reserve(4096);
+}
+
+CommandStreamRecorder::~CommandStreamRecorder() noexcept {
+    fclose(mFile);
+}
+
+void CommandStreamRecorder::begin(CommandId id) noexcept {
+    // the size of the payload is patched in end()
+    mCommand.clear();
+    mCurrentId = id;
+    write(id);
+    write(uint32_t(0));
+}
+
+void CommandStreamRecorder::end(CommandId id) noexcept {
+    uint32_t const size = uint32_t(mCommand.size() - sizeof(CommandId) - sizeof(uint32_t));
+    memcpy(mCommand.data() + sizeof(CommandId), &size, sizeof(size));
+    fwrite(mCommand.data(), 1, mCommand.size(), mFile);
+    if (id == CommandId::endFrame) {
+        // so that a capture is usable even if the application doesn't exit cleanly
+        fflush(mFile);
+    }
+}
+
+void CommandStreamRecorder::writeBytes(void const* data, size_t size) noexcept {
+    uint8_t const* const p = static_cast<uint8_t const*>(data);
+    mCommand.insert(mCommand.end(), p, p + size);
+}
+
+void CommandStreamRecorder::writeString(const char* string, size_t length) noexcept {
+    write(uint32_t(length));
+    writeBytes(string, length);
+    write('\0');
+}
+
+void CommandStreamRecorder::write(const char* string) noexcept {
+    // nullptr strings are recorded as empty strings
+    writeString(string ? string : "", string ? strlen(string) : 0);
+}
+
+void CommandStreamRecorder::write(BufferDescriptor const& data) noexcept {
+    // the destination buffer of readPixels is recorded without its (meaningless) content
+    bool const hasContent = data.buffer && mCurrentId != CommandId::readPixels;
+    write(uint32_t(data.size));
+    write(hasContent);
+    if (hasContent) {
+        writeBytes(data.buffer, data.size);
+    }
+}
+
+void CommandStreamRecorder::write(PixelBufferDescriptor const& data) noexcept {
+    write(static_cast<BufferDescriptor const&>(data));
+    write(data.left);
+    write(data.top);
+    write(data.type);
+    write(data.alignment);
+    if (data.type == PixelDataType::COMPRESSED) {
+        write(data.imageSize);
+        write(data.compressedFormat);
+    } else {
+        write(data.stride);
+        write(data.format);
+    }
+}
+
+void CommandStreamRecorder::write(Program const& program) noexcept {
+    CString const& name = program.getName();
+    writeString(name.c_str_safe(), name.size());
+
+    for (Program::ShaderBlob const& blob : program.getShadersSource()) {
+        write(uint32_t(blob.size()));
+        writeBytes(blob.data(), blob.size());
+    }
+
+    // uniform block names are only used by the GLES 3.0 backend, they're nullptr otherwise
+    for (const char* blockName : program.getUniformBlockBindings()) {
+        write(bool(blockName));
+        if (blockName) {
+            write(blockName);
+        }
+    }
+
+    for (Program::SamplerGroupData const& group : program.getSamplerGroupInfo()) {
+        write(group.stageFlags);
+        write(uint32_t(group.samplers.size()));
+        for (Program::Sampler const& sampler : group.samplers) {
+            writeString(sampler.name.c_str_safe(), sampler.name.size());
+            write(sampler.binding);
+        }
+    }
+}
+
+} // namespace filament::backend
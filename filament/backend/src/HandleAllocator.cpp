@@ -24,18 +24,20 @@ namespace filament::backend {
 
 using namespace utils;
 
+// TODO: we probably need a better way to set the size of these pools
+static char* getPoolBegin(AreaPolicy::HeapArea const& area, size_t pool) noexcept {
+    constexpr size_t offsets[] = { 0, 1, 16 };
+    const size_t unit = area.size() / 32;
+    return (char*)area.begin() + offsets[pool] * unit;
+}
+
 template <size_t P0, size_t P1, size_t P2>
 UTILS_NOINLINE
 HandleAllocator<P0, P1, P2>::Allocator::Allocator(AreaPolicy::HeapArea const& area)
-        : mArea(area) {
-    // TODO: we probably need a better way to set the size of these pools
-    const size_t unit = area.size() / 32;
-    const size_t offsetPool1 =      unit;
-    const size_t offsetPool2 = 16 * unit;
-    char* const p = (char*)area.begin();
-    mPool0 = PoolAllocator< P0, 16>(p, p + offsetPool1);
-    mPool1 = PoolAllocator< P1, 16>(p + offsetPool1, p + offsetPool2);
-    mPool2 = PoolAllocator< P2, 16>(p + offsetPool2, area.end());
+        : mPool0(getPoolBegin(area, 0), getPoolBegin(area, 1)),
+          mPool1(getPoolBegin(area, 1), getPoolBegin(area, 2)),
+          mPool2(getPoolBegin(area, 2), area.end()),
+          mArea(area) {
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -25,7 +25,7 @@ MetalBuffer::MetalBuffer(MetalContext& context, BufferUsage usage, size_t size,
         : mBufferSize(size), mContext(context) {
     // If the buffer is less than 4K in size and is updated frequently, we don't use an explicit
     // buffer. Instead, we use immediate command encoder methods like setVertexBytes:length:atIndex:.
-   if (size <= 4 * 1024 && usage == BufferUsage::DYNAMIC && !forceGpuBuffer) {
+   if (size <= 4 * 1024 && usage != BufferUsage::STATIC && !forceGpuBuffer) {
        mBuffer = nil;
        mCpuBuffer = malloc(size);
        return;
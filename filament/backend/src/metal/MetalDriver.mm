@@ -695,6 +695,10 @@ FeatureLevel MetalDriver::getFeatureLevel() {
     return FeatureLevel::FEATURE_LEVEL_1;
 }
 
+StateCacheStats MetalDriver::getStateCacheStats() {
+    return {};
+}
+
 math::float2 MetalDriver::getClipSpaceParams() {
     // virtual and physical z-coordinate of clip-space is in [-w, 0]
     // Note: this is actually never used (see: main.vs), but it's a backend API so we implement it
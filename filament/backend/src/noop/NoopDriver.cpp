@@ -181,6 +181,10 @@ FeatureLevel NoopDriver::getFeatureLevel() {
     return FeatureLevel::FEATURE_LEVEL_1;
 }
 
+StateCacheStats NoopDriver::getStateCacheStats() {
+    return {};
+}
+
 math::float2 NoopDriver::getClipSpaceParams() {
     return math::float2{ 1.0f, 0.0f };
 }
@@ -383,6 +383,7 @@ void OpenGLContext::initExtensionsGL() noexcept {
     auto major = state.major;
     auto minor = state.minor;
     ext.APPLE_color_buffer_packed_float = true;  // Assumes core profile.
+    ext.ARB_buffer_storage = exts.has("GL_ARB_buffer_storage"sv) || (major == 4 && minor >= 4);
     ext.ARB_shading_language_packing = exts.has("GL_ARB_shading_language_packing"sv) || (major == 4 && minor >= 2);
     ext.EXT_clip_control = exts.has("GL_ARB_clip_control"sv) || (major == 4 && minor >= 5);
     ext.EXT_color_buffer_float = true;  // Assumes core profile.
@@ -413,11 +414,14 @@ void OpenGLContext::bindBuffer(GLenum target, GLuint buffer) noexcept {
             if (state.vao.p != &mDefaultVAO) {
                 state.vao.p->elementArray = buffer;
             }
+            stats.buffers.issued++;
             glBindBuffer(target, buffer);
+        } else {
+            stats.buffers.elided++;
         }
     } else {
         size_t targetIndex = getIndexForBufferTarget(target);
-        update_state(state.buffers.genericBinding[targetIndex], buffer, [&]() {
+        update_state(stats.buffers, state.buffers.genericBinding[targetIndex], buffer, [&]() {
             glBindBuffer(target, buffer);
         });
     }
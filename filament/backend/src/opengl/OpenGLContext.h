@@ -137,6 +137,7 @@ public:
     // supported extensions detected at runtime
     struct {
         bool APPLE_color_buffer_packed_float = false;
+        bool ARB_buffer_storage = false;
         bool ARB_shading_language_packing = false;
         bool EXT_clip_control = false;
         bool EXT_color_buffer_float = false;
@@ -224,9 +225,18 @@ public:
     void updateTexImage(GLenum target, GLuint id) noexcept {
         const size_t index = getIndexForTextureTarget(target);
         state.textures.units[state.textures.active].targets[index].texture_id = id;
+        state.textures.generation++;
     }
     void resetProgram() noexcept { state.program.use = 0; }
 
+    // Changes each time the state of the texture units might have changed. Programs use it to
+    // skip setting up their texture units when nothing changed since they last did.
+    uint32_t getTextureStateGeneration() const noexcept { return state.textures.generation; }
+    void invalidateTextureState() noexcept { state.textures.generation++; }
+
+    // issued vs. elided GL calls, these are reset by the driver at the end of each frame
+    StateCacheStats stats;
+
     FeatureLevel getFeatureLevel() const noexcept { return mFeatureLevel; }
 
     // Try to keep the State structure sorted by data-access patterns
@@ -313,6 +323,7 @@ public:
 
         struct {
             GLuint active = 0;      // zero-based
+            uint32_t generation = 1;
             struct {
                 GLuint sampler = 0;
                 struct {
@@ -399,10 +410,14 @@ private:
     void initExtensionsGL() noexcept;
 
     template <typename T, typename F>
-    static inline void update_state(T& state, T const& expected, F functor, bool force = false) noexcept {
+    static inline void update_state(StateCacheStats::Counter& counter,
+            T& state, T const& expected, F functor, bool force = false) noexcept {
         if (UTILS_UNLIKELY(force || state != expected)) {
             state = expected;
+            counter.issued++;
             functor();
+        } else {
+            counter.elided++;
         }
     }
 
@@ -477,42 +492,43 @@ constexpr size_t OpenGLContext::getIndexForBufferTarget(GLenum target) noexcept
 
 void OpenGLContext::activeTexture(GLuint unit) noexcept {
     assert_invariant(unit < MAX_TEXTURE_UNIT_COUNT);
-    update_state(state.textures.active, unit, [&]() {
+    update_state(stats.states, state.textures.active, unit, [&]() {
         glActiveTexture(GL_TEXTURE0 + unit);
     });
 }
 
 void OpenGLContext::bindSampler(GLuint unit, GLuint sampler) noexcept {
     assert_invariant(unit < MAX_TEXTURE_UNIT_COUNT);
-    update_state(state.textures.units[unit].sampler, sampler, [&]() {
+    update_state(stats.samplers, state.textures.units[unit].sampler, sampler, [&]() {
+        state.textures.generation++;
         glBindSampler(unit, sampler);
     });
 }
 
 void OpenGLContext::setScissor(GLint left, GLint bottom, GLsizei width, GLsizei height) noexcept {
     vec4gli scissor(left, bottom, width, height);
-    update_state(state.window.scissor, scissor, [&]() {
+    update_state(stats.states, state.window.scissor, scissor, [&]() {
         glScissor(left, bottom, width, height);
     });
 }
 
 void OpenGLContext::viewport(GLint left, GLint bottom, GLsizei width, GLsizei height) noexcept {
     vec4gli viewport(left, bottom, width, height);
-    update_state(state.window.viewport, viewport, [&]() {
+    update_state(stats.states, state.window.viewport, viewport, [&]() {
         glViewport(left, bottom, width, height);
     });
 }
 
 void OpenGLContext::depthRange(GLclampf near, GLclampf far) noexcept {
     vec2glf depthRange(near, far);
-    update_state(state.window.depthRange, depthRange, [&]() {
+    update_state(stats.states, state.window.depthRange, depthRange, [&]() {
         glDepthRangef(near, far);
     });
 }
 
 void OpenGLContext::bindVertexArray(RenderPrimitive const* p) noexcept {
     RenderPrimitive* vao = p ? const_cast<RenderPrimitive *>(p) : &mDefaultVAO;
-    update_state(state.vao.p, vao, [&]() {
+    update_state(stats.vertexArrays, state.vao.p, vao, [&]() {
         glBindVertexArray(vao->vao);
         // update GL_ELEMENT_ARRAY_BUFFER, which is updated by glBindVertexArray
         size_t targetIndex = getIndexForBufferTarget(GL_ELEMENT_ARRAY_BUFFER);
@@ -538,7 +554,10 @@ void OpenGLContext::bindBufferRange(GLenum target, GLuint index, GLuint buffer,
         state.buffers.targets[targetIndex].buffers[index].offset = offset;
         state.buffers.targets[targetIndex].buffers[index].size = size;
         state.buffers.genericBinding[targetIndex] = buffer;
+        stats.bufferRanges.issued++;
         glBindBufferRange(target, index, buffer, offset, size);
+    } else {
+        stats.bufferRanges.elided++;
     }
 }
 
@@ -547,19 +566,28 @@ void OpenGLContext::bindFramebuffer(GLenum target, GLuint buffer) noexcept {
         case GL_FRAMEBUFFER:
             if (state.draw_fbo != buffer || state.read_fbo != buffer) {
                 state.draw_fbo = state.read_fbo = buffer;
+                stats.framebuffers.issued++;
                 glBindFramebuffer(target, buffer);
+            } else {
+                stats.framebuffers.elided++;
             }
             break;
         case GL_DRAW_FRAMEBUFFER:
             if (state.draw_fbo != buffer) {
                 state.draw_fbo = buffer;
+                stats.framebuffers.issued++;
                 glBindFramebuffer(target, buffer);
+            } else {
+                stats.framebuffers.elided++;
             }
             break;
         case GL_READ_FRAMEBUFFER:
             if (state.read_fbo != buffer) {
                 state.read_fbo = buffer;
+                stats.framebuffers.issued++;
                 glBindFramebuffer(target, buffer);
+            } else {
+                stats.framebuffers.elided++;
             }
             break;
         default:
@@ -570,8 +598,14 @@ void OpenGLContext::bindFramebuffer(GLenum target, GLuint buffer) noexcept {
 void OpenGLContext::bindTexture(GLuint unit, GLuint target, GLuint texId, size_t targetIndex) noexcept {
     assert_invariant(targetIndex == getIndexForTextureTarget(target));
     assert_invariant(targetIndex < TEXTURE_TARGET_COUNT);
-    update_state(state.textures.units[unit].targets[targetIndex].texture_id, texId, [&]() {
-        activeTexture(unit);
+    update_state(stats.textures,
+            state.textures.units[unit].targets[targetIndex].texture_id, texId, [&]() {
+        state.textures.generation++;
+        // selecting the unit is part of the texture bind, it's not counted as a separate state
+        if (state.textures.active != unit) {
+            state.textures.active = unit;
+            glActiveTexture(GL_TEXTURE0 + unit);
+        }
         glBindTexture(target, texId);
     }, (target == GL_TEXTURE_EXTERNAL_OES) && bugs.texture_external_needs_rebind);
 }
@@ -581,7 +615,7 @@ void OpenGLContext::bindTexture(GLuint unit, GLuint target, GLuint texId) noexce
 }
 
 void OpenGLContext::useProgram(GLuint program) noexcept {
-    update_state(state.program.use, program, [&]() {
+    update_state(stats.programs, state.program.use, program, [&]() {
         glUseProgram(program);
     });
 }
@@ -591,7 +625,10 @@ void OpenGLContext::enableVertexAttribArray(GLuint index) noexcept {
     assert_invariant(index < state.vao.p->vertexAttribArray.size());
     if (UTILS_UNLIKELY(!state.vao.p->vertexAttribArray[index])) {
         state.vao.p->vertexAttribArray.set(index);
+        stats.states.issued++;
         glEnableVertexAttribArray(index);
+    } else {
+        stats.states.elided++;
     }
 }
 
@@ -600,7 +637,10 @@ void OpenGLContext::disableVertexAttribArray(GLuint index) noexcept {
     assert_invariant(index < state.vao.p->vertexAttribArray.size());
     if (UTILS_UNLIKELY(state.vao.p->vertexAttribArray[index])) {
         state.vao.p->vertexAttribArray.unset(index);
+        stats.states.issued++;
         glDisableVertexAttribArray(index);
+    } else {
+        stats.states.elided++;
     }
 }
 
@@ -608,7 +648,10 @@ void OpenGLContext::enable(GLenum cap) noexcept {
     size_t index = getIndexForCap(cap);
     if (UTILS_UNLIKELY(!state.enables.caps[index])) {
         state.enables.caps.set(index);
+        stats.states.issued++;
         glEnable(cap);
+    } else {
+        stats.states.elided++;
     }
 }
 
@@ -616,18 +659,21 @@ void OpenGLContext::disable(GLenum cap) noexcept {
     size_t index = getIndexForCap(cap);
     if (UTILS_UNLIKELY(state.enables.caps[index])) {
         state.enables.caps.unset(index);
+        stats.states.issued++;
         glDisable(cap);
+    } else {
+        stats.states.elided++;
     }
 }
 
 void OpenGLContext::frontFace(GLenum mode) noexcept {
-    update_state(state.raster.frontFace, mode, [&]() {
+    update_state(stats.states, state.raster.frontFace, mode, [&]() {
         glFrontFace(mode);
     });
 }
 
 void OpenGLContext::cullFace(GLenum mode) noexcept {
-    update_state(state.raster.cullFace, mode, [&]() {
+    update_state(stats.states, state.raster.cullFace, mode, [&]() {
         glCullFace(mode);
     });
 }
@@ -637,7 +683,10 @@ void OpenGLContext::blendEquation(GLenum modeRGB, GLenum modeA) noexcept {
             state.raster.blendEquationRGB != modeRGB || state.raster.blendEquationA != modeA)) {
         state.raster.blendEquationRGB = modeRGB;
         state.raster.blendEquationA   = modeA;
+        stats.states.issued++;
         glBlendEquationSeparate(modeRGB, modeA);
+    } else {
+        stats.states.elided++;
     }
 }
 
@@ -651,58 +700,61 @@ void OpenGLContext::blendFunction(GLenum srcRGB, GLenum srcA, GLenum dstRGB, GLe
         state.raster.blendFunctionSrcA = srcA;
         state.raster.blendFunctionDstRGB = dstRGB;
         state.raster.blendFunctionDstA = dstA;
+        stats.states.issued++;
         glBlendFuncSeparate(srcRGB, dstRGB, srcA, dstA);
+    } else {
+        stats.states.elided++;
     }
 }
 
 void OpenGLContext::colorMask(GLboolean flag) noexcept {
-    update_state(state.raster.colorMask, flag, [&]() {
+    update_state(stats.states, state.raster.colorMask, flag, [&]() {
         glColorMask(flag, flag, flag, flag);
     });
 }
 void OpenGLContext::depthMask(GLboolean flag) noexcept {
-    update_state(state.raster.depthMask, flag, [&]() {
+    update_state(stats.states, state.raster.depthMask, flag, [&]() {
         glDepthMask(flag);
     });
 }
 
 void OpenGLContext::depthFunc(GLenum func) noexcept {
-    update_state(state.raster.depthFunc, func, [&]() {
+    update_state(stats.states, state.raster.depthFunc, func, [&]() {
         glDepthFunc(func);
     });
 }
 
 void OpenGLContext::stencilFuncSeparate(GLenum funcFront, GLint refFront, GLuint maskFront,
         GLenum funcBack, GLint refBack, GLuint maskBack) noexcept {
-    update_state(state.stencil.front.func, {funcFront, refFront, maskFront}, [&]() {
+    update_state(stats.states, state.stencil.front.func, {funcFront, refFront, maskFront}, [&]() {
         glStencilFuncSeparate(GL_FRONT, funcFront, refFront, maskFront);
     });
-    update_state(state.stencil.back.func, {funcBack, refBack, maskBack}, [&]() {
+    update_state(stats.states, state.stencil.back.func, {funcBack, refBack, maskBack}, [&]() {
         glStencilFuncSeparate(GL_BACK, funcBack, refBack, maskBack);
     });
 }
 
 void OpenGLContext::stencilOpSeparate(GLenum sfailFront, GLenum dpfailFront, GLenum dppassFront,
         GLenum sfailBack, GLenum dpfailBack, GLenum dppassBack) noexcept {
-    update_state(state.stencil.front.op, {sfailFront, dpfailFront, dppassFront}, [&]() {
+    update_state(stats.states, state.stencil.front.op, {sfailFront, dpfailFront, dppassFront}, [&]() {
         glStencilOpSeparate(GL_FRONT, sfailFront, dpfailFront, dppassFront);
     });
-    update_state(state.stencil.back.op, {sfailBack, dpfailBack, dppassBack}, [&]() {
+    update_state(stats.states, state.stencil.back.op, {sfailBack, dpfailBack, dppassBack}, [&]() {
         glStencilOpSeparate(GL_BACK, sfailBack, dpfailBack, dppassBack);
     });
 }
 
 void OpenGLContext::stencilMaskSeparate(GLuint maskFront, GLuint maskBack) noexcept {
-    update_state(state.stencil.front.stencilMask, maskFront, [&]() {
+    update_state(stats.states, state.stencil.front.stencilMask, maskFront, [&]() {
         glStencilMaskSeparate(GL_FRONT, maskFront);
     });
-    update_state(state.stencil.back.stencilMask, maskBack, [&]() {
+    update_state(stats.states, state.stencil.back.stencilMask, maskBack, [&]() {
         glStencilMaskSeparate(GL_BACK, maskBack);
     });
 }
 
 void OpenGLContext::polygonOffset(GLfloat factor, GLfloat units) noexcept {
-    update_state(state.polygonOffset, { factor, units }, [&]() {
+    update_state(stats.states, state.polygonOffset, { factor, units }, [&]() {
         if (factor != 0 || units != 0) {
             glPolygonOffset(factor, units);
             enable(GL_POLYGON_OFFSET_FILL);
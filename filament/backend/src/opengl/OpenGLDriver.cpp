@@ -225,6 +225,8 @@ void OpenGLDriver::terminate() {
 
     delete mTimerQueryImpl;
 
+    mStreamBuffer.terminate();
+
     mPlatform.terminate();
 }
 
@@ -1259,6 +1261,11 @@ void OpenGLDriver::destroyBufferObject(Handle<HwBufferObject> boh) {
         auto& gl = mContext;
         GLBufferObject const* bo = handle_cast<const GLBufferObject*>(boh);
         gl.deleteBuffers(1, &bo->gl.id, bo->gl.binding);
+        for (auto& binding : mUniformBufferBindings) {
+            if (binding.bo == bo) {
+                binding = {};
+            }
+        }
         destruct(boh, bo);
     }
 }
@@ -1639,6 +1646,11 @@ FeatureLevel OpenGLDriver::getFeatureLevel() {
     return mContext.getFeatureLevel();
 }
 
+StateCacheStats OpenGLDriver::getStateCacheStats() {
+    std::lock_guard<utils::Mutex> const lock(mStateCacheStatsLock);
+    return mStateCacheStats;
+}
+
 math::float2 OpenGLDriver::getClipSpaceParams() {
     return mContext.ext.EXT_clip_control ?
            // z-coordinate of virtual and physical clip-space is in [-w, 0]
@@ -1724,6 +1736,14 @@ void OpenGLDriver::updateBufferObject(
 
     assert_invariant(bd.size + byteOffset <= bo->byteCount);
 
+    if (bo->usage == BufferUsage::STREAM && bo->gl.binding == GL_UNIFORM_BUFFER) {
+        if (updateStreamBufferObject(bo, bd, byteOffset)) {
+            scheduleDestroy(std::move(bd));
+            CHECK_GL_ERROR(utils::slog.e)
+            return;
+        }
+    }
+
     if (bo->gl.binding == GL_ARRAY_BUFFER) {
         gl.bindVertexArray(nullptr);
     }
@@ -1754,8 +1774,9 @@ void OpenGLDriver::updateBufferObjectUnsynchronized(
         assert_invariant(bo->gl.id);
         assert_invariant(bd.size + byteOffset <= bo->byteCount);
 
-        if (bo->gl.binding != GL_UNIFORM_BUFFER) {
+        if (bo->gl.binding != GL_UNIFORM_BUFFER || bo->usage == BufferUsage::STREAM) {
             // TODO: use updateBuffer() for all types of buffer? Make sure GL supports that.
+            // Streaming buffers never synchronize with the GPU in the first place.
             updateBufferObject(boh, std::move(bd), byteOffset);
         } else {
             auto& gl = mContext;
@@ -1783,6 +1804,37 @@ retry:
     CHECK_GL_ERROR(utils::slog.e)
 }
 
+bool OpenGLDriver::updateStreamBufferObject(GLBufferObject* bo,
+        BufferDescriptor const& bd, uint32_t byteOffset) noexcept {
+    auto& gl = mContext;
+
+    // A full update goes to a fresh range of the stream buffer, so that the GPU can keep reading
+    // the previous content while we write the new one.
+    uint32_t offset;
+    if (byteOffset == 0 && bd.size == bo->byteCount &&
+            mStreamBuffer.write(bd.buffer, bo->byteCount, &offset)) {
+        bo->gl.streaming = true;
+        bo->gl.streamOffset = offset;
+        rebindUniformBuffer(bo);
+        return true;
+    }
+
+    // Otherwise, the buffer goes back to its own storage. A partial update needs the current
+    // content, which lives in the stream buffer.
+    if (bo->gl.streaming) {
+        if (bd.size != bo->byteCount) {
+            gl.bindBuffer(GL_UNIFORM_BUFFER, bo->gl.id);
+            glBindBuffer(GL_COPY_READ_BUFFER, mStreamBuffer.getId());
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_UNIFORM_BUFFER,
+                    bo->gl.streamOffset, 0, bo->byteCount);
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        }
+        bo->gl.streaming = false;
+        rebindUniformBuffer(bo);
+    }
+    return false;
+}
+
 void OpenGLDriver::resetBufferObject(Handle<HwBufferObject> boh) {
     DEBUG_MARKER()
 
@@ -1792,6 +1844,11 @@ void OpenGLDriver::resetBufferObject(Handle<HwBufferObject> boh) {
 
     gl.bindBuffer(bo->gl.binding, bo->gl.id);
     glBufferData(bo->gl.binding, bo->byteCount, nullptr, getBufferUsage(bo->usage));
+
+    if (bo->gl.streaming) {
+        bo->gl.streaming = false;
+        rebindUniformBuffer(bo);
+    }
 }
 
 void OpenGLDriver::updateSamplerGroup(Handle<HwSamplerGroup> sbh,
@@ -1856,6 +1913,8 @@ void OpenGLDriver::updateSamplerGroup(Handle<HwSamplerGroup> sbh,
 
         sb->textureUnitEntries[i] = { t, samplerId };
     }
+    // programs using this sampler group must set up their texture units again
+    context.invalidateTextureState();
     scheduleDestroy(std::move(data));
 }
 
@@ -2117,6 +2176,8 @@ void OpenGLDriver::cancelExternalImage(void* image) {
 void OpenGLDriver::setExternalImage(Handle<HwTexture> th, void* image) {
     DEBUG_MARKER()
     mPlatform.setExternalImage(image, handle_cast<GLTexture*>(th));
+    // the platform can change the texture id
+    mContext.invalidateTextureState();
     setExternalTexture(handle_cast<GLTexture*>(th), image);
 }
 
@@ -2201,6 +2262,7 @@ void OpenGLDriver::detachStream(GLTexture* t) noexcept {
     }
 
     glGenTextures(1, &t->gl.id);
+    gl.invalidateTextureState();
 
     t->hwStream = nullptr;
 }
@@ -2232,6 +2294,8 @@ void OpenGLDriver::replaceStream(GLTexture* texture, GLStream* newStream) noexce
             break;
     }
 
+    mContext.invalidateTextureState();
+
     texture->hwStream = newStream;
 }
 
@@ -2568,30 +2632,54 @@ void OpenGLDriver::updateStreamAcquired(GLTexture* gltexture, DriverApi* driver)
 
 void OpenGLDriver::bindUniformBuffer(uint32_t index, Handle<HwBufferObject> ubh) {
     DEBUG_MARKER()
-    auto& gl = mContext;
     GLBufferObject* ub = handle_cast<GLBufferObject *>(ubh);
     assert_invariant(ub->gl.binding == GL_UNIFORM_BUFFER);
-    gl.bindBufferRange(ub->gl.binding, GLuint(index), ub->gl.id, 0, ub->byteCount);
+    setUniformBufferBinding(GLuint(index), ub, 0, ub->byteCount);
     CHECK_GL_ERROR(utils::slog.e)
 }
 
 void OpenGLDriver::bindUniformBufferRange(uint32_t index, Handle<HwBufferObject> ubh,
         uint32_t offset, uint32_t size) {
     DEBUG_MARKER()
-    auto& gl = mContext;
-
     GLBufferObject* ub = handle_cast<GLBufferObject *>(ubh);
     assert_invariant(ub->gl.binding == GL_UNIFORM_BUFFER);
     assert_invariant(offset + size <= ub->byteCount);
-    gl.bindBufferRange(ub->gl.binding, GLuint(index), ub->gl.id, offset, size);
+    setUniformBufferBinding(GLuint(index), ub, offset, size);
     CHECK_GL_ERROR(utils::slog.e)
 }
 
+void OpenGLDriver::setUniformBufferBinding(GLuint index, GLBufferObject const* bo,
+        uint32_t offset, uint32_t size) noexcept {
+    auto& gl = mContext;
+    if (UTILS_LIKELY(index < mUniformBufferBindings.size())) {
+        mUniformBufferBindings[index] = { bo, offset, size };
+    }
+    if (bo->gl.streaming) {
+        gl.bindBufferRange(GL_UNIFORM_BUFFER, index, mStreamBuffer.getId(),
+                bo->gl.streamOffset + offset, size);
+    } else {
+        gl.bindBufferRange(GL_UNIFORM_BUFFER, index, bo->gl.id, offset, size);
+    }
+}
+
+void OpenGLDriver::rebindUniformBuffer(GLBufferObject const* bo) noexcept {
+    // The content of the buffer moved, so its bindings must follow.
+    for (size_t i = 0, c = mUniformBufferBindings.size(); i < c; i++) {
+        UniformBufferBinding const binding = mUniformBufferBindings[i];
+        if (binding.bo == bo) {
+            setUniformBufferBinding(GLuint(i), bo, binding.offset, binding.size);
+        }
+    }
+}
+
 void OpenGLDriver::bindSamplers(uint32_t index, Handle<HwSamplerGroup> sbh) {
     DEBUG_MARKER()
     assert_invariant(index < Program::SAMPLER_BINDING_COUNT);
     GLSamplerGroup* sb = handle_cast<GLSamplerGroup *>(sbh);
-    mSamplerBindings[index] = sb;
+    if (mSamplerBindings[index] != sb) {
+        mSamplerBindings[index] = sb;
+        mContext.invalidateTextureState();
+    }
     CHECK_GL_ERROR(utils::slog.e)
 }
 
@@ -2882,6 +2970,14 @@ void OpenGLDriver::endFrame(uint32_t frameId) {
 #endif
     //SYSTRACE_NAME("glFinish");
     //glFinish();
+    mStreamBuffer.endFrame();
+
+    { // publish this frame's state cache stats
+        std::lock_guard<utils::Mutex> const lock(mStateCacheStatsLock);
+        mStateCacheStats = mContext.stats;
+    }
+    mContext.stats = {};
+
     insertEventMarker("endFrame");
 }
 
@@ -20,6 +20,7 @@
 #include "DriverBase.h"
 #include "GLUtils.h"
 #include "OpenGLContext.h"
+#include "OpenGLStreamBuffer.h"
 
 #include "private/backend/AcquiredImage.h"
 #include "private/backend/Driver.h"
@@ -30,6 +31,7 @@
 
 #include <utils/compiler.h>
 #include <utils/Allocator.h>
+#include <utils/Mutex.h>
 
 #include <math/vec4.h>
 
@@ -78,6 +80,9 @@ public:
         struct {
             GLuint id = 0;
             GLenum binding = 0;
+            // with BufferUsage::STREAM, offset of the current content in the stream buffer
+            uint32_t streamOffset = 0;
+            bool streaming = false;
         } gl;
         BufferUsage usage = {};
     };
@@ -346,6 +351,22 @@ private:
     // sampler buffer binding points (nullptr if not used)
     std::array<GLSamplerGroup*, Program::SAMPLER_BINDING_COUNT> mSamplerBindings = {};   // 4 pointers
 
+    // uniform buffer binding points, needed to rebind streaming buffers when they're updated
+    struct UniformBufferBinding {
+        GLBufferObject const* bo = nullptr;
+        uint32_t offset = 0;
+        uint32_t size = 0;
+    };
+    std::array<UniformBufferBinding, Program::UNIFORM_BINDING_COUNT> mUniformBufferBindings = {};
+    void setUniformBufferBinding(GLuint index, GLBufferObject const* bo,
+            uint32_t offset, uint32_t size) noexcept;
+    void rebindUniformBuffer(GLBufferObject const* bo) noexcept;
+    bool updateStreamBufferObject(GLBufferObject* bo,
+            BufferDescriptor const& bd, uint32_t byteOffset) noexcept;
+
+    // ring buffer backing the BufferUsage::STREAM uniform buffers
+    OpenGLStreamBuffer mStreamBuffer{ mContext };
+
     mutable tsl::robin_map<uint32_t, GLuint> mSamplerMap;
     mutable std::vector<GLTexture*> mExternalStreams;
 
@@ -375,6 +396,10 @@ private:
     void cancelRunAtNextPassOp(void* token) noexcept;
     tsl::robin_map<void*, std::function<void()>> mRunAtNextRenderPassOps;
 
+    // state cache stats of the last frame, read from the main thread
+    mutable utils::Mutex mStateCacheStatsLock;
+    StateCacheStats mStateCacheStats;
+
     // timer query implementation
     OpenGLTimerQueryInterface* mTimerQueryImpl = nullptr;
     bool mFrameTimeSupported = false;
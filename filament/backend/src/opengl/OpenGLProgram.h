@@ -56,13 +56,20 @@ public:
             // we need to do this if:
             // - the content of mSamplerBindings has changed
             // - the content of any bound sampler buffer has changed
+            // - the texture units have been changed by someone else
             // ... since last time we used this program
-
-            // turns out the former might be relatively cheap to check, the later requires
-            // a bit less. Compared to what updateSamplers() actually does, which is
-            // pretty little, I'm not sure if we'll get ahead.
-
-            updateSamplers(gld);
+            // All of these change the texture state generation, which is typically not the case
+            // for consecutive draws sharing the same MaterialInstance.
+            const uint32_t generation = context.getTextureStateGeneration();
+            if (mTextureStateGeneration != generation ||
+                    UTILS_UNLIKELY(context.bugs.texture_external_needs_rebind)) {
+                context.stats.samplerGroups.issued++;
+                updateSamplers(gld);
+                // our own bindings are part of the state
+                mTextureStateGeneration = context.getTextureStateGeneration();
+            } else {
+                context.stats.samplerGroups.elided++;
+            }
         }
     }
 
@@ -106,6 +113,9 @@ private:
     bool mValid : 1;
     UTILS_UNUSED uint8_t padding[2] = {};
 
+    // texture state generation right after this program set up its texture units
+    uint32_t mTextureStateGeneration = 0;
+
     union {
         // when mInitialized == true:
         // information about each USED sampler buffer per binding (no gaps)
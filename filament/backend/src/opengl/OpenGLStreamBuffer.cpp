@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "OpenGLStreamBuffer.h"
+
+#include "OpenGLContext.h"
+
+#include <utils/Log.h>
+#include <utils/debug.h>
+
+#include <algorithm>
+
+#include <string.h>
+
+namespace filament::backend {
+
+using namespace utils;
+
+OpenGLStreamBuffer::OpenGLStreamBuffer(OpenGLContext& context) noexcept
+        : mContext(context) {
+}
+
+OpenGLStreamBuffer::~OpenGLStreamBuffer() noexcept {
+    assert_invariant(mId == 0);
+}
+
+void OpenGLStreamBuffer::terminate() noexcept {
+    for (Region const& region : mRegions) {
+        glDeleteSync(region.fence);
+    }
+    mRegions.clear();
+    if (mId) {
+        mContext.bindBuffer(GL_UNIFORM_BUFFER, mId);
+        if (mMapped) {
+            glUnmapBuffer(GL_UNIFORM_BUFFER);
+            mMapped = nullptr;
+        }
+        mContext.deleteBuffers(1, &mId, GL_UNIFORM_BUFFER);
+        mId = 0;
+    }
+}
+
+bool OpenGLStreamBuffer::write(void const* data, uint32_t size, uint32_t* offset) noexcept {
+#if defined(__EMSCRIPTEN__)
+    // WebGL can't map buffers, so there is nothing to gain over glBufferSubData.
+    return false;
+#else
+    auto& gl = mContext;
+    if (UTILS_UNLIKELY(mId == 0)) {
+        glGenBuffers(1, &mId);
+        gl.bindBuffer(GL_UNIFORM_BUFFER, mId);
+#if defined(GL_VERSION_4_4)
+        if (gl.ext.ARB_buffer_storage) {
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+                    GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_UNIFORM_BUFFER, CAPACITY, nullptr, flags);
+            mMapped = (uint8_t*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, CAPACITY, flags);
+            if (UTILS_UNLIKELY(!mMapped)) {
+                slog.w << "Unable to map the stream buffer persistently" << io::endl;
+            }
+        } else
+#endif
+        {
+            glBufferData(GL_UNIFORM_BUFFER, CAPACITY, nullptr, GL_STREAM_DRAW);
+        }
+    }
+
+    if (!allocate(size, offset)) {
+        return false;
+    }
+
+    if (mMapped) {
+        // The mapping is coherent, so the data is visible to the commands issued after this.
+        memcpy(mMapped + *offset, data, size);
+        return true;
+    }
+
+    // The fences guarantee that the GPU is done with this range, so there is no need to sync.
+    gl.bindBuffer(GL_UNIFORM_BUFFER, mId);
+    void* const vaddr = glMapBufferRange(GL_UNIFORM_BUFFER, *offset, size,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (UTILS_LIKELY(vaddr)) {
+        memcpy(vaddr, data, size);
+        if (UTILS_LIKELY(glUnmapBuffer(GL_UNIFORM_BUFFER) == GL_TRUE)) {
+            return true;
+        }
+    }
+    glBufferSubData(GL_UNIFORM_BUFFER, *offset, size, data);
+    return true;
+#endif
+}
+
+bool OpenGLStreamBuffer::allocate(uint32_t size, uint32_t* offset) noexcept {
+    const uint32_t alignment = std::max(1, mContext.gets.uniform_buffer_offset_alignment);
+
+    // Don't let a single update take a large part of the ring, it would stall the next frames.
+    if (size > CAPACITY / 4) {
+        return false;
+    }
+
+    retireRegions(false);
+
+    while (true) {
+        const bool empty = mRegions.empty() && !mOpen;
+        if (empty) {
+            // Restart at the beginning to get as much contiguous space as possible.
+            mHead = mTail = 0;
+        }
+
+        uint32_t start = (mHead + alignment - 1) / alignment * alignment;
+        bool fits = true;
+        if (empty || mHead > mTail) {
+            // The free space is [head, capacity) followed by [0, tail).
+            if (start + size > CAPACITY) {
+                fits = size <= mTail;
+                start = 0;
+            }
+        } else if (mHead == mTail || start + size > mTail) {
+            // Either the ring is full, or the free space [head, tail) is too small.
+            fits = false;
+        }
+
+        if (fits) {
+            mHead = start + size;
+            mOpen = true;
+            *offset = start;
+            return true;
+        }
+
+        // The GPU is still using the memory we need, wait for the oldest frame to complete.
+        if (!retireRegions(true)) {
+            return false;
+        }
+    }
+}
+
+bool OpenGLStreamBuffer::retireRegions(bool wait) noexcept {
+    // Regions are retired in submission order, so we stop at the first one that is still in use.
+    bool retired = false;
+    while (!mRegions.empty()) {
+        Region const& region = mRegions.front();
+        // When asked to wait, we only wait for the oldest frame. The flush guarantees that its
+        // fence eventually signals.
+        const GLenum status = (wait && !retired) ?
+                glClientWaitSync(region.fence, GL_SYNC_FLUSH_COMMANDS_BIT, WAIT_TIMEOUT_NS) :
+                glClientWaitSync(region.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            break;
+        }
+        glDeleteSync(region.fence);
+        mTail = region.end;
+        mRegions.pop_front();
+        retired = true;
+    }
+    return retired;
+}
+
+void OpenGLStreamBuffer::endFrame() noexcept {
+    if (!mOpen) {
+        return;
+    }
+    mRegions.push_back({ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), mHead });
+    mOpen = false;
+}
+
+} // namespace filament::backend
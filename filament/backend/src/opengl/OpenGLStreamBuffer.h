@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TNT_FILAMENT_BACKEND_OPENGL_STREAMBUFFER_H
+#define TNT_FILAMENT_BACKEND_OPENGL_STREAMBUFFER_H
+
+#include "gl_headers.h"
+
+#include <deque>
+
+#include <stdint.h>
+
+namespace filament::backend {
+
+class OpenGLContext;
+
+/*
+ * A ring of uniform buffer memory backing the buffer objects created with BufferUsage::STREAM.
+ *
+ * Every update of a streaming buffer object is written to a fresh range of the ring, so the
+ * driver never has to wait for, or orphan, a buffer that the GPU might still be reading. When
+ * GL_ARB_buffer_storage is available the ring is persistently mapped and an update is a plain
+ * memcpy, otherwise each update maps its own range with GL_MAP_UNSYNCHRONIZED_BIT.
+ *
+ * The ring is split into regions that are fenced once per frame, and a region is only reused once
+ * its fence has signaled.
+ */
+class OpenGLStreamBuffer {
+public:
+    // Enough for about three frames of per-view uniforms with many views.
+    static constexpr uint32_t CAPACITY = 2 * 1024 * 1024;
+
+    explicit OpenGLStreamBuffer(OpenGLContext& context) noexcept;
+    ~OpenGLStreamBuffer() noexcept;
+
+    OpenGLStreamBuffer(OpenGLStreamBuffer const&) = delete;
+    OpenGLStreamBuffer& operator=(OpenGLStreamBuffer const&) = delete;
+
+    // Destroys the GL objects, this must be called with the GL context current.
+    void terminate() noexcept;
+
+    // Copies the given data into the ring and returns its offset in the ring. Returns false if the
+    // data doesn't fit, in which case the caller must fall back to updating its own buffer.
+    bool write(void const* data, uint32_t size, uint32_t* offset) noexcept;
+
+    // Fences the writes made since the previous call. This is called once per frame.
+    void endFrame() noexcept;
+
+    GLuint getId() const noexcept { return mId; }
+
+private:
+    struct Region {
+        GLsync fence;
+        uint32_t end;
+    };
+
+    bool allocate(uint32_t size, uint32_t* offset) noexcept;
+    bool retireRegions(bool wait) noexcept;
+
+    // How long to wait for a frame before giving up and falling back to glBufferSubData.
+    static constexpr GLuint64 WAIT_TIMEOUT_NS = 100'000'000;
+
+    OpenGLContext& mContext;
+    GLuint mId = 0;
+    uint8_t* mMapped = nullptr;     // only set when the ring is persistently mapped
+    uint32_t mHead = 0;             // where the next write goes
+    uint32_t mTail = 0;             // start of the oldest region still in use by the GPU
+    bool mOpen = false;             // whether there were writes since the last endFrame()
+    std::deque<Region> mRegions;
+};
+
+} // namespace filament::backend
+
+#endif // TNT_FILAMENT_BACKEND_OPENGL_STREAMBUFFER_H
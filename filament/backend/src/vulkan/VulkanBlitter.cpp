@@ -311,6 +311,7 @@ void VulkanBlitter::blitSlowDepth(VkImageAspectFlags aspect, VkFilter filter,
     renderPassInfo.clearValueCount = 1;
     renderPassInfo.pClearValues = clearValues;
 
+    mStagePool.flushUploads();
     const VkCommandBuffer cmdbuffer = mContext.commands->get().cmdbuffer;
     vkCmdBeginRenderPass(cmdbuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
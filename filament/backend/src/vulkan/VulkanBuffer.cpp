@@ -54,63 +54,31 @@ void VulkanBuffer::terminate(VulkanContext& context) {
 
 void VulkanBuffer::loadFromCpu(VulkanContext& context, VulkanStagePool& stagePool,
         const void* cpuData, uint32_t byteOffset, uint32_t numBytes) const {
-    assert_invariant(byteOffset == 0);
-    VulkanStage const* stage = stagePool.acquireStage(numBytes);
-    void* mapped;
-    vmaMapMemory(context.allocator, stage->memory, &mapped);
-    memcpy(mapped, cpuData, numBytes);
-    vmaUnmapMemory(context.allocator, stage->memory);
-    vmaFlushAllocation(context.allocator, stage->memory, byteOffset, numBytes);
-
-    const VkCommandBuffer cmdbuffer = context.commands->get().cmdbuffer;
-
-    VkBufferCopy region{ .size = numBytes };
-    vkCmdCopyBuffer(cmdbuffer, stage->buffer, mGpuBuffer, 1, &region);
-
-    // Firstly, ensure that the copy finishes before the next draw call.
-    // Secondly, in case the user decides to upload another chunk (without ever using the first one)
-    // we need to ensure that this upload completes first.
-
-    if (mUsage & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT) {
-
-        VkBufferMemoryBarrier barrier{
-                .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
-                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-                .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT |
-                                 VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT,
-                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .buffer = mGpuBuffer,
-                .size = VK_WHOLE_SIZE
-        };
-
-        vkCmdPipelineBarrier(cmdbuffer,
-                VK_PIPELINE_STAGE_TRANSFER_BIT,
-                VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
-                0, 0, nullptr, 1, &barrier, 0, nullptr);
-
+    VulkanStageSlice const slice = stagePool.acquireSlice(numBytes, 4);
+    memcpy(slice.mapped, cpuData, numBytes);
+    vmaFlushAllocation(context.allocator, slice.memory, slice.offset, numBytes);
+
+    // The copy is batched with other uploads and recorded before the next render pass. The batch
+    // ends with a barrier that ensures the copy finishes before the next draw call, and also
+    // before any other upload into this buffer.
+    VkPipelineStageFlags dstStageMask = 0;
+    VkAccessFlags dstAccessMask = 0;
+
+    if (mUsage & (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT)) {
+        dstStageMask = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+        dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
     }
 
     if (mUsage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) {
         // NOTE: ideally dstStageMask would include VERTEX_SHADER_BIT | FRAGMENT_SHADER_BIT, but this
         // seems to be insufficient on Mali devices. To work around this we are using a more
         // aggressive ALL_GRAPHICS_BIT barrier.
-
-        VkBufferMemoryBarrier barrier{
-                .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
-                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-                .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_UNIFORM_READ_BIT,
-                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                .buffer = mGpuBuffer,
-                .size = VK_WHOLE_SIZE
-        };
-
-        vkCmdPipelineBarrier(cmdbuffer,
-                VK_PIPELINE_STAGE_TRANSFER_BIT,
-                VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT,
-                0, 0, nullptr, 1, &barrier, 0, nullptr);
+        dstStageMask = VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT;
+        dstAccessMask = VK_ACCESS_UNIFORM_READ_BIT;
     }
+
+    stagePool.enqueueBufferCopy(slice, mGpuBuffer, byteOffset, numBytes, dstStageMask,
+            dstAccessMask);
 }
 
 } // namespace filament::backend
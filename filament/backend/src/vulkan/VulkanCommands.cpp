@@ -162,12 +162,14 @@ bool VulkanCommands::flush() {
     // here and use VK_PIPELINE_STAGE_ALL_COMMANDS_BIT. This is a more aggressive stall, but it is
     // the only safe option because the previously submitted command buffer might have set up some
     // state that the new command buffer depends on.
-    VkPipelineStageFlags waitDestStageMasks[2] = {
+    VkPipelineStageFlags waitDestStageMasks[1 + MAX_INJECTED_SIGNALS] = {
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
     };
 
-    VkSemaphore signals[2] = {
+    VkSemaphore signals[1 + MAX_INJECTED_SIGNALS] = {
+        VK_NULL_HANDLE,
         VK_NULL_HANDLE,
         VK_NULL_HANDLE,
     };
@@ -187,13 +189,13 @@ bool VulkanCommands::flush() {
         signals[submitInfo.waitSemaphoreCount++] = mSubmissionSignal;
     }
 
-    if (mInjectedSignal) {
-        signals[submitInfo.waitSemaphoreCount++] = mInjectedSignal;
+    for (uint32_t i = 0; i < mInjectedCount; i++) {
+        signals[submitInfo.waitSemaphoreCount++] = mInjectedSignals[i];
     }
 
     if (FILAMENT_VULKAN_VERBOSE) {
         slog.i << "Submitting cmdbuffer=" << mCurrent->cmdbuffer
-            << " wait=(" << signals[0] << ", " << signals[1] << ") "
+            << " wait=(" << signals[0] << ", " << signals[1] << ", " << signals[2] << ") "
             << " signal=" << renderingFinished
             << io::endl;
     }
@@ -208,7 +210,7 @@ bool VulkanCommands::flush() {
     assert_invariant(result == VK_SUCCESS);
 
     mSubmissionSignal = renderingFinished;
-    mInjectedSignal = VK_NULL_HANDLE;
+    mInjectedCount = 0;
     mCurrent = nullptr;
     return true;
 }
@@ -223,10 +225,11 @@ VkSemaphore VulkanCommands::acquireFinishedSignal() {
 }
 
 void VulkanCommands::injectDependency(VkSemaphore next) {
-    assert_invariant(mInjectedSignal == VK_NULL_HANDLE);
-    mInjectedSignal = next;
+    assert_invariant(mInjectedCount < MAX_INJECTED_SIGNALS);
+    mInjectedSignals[mInjectedCount++] = next;
     if (FILAMENT_VULKAN_VERBOSE) {
-        slog.i << "Injecting " << next << " (e.g. due to vkAcquireNextImageKHR)" << io::endl;
+        slog.i << "Injecting " << next << " (e.g. due to vkAcquireNextImageKHR or uploads)"
+                << io::endl;
     }
 }
 
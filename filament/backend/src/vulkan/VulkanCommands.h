@@ -69,9 +69,10 @@ public:
 // - Notifies listeners when recording begins in a new VkCommandBuffer.
 //    - Used by PipelineCache so that it knows when to clear out its shadow state.
 //
-// - Allows 1 user to inject a "dependency" semaphore that stalls the next flush.
+// - Allows up to 2 users to inject a "dependency" semaphore that stalls the next flush.
 //    - This is used for asynchronous acquisition of a swap chain image, since the GPU
 //      might require a valid swap chain image when it starts executing the command buffer.
+//    - This is also used to wait for uploads that were submitted to the transfer queue.
 //
 // - Allows 1 user to listen to the most recent flush event using a "finished" VkSemaphore.
 //    - This is used to trigger presentation of the swap chain image.
@@ -98,8 +99,9 @@ class VulkanCommands {
         // vkQueuePresentKHR.
         VkSemaphore acquireFinishedSignal();
 
-        // Takes a semaphore that signals when the next flush can occur. Only one injected
-        // semaphore is allowed per flush. Useful after calling vkAcquireNextImageKHR.
+        // Takes a semaphore that signals when the next flush can occur. At most two injected
+        // semaphores are allowed per flush. Useful after calling vkAcquireNextImageKHR, or after
+        // submitting uploads to another queue.
         void injectDependency(VkSemaphore next);
 
         // Destroys all command buffers that are no longer in use.
@@ -117,12 +119,14 @@ class VulkanCommands {
 
     private:
         static constexpr int CAPACITY = VK_MAX_COMMAND_BUFFERS;
+        static constexpr uint32_t MAX_INJECTED_SIGNALS = 2;
         const VkDevice mDevice;
         const VkQueue mQueue;
         const VkCommandPool mPool;
         VulkanCommandBuffer* mCurrent = nullptr;
         VkSemaphore mSubmissionSignal = {};
-        VkSemaphore mInjectedSignal = {};
+        VkSemaphore mInjectedSignals[MAX_INJECTED_SIGNALS] = {};
+        uint32_t mInjectedCount = 0;
         VulkanCommandBuffer mStorage[CAPACITY] = {};
         VkSemaphore mSubmissionSignals[CAPACITY] = {};
         size_t mAvailableCount = CAPACITY;
@@ -26,6 +26,19 @@
 #define FILAMENT_VULKAN_HANDLE_ARENA_SIZE_IN_MB 8
 #endif
 
+// When enabled, uploads that fill entire texture subresources are recorded into a separate command
+// buffer, which is submitted to a dedicated transfer queue if the device exposes one. This lets
+// streaming uploads overlap with rendering. This is off by default until it has seen more testing.
+#ifndef FILAMENT_VULKAN_ASYNC_UPLOADS
+#define FILAMENT_VULKAN_ASYNC_UPLOADS 0
+#endif
+
+// When enabled, the contents of render passes without subpasses are recorded into secondary
+// command buffers, and large draw lists are split across worker threads. See VulkanParallelRecorder.
+#ifndef FILAMENT_VULKAN_PARALLEL_RECORDING
+#define FILAMENT_VULKAN_PARALLEL_RECORDING 0
+#endif
+
 // In debug builds, we enable validation layers and set up a debug callback.
 //
 // To enable validation layers in Android, also be sure to set the jniLibs property in the gradle
@@ -79,4 +92,8 @@ constexpr static const int VK_MAX_PIPELINE_AGE = 10;
 // destroying any unused pipeline object.
 static_assert(VK_MAX_PIPELINE_AGE >= VK_MAX_COMMAND_BUFFERS);
 
+// Capacity of the persistently mapped ring buffer that VulkanStagePool uses to sub-allocate
+// uploads. Uploads that are larger than a quarter of the ring get a dedicated stage instead.
+constexpr static const uint32_t VK_STAGING_RING_SIZE = 4 * 1024 * 1024;
+
 #endif
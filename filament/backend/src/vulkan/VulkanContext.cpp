@@ -183,7 +183,7 @@ void VulkanContext::selectPhysicalDevice() {
 }
 
 void VulkanContext::createLogicalDevice() {
-    VkDeviceQueueCreateInfo deviceQueueCreateInfo[1] = {};
+    VkDeviceQueueCreateInfo deviceQueueCreateInfo[2] = {};
     const float queuePriority[] = {1.0f};
     VkDeviceCreateInfo deviceCreateInfo = {};
     FixedCapacityVector<const char*> deviceExtensionNames;
@@ -204,14 +204,39 @@ void VulkanContext::createLogicalDevice() {
     if (maintenanceSupported[2]) {
         deviceExtensionNames.push_back(VK_KHR_MAINTENANCE3_EXTENSION_NAME);
     }
-    deviceQueueCreateInfo->sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-    deviceQueueCreateInfo->queueFamilyIndex = graphicsQueueFamilyIndex;
-    deviceQueueCreateInfo->queueCount = 1;
-    deviceQueueCreateInfo->pQueuePriorities = &queuePriority[0];
+    deviceQueueCreateInfo[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    deviceQueueCreateInfo[0].queueFamilyIndex = graphicsQueueFamilyIndex;
+    deviceQueueCreateInfo[0].queueCount = 1;
+    deviceQueueCreateInfo[0].pQueuePriorities = &queuePriority[0];
     deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     deviceCreateInfo.queueCreateInfoCount = 1;
     deviceCreateInfo.pQueueCreateInfos = deviceQueueCreateInfo;
 
+    // Look for a queue family that supports transfers but not graphics or compute. These typically
+    // map to a DMA engine that can upload textures while the graphics queue is busy. Its image
+    // transfer granularity is irrelevant because we only use it for whole subresources.
+    transferQueueFamilyIndex = graphicsQueueFamilyIndex;
+#if FILAMENT_VULKAN_ASYNC_UPLOADS
+    uint32_t queueFamiliesCount;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamiliesCount, nullptr);
+    FixedCapacityVector<VkQueueFamilyProperties> queueFamiliesProperties(queueFamiliesCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamiliesCount,
+            queueFamiliesProperties.data());
+    for (uint32_t j = 0; j < queueFamiliesCount; ++j) {
+        const VkQueueFlags flags = queueFamiliesProperties[j].queueFlags;
+        if (queueFamiliesProperties[j].queueCount > 0 && (flags & VK_QUEUE_TRANSFER_BIT) &&
+                !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+            transferQueueFamilyIndex = j;
+            deviceQueueCreateInfo[1].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+            deviceQueueCreateInfo[1].queueFamilyIndex = transferQueueFamilyIndex;
+            deviceQueueCreateInfo[1].queueCount = 1;
+            deviceQueueCreateInfo[1].pQueuePriorities = &queuePriority[0];
+            deviceCreateInfo.queueCreateInfoCount = 2;
+            break;
+        }
+    }
+#endif
+
     // We could simply enable all supported features, but since that may have performance
     // consequences let's just enable the features we need.
     const auto& supportedFeatures = physicalDeviceFeatures;
@@ -294,6 +319,11 @@ void VulkanContext::createLogicalDevice() {
     };
     vmaCreateAllocator(&allocatorInfo, &allocator);
     commands = new VulkanCommands(device, graphicsQueueFamilyIndex);
+#if FILAMENT_VULKAN_ASYNC_UPLOADS
+    // Without a dedicated transfer queue, uploads still get their own command buffer, which is
+    // submitted to the graphics queue ahead of the rendering commands.
+    transferCommands = new VulkanCommands(device, transferQueueFamilyIndex);
+#endif
 }
 
 uint32_t VulkanContext::selectMemoryType(uint32_t flags, VkFlags reqs) {
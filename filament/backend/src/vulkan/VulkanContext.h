@@ -79,6 +79,7 @@ struct VulkanContext {
     VulkanTimestamps timestamps;
     uint32_t graphicsQueueFamilyIndex;
     VkQueue graphicsQueue;
+    uint32_t transferQueueFamilyIndex;
     bool debugMarkersSupported = false;
     bool debugUtilsSupported = false;
     bool portabilitySubsetSupported = false;
@@ -93,6 +94,7 @@ struct VulkanContext {
     VmaAllocator allocator;
     VulkanTexture* emptyTexture = nullptr;
     VulkanCommands* commands = nullptr;
+    VulkanCommands* transferCommands = nullptr;
     std::string currentDebugMarker;
 };
 
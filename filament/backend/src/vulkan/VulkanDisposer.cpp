@@ -15,83 +15,131 @@
  */
 
 #include "VulkanDisposer.h"
-#include "VulkanConstants.h"
 
 #include <utils/debug.h>
 #include <utils/Log.h>
 
 namespace filament::backend {
 
-// Always wait at least 3 frames after a DriverAPI-level resource has been destroyed for safe
-// destruction, due to potential usage by outstanding command buffers and triple buffering.
-static constexpr uint32_t FRAMES_BEFORE_EVICTION = VK_MAX_COMMAND_BUFFERS;
+VulkanDisposer::VulkanDisposer(Destructor destructor, void* user) noexcept
+        : mDestructor(destructor), mUser(user) {
+}
+
+void VulkanDisposer::List::insert(VulkanResource* resource) noexcept {
+    resource->prev = nullptr;
+    resource->next = head;
+    if (head) {
+        head->prev = resource;
+    }
+    head = resource;
+}
 
-void VulkanDisposer::createDisposable(Key resource, std::function<void()> destructor) noexcept {
-    mDisposables[resource].destructor = destructor;
+void VulkanDisposer::List::remove(VulkanResource* resource) noexcept {
+    if (resource->prev) {
+        resource->prev->next = resource->next;
+    } else {
+        assert_invariant(head == resource);
+        head = resource->next;
+    }
+    if (resource->next) {
+        resource->next->prev = resource->prev;
+    }
+    resource->prev = resource->next = nullptr;
 }
 
-void VulkanDisposer::removeReference(Key resource) noexcept {
+void VulkanDisposer::createDisposable(VulkanResource* resource, VulkanResourceType type,
+        HandleBase::HandleId id) noexcept {
+    assert_invariant(type != VulkanResourceType::UNMANAGED);
+    resource->handleId = id;
+    resource->acquiredFrame = 0;
+    resource->refcount = 1;
+    resource->resourceType = type;
+    mAlive[size_t(type)].insert(resource);
+}
+
+void VulkanDisposer::removeReference(VulkanResource* resource) noexcept {
     // Null can be passed in as a no-op, this is not an error.
     if (resource == nullptr) {
         return;
     }
-    assert_invariant(mDisposables[resource].refcount > 0);
-    --mDisposables[resource].refcount;
+    assert_invariant(resource->resourceType != VulkanResourceType::UNMANAGED);
+    release(resource);
+}
+
+void VulkanDisposer::release(VulkanResource* resource) noexcept {
+    assert_invariant(resource->refcount > 0);
+    if (--resource->refcount == 0) {
+        const size_t type = size_t(resource->resourceType);
+        mAlive[type].remove(resource);
+        mDead[type].insert(resource);
+    }
 }
 
-void VulkanDisposer::acquire(Key resource) noexcept {
+void VulkanDisposer::acquire(VulkanResource* resource) noexcept {
     // It's fine to "acquire" a non-managed resource, it's just a no-op.
-    if (resource == nullptr) {
+    if (resource == nullptr || resource->resourceType == VulkanResourceType::UNMANAGED) {
         return;
     }
-    auto iter = mDisposables.find(resource);
-    if (iter == mDisposables.end()) {
+    assert_invariant(resource->refcount > 0 && resource->refcount < 65535);
+
+    // If an auto-decrement is already in place, do not increase the ref count, only postpone it.
+    // The entry left in the queue of the previous frame is skipped when that queue expires.
+    if (resource->acquiredFrame == mFrame) {
         return;
     }
-    Disposable& disposable = iter.value();
-    assert_invariant(disposable.refcount > 0 && disposable.refcount < 65535);
-
-    // If an auto-decrement is already in place, do not increase the ref count.
-    if (disposable.remainingFrames == 0) {
-        ++disposable.refcount;
+    if (resource->acquiredFrame == 0) {
+        ++resource->refcount;
     }
-
-    disposable.remainingFrames = FRAMES_BEFORE_EVICTION;
+    resource->acquiredFrame = mFrame;
+    mAcquired[mFrame % FRAMES_BEFORE_EVICTION].push_back(resource);
 }
 
 void VulkanDisposer::gc() noexcept {
-    // First decrement the frame count of all resources that were held by a command buffer.
-    // If any of these reaches zero, decrement its reference count.
-    for (auto iter = mDisposables.begin(); iter != mDisposables.end(); ++iter) {
-        Disposable& disposable = iter.value();
-        if (disposable.refcount > 0 && disposable.remainingFrames > 0) {
-            if (--disposable.remainingFrames == 0) {
-                removeReference(iter.key());
-            }
+    // Release the references held on behalf of the command buffers of FRAMES_BEFORE_EVICTION
+    // frames ago, unless the resource has been acquired again since then. Resources are only
+    // destroyed below, so the stale entries of a resource never outlive it.
+    const uint32_t expiredFrame = mFrame + 1 - FRAMES_BEFORE_EVICTION;
+    std::vector<VulkanResource*>& expired = mAcquired[(mFrame + 1) % FRAMES_BEFORE_EVICTION];
+    for (VulkanResource* resource : expired) {
+        if (resource->acquiredFrame == expiredFrame) {
+            resource->acquiredFrame = 0;
+            release(resource);
         }
     }
+    expired.clear();
+    mFrame++;
 
-    // Next, destroy all resources with a zero refcount.
-    decltype(mDisposables) disposables;
-    for (auto iter : mDisposables) {
-        Disposable& disposable = iter.second;
-        if (disposable.refcount == 0) {
-            disposable.destructor();
-        } else {
-            disposables.insert({iter.first, disposable});
-        }
+    // Next, destroy all resources with a zero refcount, one type at a time.
+    for (size_t type = 0; type < TYPE_COUNT; type++) {
+        destroyAll(mDead[type], VulkanResourceType(type));
+    }
+}
+
+void VulkanDisposer::destroyAll(List& list, VulkanResourceType type) noexcept {
+    while (VulkanResource* resource = list.head) {
+        list.remove(resource);
+        resource->resourceType = VulkanResourceType::UNMANAGED;
+        mDestructor(mUser, type, resource->handleId);
     }
-    disposables.swap(mDisposables);
 }
 
 void VulkanDisposer::reset() noexcept {
 #ifndef NDEBUG
-    utils::slog.i << mDisposables.size() << " disposables are outstanding." << utils::io::endl;
+    size_t outstanding = 0;
+    for (size_t type = 0; type < TYPE_COUNT; type++) {
+        for (VulkanResource const* r = mAlive[type].head; r; r = r->next) {
+            outstanding++;
+        }
+    }
+    utils::slog.i << outstanding << " disposables are outstanding." << utils::io::endl;
 #endif
-    for (auto iter : mDisposables) {
-        iter.second.destructor();
+    for (auto& acquired : mAcquired) {
+        acquired.clear();
+    }
+    for (size_t type = 0; type < TYPE_COUNT; type++) {
+        destroyAll(mDead[type], VulkanResourceType(type));
+        destroyAll(mAlive[type], VulkanResourceType(type));
     }
-    mDisposables.clear();
 }
 
 } // namespace filament::backend
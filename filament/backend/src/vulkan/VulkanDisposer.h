@@ -17,42 +17,96 @@
 #ifndef TNT_FILAMENT_BACKEND_VULKANDISPOSER_H
 #define TNT_FILAMENT_BACKEND_VULKANDISPOSER_H
 
-#include <tsl/robin_map.h>
+#include "VulkanConstants.h"
 
-#include <functional>
+#include <backend/Handle.h>
+
+#include <array>
+#include <stdint.h>
+#include <vector>
 
 namespace filament::backend {
 
+// Types of driver objects whose destruction is managed by VulkanDisposer.
+enum class VulkanResourceType : uint8_t {
+    UNMANAGED,      // e.g. swap chain images or the empty texture, never destroyed by the disposer
+    BUFFER_OBJECT,
+    INDEX_BUFFER,
+    PROGRAM,
+    RENDER_TARGET,
+    TEXTURE,
+    TIMER_QUERY,
+    VERTEX_BUFFER,
+};
+
+// Bookkeeping for deferred destruction, embedded in every driver object that is managed by
+// VulkanDisposer. Since driver objects live in the handle arena, tracking a resource never
+// allocates.
+struct VulkanResource {
+    VulkanResource* prev = nullptr;
+    VulkanResource* next = nullptr;
+    HandleBase::HandleId handleId = HandleBase::nullid;
+    uint32_t acquiredFrame = 0;     // frame of the last acquire() or 0 if not held by a command buffer
+    uint16_t refcount = 0;
+    VulkanResourceType resourceType = VulkanResourceType::UNMANAGED;
+};
+
 // VulkanDisposer tracks resources (such as textures or vertex buffers) that need deferred
-// destruction due to potential use by a Vulkan command buffer. Resources are represented with void*
-// to allow callers to use any type of handle.
+// destruction due to potential use by a Vulkan command buffer.
+//
+// Each resource type has an intrusive list of live resources and an intrusive list of resources
+// whose reference count dropped to zero, which are destroyed at the next gc(). References held by
+// command buffers are recorded in a ring of per-frame queues and released FRAMES_BEFORE_EVICTION
+// frames later, so gc() only visits the resources that were actually acquired or released.
 class VulkanDisposer {
 public:
-    using Key = const void*;
+    using Destructor = void(*)(void* user, VulkanResourceType type, HandleBase::HandleId id);
+
+    // Always wait at least 3 frames after a DriverAPI-level resource has been destroyed for safe
+    // destruction, due to potential usage by outstanding command buffers and triple buffering.
+    static constexpr uint32_t FRAMES_BEFORE_EVICTION = VK_MAX_COMMAND_BUFFERS;
 
-    // Adds the given resource to the disposer and sets its reference count to 1.
-    void createDisposable(Key resource, std::function<void()> destructor) noexcept;
+    // The destructor is called from gc() and reset() for each resource that needs to be destroyed.
+    VulkanDisposer(Destructor destructor, void* user) noexcept;
+
+    VulkanDisposer(VulkanDisposer const&) = delete;
+    VulkanDisposer& operator=(VulkanDisposer const&) = delete;
+
+    // Starts tracking the given resource and sets its reference count to 1.
+    void createDisposable(VulkanResource* resource, VulkanResourceType type,
+            HandleBase::HandleId id) noexcept;
 
     // Decrements the reference count.
-    void removeReference(Key resource) noexcept;
+    void removeReference(VulkanResource* resource) noexcept;
 
     // Increments the reference count and auto-decrements it after FRAMES_BEFORE_EVICTION frames.
     // This is used to indicate that the current command buffer has a reference to the resource.
-    void acquire(Key resource) noexcept;
+    void acquire(VulkanResource* resource) noexcept;
 
-    // Invokes the destructor function for each disposable with a 0 refcount.
+    // Releases the references that have expired and destroys each resource with a 0 refcount.
     void gc() noexcept;
 
-    // Invokes the destructor function for all disposables, regardless of reference count.
+    // Destroys all resources, regardless of reference count.
     void reset() noexcept;
 
 private:
-    struct Disposable {
-        uint16_t refcount = 1;
-        uint16_t remainingFrames = 0;
-        std::function<void()> destructor = []() {};
+    static constexpr size_t TYPE_COUNT = size_t(VulkanResourceType::VERTEX_BUFFER) + 1;
+
+    struct List {
+        VulkanResource* head = nullptr;
+        void insert(VulkanResource* resource) noexcept;
+        void remove(VulkanResource* resource) noexcept;
     };
-    tsl::robin_map<Key, Disposable> mDisposables;
+
+    void release(VulkanResource* resource) noexcept;
+    void destroyAll(List& list, VulkanResourceType type) noexcept;
+
+    Destructor const mDestructor;
+    void* const mUser;
+    uint32_t mFrame = 1;
+    std::array<List, TYPE_COUNT> mAlive;
+    std::array<List, TYPE_COUNT> mDead;
+    std::array<std::vector<VulkanResource*>, FRAMES_BEFORE_EVICTION> mAcquired;
 };
 
 } // namespace filament::backend
@@ -98,6 +98,9 @@ VulkanDriver::VulkanDriver(VulkanPlatform* platform,
         const Platform::DriverConfig& driverConfig) noexcept :
         mHandleAllocator("Handles", driverConfig.handleArenaSize),
         mContextManager(*platform),
+        mDisposer([](void* user, VulkanResourceType type, HandleBase::HandleId id) {
+            static_cast<VulkanDriver*>(user)->destroyResource(type, id);
+        }, this),
         mStagePool(mContext),
         mFramebufferCache(mContext),
         mSamplerCache(mContext),
@@ -281,6 +284,10 @@ VulkanDriver::VulkanDriver(VulkanPlatform* platform,
     mContext.createEmptyTexture(mStagePool);
 
     mContext.commands->setObserver(&mPipelineCache);
+
+#if FILAMENT_VULKAN_PARALLEL_RECORDING
+    mParallelRecorder.initialize(mContext.device, mContext.graphicsQueueFamilyIndex);
+#endif
     mPipelineCache.setDevice(mContext.device, mContext.allocator);
     mPipelineCache.setDummyTexture(mContext.emptyTexture->getPrimaryImageView());
 
@@ -337,7 +344,11 @@ void VulkanDriver::terminate() {
         return;
     }
 
+    delete mContext.transferCommands;
     delete mContext.commands;
+
+    // Deleting the command buffer manager waited for the device, so secondaries can be freed.
+    mParallelRecorder.terminate();
     delete mContext.emptyTexture;
 
     mBlitter.shutdown();
@@ -367,8 +378,40 @@ void VulkanDriver::terminate() {
     mContext.instance = nullptr;
 }
 
+void VulkanDriver::destroyResource(VulkanResourceType type, HandleBase::HandleId id) noexcept {
+    switch (type) {
+        case VulkanResourceType::BUFFER_OBJECT:
+            destruct<VulkanBufferObject>(mContext, Handle<HwBufferObject>(id));
+            break;
+        case VulkanResourceType::INDEX_BUFFER:
+            destruct<VulkanIndexBuffer>(mContext, Handle<HwIndexBuffer>(id));
+            break;
+        case VulkanResourceType::PROGRAM:
+            destruct<VulkanProgram>(Handle<HwProgram>(id));
+            break;
+        case VulkanResourceType::RENDER_TARGET:
+            destruct<VulkanRenderTarget>(Handle<HwRenderTarget>(id));
+            break;
+        case VulkanResourceType::TEXTURE:
+            destruct<VulkanTexture>(Handle<HwTexture>(id));
+            break;
+        case VulkanResourceType::TIMER_QUERY:
+            destruct<VulkanTimerQuery>(Handle<HwTimerQuery>(id));
+            break;
+        case VulkanResourceType::VERTEX_BUFFER:
+            destruct<VulkanVertexBuffer>(Handle<HwVertexBuffer>(id));
+            break;
+        case VulkanResourceType::UNMANAGED:
+            assert_invariant(false);
+            break;
+    }
+}
+
 void VulkanDriver::tick(int) {
     mContext.commands->updateFences();
+    if (mContext.transferCommands) {
+        mContext.transferCommands->updateFences();
+    }
 }
 
 // Garbage collection should not occur too frequently, only about once per frame. Internally, the
@@ -380,6 +423,20 @@ void VulkanDriver::collectGarbage() {
     mFramebufferCache.gc();
     mDisposer.gc();
     mContext.commands->gc();
+    if (mContext.transferCommands) {
+        mContext.transferCommands->gc();
+    }
+}
+
+// Records pending uploads and submits the current command buffer. Uploads that were recorded into
+// the transfer command buffer are submitted first, and the rendering commands wait on them.
+bool VulkanDriver::flushCommands() {
+    mStagePool.flushUploads();
+    VulkanCommands* const transfer = mContext.transferCommands;
+    if (transfer && transfer->flush()) {
+        mContext.commands->injectDependency(transfer->acquireFinishedSignal());
+    }
+    return mContext.commands->flush();
 }
 
 void VulkanDriver::beginFrame(int64_t monotonic_clock_ns, uint32_t frameId) {
@@ -400,17 +457,17 @@ void VulkanDriver::setPresentationTime(int64_t monotonic_clock_ns) {
 }
 
 void VulkanDriver::endFrame(uint32_t frameId) {
-    if (mContext.commands->flush()) {
+    if (flushCommands()) {
         collectGarbage();
     }
 }
 
 void VulkanDriver::flush(int) {
-    mContext.commands->flush();
+    flushCommands();
 }
 
 void VulkanDriver::finish(int dummy) {
-    mContext.commands->flush();
+    flushCommands();
 }
 
 void VulkanDriver::createSamplerGroupR(Handle<HwSamplerGroup> sbh, uint32_t count) {
@@ -436,9 +493,7 @@ void VulkanDriver::createVertexBufferR(Handle<HwVertexBuffer> vbh, uint8_t buffe
         uint8_t attributeCount, uint32_t elementCount, AttributeArray attributes) {
     auto vertexBuffer = construct<VulkanVertexBuffer>(vbh, mContext, mStagePool,
             bufferCount, attributeCount, elementCount, attributes);
-    mDisposer.createDisposable(vertexBuffer, [this, vbh] () {
-        destruct<VulkanVertexBuffer>(vbh);
-    });
+    mDisposer.createDisposable(vertexBuffer, VulkanResourceType::VERTEX_BUFFER, vbh.getId());
 }
 
 void VulkanDriver::destroyVertexBuffer(Handle<HwVertexBuffer> vbh) {
@@ -453,9 +508,7 @@ void VulkanDriver::createIndexBufferR(Handle<HwIndexBuffer> ibh,
     auto elementSize = (uint8_t) getElementTypeSize(elementType);
     auto indexBuffer = construct<VulkanIndexBuffer>(ibh, mContext, mStagePool,
             elementSize, indexCount);
-    mDisposer.createDisposable(indexBuffer, [this, ibh] () {
-        destruct<VulkanIndexBuffer>(mContext, ibh);
-    });
+    mDisposer.createDisposable(indexBuffer, VulkanResourceType::INDEX_BUFFER, ibh.getId());
 }
 
 void VulkanDriver::destroyIndexBuffer(Handle<HwIndexBuffer> ibh) {
@@ -469,9 +522,7 @@ void VulkanDriver::createBufferObjectR(Handle<HwBufferObject> boh,
         uint32_t byteCount, BufferObjectBinding bindingType, BufferUsage usage) {
     auto bufferObject = construct<VulkanBufferObject>(boh, mContext, mStagePool, byteCount,
             bindingType, usage);
-    mDisposer.createDisposable(bufferObject, [this, boh] () {
-       destruct<VulkanBufferObject>(mContext, boh);
-    });
+    mDisposer.createDisposable(bufferObject, VulkanResourceType::BUFFER_OBJECT, boh.getId());
 }
 
 void VulkanDriver::destroyBufferObject(Handle<HwBufferObject> boh) {
@@ -493,9 +544,7 @@ void VulkanDriver::createTextureR(Handle<HwTexture> th, SamplerType target, uint
         TextureUsage usage) {
     auto vktexture = construct<VulkanTexture>(th, mContext, target, levels,
             format, samples, w, h, depth, usage, mStagePool);
-    mDisposer.createDisposable(vktexture, [this, th] () {
-        destruct<VulkanTexture>(th);
-    });
+    mDisposer.createDisposable(vktexture, VulkanResourceType::TEXTURE, th.getId());
 }
 
 void VulkanDriver::createTextureSwizzledR(Handle<HwTexture> th, SamplerType target, uint8_t levels,
@@ -506,9 +555,7 @@ void VulkanDriver::createTextureSwizzledR(Handle<HwTexture> th, SamplerType targ
     const VkComponentMapping swizzleMap = getSwizzleMap(swizzleArray);
     auto vktexture = construct<VulkanTexture>(th, mContext, target, levels,
             format, samples, w, h, depth, usage, mStagePool, swizzleMap);
-    mDisposer.createDisposable(vktexture, [this, th] () {
-        destruct<VulkanTexture>(th);
-    });
+    mDisposer.createDisposable(vktexture, VulkanResourceType::TEXTURE, th.getId());
 }
 
 void VulkanDriver::importTextureR(Handle<HwTexture> th, intptr_t id,
@@ -528,9 +575,7 @@ void VulkanDriver::destroyTexture(Handle<HwTexture> th) {
 
 void VulkanDriver::createProgramR(Handle<HwProgram> ph, Program&& program) {
     auto vkprogram = construct<VulkanProgram>(ph, mContext, program);
-    mDisposer.createDisposable(vkprogram, [this, ph] () {
-        destruct<VulkanProgram>(ph);
-    });
+    mDisposer.createDisposable(vkprogram, VulkanResourceType::PROGRAM, ph.getId());
 }
 
 void VulkanDriver::destroyProgram(Handle<HwProgram> ph) {
@@ -543,9 +588,7 @@ void VulkanDriver::createDefaultRenderTargetR(Handle<HwRenderTarget> rth, int) {
     assert_invariant(mContext.defaultRenderTarget == nullptr);
     VulkanRenderTarget* renderTarget = construct<VulkanRenderTarget>(rth);
     mContext.defaultRenderTarget = renderTarget;
-    mDisposer.createDisposable(renderTarget, [this, rth] () {
-        destruct<VulkanRenderTarget>(rth);
-    });
+    mDisposer.createDisposable(renderTarget, VulkanResourceType::RENDER_TARGET, rth.getId());
 }
 
 void VulkanDriver::createRenderTargetR(Handle<HwRenderTarget> rth,
@@ -603,9 +646,7 @@ void VulkanDriver::createRenderTargetR(Handle<HwRenderTarget> rth,
 
     auto renderTarget = construct<VulkanRenderTarget>(rth, mContext,
             width, height, samples, colorTargets, depthStencil, mStagePool);
-    mDisposer.createDisposable(renderTarget, [this, rth] () {
-        destruct<VulkanRenderTarget>(rth);
-    });
+    mDisposer.createDisposable(renderTarget, VulkanResourceType::RENDER_TARGET, rth.getId());
 }
 
 void VulkanDriver::destroyRenderTarget(Handle<HwRenderTarget> rth) {
@@ -712,9 +753,7 @@ Handle<HwTimerQuery> VulkanDriver::createTimerQueryS() noexcept {
     // before createTimerQueryR is executed.
     Handle<HwTimerQuery> tqh = initHandle<VulkanTimerQuery>(mContext);
     auto query = handle_cast<VulkanTimerQuery*>(tqh);
-    mDisposer.createDisposable(query, [this, tqh] () {
-        destruct<VulkanTimerQuery>(tqh);
-    });
+    mDisposer.createDisposable(query, VulkanResourceType::TIMER_QUERY, tqh.getId());
     return tqh;
 }
 
@@ -737,6 +776,7 @@ void VulkanDriver::destroySamplerGroup(Handle<HwSamplerGroup> sbh) {
 void VulkanDriver::destroySwapChain(Handle<HwSwapChain> sch) {
     if (sch) {
         VulkanSwapChain& swapChain = *handle_cast<VulkanSwapChain*>(sch);
+        flushCommands();
         swapChain.destroy();
 
         vkDestroySurfaceKHR(mContext.instance, swapChain.surface, VKALLOC);
@@ -896,6 +936,10 @@ FeatureLevel VulkanDriver::getFeatureLevel() {
             FeatureLevel::FEATURE_LEVEL_1;
 }
 
+StateCacheStats VulkanDriver::getStateCacheStats() {
+    return {};
+}
+
 math::float2 VulkanDriver::getClipSpaceParams() {
     // virtual and physical z-coordinate of clip-space is in [-w, 0]
     // Note: this is actually never used (see: main.vs), but it's a backend API, so we implement it
@@ -1082,6 +1126,9 @@ void VulkanDriver::beginRenderPass(Handle<HwRenderTarget> rth, const RenderPassP
         }
     }
 
+    // Uploads cannot be recorded inside a render pass, so this is the last chance to batch them.
+    mStagePool.flushUploads();
+
     const VkCommandBuffer cmdbuffer = mContext.commands->get().cmdbuffer;
     VulkanAttachment depth = rt->getSamples() == 1 ? rt->getDepth() : rt->getMsaaDepth();
 
@@ -1252,7 +1299,11 @@ void VulkanDriver::beginRenderPass(Handle<HwRenderTarget> rth, const RenderPassP
     }
     renderPassInfo.pClearValues = &clearValues[0];
 
-    vkCmdBeginRenderPass(cmdbuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    // Render passes with subpasses are always recorded inline, since secondary command buffers
+    // would need to be split at every vkCmdNextSubpass.
+    const bool useSecondaries = mParallelRecorder.isEnabled() && !params.subpassMask;
+    vkCmdBeginRenderPass(cmdbuffer, &renderPassInfo, useSecondaries ?
+            VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
 
     VkViewport viewport = mContext.viewport = {
         .x = (float) params.viewport.left,
@@ -1264,7 +1315,11 @@ void VulkanDriver::beginRenderPass(Handle<HwRenderTarget> rth, const RenderPassP
     };
 
     rt->transformClientRectToPlatform(&viewport);
-    vkCmdSetViewport(cmdbuffer, 0, 1, &viewport);
+    if (useSecondaries) {
+        mParallelRecorder.begin(renderPassInfo.renderPass, vkfb, viewport);
+    } else {
+        vkCmdSetViewport(cmdbuffer, 0, 1, &viewport);
+    }
 
     mContext.currentRenderPass = {
         .renderTarget = rt,
@@ -1275,9 +1330,21 @@ void VulkanDriver::beginRenderPass(Handle<HwRenderTarget> rth, const RenderPassP
 }
 
 void VulkanDriver::endRenderPass(int) {
-    VkCommandBuffer cmdbuffer = mContext.commands->get().cmdbuffer;
+    VulkanCommandBuffer const& commands = mContext.commands->get();
+    VkCommandBuffer cmdbuffer = commands.cmdbuffer;
+    if (mParallelRecorder.isRecording()) {
+        mParallelRecorder.end(commands);
+
+        // Executing secondary command buffers leaves the state of the primary one undefined.
+        mPipelineCache.invalidateBindings();
+    }
     vkCmdEndRenderPass(cmdbuffer);
 
+    // Markers that were popped during the render pass could not be recorded at the time.
+    for (; mDeferredMarkerPops > 0; mDeferredMarkerPops--) {
+        popGroupMarker(0);
+    }
+
     VulkanRenderTarget* rt = mContext.currentRenderPass.renderTarget;
     assert_invariant(rt);
 
@@ -1413,7 +1480,7 @@ void VulkanDriver::commit(Handle<HwSwapChain> sch) {
     // be done as part of the render pass because it does not know if it is last pass in the frame.
     swapChain.makePresentable();
 
-    if (mContext.commands->flush()) {
+    if (flushCommands()) {
         collectGarbage();
     }
 
@@ -1469,6 +1536,11 @@ void VulkanDriver::bindSamplers(uint32_t index, Handle<HwSamplerGroup> sbh) {
 }
 
 void VulkanDriver::insertEventMarker(char const* string, uint32_t len) {
+    // Only vkCmdExecuteCommands is allowed in a render pass whose contents are secondary command
+    // buffers, so markers cannot be recorded there.
+    if (mParallelRecorder.isRecording()) {
+        return;
+    }
     constexpr float MARKER_COLOR[] = { 0.0f, 1.0f, 0.0f, 1.0f };
     const VkCommandBuffer cmdbuffer = mContext.commands->get().cmdbuffer;
     if (mContext.debugUtilsSupported) {
@@ -1490,6 +1562,10 @@ void VulkanDriver::insertEventMarker(char const* string, uint32_t len) {
 void VulkanDriver::pushGroupMarker(char const* string, uint32_t len) {
     // TODO: Add group marker color to the Driver API
     constexpr float MARKER_COLOR[] = { 0.0f, 1.0f, 0.0f, 1.0f };
+    if (mParallelRecorder.isRecording()) {
+        mSkippedMarkerPushes++;
+        return;
+    }
     const VkCommandBuffer cmdbuffer = mContext.commands->get().cmdbuffer;
     if (mContext.debugUtilsSupported) {
         VkDebugUtilsLabelEXT labelInfo = {
@@ -1509,6 +1585,14 @@ void VulkanDriver::pushGroupMarker(char const* string, uint32_t len) {
 }
 
 void VulkanDriver::popGroupMarker(int) {
+    if (mSkippedMarkerPushes > 0) {
+        mSkippedMarkerPushes--;
+        return;
+    }
+    if (mParallelRecorder.isRecording()) {
+        mDeferredMarkerPops++;
+        return;
+    }
     const VkCommandBuffer cmdbuffer = mContext.commands->get().cmdbuffer;
     if (mContext.debugUtilsSupported) {
         vkCmdEndDebugUtilsLabelEXT(cmdbuffer);
@@ -1568,7 +1652,7 @@ void VulkanDriver::readPixels(Handle<HwRenderTarget> src, uint32_t x, uint32_t y
 
     // TODO: don't flush/wait here, this should be asynchronous
 
-    mContext.commands->flush();
+    flushCommands();
     mContext.commands->wait();
 
     // Transition the staging image layout.
@@ -1648,7 +1732,7 @@ void VulkanDriver::readPixels(Handle<HwRenderTarget> src, uint32_t x, uint32_t y
     // TODO: don't flush/wait here -- we should do this asynchronously
 
     // Flush and wait.
-    mContext.commands->flush();
+    flushCommands();
     mContext.commands->wait();
 
     VkImageSubresource subResource { .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT };
@@ -1668,10 +1752,9 @@ void VulkanDriver::readPixels(Handle<HwRenderTarget> src, uint32_t x, uint32_t y
 
     vkUnmapMemory(device, stagingMemory);
 
-    mDisposer.createDisposable((void*)stagingImage, [=] () {
-        vkDestroyImage(device, stagingImage, nullptr);
-        vkFreeMemory(device, stagingMemory, nullptr);
-    });
+    // We waited for the copy above, so the staging image can be destroyed right away.
+    vkDestroyImage(device, stagingImage, VKALLOC);
+    vkFreeMemory(device, stagingMemory, VKALLOC);
 
     scheduleDestroy(std::move(pbd));
 }
@@ -1871,13 +1954,6 @@ void VulkanDriver::draw(PipelineState pipelineState, Handle<HwRenderPrimitive> r
 
     mPipelineCache.bindSamplers(iInfo);
 
-    // Bind new descriptor sets if they need to change.
-    // If descriptor set allocation failed, skip the draw call and bail. No need to emit an error
-    // message since the validation layers already do so.
-    if (!mPipelineCache.bindDescriptors(cmdbuffer)) {
-        return;
-    }
-
     // Set scissoring.
     // Compute the intersection of the requested scissor rectangle with the current viewport.
     const int32_t x = std::max(viewportScissor.left, (int32_t)mContext.viewport.x);
@@ -1892,6 +1968,38 @@ void VulkanDriver::draw(PipelineState pipelineState, Handle<HwRenderPrimitive> r
     };
 
     rt->transformClientRectToPlatform(&scissor);
+
+    const uint32_t indexCount = prim.count;
+    const uint32_t firstIndex = prim.offset / prim.indexBuffer->elementSize;
+
+    // When the render pass is recorded into secondary command buffers, resolve the pipeline and
+    // descriptor sets now and defer the actual recording to the end of the render pass.
+    if (mParallelRecorder.isRecording()) {
+        VulkanDrawCall& drawCall = mParallelRecorder.draw();
+        if (!mPipelineCache.getDescriptors(&drawCall.pipelineLayout, drawCall.descriptorSets) ||
+                !mPipelineCache.getPipeline(&drawCall.pipeline)) {
+            mParallelRecorder.cancelDraw();
+            return;
+        }
+        drawCall.scissor = scissor;
+        drawCall.indexBuffer = prim.indexBuffer->buffer.getGpuBuffer();
+        drawCall.indexType = prim.indexBuffer->indexType;
+        drawCall.indexCount = indexCount;
+        drawCall.instanceCount = instanceCount;
+        drawCall.firstIndex = firstIndex;
+        drawCall.bufferCount = bufferCount;
+        std::copy_n(buffers, bufferCount, drawCall.buffers);
+        std::copy_n(offsets, bufferCount, drawCall.offsets);
+        return;
+    }
+
+    // Bind new descriptor sets if they need to change.
+    // If descriptor set allocation failed, skip the draw call and bail. No need to emit an error
+    // message since the validation layers already do so.
+    if (!mPipelineCache.bindDescriptors(cmdbuffer)) {
+        return;
+    }
+
     mPipelineCache.bindScissor(cmdbuffer, scissor);
 
     // Bind a new pipeline if the pipeline state changed.
@@ -1909,8 +2017,6 @@ void VulkanDriver::draw(PipelineState pipelineState, Handle<HwRenderPrimitive> r
             prim.indexBuffer->indexType);
 
     // Finally, make the actual draw call. TODO: support subranges
-    const uint32_t indexCount = prim.count;
-    const uint32_t firstIndex = prim.offset / prim.indexBuffer->elementSize;
     const int32_t vertexOffset = 0;
     const uint32_t firstInstId = 0;
     vkCmdDrawIndexed(cmdbuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstId);
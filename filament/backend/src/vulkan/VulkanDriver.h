@@ -23,6 +23,7 @@
 #include "VulkanConstants.h"
 #include "VulkanContext.h"
 #include "VulkanFboCache.h"
+#include "VulkanParallelRecorder.h"
 #include "VulkanSamplerCache.h"
 #include "VulkanStagePool.h"
 #include "VulkanUtility.h"
@@ -142,6 +143,8 @@ private:
 
     void refreshSwapChain();
     void collectGarbage();
+    bool flushCommands();
+    void destroyResource(VulkanResourceType type, HandleBase::HandleId id) noexcept;
 
     VulkanContext mContext = {};
     VulkanPipelineCache mPipelineCache;
@@ -150,6 +153,9 @@ private:
     VulkanFboCache mFramebufferCache;
     VulkanSamplerCache mSamplerCache;
     VulkanBlitter mBlitter;
+    VulkanParallelRecorder mParallelRecorder;
+    uint32_t mSkippedMarkerPushes = 0;
+    uint32_t mDeferredMarkerPops = 0;
     VulkanSamplerGroup* mSamplerBindings[VulkanPipelineCache::SAMPLER_BINDING_COUNT] = {};
     VkDebugReportCallbackEXT mDebugCallback = VK_NULL_HANDLE;
     VkDebugUtilsMessengerEXT mDebugMessenger = VK_NULL_HANDLE;
@@ -28,7 +28,7 @@
 
 namespace filament::backend {
 
-struct VulkanProgram : public HwProgram {
+struct VulkanProgram : public HwProgram, VulkanResource {
     VulkanProgram(VulkanContext& context, const Program& builder) noexcept;
     VulkanProgram(VulkanContext& context, VkShaderModule vs, VkShaderModule fs) noexcept;
     ~VulkanProgram();
@@ -45,7 +45,7 @@ struct VulkanProgram : public HwProgram {
 //
 // We use private inheritance to shield clients from the width / height fields in HwRenderTarget,
 // which are not representative when this is the default render target.
-struct VulkanRenderTarget : private HwRenderTarget {
+struct VulkanRenderTarget : private HwRenderTarget, public VulkanResource {
     // Creates an offscreen render target.
     VulkanRenderTarget(VulkanContext& context, uint32_t width, uint32_t height, uint8_t samples,
             VulkanAttachment color[MRT::MAX_SUPPORTED_RENDER_TARGET_COUNT], VulkanAttachment depthStencil[2],
@@ -76,14 +76,14 @@ private:
     uint8_t mSamples : 7;
 };
 
-struct VulkanVertexBuffer : public HwVertexBuffer {
+struct VulkanVertexBuffer : public HwVertexBuffer, VulkanResource {
     VulkanVertexBuffer(VulkanContext& context, VulkanStagePool& stagePool,
             uint8_t bufferCount, uint8_t attributeCount, uint32_t elementCount,
             AttributeArray const& attributes);
     utils::FixedCapacityVector<VulkanBuffer const*> buffers;
 };
 
-struct VulkanIndexBuffer : public HwIndexBuffer {
+struct VulkanIndexBuffer : public HwIndexBuffer, VulkanResource {
     VulkanIndexBuffer(VulkanContext& context, VulkanStagePool& stagePool,
             uint8_t elementSize, uint32_t indexCount) : HwIndexBuffer(elementSize, indexCount),
             buffer(context, stagePool,
@@ -94,7 +94,7 @@ struct VulkanIndexBuffer : public HwIndexBuffer {
     const VkIndexType indexType;
 };
 
-struct VulkanBufferObject : public HwBufferObject {
+struct VulkanBufferObject : public HwBufferObject, VulkanResource {
     VulkanBufferObject(VulkanContext& context, VulkanStagePool& stagePool,
             uint32_t byteCount, BufferObjectBinding bindingType, BufferUsage usage);
     void terminate(VulkanContext& context) { buffer.terminate(context); }
@@ -127,7 +127,7 @@ struct VulkanSync : public HwSync {
     std::shared_ptr<VulkanCmdFence> fence;
 };
 
-struct VulkanTimerQuery : public HwTimerQuery {
+struct VulkanTimerQuery : public HwTimerQuery, VulkanResource {
     VulkanTimerQuery(VulkanContext& context);
     ~VulkanTimerQuery();
     uint32_t startingQueryIndex;
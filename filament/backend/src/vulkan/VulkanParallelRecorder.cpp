@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "VulkanParallelRecorder.h"
+
+#include "VulkanConstants.h"
+
+#include <utils/Panic.h>
+#include <utils/debug.h>
+
+#include <algorithm>
+#include <thread>
+
+using namespace bluevk;
+using namespace utils;
+
+namespace filament::backend {
+
+void VulkanParallelRecorder::initialize(VkDevice device, uint32_t queueFamilyIndex) {
+    // Leave a core to the application thread and another one to the driver thread, which records
+    // the first chunk itself. With fewer than three cores, there is nothing to gain.
+    const size_t cores = std::thread::hardware_concurrency();
+    const size_t workerCount = std::min(MAX_CHUNK_COUNT - 1, cores > 2 ? cores - 2 : 0);
+    if (workerCount == 0) {
+        return;
+    }
+
+    const VkCommandPoolCreateInfo createInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT |
+                VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+        .queueFamilyIndex = queueFamilyIndex,
+    };
+    for (Slot& slot : mSlots) {
+        vkCreateCommandPool(device, &createInfo, VKALLOC, &slot.pool);
+    }
+
+    // The only thread that needs to be adopted is the driver thread.
+    mJobSystem = std::make_unique<JobSystem>(workerCount, 1);
+    mChunkCount = workerCount + 1;
+    mDevice = device;
+}
+
+void VulkanParallelRecorder::terminate() noexcept {
+    if (!isEnabled()) {
+        return;
+    }
+    assert_invariant(!isRecording());
+    if (mAdopted) {
+        mJobSystem->emancipate();
+        mAdopted = false;
+    }
+    mJobSystem.reset();
+    for (Slot& slot : mSlots) {
+        // Destroying the pool frees all of its command buffers.
+        vkDestroyCommandPool(mDevice, slot.pool, VKALLOC);
+        slot.pool = VK_NULL_HANDLE;
+        slot.cmdbuffers.clear();
+    }
+    mDrawCalls.clear();
+    mDrawCalls.shrink_to_fit();
+    mDevice = VK_NULL_HANDLE;
+}
+
+void VulkanParallelRecorder::begin(VkRenderPass renderPass, VkFramebuffer framebuffer,
+        VkViewport const& viewport) {
+    assert_invariant(isEnabled() && !isRecording());
+    assert_invariant(mDrawCalls.empty());
+    mRenderPass = renderPass;
+    mFramebuffer = framebuffer;
+    mViewport = viewport;
+}
+
+void VulkanParallelRecorder::end(VulkanCommandBuffer const& primary) {
+    assert_invariant(isRecording());
+
+    const size_t drawCount = mDrawCalls.size();
+    if (drawCount > 0) {
+        const size_t chunkCount = std::clamp(drawCount / MIN_DRAWS_PER_CHUNK,
+                size_t(1), mChunkCount);
+
+        VkCommandBuffer cmdbuffers[MAX_CHUNK_COUNT];
+        for (size_t i = 0; i < chunkCount; i++) {
+            cmdbuffers[i] = acquire(mSlots[i], primary.fence);
+        }
+
+        // Split the draw calls evenly, chunk i covers [chunk(i), chunk(i + 1)).
+        VulkanDrawCall const* const draws = mDrawCalls.data();
+        auto chunk = [draws, drawCount, chunkCount](size_t i) {
+            return draws + drawCount * i / chunkCount;
+        };
+
+        if (chunkCount == 1) {
+            record(cmdbuffers[0], chunk(0), chunk(1));
+        } else {
+            JobSystem& js = *mJobSystem;
+            if (UTILS_UNLIKELY(!mAdopted)) {
+                js.adopt();
+                mAdopted = true;
+            }
+            JobSystem::Job* root = js.createJob();
+            for (size_t i = 1; i < chunkCount; i++) {
+                js.run(jobs::createJob(js, root,
+                        [this, cmdbuffer = cmdbuffers[i], first = chunk(i), last = chunk(i + 1)]() {
+                            record(cmdbuffer, first, last);
+                        }));
+            }
+            record(cmdbuffers[0], chunk(0), chunk(1));
+            js.runAndWait(root);
+        }
+
+        vkCmdExecuteCommands(primary.cmdbuffer, (uint32_t) chunkCount, cmdbuffers);
+    }
+
+    mDrawCalls.clear();
+    mRenderPass = VK_NULL_HANDLE;
+    mFramebuffer = VK_NULL_HANDLE;
+}
+
+VkCommandBuffer VulkanParallelRecorder::acquire(Slot& slot,
+        std::shared_ptr<VulkanCmdFence> const& fence) {
+    // Recycle a secondary command buffer whose primary has finished executing. The pool was created
+    // with RESET_COMMAND_BUFFER_BIT, so vkBeginCommandBuffer implicitly resets it.
+    for (SecondaryCommandBuffer& secondary : slot.cmdbuffers) {
+        if (secondary.fence->status.load(std::memory_order_relaxed) == VK_SUCCESS) {
+            secondary.fence = fence;
+            return secondary.cmdbuffer;
+        }
+    }
+
+    const VkCommandBufferAllocateInfo allocateInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool = slot.pool,
+        .level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+        .commandBufferCount = 1,
+    };
+    VkCommandBuffer cmdbuffer;
+    UTILS_UNUSED_IN_RELEASE VkResult result = vkAllocateCommandBuffers(mDevice, &allocateInfo,
+            &cmdbuffer);
+    assert_invariant(result == VK_SUCCESS);
+    slot.cmdbuffers.push_back({ cmdbuffer, fence });
+    return cmdbuffer;
+}
+
+void VulkanParallelRecorder::record(VkCommandBuffer cmdbuffer, VulkanDrawCall const* first,
+        VulkanDrawCall const* last) const noexcept {
+    const VkCommandBufferInheritanceInfo inheritanceInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .renderPass = mRenderPass,
+        .subpass = 0,
+        .framebuffer = mFramebuffer,
+    };
+    const VkCommandBufferBeginInfo beginInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+                VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+        .pInheritanceInfo = &inheritanceInfo,
+    };
+    vkBeginCommandBuffer(cmdbuffer, &beginInfo);
+    vkCmdSetViewport(cmdbuffer, 0, 1, &mViewport);
+
+    // Secondary command buffers start with undefined state, so the first draw call binds
+    // everything. After that, only the bindings that change are recorded, like the pipeline cache
+    // does for the primary command buffer.
+    VulkanDrawCall const* previous = nullptr;
+    for (VulkanDrawCall const* draw = first; draw != last; ++draw) {
+        if (!previous || previous->pipeline != draw->pipeline) {
+            vkCmdBindPipeline(cmdbuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, draw->pipeline);
+        }
+        if (!previous || previous->pipelineLayout != draw->pipelineLayout ||
+                !std::equal(std::begin(draw->descriptorSets), std::end(draw->descriptorSets),
+                        std::begin(previous->descriptorSets))) {
+            vkCmdBindDescriptorSets(cmdbuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                    draw->pipelineLayout, 0, VulkanPipelineCache::DESCRIPTOR_TYPE_COUNT,
+                    draw->descriptorSets, 0, nullptr);
+        }
+        if (!previous || previous->scissor.offset.x != draw->scissor.offset.x ||
+                previous->scissor.offset.y != draw->scissor.offset.y ||
+                previous->scissor.extent.width != draw->scissor.extent.width ||
+                previous->scissor.extent.height != draw->scissor.extent.height) {
+            vkCmdSetScissor(cmdbuffer, 0, 1, &draw->scissor);
+        }
+        vkCmdBindVertexBuffers(cmdbuffer, 0, draw->bufferCount, draw->buffers, draw->offsets);
+        vkCmdBindIndexBuffer(cmdbuffer, draw->indexBuffer, 0, draw->indexType);
+        vkCmdDrawIndexed(cmdbuffer, draw->indexCount, draw->instanceCount, draw->firstIndex,
+                0, 0);
+        previous = draw;
+    }
+
+    vkEndCommandBuffer(cmdbuffer);
+}
+
+} // namespace filament::backend
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TNT_FILAMENT_BACKEND_VULKANPARALLELRECORDER_H
+#define TNT_FILAMENT_BACKEND_VULKANPARALLELRECORDER_H
+
+#include "VulkanCommands.h"
+#include "VulkanPipelineCache.h"
+
+#include <bluevk/BlueVK.h>
+
+#include <utils/JobSystem.h>
+
+#include <memory>
+#include <vector>
+
+namespace filament::backend {
+
+// Draw call whose bindings have all been resolved on the driver thread, such that it can be
+// recorded on any thread.
+struct VulkanDrawCall {
+    VkPipeline pipeline;
+    VkPipelineLayout pipelineLayout;
+    VkDescriptorSet descriptorSets[VulkanPipelineCache::DESCRIPTOR_TYPE_COUNT];
+    VkRect2D scissor;
+    VkBuffer indexBuffer;
+    VkIndexType indexType;
+    uint32_t indexCount;
+    uint32_t instanceCount;
+    uint32_t firstIndex;
+    uint32_t bufferCount;
+    VkBuffer buffers[MAX_VERTEX_ATTRIBUTE_COUNT];
+    VkDeviceSize offsets[MAX_VERTEX_ATTRIBUTE_COUNT];
+};
+
+// Records the contents of a render pass into secondary command buffers.
+//
+// The driver thread still resolves pipelines and descriptor sets for every draw call, because the
+// caches are not thread safe, but it only appends the results to a list. When the render pass
+// ends, the list is split into contiguous chunks that are recorded concurrently by a small pool of
+// worker threads, and the resulting secondary command buffers are executed in order with
+// vkCmdExecuteCommands.
+//
+// Command pools must be externally synchronized, so each chunk slot owns its own pool. Secondary
+// command buffers are recycled once the fence of the primary command buffer that executed them
+// has signaled.
+class VulkanParallelRecorder {
+public:
+    VulkanParallelRecorder() noexcept = default;
+    VulkanParallelRecorder(VulkanParallelRecorder const&) = delete;
+    VulkanParallelRecorder& operator=(VulkanParallelRecorder const&) = delete;
+
+    // Creates the command pools and the worker threads. Until this is called, isEnabled() returns
+    // false and the driver records everything into the primary command buffer.
+    void initialize(VkDevice device, uint32_t queueFamilyIndex);
+
+    // Frees all command buffers and pools. This must be called from the driver thread after the
+    // device is idle.
+    void terminate() noexcept;
+
+    bool isEnabled() const noexcept { return mDevice != VK_NULL_HANDLE; }
+    bool isRecording() const noexcept { return mRenderPass != VK_NULL_HANDLE; }
+
+    // Starts collecting the draw calls of a render pass that was begun with
+    // VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS. Dynamic state is not inherited by secondary
+    // command buffers, so the viewport is set in each of them.
+    void begin(VkRenderPass renderPass, VkFramebuffer framebuffer, VkViewport const& viewport);
+
+    // Appends a draw call to the current render pass.
+    VulkanDrawCall& draw() { return mDrawCalls.emplace_back(); }
+
+    // Removes the draw call returned by the last call to draw(), if it could not be resolved.
+    void cancelDraw() noexcept { mDrawCalls.pop_back(); }
+
+    // Records the collected draw calls and executes them from the given primary command buffer.
+    // This must be called before vkCmdEndRenderPass.
+    void end(VulkanCommandBuffer const& primary);
+
+private:
+    // Minimum number of draw calls per chunk, below which the threading overhead isn't worth it.
+    static constexpr size_t MIN_DRAWS_PER_CHUNK = 128;
+
+    // Maximum number of chunks, the driver thread records one of them.
+    static constexpr size_t MAX_CHUNK_COUNT = 4;
+
+    struct SecondaryCommandBuffer {
+        VkCommandBuffer cmdbuffer;
+        std::shared_ptr<VulkanCmdFence> fence;
+    };
+
+    struct Slot {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        std::vector<SecondaryCommandBuffer> cmdbuffers;
+    };
+
+    VkCommandBuffer acquire(Slot& slot, std::shared_ptr<VulkanCmdFence> const& fence);
+    void record(VkCommandBuffer cmdbuffer, VulkanDrawCall const* first,
+            VulkanDrawCall const* last) const noexcept;
+
+    VkDevice mDevice = VK_NULL_HANDLE;
+    std::unique_ptr<utils::JobSystem> mJobSystem;
+    bool mAdopted = false;
+    size_t mChunkCount = 1;
+    Slot mSlots[MAX_CHUNK_COUNT];
+
+    VkRenderPass mRenderPass = VK_NULL_HANDLE;
+    VkFramebuffer mFramebuffer = VK_NULL_HANDLE;
+    VkViewport mViewport = {};
+    std::vector<VulkanDrawCall> mDrawCalls;
+};
+
+} // namespace filament::backend
+
+#endif // TNT_FILAMENT_BACKEND_VULKANPARALLELRECORDER_H
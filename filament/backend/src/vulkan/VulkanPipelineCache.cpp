@@ -217,6 +217,42 @@ void VulkanPipelineCache::bindScissor(VkCommandBuffer cmdbuffer, VkRect2D scisso
     }
 }
 
+bool VulkanPipelineCache::getDescriptors(VkPipelineLayout* layout,
+        VkDescriptorSet* handles) noexcept {
+    DescriptorMap::iterator descriptorIter = mDescriptorSets.find(mDescriptorRequirements);
+    DescriptorCacheEntry* cacheEntry = UTILS_LIKELY(descriptorIter != mDescriptorSets.end()) ?
+            &descriptorIter.value() : createDescriptorSets();
+    assert_invariant(cacheEntry != nullptr);
+    if (UTILS_UNLIKELY(cacheEntry == nullptr)) {
+        return false;
+    }
+    cacheEntry->lastUsed = mCurrentTime;
+    *layout = getOrCreatePipelineLayout()->handle;
+    std::copy(cacheEntry->handles.begin(), cacheEntry->handles.end(), handles);
+    return true;
+}
+
+bool VulkanPipelineCache::getPipeline(VkPipeline* pipeline) noexcept {
+    PipelineMap::iterator pipelineIter = mPipelines.find(mPipelineRequirements);
+    PipelineCacheEntry* cacheEntry = UTILS_LIKELY(pipelineIter != mPipelines.end()) ?
+            &pipelineIter.value() : createPipeline();
+    assert_invariant(cacheEntry != nullptr);
+    if (UTILS_UNLIKELY(cacheEntry == nullptr)) {
+        return false;
+    }
+    cacheEntry->lastUsed = mCurrentTime;
+    getOrCreatePipelineLayout()->lastUsed = mCurrentTime;
+    *pipeline = cacheEntry->handle;
+    return true;
+}
+
+void VulkanPipelineCache::invalidateBindings() noexcept {
+    mBoundPipeline = {};
+    mBoundLayout = {};
+    mBoundDescriptor = {};
+    mCurrentScissor = {};
+}
+
 VulkanPipelineCache::DescriptorCacheEntry* VulkanPipelineCache::createDescriptorSets() noexcept {
     PipelineLayoutCacheEntry* layoutCacheEntry = getOrCreatePipelineLayout();
 
@@ -696,10 +732,7 @@ void VulkanPipelineCache::onCommandBuffer(const VulkanCommandBuffer& cmdbuffer)
 
     // The Vulkan spec says: "When a command buffer begins recording, all state in that command
     // buffer is undefined." Therefore, we need to clear all bindings at this time.
-    mBoundPipeline = {};
-    mBoundLayout = {};
-    mBoundDescriptor = {};
-    mCurrentScissor = {};
+    invalidateBindings();
 
     // NOTE: Due to robin_map restrictions, we cannot use auto or range-based loops.
 
@@ -142,6 +142,18 @@ public:
     // Sets up a new scissor rectangle if it has been dirtied.
     void bindScissor(VkCommandBuffer cmdbuffer, VkRect2D scissor) noexcept;
 
+    // Creates new descriptor sets if necessary and returns them along with their pipeline layout,
+    // without binding them. Returns false if descriptor set allocation fails.
+    bool getDescriptors(VkPipelineLayout* layout, VkDescriptorSet* handles) noexcept;
+
+    // Creates a new pipeline if necessary and returns it without binding it.
+    // Returns false if an error occurred.
+    bool getPipeline(VkPipeline* pipeline) noexcept;
+
+    // Forgets the bindings of the current command buffer. This must be called after executing
+    // secondary command buffers, which leaves the bindings of the primary command buffer undefined.
+    void invalidateBindings() noexcept;
+
     // Each of the following methods are fast and do not make Vulkan calls.
     void bindProgram(const VulkanProgram& program) noexcept;
     void bindRasterState(const RasterState& rasterState) noexcept;
@@ -21,6 +21,9 @@
 #include "VulkanUtility.h"
 
 #include <utils/Panic.h>
+#include <utils/Systrace.h>
+
+using namespace bluevk;
 
 static constexpr uint32_t TIME_BEFORE_EVICTION = VK_MAX_COMMAND_BUFFERS;
 
@@ -41,6 +44,7 @@ VulkanStage const* VulkanStagePool::acquireStage(uint32_t numBytes) {
         .buffer = VK_NULL_HANDLE,
         .capacity = numBytes,
         .lastAccessed = mCurrentFrame,
+        .mapped = nullptr,
     });
 
     // Create the VkBuffer.
@@ -50,9 +54,14 @@ VulkanStage const* VulkanStagePool::acquireStage(uint32_t numBytes) {
         .size = numBytes,
         .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
     };
-    VmaAllocationCreateInfo allocInfo { .usage = VMA_MEMORY_USAGE_CPU_ONLY };
+    VmaAllocationCreateInfo allocInfo {
+        .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT,
+        .usage = VMA_MEMORY_USAGE_CPU_ONLY
+    };
+    VmaAllocationInfo allocationInfo;
     UTILS_UNUSED_IN_RELEASE VkResult result = vmaCreateBuffer(mContext.allocator, &bufferInfo,
-            &allocInfo, &stage->buffer, &stage->memory, nullptr);
+            &allocInfo, &stage->buffer, &stage->memory, &allocationInfo);
+    stage->mapped = allocationInfo.pMappedData;
 
 #ifndef NDEBUG
     if (result != VK_SUCCESS) {
@@ -63,6 +72,150 @@ VulkanStage const* VulkanStagePool::acquireStage(uint32_t numBytes) {
     return stage;
 }
 
+VulkanStageSlice VulkanStagePool::acquireSlice(uint32_t numBytes, uint32_t alignment) {
+    mFrameCounters.bytes += numBytes;
+    mFrameCounters.uploads++;
+
+    VkDeviceSize offset;
+    if (numBytes <= VK_STAGING_RING_SIZE / 4 && allocateFromRing(numBytes, alignment, &offset)) {
+        return {
+            .buffer = mRingBuffer,
+            .memory = mRingMemory,
+            .offset = offset,
+            .mapped = mRingMapped + offset,
+        };
+    }
+    VulkanStage const* stage = acquireStage(numBytes);
+    return {
+        .buffer = stage->buffer,
+        .memory = stage->memory,
+        .offset = 0,
+        .mapped = stage->mapped,
+    };
+}
+
+bool VulkanStagePool::allocateFromRing(uint32_t numBytes, uint32_t alignment,
+        VkDeviceSize* offset) noexcept {
+    if (mRingBuffer == VK_NULL_HANDLE) {
+        VkBufferCreateInfo bufferInfo {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            .size = VK_STAGING_RING_SIZE,
+            .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        };
+        VmaAllocationCreateInfo allocInfo {
+            .flags = VMA_ALLOCATION_CREATE_MAPPED_BIT,
+            .usage = VMA_MEMORY_USAGE_CPU_ONLY
+        };
+        VmaAllocationInfo allocationInfo;
+        VkResult result = vmaCreateBuffer(mContext.allocator, &bufferInfo, &allocInfo,
+                &mRingBuffer, &mRingMemory, &allocationInfo);
+        if (result != VK_SUCCESS) {
+            utils::slog.e << "Unable to create the staging ring: " << result << utils::io::endl;
+            mRingBuffer = VK_NULL_HANDLE;
+            return false;
+        }
+        mRingMapped = (uint8_t*) allocationInfo.pMappedData;
+    }
+
+    retireRingRegions();
+
+    const bool empty = mRingRegions.empty() && !mRingOpen;
+    if (empty) {
+        // Restart at the beginning to get as much contiguous space as possible.
+        mRingHead = mRingTail = 0;
+    }
+
+    VkDeviceSize start = (mRingHead + alignment - 1) / alignment * alignment;
+    if (empty || mRingHead > mRingTail) {
+        // The free space is [head, size) followed by [0, tail).
+        if (start + numBytes > VK_STAGING_RING_SIZE) {
+            if (numBytes > mRingTail) {
+                return false;
+            }
+            start = 0;
+        }
+    } else if (mRingHead == mRingTail || start + numBytes > mRingTail) {
+        // Either the ring is full, or the free space [head, tail) is too small.
+        return false;
+    }
+
+    mRingHead = start + numBytes;
+    mRingOpen = true;
+    *offset = start;
+    return true;
+}
+
+void VulkanStagePool::retireRingRegions() noexcept {
+    // Reclaim the space of every command buffer that has finished executing. Regions are retired
+    // in submission order, so we stop at the first one that is still in flight.
+    while (!mRingRegions.empty() && mRingRegions.front().fence->status.load() == VK_SUCCESS) {
+        mRingTail = mRingRegions.front().end;
+        mRingRegions.pop_front();
+    }
+}
+
+void VulkanStagePool::enqueueBufferCopy(VulkanStageSlice const& slice, VkBuffer dst,
+        uint32_t dstOffset, uint32_t numBytes, VkPipelineStageFlags dstStageMask,
+        VkAccessFlags dstAccessMask) {
+    // Copies within a batch are not synchronized with each other, so uploading into the same
+    // buffer twice requires the previous batch to be recorded first.
+    if (!mPendingDestinations.insert(dst).second) {
+        flushUploads();
+        mPendingDestinations.insert(dst);
+    }
+    mPendingCopies.push_back({
+        .src = slice.buffer,
+        .dst = dst,
+        .region = { .srcOffset = slice.offset, .dstOffset = dstOffset, .size = numBytes },
+    });
+    mPendingStages |= dstStageMask;
+    mPendingAccesses |= dstAccessMask;
+}
+
+void VulkanStagePool::flushUploads() {
+    if (mPendingCopies.empty() && !mRingOpen) {
+        return;
+    }
+
+    VulkanCommandBuffer const& commands = mContext.commands->get();
+
+    if (!mPendingCopies.empty()) {
+        // Consecutive copies between the same pair of buffers share a single command.
+        VkBufferCopy regions[64];
+        size_t i = 0;
+        while (i < mPendingCopies.size()) {
+            PendingCopy const& first = mPendingCopies[i];
+            uint32_t count = 0;
+            while (i < mPendingCopies.size() && count < 64 &&
+                    mPendingCopies[i].src == first.src && mPendingCopies[i].dst == first.dst) {
+                regions[count++] = mPendingCopies[i++].region;
+            }
+            vkCmdCopyBuffer(commands.cmdbuffer, first.src, first.dst, count, regions);
+        }
+
+        // Make all copies visible to subsequent draws, and order them before any later upload.
+        VkMemoryBarrier barrier {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | mPendingAccesses,
+        };
+        vkCmdPipelineBarrier(commands.cmdbuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT | mPendingStages,
+                0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        mPendingCopies.clear();
+        mPendingDestinations.clear();
+        mPendingStages = 0;
+        mPendingAccesses = 0;
+    }
+
+    if (mRingOpen) {
+        mRingRegions.push_back({ .fence = commands.fence, .end = mRingHead });
+        mRingOpen = false;
+    }
+}
+
 VulkanStageImage const* VulkanStagePool::acquireImage(PixelDataFormat format, PixelDataType type,
         uint32_t width, uint32_t height) {
     const VkFormat vkformat = getVkFormat(format, type);
@@ -127,6 +280,19 @@ VulkanStageImage const* VulkanStagePool::acquireImage(PixelDataFormat format, Pi
 }
 
 void VulkanStagePool::gc() noexcept {
+    SYSTRACE_CONTEXT();
+    SYSTRACE_VALUE32("vk.uploadKiB", uint32_t(mFrameCounters.bytes / 1024));
+    SYSTRACE_VALUE32("vk.transferKiB", uint32_t(mFrameCounters.transferBytes / 1024));
+    SYSTRACE_VALUE32("vk.uploadCount", mFrameCounters.uploads);
+    if (FILAMENT_VULKAN_VERBOSE) {
+        utils::slog.i << "Uploaded " << mFrameCounters.bytes << " bytes ("
+                << mFrameCounters.transferBytes << " via the transfer queue) in "
+                << mFrameCounters.uploads << " uploads" << utils::io::endl;
+    }
+    mFrameCounters = {};
+
+    retireRingRegions();
+
     // If this is one of the first few frames, return early to avoid wrapping unsigned integers.
     if (++mCurrentFrame <= TIME_BEFORE_EVICTION) {
         return;
@@ -183,6 +349,18 @@ void VulkanStagePool::gc() noexcept {
 }
 
 void VulkanStagePool::reset() noexcept {
+    mPendingCopies.clear();
+    mPendingDestinations.clear();
+    mRingRegions.clear();
+    mRingOpen = false;
+    mRingHead = mRingTail = 0;
+    if (mRingBuffer != VK_NULL_HANDLE) {
+        vmaDestroyBuffer(mContext.allocator, mRingBuffer, mRingMemory);
+        mRingBuffer = VK_NULL_HANDLE;
+        mRingMemory = VK_NULL_HANDLE;
+        mRingMapped = nullptr;
+    }
+
     for (auto stage : mUsedStages) {
         vmaDestroyBuffer(mContext.allocator, stage->buffer, stage->memory);
         delete stage;
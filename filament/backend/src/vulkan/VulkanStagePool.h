@@ -19,8 +19,11 @@
 
 #include "VulkanContext.h"
 
+#include <deque>
 #include <map>
+#include <memory>
 #include <unordered_set>
+#include <vector>
 
 namespace filament::backend {
 
@@ -30,6 +33,16 @@ struct VulkanStage {
     VkBuffer buffer;
     uint32_t capacity;
     mutable uint64_t lastAccessed;
+    void* mapped;
+};
+
+// Host-visible range of a staging buffer, either carved out of the staging ring or backed by a
+// dedicated stage. The memory must be written before the command that reads it is submitted.
+struct VulkanStageSlice {
+    VkBuffer buffer;
+    VmaAllocation memory;
+    VkDeviceSize offset;
+    void* mapped;
 };
 
 struct VulkanStageImage {
@@ -41,8 +54,19 @@ struct VulkanStageImage {
     VkImage image;
 };
 
+// Amount of data that went through the stage pool during one frame.
+struct VulkanUploadCounters {
+    uint64_t bytes = 0;          // all uploads
+    uint64_t transferBytes = 0;  // uploads recorded into the transfer command buffer
+    uint32_t uploads = 0;
+};
+
 // Manages a pool of stages, periodically releasing stages that have been unused for a while.
 // This class manages two types of host-mappable staging areas: buffer stages and image stages.
+//
+// Small uploads do not use the pool; they are sub-allocated from a single persistently mapped ring
+// buffer. Space in the ring is handed over to the current command buffer in flushUploads() and is
+// reused once that command buffer's fence has signaled.
 class VulkanStagePool {
 public:
     explicit VulkanStagePool(VulkanContext& context) noexcept : mContext(context) {}
@@ -51,20 +75,70 @@ public:
     // The stage is automatically released back to the pool after TIME_BEFORE_EVICTION frames.
     VulkanStage const* acquireStage(uint32_t numBytes);
 
+    // Returns a mapped staging range of at least the given size whose offset is a multiple of the
+    // given alignment. Requests that do not fit in the staging ring fall back to acquireStage().
+    VulkanStageSlice acquireSlice(uint32_t numBytes, uint32_t alignment);
+
+    // Defers a copy from a staging slice into a buffer until the next call to flushUploads(), which
+    // records all pending copies followed by a single barrier towards the given stages and accesses.
+    void enqueueBufferCopy(VulkanStageSlice const& slice, VkBuffer dst, uint32_t dstOffset,
+            uint32_t numBytes, VkPipelineStageFlags dstStageMask, VkAccessFlags dstAccessMask);
+
+    // Records pending buffer copies into the current command buffer and ties the ring space used
+    // so far to its fence. This must be called before beginning a render pass and before the
+    // current command buffer is submitted.
+    void flushUploads();
+
+    // Notes that an upload of the given size was recorded into the transfer command buffer.
+    void trackTransferUpload(uint32_t numBytes) noexcept { mFrameCounters.transferBytes += numBytes; }
+
     // Images have VK_IMAGE_LAYOUT_GENERAL and must not be transitioned to any other layout
     VulkanStageImage const* acquireImage(PixelDataFormat format, PixelDataType type,
             uint32_t width, uint32_t height);
 
-    // Evicts old unused stages and bumps the current frame number.
+    // Evicts old unused stages, bumps the current frame number, then reports and resets the upload
+    // counters.
     void gc() noexcept;
 
-    // Destroys all unused stages and asserts that there are no stages currently in use.
+    // Destroys all stages and the staging ring, dropping any upload that has not been flushed.
     // This should be called while the context's VkDevice is still alive.
     void reset() noexcept;
 
 private:
+    struct PendingCopy {
+        VkBuffer src;
+        VkBuffer dst;
+        VkBufferCopy region;
+    };
+
+    // Span of the staging ring that ends at the given offset and is in use by a command buffer.
+    struct RingRegion {
+        std::shared_ptr<VulkanCmdFence> fence;
+        VkDeviceSize end;
+    };
+
+    bool allocateFromRing(uint32_t numBytes, uint32_t alignment, VkDeviceSize* offset) noexcept;
+    void retireRingRegions() noexcept;
+
     VulkanContext& mContext;
 
+    // Persistently mapped ring buffer, created lazily. Bytes in [mRingTail, mRingHead) (modulo the
+    // ring size) are in flight. Bytes handed out since the last flushUploads() belong to the
+    // "open" region and cannot be reclaimed yet.
+    VkBuffer mRingBuffer = VK_NULL_HANDLE;
+    VmaAllocation mRingMemory = VK_NULL_HANDLE;
+    uint8_t* mRingMapped = nullptr;
+    VkDeviceSize mRingHead = 0;
+    VkDeviceSize mRingTail = 0;
+    bool mRingOpen = false;
+    std::deque<RingRegion> mRingRegions;
+
+    // Buffer copies recorded by flushUploads() and the union of their destination usages.
+    std::vector<PendingCopy> mPendingCopies;
+    std::unordered_set<VkBuffer> mPendingDestinations;
+    VkPipelineStageFlags mPendingStages = 0;
+    VkAccessFlags mPendingAccesses = 0;
+
     // Use an ordered multimap for quick (capacity => stage) lookups using lower_bound().
     std::multimap<uint32_t, VulkanStage const*> mFreeStages;
 
@@ -74,6 +148,9 @@ private:
     std::unordered_set<VulkanStageImage const*> mFreeImages;
     std::unordered_set<VulkanStageImage const*> mUsedImages;
 
+    // Reported to systrace, and logged when FILAMENT_VULKAN_VERBOSE is set, at every gc().
+    VulkanUploadCounters mFrameCounters;
+
     // Store the current "time" (really just a frame count) and LRU eviction parameters.
     uint64_t mCurrentFrame = 0;
 };
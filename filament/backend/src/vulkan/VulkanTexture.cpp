@@ -24,6 +24,8 @@
 
 #include <utils/Panic.h>
 
+#include <numeric>
+
 using namespace bluevk;
 
 namespace filament::backend {
@@ -236,18 +238,15 @@ void VulkanTexture::updateImage(const PixelBufferDescriptor& data, uint32_t widt
     }
 
     // Otherwise, use vkCmdCopyBufferToImage.
-    void* mapped = nullptr;
-    VulkanStage const* stage = mStagePool.acquireStage(hostData->size);
-    assert_invariant(stage->memory);
-    vmaMapMemory(mContext.allocator, stage->memory, &mapped);
-    memcpy(mapped, hostData->buffer, hostData->size);
-    vmaUnmapMemory(mContext.allocator, stage->memory);
-    vmaFlushAllocation(mContext.allocator, stage->memory, 0, hostData->size);
-
-    const VkCommandBuffer cmdbuffer = mContext.commands->get().cmdbuffer;
+    // The source offset of vkCmdCopyBufferToImage must be a multiple of both 4 and the texel size.
+    const uint32_t texelSize = getBytesPerPixel(format);
+    const uint32_t alignment = texelSize ? std::lcm(4u, texelSize) : 16u;
+    VulkanStageSlice const slice = mStagePool.acquireSlice(hostData->size, alignment);
+    memcpy(slice.mapped, hostData->buffer, hostData->size);
+    vmaFlushAllocation(mContext.allocator, slice.memory, slice.offset, hostData->size);
 
     VkBufferImageCopy copyRegion = {
-        .bufferOffset = {},
+        .bufferOffset = slice.offset,
         .bufferRowLength = {},
         .bufferImageHeight = {},
         .imageSubresource = {
@@ -280,14 +279,107 @@ void VulkanTexture::updateImage(const PixelBufferDescriptor& data, uint32_t widt
         transitionRange.layerCount = depth;
     }
 
+    if (mContext.transferCommands && canUpdateAsync(copyRegion, transitionRange)) {
+        updateImageAsync(slice.buffer, copyRegion, transitionRange);
+        mStagePool.trackTransferUpload(hostData->size);
+        return;
+    }
+
+    const VkCommandBuffer cmdbuffer = mContext.commands->get().cmdbuffer;
+
     transitionLayout(cmdbuffer, transitionRange, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
 
-    vkCmdCopyBufferToImage(cmdbuffer, stage->buffer, mTextureImage,
+    vkCmdCopyBufferToImage(cmdbuffer, slice.buffer, mTextureImage,
             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
 
     transitionLayout(cmdbuffer, transitionRange, getDefaultImageLayout(usage));
 }
 
+bool VulkanTexture::canUpdateAsync(const VkBufferImageCopy& copyRegion,
+        const VkImageSubresourceRange& range) const {
+    // The transfer queue only handles sampleable textures, so that the rendering side never needs
+    // to give up ownership.
+    if (getDefaultImageLayout(usage) != VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+        return false;
+    }
+
+    // Only whole subresources can be uploaded, which makes the image transfer granularity of the
+    // queue irrelevant.
+    const uint32_t level = copyRegion.imageSubresource.mipLevel;
+    const uint32_t depth = target == SamplerType::SAMPLER_3D ? this->depth : 1;
+    const VkOffset3D offset = copyRegion.imageOffset;
+    const VkExtent3D extent = copyRegion.imageExtent;
+    if (offset.x != 0 || offset.y != 0 || offset.z != 0 ||
+            extent.width != std::max(1u, this->width >> level) ||
+            extent.height != std::max(1u, this->height >> level) ||
+            extent.depth != std::max(1u, depth >> level)) {
+        return false;
+    }
+
+    // The previous contents must be undefined, which means that no command reads or writes them
+    // and that the transfer queue can implicitly take ownership.
+    for (uint32_t layer = 0; layer < range.layerCount; ++layer) {
+        if (getVkLayout(range.baseArrayLayer + layer, level) != VK_IMAGE_LAYOUT_UNDEFINED) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void VulkanTexture::updateImageAsync(VkBuffer stage, const VkBufferImageCopy& copyRegion,
+        const VkImageSubresourceRange& range) {
+    const VkCommandBuffer transfer = mContext.transferCommands->get().cmdbuffer;
+    const VkCommandBuffer graphics = mContext.commands->get().cmdbuffer;
+    const uint32_t srcQueueFamily = mContext.transferQueueFamilyIndex;
+    const uint32_t dstQueueFamily = mContext.graphicsQueueFamilyIndex;
+    const bool ownershipTransfer = srcQueueFamily != dstQueueFamily;
+    const VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkImageMemoryBarrier barrier = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = 0,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = mTextureImage,
+        .subresourceRange = range,
+    };
+    vkCmdPipelineBarrier(transfer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    vkCmdCopyBufferToImage(transfer, stage, mTextureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1, &copyRegion);
+
+    // Transition to the final layout on the transfer side. When the queue families differ, this
+    // barrier also releases ownership of the image. Either way, the rendering commands wait on a
+    // semaphore signaled by the transfer submission, which makes the copy visible to them.
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = finalLayout;
+    if (ownershipTransfer) {
+        barrier.srcQueueFamilyIndex = srcQueueFamily;
+        barrier.dstQueueFamilyIndex = dstQueueFamily;
+    }
+    vkCmdPipelineBarrier(transfer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    // The matching acquire operation must use the same layouts and queue families as the release.
+    if (ownershipTransfer) {
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(graphics, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                0, 0, nullptr, 0, nullptr, 1, &barrier);
+    }
+
+    for (uint32_t layer = 0; layer < range.layerCount; ++layer) {
+        trackLayout(range.baseMipLevel, range.baseArrayLayer + layer, finalLayout);
+    }
+}
+
 void VulkanTexture::updateImageWithBlit(const PixelBufferDescriptor& hostData, uint32_t width,
         uint32_t height, uint32_t depth, uint32_t miplevel) {
     void* mapped = nullptr;
@@ -25,7 +25,7 @@
 
 namespace filament::backend {
 
-struct VulkanTexture : public HwTexture {
+struct VulkanTexture : public HwTexture, VulkanResource {
 
     // Standard constructor for user-facing textures.
     VulkanTexture(VulkanContext& context, SamplerType target, uint8_t levels,
@@ -85,6 +85,12 @@ private:
     void updateImageWithBlit(const PixelBufferDescriptor& hostData, uint32_t width,
         uint32_t height, uint32_t depth, uint32_t miplevel);
 
+    // Uploads into subresources with undefined contents can bypass the rendering command buffer.
+    bool canUpdateAsync(const VkBufferImageCopy& copyRegion,
+            const VkImageSubresourceRange& range) const;
+    void updateImageAsync(VkBuffer stage, const VkBufferImageCopy& copyRegion,
+            const VkImageSubresourceRange& range);
+
     VulkanTexture* mSidecarMSAA = nullptr;
     const VkFormat mVkFormat;
     const VkImageViewType mViewType;
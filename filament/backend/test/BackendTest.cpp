@@ -191,6 +191,16 @@ void BackendTest::readPixelsAndAssertHash(const char* testName, size_t width, si
     getDriverApi().readPixels(rt, 0, 0, width, height, std::move(pbd));
 }
 
+void BackendTest::readPixels(Handle<HwRenderTarget> rt, uint32_t width, uint32_t height,
+        Readback& readback) {
+    readback.pixels.assign(size_t(width) * height * 4, 0);
+    readback.ready = false;
+    PixelBufferDescriptor pbd(readback.pixels.data(), readback.pixels.size(),
+            PixelDataFormat::RGBA, PixelDataType::UBYTE, 1, 0, 0, width,
+            [](void*, size_t, void* user) { ((Readback*) user)->ready = true; }, &readback);
+    getDriverApi().readPixels(rt, 0, 0, width, height, std::move(pbd));
+}
+
 class Environment : public ::testing::Environment {
 public:
     virtual void SetUp() override {
@@ -26,6 +26,8 @@
 
 #include "PlatformRunner.h"
 
+#include <vector>
+
 namespace test {
 
 class BackendTest : public ::testing::Test {
@@ -63,6 +65,18 @@ protected:
             filament::backend::Handle<filament::backend::HwRenderTarget> rt, uint32_t expectedHash,
             bool exportScreenshot = false);
 
+    // RGBA8 pixels read back from a render target.
+    struct Readback {
+        std::vector<uint8_t> pixels;
+        bool ready = false;
+    };
+
+    // Reads back the given render target into readback, which must outlive the driver callback.
+    // The pixels are available once ready is set, e.g. after finish(), executeCommands() and
+    // purge().
+    void readPixels(filament::backend::Handle<filament::backend::HwRenderTarget> rt,
+            uint32_t width, uint32_t height, Readback& readback);
+
     filament::backend::DriverApi& getDriverApi() { return *commandStream; }
     filament::backend::Driver& getDriver() { return *driver; }
 
@@ -19,6 +19,13 @@
 #include "ShaderGenerator.h"
 #include "TrianglePrimitive.h"
 
+#include <utils/Log.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
 namespace {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -79,6 +86,13 @@ struct MaterialParams {
 };
 static_assert(sizeof(MaterialParams) == 8 * sizeof(float));
 
+// The whole Params uniform block, as laid out by std140.
+struct ParamsBlock {
+    math::float4 padding[4];
+    MaterialParams params;
+};
+static_assert(offsetof(ParamsBlock, params) == 64);
+
 TEST_F(BackendTest, VertexBufferUpdate) {
     const bool largeBuffers = false;
 
@@ -284,4 +298,297 @@ TEST_F(BackendTest, BufferObjectUpdateWithOffset) {
     getDriver().purge();
 }
 
+// This test streams many small buffer updates per frame, interleaved with draw calls, which is the
+// pattern that the staging allocators are optimized for. The total amount of uploaded data is
+// larger than the staging ring, so the ring has to wrap around and recycle space.
+//
+// Each draw call renders a triangle in its own column of the render target, with the uniforms and
+// vertices that were uploaded right before it. The last frame is read back to check that every
+// draw call saw its own data.
+TEST_F(BackendTest, StreamingBufferUpdates) {
+    constexpr size_t FRAME_COUNT = 16;
+    constexpr size_t DRAWS_PER_FRAME = 32;
+    constexpr size_t UPLOADS_PER_DRAW = 16;
+    constexpr size_t UPLOAD_SIZE = 16 * 1024;
+    constexpr uint32_t SIZE = 512;
+    constexpr uint32_t COLUMN_WIDTH = SIZE / DRAWS_PER_FRAME;
+
+    // Create a platform-specific SwapChain and make it current.
+    auto swapChain = createSwapChain();
+    getDriverApi().makeCurrent(swapChain, swapChain);
+
+    ShaderGenerator shaderGen(vertex, fragment, sBackend, sIsMobilePlatform);
+    Program p = shaderGen.getProgram(getDriverApi());
+    auto program = getDriverApi().createProgram(std::move(p));
+
+    auto colorTexture = getDriverApi().createTexture(SamplerType::SAMPLER_2D, 1,
+            TextureFormat::RGBA8, 1, SIZE, SIZE, 1, TextureUsage::COLOR_ATTACHMENT);
+    auto renderTarget = getDriverApi().createRenderTarget(
+            TargetBufferFlags::COLOR0, SIZE, SIZE, 1, {{colorTexture}}, {}, {});
+
+    TrianglePrimitive triangle(getDriverApi());
+
+    auto ubuffer = getDriverApi().createBufferObject(sizeof(ParamsBlock),
+            BufferObjectBinding::UNIFORM, BufferUsage::STATIC);
+    getDriverApi().bindUniformBuffer(0, ubuffer);
+
+    // Scratch buffers that only add pressure on the staging ring; they are never drawn.
+    BufferObjectHandle scratch[UPLOADS_PER_DRAW];
+    for (auto& buffer : scratch) {
+        buffer = getDriverApi().createBufferObject(UPLOAD_SIZE,
+                BufferObjectBinding::VERTEX, BufferUsage::DYNAMIC);
+    }
+
+    PipelineState state;
+    state.program = program;
+    state.rasterState.colorWrite = true;
+    state.rasterState.depthWrite = false;
+    state.rasterState.depthFunc = RasterState::DepthFunc::A;
+    state.rasterState.culling = CullingMode::NONE;
+
+    RenderPassParams params = {};
+    params.viewport.width = SIZE;
+    params.viewport.height = SIZE;
+    params.flags.discardEnd = TargetBufferFlags::NONE;
+
+    auto freeCallback = [](void* buffer, size_t size, void* user) { free(buffer); };
+    auto redForDraw = [](size_t draw) { return float(draw) / DRAWS_PER_FRAME; };
+
+    Readback readback;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for (size_t frame = 0; frame < FRAME_COUNT; frame++) {
+        getDriverApi().makeCurrent(swapChain, swapChain);
+        getDriverApi().beginFrame(0, 0);
+
+        params.flags.clear = TargetBufferFlags::COLOR;
+        params.flags.discardStart = TargetBufferFlags::ALL;
+        params.clearColor = {0.f, 1.f, 0.f, 1.f};
+
+        for (size_t draw = 0; draw < DRAWS_PER_FRAME; draw++) {
+            for (auto buffer : scratch) {
+                void* data = malloc(UPLOAD_SIZE);
+                memset(data, int(draw), UPLOAD_SIZE);
+                getDriverApi().updateBufferObject(buffer,
+                        BufferDescriptor(data, UPLOAD_SIZE, freeCallback), 0);
+            }
+
+            auto* uniforms = (ParamsBlock*) calloc(1, sizeof(ParamsBlock));
+            uniforms->params = {
+                .color = { redForDraw(draw), 0.0f, 1.0f, 1.0f },
+                .offset = { 0.0f, 0.0f, 0.0f, 0.0f }
+            };
+            getDriverApi().updateBufferObject(ubuffer,
+                    BufferDescriptor(uniforms, sizeof(ParamsBlock), freeCallback), 0);
+
+            const float low = -1.0f + 2.0f * float(draw) / DRAWS_PER_FRAME;
+            const float high = low + 2.0f / DRAWS_PER_FRAME;
+            const math::float2 v[3] {{low, low}, {high, low}, {low, high}};
+            triangle.updateVertices(v);
+
+            getDriverApi().beginRenderPass(renderTarget, params);
+            getDriverApi().draw(state, triangle.getRenderPrimitive(), 1);
+            getDriverApi().endRenderPass();
+
+            params.flags.clear = TargetBufferFlags::NONE;
+            params.flags.discardStart = TargetBufferFlags::NONE;
+        }
+
+        if (frame == FRAME_COUNT - 1) {
+            readPixels(renderTarget, SIZE, SIZE, readback);
+        }
+
+        getDriverApi().commit(swapChain);
+        getDriverApi().endFrame(0);
+
+        // Execute every frame, so that the command stream does not need to hold the whole test.
+        executeCommands();
+    }
+
+    flushAndWait();
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    const double megabytes = double(FRAME_COUNT * DRAWS_PER_FRAME * UPLOADS_PER_DRAW * UPLOAD_SIZE)
+            / (1024.0 * 1024.0);
+    utils::slog.i << "StreamingBufferUpdates: " << megabytes << " MiB in "
+            << elapsed.count() * 1000.0 << " ms (" << megabytes / elapsed.count() << " MiB/s)"
+            << utils::io::endl;
+
+    getDriverApi().destroyProgram(program);
+    getDriverApi().destroySwapChain(swapChain);
+    getDriverApi().destroyBufferObject(ubuffer);
+    for (auto buffer : scratch) {
+        getDriverApi().destroyBufferObject(buffer);
+    }
+    getDriverApi().destroyRenderTarget(renderTarget);
+    getDriverApi().destroyTexture(colorTexture);
+
+    // This ensures all driver commands have finished before exiting the test.
+    getDriverApi().finish();
+
+    executeCommands();
+
+    getDriver().purge();
+
+    // The triangles are in disjoint columns, so every pixel that was drawn in the middle of a
+    // column must have the color of that column's draw call. Checking whole columns makes this
+    // independent of the vertical orientation of the backend.
+    ASSERT_TRUE(readback.ready);
+    for (size_t draw = 0; draw < DRAWS_PER_FRAME; draw++) {
+        const uint32_t x = uint32_t(draw) * COLUMN_WIDTH + COLUMN_WIDTH / 2;
+        const int red = int(std::lround(redForDraw(draw) * 255.0f));
+        size_t drawnCount = 0;
+        for (uint32_t y = 0; y < SIZE; y++) {
+            uint8_t const* pixel = readback.pixels.data() + (size_t(y) * SIZE + x) * 4;
+            if (pixel[0] == 0 && pixel[1] == 255 && pixel[2] == 0) {
+                continue; // clear color
+            }
+            drawnCount++;
+            EXPECT_NEAR(pixel[0], red, 1) << "draw " << draw << ", row " << y;
+            EXPECT_EQ(pixel[1], 0) << "draw " << draw << ", row " << y;
+            EXPECT_EQ(pixel[2], 255) << "draw " << draw << ", row " << y;
+        }
+        EXPECT_GT(drawnCount, 0u) << "draw " << draw;
+    }
+}
+
+
+// This test replaces the whole content of a uniform buffer before every draw call, like the
+// per-view uniforms do, and compares the throughput of DYNAMIC and STREAM buffers. With the
+// OpenGL backend, STREAM buffers are written into a ring buffer, which can be checked with Mesa's
+// software rasterizer (e.g. LIBGL_ALWAYS_SOFTWARE=1).
+//
+// Each draw call moves the triangle and changes its color through the uniforms. The last frame of
+// each run is read back, and both runs must produce the same image.
+TEST_F(BackendTest, UniformBufferStreamingThroughput) {
+    constexpr size_t FRAME_COUNT = 16;
+    constexpr size_t DRAWS_PER_FRAME = 256;
+    constexpr size_t UNIFORM_SIZE = 1024;
+    constexpr uint32_t SIZE = 512;
+    static_assert(UNIFORM_SIZE >= sizeof(ParamsBlock));
+
+    // Create a platform-specific SwapChain and make it current.
+    auto swapChain = createSwapChain();
+    getDriverApi().makeCurrent(swapChain, swapChain);
+
+    ShaderGenerator shaderGen(vertex, fragment, sBackend, sIsMobilePlatform);
+    Program p = shaderGen.getProgram(getDriverApi());
+    auto program = getDriverApi().createProgram(std::move(p));
+
+    auto colorTexture = getDriverApi().createTexture(SamplerType::SAMPLER_2D, 1,
+            TextureFormat::RGBA8, 1, SIZE, SIZE, 1, TextureUsage::COLOR_ATTACHMENT);
+    auto renderTarget = getDriverApi().createRenderTarget(
+            TargetBufferFlags::COLOR0, SIZE, SIZE, 1, {{colorTexture}}, {}, {});
+
+    // A small triangle on the left edge, which the uniforms move to the right.
+    TrianglePrimitive triangle(getDriverApi());
+    const math::float2 v[3] {{-1.0f, -0.5f}, {-0.9f, -0.5f}, {-1.0f, 0.5f}};
+    triangle.updateVertices(v);
+
+    PipelineState state;
+    state.program = program;
+    state.rasterState.colorWrite = true;
+    state.rasterState.depthWrite = false;
+    state.rasterState.depthFunc = RasterState::DepthFunc::A;
+    state.rasterState.culling = CullingMode::NONE;
+
+    RenderPassParams params = {};
+    params.viewport.width = SIZE;
+    params.viewport.height = SIZE;
+    params.flags.discardEnd = TargetBufferFlags::NONE;
+
+    auto freeCallback = [](void* buffer, size_t size, void* user) { free(buffer); };
+
+    auto run = [&](BufferUsage usage, Readback& readback) {
+        auto ubuffer = getDriverApi().createBufferObject(UNIFORM_SIZE,
+                BufferObjectBinding::UNIFORM, usage);
+        getDriverApi().bindUniformBuffer(0, ubuffer);
+
+        const auto start = std::chrono::steady_clock::now();
+
+        for (size_t frame = 0; frame < FRAME_COUNT; frame++) {
+            getDriverApi().makeCurrent(swapChain, swapChain);
+            getDriverApi().beginFrame(0, 0);
+
+            params.flags.clear = TargetBufferFlags::COLOR;
+            params.flags.discardStart = TargetBufferFlags::ALL;
+            params.clearColor = {0.f, 1.f, 0.f, 1.f};
+
+            for (size_t draw = 0; draw < DRAWS_PER_FRAME; draw++) {
+                auto* uniforms = (ParamsBlock*) calloc(1, UNIFORM_SIZE);
+                uniforms->params = {
+                    .color = { float(draw) / DRAWS_PER_FRAME, 0.0f, 1.0f, 1.0f },
+                    .offset = { 1.8f * float(draw) / DRAWS_PER_FRAME, 0.0f, 0.0f, 0.0f }
+                };
+                getDriverApi().updateBufferObject(ubuffer,
+                        BufferDescriptor(uniforms, UNIFORM_SIZE, freeCallback), 0);
+
+                // Buffer updates aren't allowed within a render pass on all backends.
+                getDriverApi().beginRenderPass(renderTarget, params);
+                getDriverApi().draw(state, triangle.getRenderPrimitive(), 1);
+                getDriverApi().endRenderPass();
+
+                params.flags.clear = TargetBufferFlags::NONE;
+                params.flags.discardStart = TargetBufferFlags::NONE;
+            }
+
+            if (frame == FRAME_COUNT - 1) {
+                readPixels(renderTarget, SIZE, SIZE, readback);
+            }
+
+            getDriverApi().commit(swapChain);
+            getDriverApi().endFrame(0);
+
+            // Execute every frame, so that the command stream does not need to hold the whole test.
+            executeCommands();
+        }
+
+        flushAndWait();
+
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        const double updates = double(FRAME_COUNT * DRAWS_PER_FRAME);
+        utils::slog.i << "UniformBufferStreamingThroughput ("
+                << (usage == BufferUsage::STREAM ? "STREAM" : "DYNAMIC") << "): "
+                << updates / elapsed.count() << " updates/s, "
+                << updates * UNIFORM_SIZE / (elapsed.count() * 1024.0 * 1024.0) << " MiB/s"
+                << utils::io::endl;
+
+        getDriverApi().destroyBufferObject(ubuffer);
+    };
+
+    Readback dynamicReadback;
+    Readback streamReadback;
+    run(BufferUsage::DYNAMIC, dynamicReadback);
+    run(BufferUsage::STREAM, streamReadback);
+
+    getDriverApi().destroyProgram(program);
+    getDriverApi().destroySwapChain(swapChain);
+    getDriverApi().destroyRenderTarget(renderTarget);
+    getDriverApi().destroyTexture(colorTexture);
+
+    // This ensures all driver commands have finished before exiting the test.
+    getDriverApi().finish();
+
+    executeCommands();
+
+    getDriver().purge();
+
+    ASSERT_TRUE(dynamicReadback.ready);
+    ASSERT_TRUE(streamReadback.ready);
+    EXPECT_TRUE(dynamicReadback.pixels == streamReadback.pixels);
+
+    // Both images must show the per-draw colors, otherwise the comparison above would also pass
+    // if the uniforms were never read. Triangles only partially overlap, so most draw calls leave
+    // some pixels of their own color.
+    std::vector<bool> reds(256);
+    for (size_t i = 0; i < dynamicReadback.pixels.size(); i += 4) {
+        uint8_t const* pixel = dynamicReadback.pixels.data() + i;
+        if (pixel[1] == 0 && pixel[2] == 255) {
+            reds[pixel[0]] = true;
+        }
+    }
+    EXPECT_GE(std::count(reds.begin(), reds.end(), true), DRAWS_PER_FRAME / 2);
+}
+
 } // namespace test
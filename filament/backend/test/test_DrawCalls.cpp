@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "BackendTest.h"
+
+#include "ShaderGenerator.h"
+#include "TrianglePrimitive.h"
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Shaders
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string vertex (R"(#version 450 core
+
+layout(location = 0) in vec4 mesh_position;
+
+uniform Params {
+    highp vec4 color;
+    highp vec4 offset;
+} params;
+
+void main() {
+    gl_Position = vec4(mesh_position.xy + params.offset.xy, 0.0, 1.0);
+#if defined(TARGET_VULKAN_ENVIRONMENT)
+    // In Vulkan, clip space is Y-down. In OpenGL and Metal, clip space is Y-up.
+    gl_Position.y = -gl_Position.y;
+#endif
+}
+)");
+
+std::string fragment (R"(#version 450 core
+
+layout(location = 0) out vec4 fragColor;
+
+uniform Params {
+    highp vec4 color;
+    highp vec4 offset;
+} params;
+
+void main() {
+    fragColor = vec4(params.color.rgb, 1.0f);
+}
+
+)");
+
+}
+
+namespace test {
+
+using namespace filament;
+using namespace filament::backend;
+
+struct MaterialParams {
+    math::float4 color;
+    math::float4 offset;
+};
+
+// This test renders many overlapping triangles in a single render pass, which is enough for the
+// Vulkan backend to split the pass into several chunks recorded on different threads when
+// FILAMENT_VULKAN_PARALLEL_RECORDING is enabled. The same draw calls are then rendered in passes
+// too small to be split, and both results must be identical. Since the triangles overlap, this
+// checks that the draw order is preserved across chunks, and that every chunk sees the right
+// pipeline state and bindings.
+TEST_F(BackendTest, ManyDrawCallsInOneRenderPass) {
+    constexpr uint32_t GRID_SIZE = 32;
+    constexpr uint32_t DRAW_COUNT = GRID_SIZE * GRID_SIZE;
+    constexpr uint32_t DRAWS_PER_SMALL_PASS = 64;
+    constexpr uint32_t SIZE = 512;
+
+    // Uniform buffer offsets must be aligned to minUniformBufferOffsetAlignment, which is at most
+    // 256 bytes.
+    constexpr uint32_t UNIFORM_STRIDE = 256;
+    static_assert(sizeof(MaterialParams) <= UNIFORM_STRIDE);
+
+    // Create a platform-specific SwapChain and make it current.
+    auto swapChain = createSwapChain();
+    getDriverApi().makeCurrent(swapChain, swapChain);
+
+    ShaderGenerator shaderGen(vertex, fragment, sBackend, sIsMobilePlatform);
+    Program p = shaderGen.getProgram(getDriverApi());
+    auto program = getDriverApi().createProgram(std::move(p));
+
+    Handle<HwTexture> colorTextures[2];
+    Handle<HwRenderTarget> renderTargets[2];
+    for (size_t i = 0; i < 2; i++) {
+        colorTextures[i] = getDriverApi().createTexture(SamplerType::SAMPLER_2D, 1,
+                TextureFormat::RGBA8, 1, SIZE, SIZE, 1, TextureUsage::COLOR_ATTACHMENT);
+        renderTargets[i] = getDriverApi().createRenderTarget(
+                TargetBufferFlags::COLOR0, SIZE, SIZE, 1, {{colorTextures[i]}}, {}, {});
+    }
+
+    // A small triangle in the bottom-left corner, which each draw call moves to its grid cell.
+    // Triangles are larger than grid cells, so each one partially covers the previous ones.
+    TrianglePrimitive triangle(getDriverApi());
+    const math::float2 v[3] {{-1.0f, -1.0f}, {-0.75f, -1.0f}, {-1.0f, -0.75f}};
+    triangle.updateVertices(v);
+
+    // Every draw call gets its own color and offset, in its own range of the uniform buffer.
+    auto* uniforms = (uint8_t*) calloc(DRAW_COUNT, UNIFORM_STRIDE);
+    for (uint32_t i = 0; i < DRAW_COUNT; i++) {
+        const uint32_t column = i % GRID_SIZE;
+        const uint32_t row = i / GRID_SIZE;
+        const float step = 1.75f / GRID_SIZE;
+        *(MaterialParams*) (uniforms + i * UNIFORM_STRIDE) = {
+            .color = { float(column) / (GRID_SIZE - 1), float(row) / (GRID_SIZE - 1),
+                    float(i % 7) / 6.0f, 1.0f },
+            .offset = { float(column) * step, float(row) * step, 0.0f, 0.0f }
+        };
+    }
+    auto ubuffer = getDriverApi().createBufferObject(DRAW_COUNT * UNIFORM_STRIDE,
+            BufferObjectBinding::UNIFORM, BufferUsage::STATIC);
+    getDriverApi().updateBufferObject(ubuffer, BufferDescriptor(uniforms,
+            DRAW_COUNT * UNIFORM_STRIDE, [](void* buffer, size_t, void*) { free(buffer); }), 0);
+
+    PipelineState state;
+    state.program = program;
+    state.rasterState.colorWrite = true;
+    state.rasterState.depthWrite = false;
+    state.rasterState.depthFunc = RasterState::DepthFunc::A;
+    state.rasterState.culling = CullingMode::NONE;
+
+    auto render = [&](Handle<HwRenderTarget> renderTarget, uint32_t drawsPerPass) {
+        RenderPassParams params = {};
+        params.viewport.width = SIZE;
+        params.viewport.height = SIZE;
+        params.flags.clear = TargetBufferFlags::COLOR;
+        params.flags.discardStart = TargetBufferFlags::ALL;
+        params.flags.discardEnd = TargetBufferFlags::NONE;
+        params.clearColor = {0.f, 0.f, 0.f, 1.f};
+        for (uint32_t first = 0; first < DRAW_COUNT; first += drawsPerPass) {
+            getDriverApi().beginRenderPass(renderTarget, params);
+            for (uint32_t i = first; i < first + drawsPerPass; i++) {
+                getDriverApi().bindUniformBufferRange(0, ubuffer, i * UNIFORM_STRIDE,
+                        sizeof(MaterialParams));
+                getDriverApi().draw(state, triangle.getRenderPrimitive(), 1);
+            }
+            getDriverApi().endRenderPass();
+            params.flags.clear = TargetBufferFlags::NONE;
+            params.flags.discardStart = TargetBufferFlags::NONE;
+        }
+    };
+
+    getDriverApi().makeCurrent(swapChain, swapChain);
+    getDriverApi().beginFrame(0, 0);
+
+    Readback readbacks[2];
+    render(renderTargets[0], DRAW_COUNT);
+    render(renderTargets[1], DRAWS_PER_SMALL_PASS);
+    readPixels(renderTargets[0], SIZE, SIZE, readbacks[0]);
+    readPixels(renderTargets[1], SIZE, SIZE, readbacks[1]);
+
+    getDriverApi().flush();
+    getDriverApi().commit(swapChain);
+    getDriverApi().endFrame(0);
+
+    getDriverApi().destroyProgram(program);
+    getDriverApi().destroySwapChain(swapChain);
+    getDriverApi().destroyBufferObject(ubuffer);
+    for (size_t i = 0; i < 2; i++) {
+        getDriverApi().destroyRenderTarget(renderTargets[i]);
+        getDriverApi().destroyTexture(colorTextures[i]);
+    }
+
+    // This ensures all driver commands have finished before exiting the test.
+    getDriverApi().finish();
+
+    executeCommands();
+
+    getDriver().purge();
+
+    ASSERT_TRUE(readbacks[0].ready);
+    ASSERT_TRUE(readbacks[1].ready);
+    EXPECT_TRUE(readbacks[0].pixels == readbacks[1].pixels);
+
+    // Make sure that the draw calls actually rendered something with their own colors, rather
+    // than comparing two empty images.
+    size_t coloredCount = 0;
+    for (size_t i = 0; i < readbacks[0].pixels.size(); i += 4) {
+        uint8_t const* pixel = readbacks[0].pixels.data() + i;
+        coloredCount += (pixel[0] | pixel[1] | pixel[2]) != 0;
+    }
+    EXPECT_GT(coloredCount, size_t(SIZE) * SIZE / 2);
+}
+
+} // namespace test
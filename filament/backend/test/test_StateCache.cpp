@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BackendTest.h"
+
+#include "ShaderGenerator.h"
+#include "TrianglePrimitive.h"
+
+#include "private/backend/SamplerGroup.h"
+
+#include <stdlib.h>
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Shaders
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string vertex (R"(#version 450 core
+
+layout(location = 0) in vec4 mesh_position;
+
+void main() {
+    gl_Position = vec4(mesh_position.xy, 0.0, 1.0);
+#if defined(TARGET_VULKAN_ENVIRONMENT)
+    // In Vulkan, clip space is Y-down. In OpenGL and Metal, clip space is Y-up.
+    gl_Position.y *= -1.0f;
+#endif
+}
+)");
+
+std::string fragment (R"(#version 450 core
+
+layout(location = 0) out vec4 fragColor;
+
+// Filament's Vulkan backend requires a descriptor set index of 1 for all samplers.
+// This parameter is ignored for other backends.
+layout(location = 0, set = 1) uniform sampler2D tex;
+
+void main() {
+    fragColor = texture(tex, vec2(0.5));
+}
+
+)");
+
+}
+
+namespace test {
+
+using namespace filament;
+using namespace filament::backend;
+
+// Draws with the same and with different textures, and checks that the OpenGL backend only sets
+// up the texture units of the program, and only binds a texture, when the bound sampler group
+// changed since the previous draw.
+TEST_F(BackendTest, StateCacheTextureBinds) {
+    if (sBackend != Backend::OPENGL) {
+        // other backends don't report state cache statistics
+        return;
+    }
+
+    auto& api = getDriverApi();
+
+    // Create a platform-specific SwapChain and make it current.
+    auto swapChain = createSwapChain();
+    api.makeCurrent(swapChain, swapChain);
+    auto defaultRenderTarget = api.createDefaultRenderTarget(0);
+
+    ShaderGenerator shaderGen(vertex, fragment, sBackend, sIsMobilePlatform);
+    Program prog = shaderGen.getProgram(api);
+    Program::Sampler psamplers[] = { utils::CString("tex"), 0 };
+    prog.setSamplerGroup(0, ShaderStageFlags::ALL_SHADER_STAGE_FLAGS, psamplers, 1);
+    ProgramHandle program = api.createProgram(std::move(prog));
+
+    TrianglePrimitive triangle(api);
+
+    // Two textures, each in its own sampler group.
+    Handle<HwTexture> textures[2];
+    Handle<HwSamplerGroup> sgroups[2];
+    for (size_t i = 0; i < 2; i++) {
+        textures[i] = api.createTexture(SamplerType::SAMPLER_2D, 1,
+                TextureFormat::RGBA8, 1, 4, 4, 1, TextureUsage::SAMPLEABLE);
+        void* buffer = calloc(1, 4 * 4 * 4);
+        api.update3DImage(textures[i], 0, 0, 0, 0, 4, 4, 1, PixelBufferDescriptor(buffer,
+                4 * 4 * 4, PixelDataFormat::RGBA, PixelDataType::UBYTE, 1, 0, 0, 4,
+                [](void* buffer, size_t, void*) { free(buffer); }));
+
+        SamplerGroup samplers(1);
+        SamplerParams sparams = {};
+        sparams.filterMag = SamplerMagFilter::NEAREST;
+        sparams.filterMin = SamplerMinFilter::NEAREST;
+        samplers.setSampler(0, { textures[i], sparams });
+        sgroups[i] = api.createSamplerGroup(samplers.getSize());
+        api.updateSamplerGroup(sgroups[i], samplers.toBufferDescriptor(api));
+    }
+
+    PipelineState state;
+    state.program = program;
+    state.rasterState.colorWrite = true;
+    state.rasterState.depthWrite = false;
+    state.rasterState.depthFunc = RasterState::DepthFunc::A;
+    state.rasterState.culling = CullingMode::NONE;
+
+    RenderPassParams params = {};
+    fullViewport(params);
+    params.flags.clear = TargetBufferFlags::COLOR;
+    params.flags.discardStart = TargetBufferFlags::ALL;
+    params.flags.discardEnd = TargetBufferFlags::NONE;
+
+    auto draw = [&](size_t i) {
+        api.bindSamplers(0, sgroups[i]);
+        api.draw(state, triangle.getRenderPrimitive(), 1);
+    };
+
+    // The first frame uploads the textures and leaves the second one bound, the statistics are
+    // only those of the second frame.
+    api.beginFrame(0, 0);
+    api.beginRenderPass(defaultRenderTarget, params);
+    draw(1);
+    api.endRenderPass();
+    api.flush();
+    api.commit(swapChain);
+    api.endFrame(0);
+
+    api.beginFrame(0, 0);
+    api.beginRenderPass(defaultRenderTarget, params);
+    draw(0);    // set-up, binds the first texture
+    draw(0);    // nothing changed
+    draw(1);    // set-up, binds the second texture
+    draw(1);    // nothing changed
+    draw(1);    // nothing changed
+    draw(0);    // set-up, binds the first texture
+    api.endRenderPass();
+    api.flush();
+    api.commit(swapChain);
+    api.endFrame(0);
+
+    // This ensures all driver commands have finished before reading the statistics.
+    api.finish();
+    executeCommands();
+
+    const StateCacheStats stats = api.getStateCacheStats();
+    EXPECT_EQ(stats.samplerGroups.issued, 3u);
+    EXPECT_EQ(stats.samplerGroups.elided, 3u);
+    EXPECT_EQ(stats.textures.issued, 3u);
+    EXPECT_EQ(stats.textures.elided, 0u);
+
+    api.destroyProgram(program);
+    api.destroySwapChain(swapChain);
+    api.destroyRenderTarget(defaultRenderTarget);
+    for (size_t i = 0; i < 2; i++) {
+        api.destroySamplerGroup(sgroups[i]);
+        api.destroyTexture(textures[i]);
+    }
+
+    api.finish();
+
+    executeCommands();
+
+    getDriver().purge();
+}
+
+} // namespace test
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <filament/Engine.h>
+#include <filament/Texture.h>
+
+#include <math/vec4.h>
+
+#include <random>
+#include <vector>
+
+using namespace filament;
+using namespace filament::math;
+
+// Compares the CPU and GPU paths of Texture::generatePrefilterMipmap().
+// Arguments are the cubemap size and whether the GPU path is requested.
+static void prefilter(benchmark::State& state) {
+    const uint32_t size = uint32_t(state.range(0));
+    const bool gpu = state.range(1) != 0;
+
+    Engine* engine = Engine::create(Engine::Backend::DEFAULT);
+    if (!engine) {
+        state.SkipWithError("no backend available");
+        return;
+    }
+
+    Texture* texture = Texture::Builder()
+            .sampler(Texture::Sampler::SAMPLER_CUBEMAP)
+            .format(Texture::InternalFormat::R11F_G11F_B10F)
+            .usage(Texture::Usage::COLOR_ATTACHMENT | Texture::Usage::SAMPLEABLE)
+            .width(size).height(size).levels(0xFF)
+            .build(*engine);
+
+    // a noisy environment with a few bright spots so that filtering isn't trivial
+    std::default_random_engine gen; // NOLINT
+    std::uniform_real_distribution<float> rand(0.0f, 1.0f);
+    std::vector<float4> environment(size * size * 6);
+    for (float4& texel : environment) {
+        const float v = rand(gen);
+        texel = float4{ v < 0.001f ? float3(64.0f) : float3(v), 1.0f };
+    }
+
+    const size_t faceSize = size * size * sizeof(float4);
+    Texture::FaceOffsets offsets(faceSize);
+
+    Texture::PrefilterOptions options;
+    options.sampleCount = 16;
+    options.gpu = gpu;
+
+    for (auto _ : state) {
+        texture->generatePrefilterMipmap(*engine,
+                { environment.data(), environment.size() * sizeof(float4),
+                  Texture::Format::RGBA, Texture::Type::FLOAT },
+                offsets, &options);
+        engine->flushAndWait();
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * size * size * 6);
+
+    engine->destroy(texture);
+    Engine::destroy(&engine);
+}
+
+BENCHMARK(prefilter)
+        ->ArgNames({ "size", "gpu" })
+        ->Args({ 64, 0 })->Args({ 64, 1 })
+        ->Args({ 256, 0 })->Args({ 256, 1 })
+        ->Args({ 512, 0 })->Args({ 512, 1 })
+        ->Args({ 1024, 0 })->Args({ 1024, 1 })
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
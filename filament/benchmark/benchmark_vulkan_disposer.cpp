@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <benchmark/benchmark.h>
+
+#include "vulkan/VulkanDisposer.h"
+
+#include <vector>
+
+using namespace filament::backend;
+
+namespace {
+
+// Stands in for the driver's handle arena: resources are addressed by their index.
+struct Resources {
+    explicit Resources(size_t count) : storage(count),
+            disposer([](void* user, VulkanResourceType, HandleBase::HandleId) {
+                static_cast<Resources*>(user)->destroyed++;
+            }, this) {
+    }
+    std::vector<VulkanResource> storage;
+    VulkanDisposer disposer;
+    size_t destroyed = 0;
+};
+
+} // anonymous namespace
+
+// Creates, uses and destroys a batch of resources every frame, like transient render targets or
+// per-frame buffers do. The argument is the batch size.
+static void disposerChurn(benchmark::State& state) {
+    const size_t count = size_t(state.range(0));
+    Resources resources(count);
+    VulkanDisposer& disposer = resources.disposer;
+    for (auto _ : state) {
+        for (size_t i = 0; i < count; i++) {
+            disposer.createDisposable(&resources.storage[i], VulkanResourceType::TEXTURE,
+                    HandleBase::HandleId(i));
+        }
+        for (VulkanResource& resource : resources.storage) {
+            disposer.acquire(&resource);
+        }
+        for (VulkanResource& resource : resources.storage) {
+            disposer.removeReference(&resource);
+        }
+        // Resources must outlive the command buffers that used them before they can be reused.
+        for (uint32_t frame = 0; frame < VulkanDisposer::FRAMES_BEFORE_EVICTION; frame++) {
+            disposer.gc();
+        }
+    }
+    benchmark::DoNotOptimize(resources.destroyed);
+    disposer.reset();
+    state.SetItemsProcessed(int64_t(state.iterations() * count));
+}
+
+// Acquires a set of long-lived resources every frame, which is what draw calls do.
+// The argument is the number of resources.
+static void disposerAcquire(benchmark::State& state) {
+    const size_t count = size_t(state.range(0));
+    Resources resources(count);
+    VulkanDisposer& disposer = resources.disposer;
+    for (size_t i = 0; i < count; i++) {
+        disposer.createDisposable(&resources.storage[i], VulkanResourceType::BUFFER_OBJECT,
+                HandleBase::HandleId(i));
+    }
+    for (auto _ : state) {
+        for (VulkanResource& resource : resources.storage) {
+            disposer.acquire(&resource);
+        }
+        disposer.gc();
+    }
+    disposer.reset();
+    state.SetItemsProcessed(int64_t(state.iterations() * count));
+}
+
+BENCHMARK(disposerChurn)->Arg(64)->Arg(1024);
+BENCHMARK(disposerAcquire)->Arg(64)->Arg(1024);
@@ -389,6 +389,27 @@ public:
          */
         Builder& instances(size_t instanceCount) noexcept;
 
+        /**
+         * Specifies the index of the layer this renderable samples from in its material's
+         * texture arrays. The default is 0.
+         *
+         * Renderables that only differ by their textures normally need their own
+         * MaterialInstance, which prevents them from being batched together with automatic
+         * instancing (see Engine::setAutomaticInstancingEnabled()). Instead, textures that share
+         * the same format and size can be packed into the layers of a single
+         * Texture::Sampler::SAMPLER_2D_ARRAY, and renderables can then share one MaterialInstance
+         * and select their layer with getTextureArrayIndex() in the vertex or fragment shader.
+         * The index is stored with the per-renderable uniforms, so it doesn't prevent instancing.
+         *
+         * Filament doesn't pack textures into arrays: the application creates the array texture,
+         * uploads each texture into its own layer (see Texture::setImage() with a zoffset) and
+         * assigns the matching indices. gltfio doesn't do it either, glTF assets keep one
+         * MaterialInstance per material.
+         *
+         * @param index the layer index, returned as an int by getTextureArrayIndex().
+         */
+        Builder& textureArrayIndex(uint32_t index) noexcept;
+
         /**
          * Adds the Renderable component to an entity.
          *
@@ -484,6 +505,20 @@ public:
      */
     bool getLightChannel(Instance instance, unsigned int channel) const noexcept;
 
+    /**
+     * Changes the layer this renderable samples from in its material's texture arrays.
+     *
+     * \see Builder::textureArrayIndex()
+     */
+    void setTextureArrayIndex(Instance instance, uint32_t index) noexcept;
+
+    /**
+     * Returns the layer this renderable samples from in its material's texture arrays.
+     *
+     * \see Builder::textureArrayIndex()
+     */
+    uint32_t getTextureArrayIndex(Instance instance) const noexcept;
+
     /**
      * Changes whether or not the renderable casts shadows.
      *
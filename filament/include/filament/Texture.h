@@ -99,6 +99,12 @@ public:
     struct PrefilterOptions {
         uint16_t sampleCount = 8;   //!< sample count used for filtering
         bool mirror = true;         //!< whether the environment must be mirrored
+        /**
+         * Whether the filtering is done on the GPU. This requires a cubemap created with
+         * Usage::COLOR_ATTACHMENT | Usage::SAMPLEABLE and a color-renderable internal format,
+         * otherwise the CPU path is used.
+         */
+        bool gpu = false;
     private:
         UTILS_UNUSED uintptr_t reserved[3] = {};
     };
@@ -459,6 +465,24 @@ public:
      */
     void generateMipmaps(Engine& engine) const noexcept;
 
+    /**
+     * Restricts sampling to a range of miplevels.
+     *
+     * This is useful for textures whose miplevels are uploaded progressively, e.g. smallest first:
+     * sampling can be limited to the levels that have been uploaded so far, and the range widened
+     * as more levels become available. The Metal backend ignores this, since it always restricts
+     * sampling to the levels that have been uploaded.
+     *
+     * @param engine        Engine this texture is associated to.
+     * @param minLevel      Largest (i.e. most detailed) miplevel that can be sampled.
+     * @param maxLevel      Smallest (i.e. least detailed) miplevel that can be sampled.
+     *
+     * @attention \p engine must be the instance passed to Builder::build()
+     * @attention \p minLevel must not be greater than \p maxLevel, and \p maxLevel must be smaller
+     *            than getLevels().
+     */
+    void setMinMaxLevels(Engine& engine, uint8_t minLevel, uint8_t maxLevel) const;
+
     /**
      * Creates a reflection map from an environment map.
      *
@@ -482,7 +506,8 @@ public:
      * The reflections cubemap's dimension must be a power-of-two.
      *
      * @warning This operation is computationally intensive, especially with large environments and
-     *          is currently synchronous. Expect about 1ms for a 16x16 cubemap.
+     *          is currently synchronous. Expect about 1ms for a 16x16 cubemap. Setting
+     *          PrefilterOptions::gpu moves most of the work to the GPU.
      *
      * @param engine        Reference to the filament::Engine to associate this IndirectLight with.
      * @param buffer        Client-side buffer containing the images to set.
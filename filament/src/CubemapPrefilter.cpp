@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CubemapPrefilter.h"
+
+#include "PerViewUniforms.h"
+#include "PostProcessManager.h"
+#include "ResourceAllocator.h"
+
+#include "details/Engine.h"
+#include "details/Texture.h"
+
+#include "fg/FrameGraph.h"
+#include "fg/FrameGraphResources.h"
+
+#include <filament/Viewport.h>
+
+#include <utils/Systrace.h>
+
+namespace filament {
+
+using namespace backend;
+
+TextureFormat CubemapPrefilter::getSourceFormat(PixelDataFormat format) noexcept {
+    // these are the only two formats accepted by generatePrefilterMipmap()
+    return format == PixelDataFormat::RGBA ? TextureFormat::RGBA16F : TextureFormat::R11F_G11F_B10F;
+}
+
+bool CubemapPrefilter::isSupported(FEngine& engine, FTexture const& texture,
+        Texture::PixelBufferDescriptor const& buffer) noexcept {
+    if (engine.getBackend() == Backend::NOOP) {
+        return false;
+    }
+    if (texture.getTarget() != SamplerType::SAMPLER_CUBEMAP ||
+        !any(texture.getUsage() & TextureUsage::COLOR_ATTACHMENT) ||
+        !any(texture.getUsage() & TextureUsage::SAMPLEABLE)) {
+        return false;
+    }
+    if (buffer.format == PixelDataFormat::RGBA &&
+        buffer.type == PixelDataType::UINT_10F_11F_11F_REV) {
+        // there is no RGBA texture format we can upload packed floats to
+        return false;
+    }
+    FEngine::DriverApi& driver = engine.getDriverApi();
+    return driver.isRenderTargetFormatSupported(texture.getFormat()) &&
+           driver.isTextureFormatMipmappable(getSourceFormat(buffer.format));
+}
+
+void CubemapPrefilter::filter(FEngine& engine, FTexture& texture,
+        Texture::PixelBufferDescriptor&& buffer,
+        Texture::FaceOffsets const& faceOffsets,
+        Texture::PrefilterOptions const& options) {
+    SYSTRACE_CALL();
+
+    FEngine::DriverApi& driver = engine.getDriverApi();
+    const uint32_t size = texture.getWidth();
+
+    /*
+     * Upload the environment and let the backend generate its mipmap chain, which is what
+     * the importance sampling reads from. This replaces the CPU box-filter chain.
+     */
+
+    FTexture* const environment = upcast(Texture::Builder()
+            .sampler(Texture::Sampler::SAMPLER_CUBEMAP)
+            .format(getSourceFormat(buffer.format))
+            .usage(Texture::Usage::SAMPLEABLE | Texture::Usage::COLOR_ATTACHMENT |
+                   Texture::Usage::UPLOADABLE)
+            .width(size).height(size).levels(0xFF)
+            .build(engine));
+
+    environment->setImage(engine, 0, std::move(buffer), faceOffsets);
+    environment->generateMipmaps(engine);
+
+    /*
+     * Filter every level of the destination in a standalone frame graph. Post-process
+     * materials read the per-view uniforms, of which only the viewport matters here.
+     */
+
+    PerViewUniforms uniforms(engine);
+    uniforms.prepareViewport({ 0, 0, size, size }, 0, 0);
+    uniforms.commit(driver);
+    uniforms.bind(driver);
+
+    FrameGraph fg(engine.getResourceAllocator());
+
+    auto input = fg.import("Environment", {
+            .width = size,
+            .height = size,
+            .levels = environment->getLevels(),
+            .type = SamplerType::SAMPLER_CUBEMAP,
+            .format = environment->getFormat()
+    }, FrameGraphTexture::Usage::SAMPLEABLE,
+            FrameGraphTexture{ .handle = environment->getHwHandle() });
+
+    auto output = fg.import("Prefiltered", {
+            .width = size,
+            .height = size,
+            .levels = texture.getLevels(),
+            .type = SamplerType::SAMPLER_CUBEMAP,
+            .format = texture.getFormat()
+    }, FrameGraphTexture::Usage::COLOR_ATTACHMENT,
+            FrameGraphTexture{ .handle = texture.getHwHandle() });
+
+    engine.getPostProcessManager().prefilterCubemap(fg, input, output,
+            options.sampleCount, options.mirror);
+
+    fg.present(output);
+    fg.compile();
+    fg.execute(driver);
+
+    uniforms.terminate(driver);
+    engine.destroy(environment);
+}
+
+} // namespace filament
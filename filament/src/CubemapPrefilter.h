@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_CUBEMAPPREFILTER_H
+#define TNT_FILAMENT_CUBEMAPPREFILTER_H
+
+#include "details/Texture.h"
+
+#include <backend/DriverEnums.h>
+
+#include <utils/compiler.h>
+
+namespace filament {
+
+class FEngine;
+
+/*
+ * GPU implementation of Texture::generatePrefilterMipmap().
+ *
+ * The environment is uploaded to a temporary cubemap whose mip chain is generated by the
+ * backend, then each level of the destination is rendered by a post-process pass that does
+ * the same GGX importance sampling as CubemapIBL::roughnessFilter().
+ */
+class CubemapPrefilter {
+public:
+    // Returns whether the given texture can be filtered on the GPU with this kind of input.
+    static bool isSupported(FEngine& engine, FTexture const& texture,
+            Texture::PixelBufferDescriptor const& buffer) noexcept;
+
+    // The buffer is consumed by the upload of the temporary environment cubemap.
+    static void filter(FEngine& engine, FTexture& texture,
+            Texture::PixelBufferDescriptor&& buffer,
+            Texture::FaceOffsets const& faceOffsets,
+            Texture::PrefilterOptions const& options);
+
+private:
+    // format of the temporary cubemap holding the environment and its mip chain
+    static backend::TextureFormat getSourceFormat(backend::PixelDataFormat format) noexcept;
+};
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_CUBEMAPPREFILTER_H
@@ -47,8 +47,9 @@ PerViewUniforms::PerViewUniforms(FEngine& engine) noexcept
 
     mSamplerGroupHandle = driver.createSamplerGroup(mSamplers.getSize());
 
+    // the per-view uniforms are fully rewritten every frame, often several times
     mUniformBufferHandle = driver.createBufferObject(mUniforms.getSize(),
-            BufferObjectBinding::UNIFORM, BufferUsage::DYNAMIC);
+            BufferObjectBinding::UNIFORM, BufferUsage::STREAM);
 
     // with a clip-space of [-w, w] ==> z' = -z
     // with a clip-space of [0,  w] ==> z' = (w - z)/2
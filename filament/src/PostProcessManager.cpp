@@ -225,6 +225,7 @@ static const MaterialInfo sMaterialList[] = {
         { "flare",                      MATERIAL(FLARE) },
         { "fxaa",                       MATERIAL(FXAA) },
         { "mipmapDepth",                MATERIAL(MIPMAPDEPTH) },
+        { "prefilter",                  MATERIAL(PREFILTER) },
         { "sao",                        MATERIAL(SAO) },
         { "saoBentNormals",             MATERIAL(SAOBENTNORMALS) },
         { "separableGaussianBlur1",     MATERIAL(SEPARABLEGAUSSIANBLUR1) },
@@ -2981,4 +2982,71 @@ FrameGraphId<FrameGraphTexture> PostProcessManager::vsmMipmapPass(FrameGraph& fg
     return depthMipmapPass->in;
 }
 
+void PostProcessManager::prefilterCubemap(FrameGraph& fg,
+        FrameGraphId<FrameGraphTexture> input, FrameGraphId<FrameGraphTexture> output,
+        uint16_t sampleCount, bool mirror) noexcept {
+
+    // three faces are rendered at once, the positive ones then the negative ones
+    constexpr size_t MAX_LEVEL_COUNT = 16;
+    struct PrefilterData {
+        FrameGraphId<FrameGraphTexture> in;
+        uint32_t rt[MAX_LEVEL_COUNT][2];
+    };
+
+    auto const& outDesc = fg.getDescriptor(output);
+    const uint32_t size = outDesc.width;
+    const uint8_t levels = outDesc.levels;
+    assert_invariant(outDesc.type == SamplerType::SAMPLER_CUBEMAP);
+    assert_invariant(levels <= MAX_LEVEL_COUNT);
+
+    fg.addPass<PrefilterData>("Prefilter Cubemap",
+            [&](FrameGraph::Builder& builder, auto& data) {
+                data.in = builder.sample(input);
+                for (uint8_t level = 0; level < levels; level++) {
+                    for (uint8_t side = 0; side < 2; side++) {
+                        FrameGraphRenderPass::Descriptor desc;
+                        for (uint8_t axis = 0; axis < 3; axis++) {
+                            // faces are ordered +x, -x, +y, -y, +z, -z
+                            auto face = builder.createSubresource(output, "Prefiltered face", {
+                                    .level = level, .layer = uint8_t(axis * 2 + side) });
+                            desc.attachments.color[axis] = builder.write(face,
+                                    FrameGraphTexture::Usage::COLOR_ATTACHMENT);
+                        }
+                        data.rt[level][side] = builder.declareRenderPass("Prefilter Target", desc);
+                    }
+                }
+            },
+            [=](FrameGraphResources const& resources,
+                    auto const& data, DriverApi& driver) {
+
+                auto const& material = getPostProcessMaterial("prefilter");
+                FMaterialInstance* const mi = material.getMaterialInstance(mEngine);
+
+                // solid angle of a texel of the base level, see CubemapIBL::roughnessFilter()
+                const float omegaP = (4.0f * f::PI) / float(6 * size * size);
+                // lod = log4(omegaS / omegaP) + log4(K), with K = 4
+                const float lodOffset = 1.0f - std::log2(omegaP) * 0.5f;
+
+                mi->setParameter("environment", resources.getTexture(data.in), {
+                        .filterMag = SamplerMagFilter::LINEAR,
+                        .filterMin = SamplerMinFilter::LINEAR_MIPMAP_LINEAR
+                });
+                mi->setParameter("mirror", mirror ? -1.0f : 1.0f);
+                mi->setParameter("lodOffset", lodOffset);
+
+                const uint32_t numLevels = 1u + ctz(size);
+                for (uint8_t level = 0; level < levels; level++) {
+                    const float lod = saturate(float(level) / (float(numLevels) - 1.0f));
+                    const float linearRoughness = lod * lod;
+                    mi->setParameter("roughness", linearRoughness);
+                    mi->setParameter("sampleCount", uint32_t(level == 0 ? 1u : sampleCount));
+                    for (uint8_t side = 0; side < 2; side++) {
+                        mi->setParameter("side", side == 0 ? 1.0f : -1.0f);
+                        commitAndRender(resources.getRenderPassInfo(data.rt[level][side]),
+                                material, driver);
+                    }
+                }
+            });
+}
+
 } // namespace filament
@@ -237,6 +237,12 @@ public:
             FrameGraphId<FrameGraphTexture> input, uint8_t layer, size_t level,
             math::float4 clearColor, bool finalize) noexcept;
 
+    // Pre-filters the environment cubemap into every level of output for image-based lighting,
+    // see Texture::generatePrefilterMipmap(). input must have a complete mip chain.
+    void prefilterCubemap(FrameGraph& fg,
+            FrameGraphId<FrameGraphTexture> input, FrameGraphId<FrameGraphTexture> output,
+            uint16_t sampleCount, bool mirror) noexcept;
+
     FrameGraphId<FrameGraphTexture> gaussianBlurPass(FrameGraph& fg,
             FrameGraphId<FrameGraphTexture> input,
             FrameGraphId<FrameGraphTexture> output,
@@ -200,6 +200,9 @@ void RenderPass::instanceify() noexcept {
     // we could improve this by including some or all of these "repeat" parameters in the
     // sorting key (e.g. raster state, primitive handle, etc...), the key could even use a small
     // hash of those parameters.
+    // Renderables that only differ by their textures can still be instanced if they share a
+    // single MaterialInstance and select their texture with a per-renderable texture array
+    // index, since the latter is part of PerRenderableData.
 
     UTILS_UNUSED_IN_RELEASE uint32_t drawCallsSavedCount = 0;
 
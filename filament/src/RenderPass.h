@@ -39,6 +39,9 @@
 #include <limits>
 #include <vector>
 
+// for gtest
+class FilamentTest_InstanceifyTextureArrayIndex_Test;
+
 namespace filament {
 
 class FMaterialInstance;
@@ -369,6 +372,7 @@ public:
 
 private:
     friend class FRenderer;
+    friend class ::FilamentTest_InstanceifyTextureArrayIndex_Test;
 
     Command* append(size_t count) noexcept;
     void resize(size_t count) noexcept;
@@ -156,4 +156,12 @@ bool RenderableManager::getLightChannel(Instance instance, unsigned int channel)
     return upcast(this)->getLightChannel(instance, channel);
 }
 
+void RenderableManager::setTextureArrayIndex(Instance instance, uint32_t index) noexcept {
+    upcast(this)->setTextureArrayIndex(instance, index);
+}
+
+uint32_t RenderableManager::getTextureArrayIndex(Instance instance) const noexcept {
+    return upcast(this)->getTextureArrayIndex(instance);
+}
+
 } // namespace filament
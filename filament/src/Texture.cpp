@@ -74,6 +74,10 @@ void Texture::generateMipmaps(Engine& engine) const noexcept {
     upcast(this)->generateMipmaps(upcast(engine));
 }
 
+void Texture::setMinMaxLevels(Engine& engine, uint8_t minLevel, uint8_t maxLevel) const {
+    upcast(this)->setMinMaxLevels(upcast(engine), minLevel, maxLevel);
+}
+
 bool Texture::isTextureFormatSupported(Engine& engine, InternalFormat format) noexcept {
     return FTexture::isTextureFormatSupported(upcast(engine), format);
 }
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "UniformArena.h"
+
+#include "UniformBuffer.h"
+
+#include <utils/Systrace.h>
+#include <utils/debug.h>
+
+#include <algorithm>
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace filament {
+
+using namespace backend;
+
+void UniformArena::init() noexcept {
+    // the buffer objects are created by the first batch
+    mStorage.resize(INITIAL_CAPACITY);
+}
+
+void UniformArena::terminate(DriverApi& driver) {
+    for (Buffer& buffer : mBuffers) {
+        if (buffer.handle) {
+            driver.destroyBufferObject(buffer.handle);
+        }
+        buffer = {};
+    }
+    mStorage.clear();
+    mFreeSlots.clear();
+    mUsed = 0;
+}
+
+uint32_t UniformArena::allocate(size_t size) noexcept {
+    const uint32_t alignedSize = align(size);
+    auto pos = mFreeSlots.find(alignedSize);
+    if (pos != mFreeSlots.end() && !pos->second.empty()) {
+        uint32_t const offset = pos->second.back();
+        pos->second.pop_back();
+        return offset;
+    }
+    if (UTILS_UNLIKELY(mUsed + alignedSize > mStorage.size())) {
+        // the buffer objects are recreated with the new capacity when they're next used
+        mStorage.resize(std::max(uint32_t(mStorage.size() * 2), mUsed + alignedSize));
+    }
+    uint32_t const offset = mUsed;
+    mUsed += alignedSize;
+    return offset;
+}
+
+void UniformArena::free(uint32_t offset, size_t size) noexcept {
+    assert_invariant(offset + size <= mUsed);
+    mFreeSlots[align(size)].push_back(offset);
+}
+
+void UniformArena::write(uint32_t offset, UniformBuffer const& ub) noexcept {
+    assert_invariant(mBatching);
+    const uint32_t size = uint32_t(ub.getSize());
+    assert_invariant(offset + size <= mUsed);
+    memcpy(mStorage.data() + offset, ub.getBuffer(), size);
+    ub.clean();
+
+    mStats.writeCount++;
+    mStats.bytesWritten += size;
+    mDirty = true;
+}
+
+void UniformArena::beginBatch() noexcept {
+    assert_invariant(!mBatching);
+    mBatching = true;
+    mDirty = false;
+    mStats = {};
+}
+
+void UniformArena::endBatch(DriverApi& driver) noexcept {
+    assert_invariant(mBatching);
+    mBatching = false;
+
+    if (mDirty) {
+        // The next buffer object was last used BUFFER_COUNT - 1 frames ago, and its whole content
+        // is replaced, so it never needs to be synchronized with the GPU.
+        mCurrent = (mCurrent + 1) % BUFFER_COUNT;
+        Buffer& buffer = mBuffers[mCurrent];
+        const uint32_t capacity = uint32_t(mStorage.size());
+        if (buffer.capacity != capacity) {
+            // Commands already issued still refer to the old buffer object, they're executed
+            // before its destruction.
+            if (buffer.handle) {
+                driver.destroyBufferObject(buffer.handle);
+            }
+            buffer.handle = driver.createBufferObject(capacity,
+                    BufferObjectBinding::UNIFORM, BufferUsage::DYNAMIC);
+            buffer.capacity = capacity;
+        }
+
+        // the arena can be too large for the CommandStream, so it's copied on the heap
+        void* const data = ::malloc(capacity);
+        memcpy(data, mStorage.data(), capacity);
+        driver.updateBufferObject(buffer.handle, { data, capacity,
+                [](void* buffer, size_t, void*) { ::free(buffer); }}, 0);
+
+        mStats.uploadCount++;
+        mStats.bytesUploaded += capacity;
+    }
+
+    SYSTRACE_CONTEXT();
+    SYSTRACE_VALUE32("UniformArena::updatesSaved", mStats.writeCount - mStats.uploadCount);
+    SYSTRACE_VALUE32("UniformArena::bytesUploaded", mStats.bytesUploaded);
+}
+
+} // namespace filament
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TNT_FILAMENT_UNIFORMARENA_H
+#define TNT_FILAMENT_UNIFORMARENA_H
+
+#include "private/backend/DriverApi.h"
+
+#include <backend/Handle.h>
+
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filament {
+
+class UniformBuffer;
+
+/*
+ * UniformArena packs many small uniform buffers (typically, one per material instance) into a
+ * single backend buffer object per frame, which is bound with bindUniformBufferRange().
+ *
+ * Each client owns a slot in the arena for its whole lifetime. The arena keeps a CPU copy of the
+ * content of all slots. Writes only happen between beginBatch() and endBatch() and only update
+ * the CPU copy. If anything was written, endBatch() switches to the next of BUFFER_COUNT buffer
+ * objects and uploads the whole arena into it with a single updateBufferObject(). A buffer object
+ * is never updated while the frames in flight or the draw calls already issued may read it, and
+ * the backends can replace its storage, since it's always updated as a whole (e.g. GL orphans
+ * it).
+ *
+ * Clients that need to update their uniforms between draw calls (e.g. post-processing) can't use
+ * the arena for these updates, see isBatching().
+ */
+class UniformArena {
+public:
+    // All backends support binding a uniform buffer at an offset multiple of 256 bytes.
+    static constexpr uint32_t ALIGNMENT = 256;
+
+    // Number of buffer objects used in turn, this must cover the frames the GPU may still be
+    // processing, in addition to the current one.
+    static constexpr size_t BUFFER_COUNT = 3;
+
+    struct Stats {
+        uint32_t writeCount = 0;        // number of slots written
+        uint32_t uploadCount = 0;       // number of calls to updateBufferObject()
+        uint32_t bytesWritten = 0;      // number of bytes written into slots
+        uint32_t bytesUploaded = 0;     // number of bytes actually uploaded
+    };
+
+    UniformArena() noexcept = default;
+    UniformArena(UniformArena const& rhs) = delete;
+    UniformArena& operator=(UniformArena const& rhs) = delete;
+
+    void init() noexcept;
+
+    void terminate(backend::DriverApi& driver);
+
+    // Returns the offset of a new slot large enough for `size` bytes. The slot is part of the
+    // buffer object returned by getHandle() after the next batch.
+    uint32_t allocate(size_t size) noexcept;
+
+    // Returns a slot allocated with allocate(). `size` must be the allocated size.
+    void free(uint32_t offset, size_t size) noexcept;
+
+    // Copies the content of `ub` into the slot at `offset`, and marks `ub` as clean. This must
+    // be called between beginBatch() and endBatch().
+    void write(uint32_t offset, UniformBuffer const& ub) noexcept;
+
+    void beginBatch() noexcept;
+
+    // Uploads the arena into the next buffer object if anything was written since beginBatch().
+    void endBatch(backend::DriverApi& driver) noexcept;
+
+    // Whether write() can be called.
+    bool isBatching() const noexcept { return mBatching; }
+
+    // Buffer object holding the content of the arena as of the last endBatch().
+    backend::Handle<backend::HwBufferObject> getHandle() const noexcept {
+        return mBuffers[mCurrent].handle;
+    }
+
+    // Stats since the last call to beginBatch(), i.e. for the current frame.
+    Stats const& getStats() const noexcept { return mStats; }
+
+private:
+    static constexpr uint32_t INITIAL_CAPACITY = 64 * 1024;
+
+    static uint32_t align(size_t size) noexcept {
+        return uint32_t((size + ALIGNMENT - 1) & ~size_t(ALIGNMENT - 1));
+    }
+
+    struct Buffer {
+        backend::Handle<backend::HwBufferObject> handle;
+        uint32_t capacity = 0;
+    };
+
+    std::array<Buffer, BUFFER_COUNT> mBuffers;
+    size_t mCurrent = 0;
+
+    std::vector<uint8_t> mStorage;      // CPU copy of the arena, mStorage.size() is the capacity
+    uint32_t mUsed = 0;
+
+    // free slots, by (aligned) size. Material instances of a same material share the same size,
+    // so slots are almost always reused as is.
+    std::unordered_map<uint32_t, std::vector<uint32_t>> mFreeSlots;
+
+    bool mBatching = false;
+    bool mDirty = false;                // whether anything was written since beginBatch()
+
+    Stats mStats;
+};
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_UNIFORMARENA_H
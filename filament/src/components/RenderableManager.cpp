@@ -37,6 +37,8 @@
 #include <utils/Panic.h>
 #include <utils/debug.h>
 
+#include <limits>
+
 
 using namespace filament::math;
 using namespace utils;
@@ -53,6 +55,7 @@ struct RenderableManager::BuilderDetails {
     uint8_t mPriority = 0x4;
     uint8_t mChannels = 1;
     uint16_t mInstanceCount = 1;
+    uint32_t mTextureArrayIndex = 0;
     bool mCulling : 1;
     bool mCastShadows : 1;
     bool mReceiveShadows : 1;
@@ -235,6 +238,10 @@ RenderableManager::Builder::Result RenderableManager::Builder::build(Engine& eng
     ASSERT_PRECONDITION(mImpl->mSkinningBoneCount <= CONFIG_MAX_BONE_COUNT,
             "bone count > %u", CONFIG_MAX_BONE_COUNT);
 
+    // bone offsets are stored in 16 bits
+    ASSERT_PRECONDITION(mImpl->mSkinningBufferOffset <= std::numeric_limits<uint16_t>::max(),
+            "skinning buffer offset > %u", std::numeric_limits<uint16_t>::max());
+
     for (size_t i = 0, c = mImpl->mEntries.size(); i < c; i++) {
         auto& entry = mImpl->mEntries[i];
 
@@ -299,6 +306,11 @@ RenderableManager::Builder& RenderableManager::Builder::instances(size_t instanc
     return *this;
 }
 
+RenderableManager::Builder& RenderableManager::Builder::textureArrayIndex(uint32_t index) noexcept {
+    mImpl->mTextureArrayIndex = index;
+    return *this;
+}
+
 // ------------------------------------------------------------------------------------------------
 
 FRenderableManager::FRenderableManager(FEngine& engine) noexcept : mEngine(engine) {
@@ -346,6 +358,7 @@ void FRenderableManager::create(
         setMorphing(ci, builder->mMorphTargetCount);
         mManager[ci].channels = builder->mChannels;
         mManager[ci].instanceCount = builder->mInstanceCount;
+        mManager[ci].textureArrayIndex = builder->mTextureArrayIndex;
 
         const uint32_t boneCount = builder->mSkinningBoneCount;
         const uint32_t targetCount = builder->mMorphTargetCount;
@@ -659,6 +672,9 @@ void FRenderableManager::setSkinningBuffer(FRenderableManager::Instance ci,
             "SkinningBuffer overflow (size=%u, count=%u, offset=%u)",
             skinningBuffer->getBoneCount(), count, offset);
 
+    ASSERT_PRECONDITION(offset <= std::numeric_limits<uint16_t>::max(),
+            "SkinningBuffer offset > %u (offset=%u)", std::numeric_limits<uint16_t>::max(), offset);
+
     bones.handle = skinningBuffer->getHwHandle();
     bones.count = uint16_t(count);
     bones.offset = uint16_t(offset);
@@ -108,6 +108,7 @@ public:
     inline void setReceiveShadows(Instance instance, bool enable) noexcept;
     inline void setScreenSpaceContactShadows(Instance instance, bool enable) noexcept;
     inline void setCulling(Instance instance, bool enable) noexcept;
+    inline void setTextureArrayIndex(Instance instance, uint32_t index) noexcept;
 
     inline void setPrimitives(Instance instance, utils::Slice<FRenderPrimitive> const& primitives) noexcept;
 
@@ -138,6 +139,7 @@ public:
     inline uint8_t getPriority(Instance instance) const noexcept;
     inline uint8_t getChannels(Instance instance) const noexcept;
     inline uint16_t getInstanceCount(Instance instance) const noexcept;
+    inline uint32_t getTextureArrayIndex(Instance instance) const noexcept;
 
     struct SkinningBindingInfo {
         backend::Handle<backend::HwBufferObject> handle;
@@ -202,6 +204,7 @@ private:
         MORPH_WEIGHTS,      // filament data, UBO storing a pointer to the morph weights information
         CHANNELS,           // user data
         INSTANCE_COUNT,     // user data
+        TEXTURE_ARRAY_INDEX,// user data
         VISIBILITY,         // user data
         PRIMITIVES,         // user data
         BONES,              // filament data, UBO storing a pointer to the bones information
@@ -214,6 +217,7 @@ private:
             MorphWeights,                    // MORPH_WEIGHTS
             uint8_t,                         // CHANNELS
             uint16_t,                        // INSTANCE_COUNT
+            uint32_t,                        // TEXTURE_ARRAY_INDEX
             Visibility,                      // VISIBILITY
             utils::Slice<FRenderPrimitive>,  // PRIMITIVES
             Bones,                           // BONES
@@ -237,6 +241,7 @@ private:
                 Field<MORPH_WEIGHTS>    morphWeights;
                 Field<CHANNELS>         channels;
                 Field<INSTANCE_COUNT>   instanceCount;
+                Field<TEXTURE_ARRAY_INDEX> textureArrayIndex;
                 Field<VISIBILITY>       visibility;
                 Field<PRIMITIVES>       primitives;
                 Field<BONES>            bones;
@@ -314,6 +319,12 @@ void FRenderableManager::setCulling(Instance instance, bool enable) noexcept {
     }
 }
 
+void FRenderableManager::setTextureArrayIndex(Instance instance, uint32_t index) noexcept {
+    if (instance) {
+        mManager[instance].textureArrayIndex = index;
+    }
+}
+
 void FRenderableManager::setSkinning(Instance instance, bool enable) noexcept {
     if (instance) {
         Visibility& visibility = mManager[instance].visibility;
@@ -368,6 +379,10 @@ uint16_t FRenderableManager::getInstanceCount(Instance instance) const noexcept
     return mManager[instance].instanceCount;
 }
 
+uint32_t FRenderableManager::getTextureArrayIndex(Instance instance) const noexcept {
+    return mManager[instance].textureArrayIndex;
+}
+
 Box const& FRenderableManager::getAABB(Instance instance) const noexcept {
     return mManager[instance].aabb;
 }
@@ -267,6 +267,10 @@ void FEngine::init() {
     slog.i << "FEngine feature level: " << int(driverApi.getFeatureLevel()) << io::endl;
 
     mResourceAllocator = new ResourceAllocator(driverApi);
+    mUniformArena.init();
+    mDebugRegistry.registerProperty("d.uniforms.writes", &debug.uniforms.writes);
+    mDebugRegistry.registerProperty("d.uniforms.uploads", &debug.uniforms.uploads);
+    mDebugRegistry.registerProperty("d.uniforms.bytes_uploaded", &debug.uniforms.bytes_uploaded);
 
     mFullScreenTriangleVb = upcast(VertexBuffer::Builder()
             .vertexCount(3)
@@ -458,6 +462,9 @@ void FEngine::shutdown() {
 
     cleanupResourceListLocked(mFenceListLock, std::move(mFences));
 
+    // this must be done after all material instances are destroyed
+    mUniformArena.terminate(driver);
+
     driver.destroyTexture(mDummyOneTexture);
     driver.destroyTexture(mDummyOneTextureArray);
     driver.destroyTexture(mDummyZeroTexture);
@@ -504,8 +511,18 @@ void FEngine::prepare() {
     // prepare() is called once per Renderer frame. Ideally we would upload the content of
     // UBOs that are visible only. It's not such a big issue because the actual upload() is
     // skipped is the UBO hasn't changed. Still we could have a lot of these.
+    // The material instances committed here update their uniforms in the uniform arena, which
+    // is uploaded at once.
     FEngine::DriverApi& driver = getDriverApi();
 
+    // publish the arena's activity of the previous frame
+    UniformArena::Stats const& stats = mUniformArena.getStats();
+    debug.uniforms.writes = int(stats.writeCount);
+    debug.uniforms.uploads = int(stats.uploadCount);
+    debug.uniforms.bytes_uploaded = int(stats.bytesUploaded);
+
+    mUniformArena.beginBatch();
+
     for (auto& materialInstanceList: mMaterialInstances) {
         materialInstanceList.second.forEach([&driver](FMaterialInstance* item) {
             item->commit(driver);
@@ -519,6 +536,8 @@ void FEngine::prepare() {
 #endif
         material->getDefaultInstance()->commit(driver);
     });
+
+    mUniformArena.endBatch(driver);
 }
 
 void FEngine::gc() {
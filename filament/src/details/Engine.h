@@ -23,6 +23,7 @@
 #include "DFG.h"
 #include "PostProcessManager.h"
 #include "ResourceList.h"
+#include "UniformArena.h"
 
 #include "components/CameraManager.h"
 #include "components/LightManager.h"
@@ -228,6 +229,10 @@ public:
         return *mResourceAllocator;
     }
 
+    UniformArena& getUniformArena() noexcept {
+        return mUniformArena;
+    }
+
     void* streamAlloc(size_t size, size_t alignment) noexcept;
 
     Epoch getEngineEpoch() const { return mEngineEpoch; }
@@ -420,6 +425,7 @@ private:
     FLightManager mLightManager;
     FCameraManager mCameraManager;
     ResourceAllocator* mResourceAllocator = nullptr;
+    UniformArena mUniformArena;
 
     ResourceList<FBufferObject> mBufferObjects{ "BufferObject" };
     ResourceList<FRenderer> mRenderers{ "Renderer" };
@@ -516,6 +522,13 @@ public:
             // capture to file. At the moment, only supported by the Metal backend.
             bool doFrameCapture = false;
         } renderer;
+        struct {
+            // Activity of the uniform arena during the previous frame. These are only updated by
+            // the engine, writing them has no effect.
+            int writes = 0;
+            int uploads = 0;
+            int bytes_uploaded = 0;
+        } uniforms;
         matdbg::DebugServer* server = nullptr;
     } debug;
 };
@@ -54,8 +54,8 @@ FMaterialInstance::FMaterialInstance(FEngine& engine,
 
     if (!material->getUniformInterfaceBlock().isEmpty()) {
         mUniforms.setUniforms(other->getUniformBuffer());
-        mUbHandle = driver.createBufferObject(mUniforms.getSize(),
-                BufferObjectBinding::UNIFORM, backend::BufferUsage::DYNAMIC);
+        mUniformArena = &engine.getUniformArena();
+        mUbOffset = mUniformArena->allocate(mUniforms.getSize());
     }
 
     if (!material->getSamplerInterfaceBlock().isEmpty()) {
@@ -83,8 +83,8 @@ void FMaterialInstance::initDefaultInstance(FEngine& engine, FMaterial const* ma
 
     if (!material->getUniformInterfaceBlock().isEmpty()) {
         mUniforms = UniformBuffer(material->getUniformInterfaceBlock().getSize());
-        mUbHandle = driver.createBufferObject(mUniforms.getSize(),
-                BufferObjectBinding::UNIFORM, backend::BufferUsage::STATIC);
+        mUniformArena = &engine.getUniformArena();
+        mUbOffset = mUniformArena->allocate(mUniforms.getSize());
     }
 
     if (!material->getSamplerInterfaceBlock().isEmpty()) {
@@ -129,14 +129,32 @@ FMaterialInstance::~FMaterialInstance() noexcept = default;
 
 void FMaterialInstance::terminate(FEngine& engine) {
     FEngine::DriverApi& driver = engine.getDriverApi();
-    driver.destroyBufferObject(mUbHandle);
+    if (mUniformArena) {
+        mUniformArena->free(mUbOffset, mUniforms.getSize());
+    }
+    if (mUbHandle) {
+        driver.destroyBufferObject(mUbHandle);
+    }
     driver.destroySamplerGroup(mSbHandle);
 }
 
 void FMaterialInstance::commitSlow(DriverApi& driver) const {
     // update uniforms if needed
     if (mUniforms.isDirty()) {
-        driver.updateBufferObject(mUbHandle, mUniforms.toBufferDescriptor(driver), 0);
+        if (mUniformArena->isBatching()) {
+            mUniformArena->write(mUbOffset, mUniforms);
+            mUniformsInArena = true;
+        } else {
+            // Outside of the engine's batch (e.g. during post-processing) the uniforms can change
+            // between draw calls, so they're uploaded to a buffer of our own. It's always updated
+            // as a whole, which lets the backend replace its storage instead of synchronizing.
+            if (!mUbHandle) {
+                mUbHandle = driver.createBufferObject(mUniforms.getSize(),
+                        BufferObjectBinding::UNIFORM, BufferUsage::DYNAMIC);
+            }
+            driver.updateBufferObject(mUbHandle, mUniforms.toBufferDescriptor(driver), 0);
+            mUniformsInArena = false;
+        }
     }
     if (mSamplers.isDirty()) {
         driver.updateSamplerGroup(mSbHandle, mSamplers.toBufferDescriptor(driver));
@@ -55,8 +55,13 @@ public:
     }
 
     void use(FEngine::DriverApi& driver) const {
-        if (mUbHandle) {
-            driver.bindUniformBuffer(+UniformBindingPoints::PER_MATERIAL_INSTANCE, mUbHandle);
+        if (mUniformArena) {
+            if (mUniformsInArena) {
+                driver.bindUniformBufferRange(+UniformBindingPoints::PER_MATERIAL_INSTANCE,
+                        mUniformArena->getHandle(), mUbOffset, mUniforms.getSize());
+            } else {
+                driver.bindUniformBuffer(+UniformBindingPoints::PER_MATERIAL_INSTANCE, mUbHandle);
+            }
         }
         if (mSbHandle) {
             driver.bindSamplers(+SamplerBindingPoints::PER_MATERIAL_INSTANCE, mSbHandle);
@@ -221,7 +226,11 @@ private:
 
     // keep these grouped, they're accessed together in the render-loop
     FMaterial const* mMaterial = nullptr;
-    backend::Handle<backend::HwBufferObject> mUbHandle;
+    UniformArena* mUniformArena = nullptr;  // null if there are no uniforms
+    uint32_t mUbOffset = 0;                 // offset of our uniforms in mUniformArena
+    // our own uniform buffer, for the commits made outside of the arena's batch
+    mutable backend::Handle<backend::HwBufferObject> mUbHandle;
+    mutable bool mUniformsInArena = false;  // whether the last commit went to mUniformArena
     backend::Handle<backend::HwSamplerGroup> mSbHandle;
 
     UniformBuffer mUniforms;
@@ -247,6 +247,8 @@ void FScene::prepareVisibleRenderables(Range<uint32_t> visibleRenderables) noexc
 
         uboData.objectId = rcm.getEntity(ri).getId();
 
+        uboData.textureArrayIndex = rcm.getTextureArrayIndex(ri);
+
         // TODO: We need to find a better way to provide the scale information per object
         uboData.userData = sceneData.elementAt<USER_DATA>(i);
 
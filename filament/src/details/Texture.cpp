@@ -16,6 +16,8 @@
 
 #include "details/Texture.h"
 
+#include "CubemapPrefilter.h"
+
 #include "details/Engine.h"
 #include "details/Stream.h"
 
@@ -369,6 +371,13 @@ void FTexture::setExternalStream(FEngine& engine, FStream* stream) noexcept {
     }
 }
 
+void FTexture::setMinMaxLevels(FEngine& engine, uint8_t minLevel, uint8_t maxLevel) const {
+    ASSERT_PRECONDITION(minLevel <= maxLevel && maxLevel < mLevelCount,
+            "Invalid miplevel range [%u, %u] for a texture with %u levels.",
+            unsigned(minLevel), unsigned(maxLevel), unsigned(mLevelCount));
+    engine.getDriverApi().setMinMaxLevels(mHandle, minLevel, maxLevel);
+}
+
 void FTexture::generateMipmaps(FEngine& engine) const noexcept {
     ASSERT_PRECONDITION(mTarget != SamplerType::SAMPLER_EXTERNAL,
             "External Textures are not mipmappable.");
@@ -503,6 +512,11 @@ void FTexture::generatePrefilterMipmap(FEngine& engine,
     PrefilterOptions defaultOptions;
     options = options ? options : &defaultOptions;
 
+    if (options->gpu && CubemapPrefilter::isSupported(engine, *this, buffer)) {
+        CubemapPrefilter::filter(engine, *this, std::move(buffer), faceOffsets, *options);
+        return;
+    }
+
     JobSystem& js = engine.getJobSystem();
     FEngine::DriverApi& driver = engine.getDriverApi();
 
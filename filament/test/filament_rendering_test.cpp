@@ -17,19 +17,28 @@
 #include <gtest/gtest.h>
 
 #include <filament/Engine.h>
+#include <filament/RenderTarget.h>
 #include <filament/Renderer.h>
 #include <filament/Skybox.h>
 #include <filament/Scene.h>
 #include <filament/View.h>
 #include <filament/Viewport.h>
 #include <filament/ColorGrading.h>
+#include <filament/Texture.h>
 
 #include <utils/EntityManager.h>
 
 #include <backend/PixelBufferDescriptor.h>
 
+#include <math/vec4.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 using namespace filament;
 using namespace backend;
+using namespace math;
 
 class RenderingTest : public testing::Test {
 protected:
@@ -139,3 +148,86 @@ TEST_F(RenderingTest, ClearGreen) {
         EXPECT_EQ(rgba[3], 0xff);
     });
 }
+
+TEST_F(RenderingTest, PrefilterMatchesCpu) {
+    constexpr uint32_t size = 32;
+    constexpr size_t levelCount = 6;
+
+    // A different color on each face, so that rough levels have to blend neighboring faces.
+    const float3 faceColors[6] = {
+            { 1.0f, 0.2f, 0.2f }, { 0.2f, 1.0f, 0.2f }, { 0.2f, 0.2f, 1.0f },
+            { 1.0f, 1.0f, 0.2f }, { 0.2f, 1.0f, 1.0f }, { 1.0f, 0.2f, 1.0f },
+    };
+    std::vector<float4> environment(size * size * 6);
+    for (size_t face = 0; face < 6; face++) {
+        std::fill_n(environment.begin() + face * size * size, size * size,
+                float4{ faceColors[face], 1.0f });
+    }
+    const Texture::FaceOffsets offsets(size * size * sizeof(float4));
+
+    auto prefilter = [&](bool gpu) {
+        Texture* texture = Texture::Builder()
+                .sampler(Texture::Sampler::SAMPLER_CUBEMAP)
+                .format(Texture::InternalFormat::R11F_G11F_B10F)
+                .usage(Texture::Usage::COLOR_ATTACHMENT | Texture::Usage::SAMPLEABLE)
+                .width(size).height(size).levels(levelCount)
+                .build(*mEngine);
+        Texture::PrefilterOptions options;
+        options.sampleCount = 64;
+        options.gpu = gpu;
+        texture->generatePrefilterMipmap(*mEngine,
+                { environment.data(), environment.size() * sizeof(float4),
+                  Texture::Format::RGBA, Texture::Type::FLOAT },
+                offsets, &options);
+        return texture;
+    };
+    Texture* cpu = prefilter(false);
+    Texture* gpu = prefilter(true);
+
+    // Read back every face of every level of both textures. Faces are compared by their
+    // average color, which doesn't depend on the per-pixel noise of importance sampling nor
+    // on the orientation of the readback.
+    std::vector<std::vector<float4>> pixels[2];
+    mRenderer->beginFrame(mSurface);
+    for (size_t i = 0; i < 2; i++) {
+        Texture* const texture = i == 0 ? cpu : gpu;
+        for (size_t level = 0; level < levelCount; level++) {
+            const uint32_t dim = size >> level;
+            for (size_t face = 0; face < 6; face++) {
+                auto& data = pixels[i].emplace_back(dim * dim);
+                RenderTarget* rt = RenderTarget::Builder()
+                        .texture(RenderTarget::AttachmentPoint::COLOR, texture)
+                        .mipLevel(RenderTarget::AttachmentPoint::COLOR, level)
+                        .face(RenderTarget::AttachmentPoint::COLOR,
+                                RenderTarget::CubemapFace(face))
+                        .build(*mEngine);
+                mRenderer->readPixels(rt, 0, 0, dim, dim, {
+                        data.data(), data.size() * sizeof(float4),
+                        PixelDataFormat::RGBA, PixelDataType::FLOAT });
+                mEngine->destroy(rt);
+            }
+        }
+    }
+    mRenderer->endFrame();
+    mEngine->flushAndWait();
+
+    for (size_t i = 0; i < pixels[0].size(); i++) {
+        float3 averages[2];
+        for (size_t j = 0; j < 2; j++) {
+            float3 sum{};
+            for (float4 const& texel : pixels[j][i]) {
+                sum += texel.rgb;
+            }
+            averages[j] = sum / float(pixels[j][i].size());
+        }
+        const size_t level = i / 6;
+        const size_t face = i % 6;
+        for (size_t c = 0; c < 3; c++) {
+            EXPECT_NEAR(averages[1][c], averages[0][c], 0.05f)
+                    << "level " << level << ", face " << face << ", channel " << c;
+        }
+    }
+
+    mEngine->destroy(cpu);
+    mEngine->destroy(gpu);
+}
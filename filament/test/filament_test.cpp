@@ -31,6 +31,9 @@
 #include <filament/Frustum.h>
 #include <filament/Material.h>
 #include <filament/Engine.h>
+#include <filament/IndexBuffer.h>
+#include <filament/RenderableManager.h>
+#include <filament/VertexBuffer.h>
 
 #include <private/filament/UniformInterfaceBlock.h>
 #include <private/filament/UibStructs.h>
@@ -40,7 +43,9 @@
 #include "details/Material.h"
 #include "details/Camera.h"
 #include "Froxelizer.h"
+#include "RenderPass.h"
 #include "details/Engine.h"
+#include "details/Scene.h"
 #include "components/RenderableManager.h"
 #include "components/TransformManager.h"
 #include "UniformBuffer.h"
@@ -735,6 +740,97 @@ TEST(FilamentTest, FroxelData) {
     Engine::destroy((Engine **)&engine);
 }
 
+TEST(FilamentTest, InstanceifyTextureArrayIndex) {
+    using namespace filament;
+
+    Engine* engine = Engine::create(Engine::Backend::NOOP);
+    Scene* scene = engine->createScene();
+    FEngine& fengine = upcast(*engine);
+    FScene& fscene = upcast(*scene);
+
+    VertexBuffer* vb = VertexBuffer::Builder()
+            .vertexCount(3)
+            .bufferCount(1)
+            .attribute(VertexAttribute::POSITION, 0, VertexBuffer::AttributeType::FLOAT3)
+            .build(*engine);
+    IndexBuffer* ib = IndexBuffer::Builder()
+            .indexCount(3)
+            .bufferType(IndexBuffer::IndexType::USHORT)
+            .build(*engine);
+
+    // renderables that only differ by their texture array index all share the same
+    // MaterialInstance and geometry
+    constexpr uint32_t count = 4;
+    MaterialInstance const* mi = engine->getDefaultMaterial()->getDefaultInstance();
+    Entity entities[count];
+    engine->getEntityManager().create(count, entities);
+    for (uint32_t i = 0; i < count; i++) {
+        RenderableManager::Builder(1)
+                .boundingBox({{ 0, 0, 0 }, { 1, 1, 1 }})
+                .material(0, mi)
+                .geometry(0, RenderableManager::PrimitiveType::TRIANGLES, vb, ib)
+                .textureArrayIndex(i)
+                .build(*engine, entities[i]);
+        scene->addEntity(entities[i]);
+    }
+
+    // what FView does for the visible renderables
+    fscene.prepare({}, false);
+    FScene::RenderableSoa& soa = fscene.getRenderableData();
+    ASSERT_EQ(soa.size(), count);
+    FRenderableManager& rcm = fengine.getRenderableManager();
+    for (uint32_t i = 0; i < count; i++) {
+        auto ri = soa.elementAt<FScene::RENDERABLE_INSTANCE>(i);
+        soa.elementAt<FScene::PRIMITIVES>(i) = rcm.getRenderPrimitives(ri, 0);
+        soa.elementAt<FScene::VISIBLE_MASK>(i) = 1;
+    }
+    fscene.prepareVisibleRenderables({ 0, count });
+
+    LinearAllocatorArena arena("FilamentTest: commands", 1024 * 1024);
+    utils::ArenaScope<LinearAllocatorArena> scope(arena);
+    const size_t arenaSize = 64 * 1024;
+    void* const arenaBegin = scope.allocate(arenaSize, CACHELINE_SIZE);
+    RenderPass::Arena commandArena("FilamentTest: command arena",
+            { arenaBegin, pointermath::add(arenaBegin, arenaSize) });
+
+    // sort without instancing first, to know which renderable each instance comes from
+    engine->setAutomaticInstancingEnabled(false);
+    RenderPass pass(fengine, commandArena);
+    pass.setGeometry(soa, { 0, count }, {});
+    pass.setCamera({});
+    pass.appendCommands(RenderPass::CommandTypeFlags::COLOR);
+    pass.sortCommands();
+    ASSERT_EQ(pass.end() - pass.begin(), count);
+
+    uint32_t layers[count];
+    PerRenderableData const* uboData = soa.data<FScene::UBO>();
+    for (uint32_t i = 0; i < count; i++) {
+        layers[i] = uboData[pass.begin()[i].primitive.index].textureArrayIndex;
+    }
+    std::sort(std::begin(layers), std::end(layers));
+    for (uint32_t i = 0; i < count; i++) {
+        EXPECT_EQ(layers[i], i);
+    }
+
+    // the draws are merged, and the per-instance data copied in the order above keeps each
+    // renderable's texture array index
+    pass.instanceify();
+    ASSERT_EQ(pass.end() - pass.begin(), 1);
+    EXPECT_EQ(pass.begin()->primitive.instanceCount, count);
+    EXPECT_EQ(pass.begin()->primitive.index, 0);
+    EXPECT_TRUE(pass.mInstancedUboHandle);
+    fengine.getDriverApi().destroyBufferObject(pass.mInstancedUboHandle);
+
+    for (Entity e : entities) {
+        engine->destroy(e);
+    }
+    engine->getEntityManager().destroy(count, entities);
+    engine->destroy(vb);
+    engine->destroy(ib);
+    engine->destroy(scene);
+    Engine::destroy(&engine);
+}
+
 TEST(FilamentTest, GoogleLineDirective) {
     {
         char s[512] = "#line 10 \"foobar\"";
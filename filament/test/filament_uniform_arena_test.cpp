@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "UniformArena.h"
+#include "UniformBuffer.h"
+
+#include <backend/Platform.h>
+
+#include "private/backend/CommandBufferQueue.h"
+#include "private/backend/CommandStream.h"
+
+#include <vector>
+
+using namespace filament;
+using namespace backend;
+
+class UniformArenaTest : public testing::Test {
+protected:
+    ~UniformArenaTest() override {
+        arena.terminate(driverApi);
+        executeCommands();
+        delete driver;
+        DefaultPlatform::destroy(&platform);
+    }
+
+    // Runs the commands issued so far, which releases the uploaded data.
+    void executeCommands() {
+        if (commandBufferQueue.getCircularBuffer().empty()) {
+            return;
+        }
+        commandBufferQueue.flush();
+        for (auto& item : commandBufferQueue.waitForCommands()) {
+            if (item.begin) {
+                driverApi.execute(item.begin);
+                commandBufferQueue.releaseBuffer(item);
+            }
+        }
+        driver->purge();
+    }
+
+    // Writes a dirty UniformBuffer of the given size into the slot at the given offset.
+    void write(uint32_t offset, size_t size) {
+        UniformBuffer ub(size);
+        ub.setUniform(0, float(offset));
+        arena.write(offset, ub);
+        EXPECT_FALSE(ub.isDirty());
+    }
+
+    Backend backend = Backend::NOOP;
+    DefaultPlatform* platform = DefaultPlatform::create(&backend);
+    Driver* driver = platform->createDriver(nullptr, {});
+    CommandBufferQueue commandBufferQueue{ 1024 * 1024, 3 * 1024 * 1024 };
+    CommandStream driverApi{ *driver, commandBufferQueue.getCircularBuffer() };
+    UniformArena arena;
+};
+
+TEST_F(UniformArenaTest, AllocateAndReuse) {
+    constexpr uint32_t A = UniformArena::ALIGNMENT;
+    arena.init();
+
+    // Slots are aligned and packed.
+    EXPECT_EQ(arena.allocate(100), 0);
+    EXPECT_EQ(arena.allocate(A + 1), A);
+    EXPECT_EQ(arena.allocate(A), 3 * A);
+
+    // Freed slots are reused by allocations of the same aligned size only.
+    arena.free(A, A + 1);
+    EXPECT_EQ(arena.allocate(100), 4 * A);
+    EXPECT_EQ(arena.allocate(2 * A), A);
+    arena.free(0, 100);
+    arena.free(3 * A, A);
+    EXPECT_EQ(arena.allocate(A), 3 * A);
+    EXPECT_EQ(arena.allocate(1), 0);
+    EXPECT_EQ(arena.allocate(1), 5 * A);
+}
+
+TEST_F(UniformArenaTest, OneUploadPerBatch) {
+    arena.init();
+    uint32_t slots[8];
+    for (uint32_t& slot : slots) {
+        slot = arena.allocate(64);
+    }
+
+    // Nothing is uploaded before the end of the batch, and then the whole arena is uploaded once.
+    arena.beginBatch();
+    EXPECT_TRUE(arena.isBatching());
+    write(slots[2], 64);
+    write(slots[0], 64);
+    write(slots[7], 64);
+    write(slots[0], 64);
+    EXPECT_EQ(arena.getStats().uploadCount, 0);
+    EXPECT_FALSE(arena.getHandle());
+    arena.endBatch(driverApi);
+    EXPECT_FALSE(arena.isBatching());
+    EXPECT_TRUE(arena.getHandle());
+    EXPECT_EQ(arena.getStats().writeCount, 4);
+    EXPECT_EQ(arena.getStats().bytesWritten, 4 * 64);
+    EXPECT_EQ(arena.getStats().uploadCount, 1);
+    EXPECT_EQ(arena.getStats().bytesUploaded, 64 * 1024);
+
+    // A batch without writes doesn't upload anything, and keeps the same buffer object.
+    auto const handle = arena.getHandle();
+    arena.beginBatch();
+    arena.endBatch(driverApi);
+    EXPECT_EQ(arena.getStats().uploadCount, 0);
+    EXPECT_EQ(arena.getHandle(), handle);
+
+    executeCommands();
+}
+
+TEST_F(UniformArenaTest, BuffersRotate) {
+    arena.init();
+    const uint32_t slot = arena.allocate(64);
+
+    // Each batch with writes uploads into a buffer object that the previous frames don't use.
+    std::vector<Handle<HwBufferObject>> handles;
+    for (size_t i = 0; i < 2 * UniformArena::BUFFER_COUNT; i++) {
+        arena.beginBatch();
+        write(slot, 64);
+        arena.endBatch(driverApi);
+        handles.push_back(arena.getHandle());
+    }
+    for (size_t i = 0; i < handles.size(); i++) {
+        for (size_t j = 1; j < UniformArena::BUFFER_COUNT && i + j < handles.size(); j++) {
+            EXPECT_NE(handles[i], handles[i + j]);
+        }
+        if (i + UniformArena::BUFFER_COUNT < handles.size()) {
+            EXPECT_EQ(handles[i], handles[i + UniformArena::BUFFER_COUNT]);
+        }
+    }
+
+    executeCommands();
+}
+
+TEST_F(UniformArenaTest, GrowDuringBatch) {
+    constexpr uint32_t A = UniformArena::ALIGNMENT;
+    arena.init();
+    const uint32_t first = arena.allocate(A);
+    arena.beginBatch();
+    write(first, A);
+    arena.endBatch(driverApi);
+    EXPECT_EQ(arena.getStats().bytesUploaded, 64 * 1024);
+
+    // Allocating past the capacity of the arena grows it, the next upload is for the new
+    // capacity.
+    arena.beginBatch();
+    uint32_t last = 0;
+    for (size_t i = 0; i < 64 * 1024 / A; i++) {
+        last = arena.allocate(A);
+    }
+    EXPECT_EQ(last, 64 * 1024);
+    write(last, A);
+    arena.endBatch(driverApi);
+    EXPECT_EQ(arena.getStats().uploadCount, 1);
+    EXPECT_EQ(arena.getStats().bytesUploaded, 128 * 1024);
+
+    executeCommands();
+}
@@ -194,8 +194,12 @@ struct PerRenderableData {
     uint32_t objectId;                        // used for picking
     // TODO: We need a better solution, this currently holds the average local scale for the renderable
     float userData;
+    uint32_t textureArrayIndex;               // see RenderableManager::Builder::textureArrayIndex()
+    uint32_t reserved0;
+    uint32_t reserved1;
+    uint32_t reserved2;
 
-    math::float4 reserved[8];
+    math::float4 reserved[7];
 
     static uint32_t packFlagsChannels(
             bool skinning, bool morphing, bool contactShadows, uint8_t channels) noexcept {
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gltfio/Animator.h>
+#include <gltfio/AssetLoader.h>
+#include <gltfio/MaterialProvider.h>
+#include <gltfio/ResourceLoader.h>
+#include <gltfio/TextureProvider.h>
+
+#include <filament/Engine.h>
+
+#include <utils/EntityManager.h>
+#include <utils/NameComponentManager.h>
+#include <utils/Path.h>
+
+#include <benchmark/benchmark.h>
+
+#include "materials/uberarchive.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace filament;
+using namespace filament::gltfio;
+using namespace utils;
+
+// Models that ship with the source tree, relative to GLTFIO_BENCHMARK_MODELS.
+static const char* const kModels[] = {
+    "AnimatedMorphCube/AnimatedMorphCube.gltf",
+    "BusterDrone/scene.gltf",
+    "DamagedHelmet/DamagedHelmet.glb",
+    "FlightHelmet/FlightHelmet.gltf",
+    "lucy/lucy.glb",
+    "shader_ball/shader_ball.gltf",
+};
+
+class GltfioFixture : public benchmark::Fixture {
+protected:
+    Engine* engine = nullptr;
+    NameComponentManager* names = nullptr;
+    MaterialProvider* materials = nullptr;
+    AssetLoader* assetLoader = nullptr;
+    TextureProvider* stbDecoder = nullptr;
+    TextureProvider* ktxDecoder = nullptr;
+
+public:
+    void SetUp(const benchmark::State&) override {
+        engine = Engine::create(Engine::Backend::NOOP);
+        names = new NameComponentManager(EntityManager::get());
+        materials = createUbershaderProvider(engine,
+                UBERARCHIVE_DEFAULT_DATA, UBERARCHIVE_DEFAULT_SIZE);
+        assetLoader = AssetLoader::create({ engine, materials, names });
+        stbDecoder = createStbProvider(engine);
+        ktxDecoder = createKtx2Provider(engine);
+    }
+
+    void TearDown(const benchmark::State&) override {
+        delete stbDecoder;
+        delete ktxDecoder;
+        AssetLoader::destroy(&assetLoader);
+        materials->destroyMaterials();
+        delete materials;
+        delete names;
+        Engine::destroy(&engine);
+    }
+
+    static std::vector<uint8_t> readFile(const Path& path) {
+        std::ifstream in(path.c_str(), std::ifstream::binary | std::ifstream::in);
+        return { std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>() };
+    }
+};
+
+BENCHMARK_DEFINE_F(GltfioFixture, loadResources)(benchmark::State& state) {
+    const Path path = Path(GLTFIO_BENCHMARK_MODELS) + kModels[state.range(0)];
+    const std::vector<uint8_t> content = readFile(path);
+    if (content.empty()) {
+        state.SkipWithError("Unable to read model");
+        return;
+    }
+    state.SetLabel(path.getName());
+
+    const std::string gltfPath = path.getAbsolutePath();
+    ResourceConfiguration configuration = {};
+    configuration.engine = engine;
+    configuration.gltfPath = gltfPath.c_str();
+    configuration.normalizeSkinningWeights = true;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        FilamentAsset* asset = assetLoader->createAsset(content.data(), uint32_t(content.size()));
+        ResourceLoader resourceLoader(configuration);
+        resourceLoader.addTextureProvider("image/png", stbDecoder);
+        resourceLoader.addTextureProvider("image/jpeg", stbDecoder);
+        resourceLoader.addTextureProvider("image/ktx2", ktxDecoder);
+        state.ResumeTiming();
+
+        resourceLoader.loadResources(asset);
+
+        state.PauseTiming();
+        assetLoader->destroyAsset(asset);
+        engine->flushAndWait();
+        state.ResumeTiming();
+    }
+}
+
+BENCHMARK_REGISTER_F(GltfioFixture, loadResources)
+        ->DenseRange(0, sizeof(kModels) / sizeof(kModels[0]) - 1)
+        ->Unit(benchmark::kMillisecond);
+
+// Applies the first animation of an instanced asset, advancing by one 60 Hz frame per iteration.
+BENCHMARK_DEFINE_F(GltfioFixture, applyAnimation)(benchmark::State& state) {
+    const Path path = Path(GLTFIO_BENCHMARK_MODELS) + kModels[state.range(0)];
+    const std::vector<uint8_t> content = readFile(path);
+    if (content.empty()) {
+        state.SkipWithError("Unable to read model");
+        return;
+    }
+    state.SetLabel(path.getName());
+
+    const size_t instanceCount = size_t(state.range(1));
+    std::vector<FilamentInstance*> instances(instanceCount);
+    FilamentAsset* asset = assetLoader->createInstancedAsset(content.data(),
+            uint32_t(content.size()), instances.data(), instanceCount);
+
+    const std::string gltfPath = path.getAbsolutePath();
+    ResourceConfiguration configuration = {};
+    configuration.engine = engine;
+    configuration.gltfPath = gltfPath.c_str();
+    ResourceLoader resourceLoader(configuration);
+    resourceLoader.addTextureProvider("image/png", stbDecoder);
+    resourceLoader.addTextureProvider("image/jpeg", stbDecoder);
+    resourceLoader.addTextureProvider("image/ktx2", ktxDecoder);
+    resourceLoader.loadResources(asset);
+
+    Animator* animator = asset->getAnimator();
+    if (animator->getAnimationCount() == 0) {
+        state.SkipWithError("Model has no animations");
+    } else {
+        float time = 0.0f;
+        for (auto _ : state) {
+            animator->applyAnimation(0, time);
+            time += 1.0f / 60.0f;
+        }
+        state.SetItemsProcessed(int64_t(state.iterations() * instanceCount));
+    }
+
+    assetLoader->destroyAsset(asset);
+    engine->flushAndWait();
+}
+
+BENCHMARK_REGISTER_F(GltfioFixture, applyAnimation)
+        ->RangeMultiplier(16)
+        ->Ranges({ { 0, 1 }, { 1, 256 } })
+        ->Unit(benchmark::kMicrosecond);
@@ -48,9 +48,10 @@ public:
     void applyAnimation(size_t animationIndex, float time) const;
 
     /**
-     * Computes root-to-node transforms for all bone nodes, then passes
-     * the results into filament::RenderableManager::setBones.
-     * Uses filament::TransformManager and filament::RenderableManager.
+     * Computes root-to-node transforms for all bone nodes, then uploads the results into the
+     * asset's filament::SkinningBuffer. Bone matrices are evaluated in parallel using the
+     * engine's JobSystem. Skinned renderables that are not owned by the asset are updated with
+     * filament::RenderableManager::setBones.
      *
      * NOTE: this operation is independent of \c animation.
      */
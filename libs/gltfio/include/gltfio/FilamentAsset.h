@@ -155,7 +155,11 @@ public:
      */
     size_t popRenderables(Entity* entities, size_t count) noexcept;
 
-    /** Gets all material instances. These are already bound to renderables. */
+    /**
+     * Gets all material instances owned by the asset. These are already bound to renderables.
+     * Material instances that are shared through a ResourceCache are owned by the cache and are
+     * not included.
+     */
     const filament::MaterialInstance* const* getMaterialInstances() const noexcept;
 
     /** Gets all material instances (non-const). These are already bound to renderables. */
@@ -315,6 +319,7 @@ public:
      *
      * This makes the client take responsibility for destroying MaterialInstance
      * objects. The getMaterialInstances query becomes invalid after detachment.
+     * Material instances owned by a ResourceCache are not affected.
      */
     void detachMaterialInstances();
 
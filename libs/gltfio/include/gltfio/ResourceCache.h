@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLTFIO_RESOURCECACHE_H
+#define GLTFIO_RESOURCECACHE_H
+
+#include <utils/compiler.h>
+
+#include <stddef.h>
+
+namespace filament {
+    class Engine;
+}
+
+namespace filament::gltfio {
+
+/**
+ * \class ResourceCache ResourceCache.h gltfio/ResourceCache.h
+ * \brief Shares textures and material instances between assets.
+ *
+ * By default, every asset owns its own Texture and MaterialInstance objects, even when several
+ * assets were exported with identical images or identical material parameters. When a cache is
+ * supplied to ResourceLoader (see ResourceConfiguration::cache), textures are keyed by a hash of
+ * their encoded content and material instances are keyed by a hash of their glTF parameters and
+ * bound textures. Assets that resolve to the same key share a single reference-counted object,
+ * which saves GPU memory and allows renderables from different assets to be batched together.
+ *
+ * A single cache can be used with any number of ResourceLoader objects, provided that they all
+ * use the same Engine. Shared objects are destroyed when the last asset referencing them is
+ * destroyed. The cache must outlive all assets that were loaded with it.
+ *
+ * Material instances are shared only if all of their textures are available when the asset's
+ * resources start loading, and never for assets that use KHR_materials_variants. Shared material
+ * instances are owned by the cache, so they are not listed by FilamentAsset::getMaterialInstances()
+ * and cannot be detached with FilamentAsset::detachMaterialInstances(). They can still be
+ * retrieved from the renderables with RenderableManager::getMaterialInstanceAt().
+ */
+class UTILS_PUBLIC ResourceCache {
+public:
+    /**
+     * Creates an empty cache for the given engine. The engine is held weakly.
+     */
+    static ResourceCache* create(filament::Engine* engine);
+
+    /**
+     * Destroys the cache. All assets that were loaded with the cache must be destroyed first.
+     */
+    static void destroy(ResourceCache** cache);
+
+    /** Returns the number of distinct textures that are currently shared through the cache. */
+    size_t getTextureCount() const noexcept;
+
+    /** Returns the number of distinct material instances currently shared through the cache. */
+    size_t getMaterialInstanceCount() const noexcept;
+
+protected:
+    ResourceCache() noexcept = default;
+    ~ResourceCache() = default;
+
+public:
+    ResourceCache(ResourceCache const&) = delete;
+    ResourceCache(ResourceCache&&) = delete;
+    ResourceCache& operator=(ResourceCache const&) = delete;
+    ResourceCache& operator=(ResourceCache&&) = delete;
+};
+
+} // namespace filament::gltfio
+
+#endif // GLTFIO_RESOURCECACHE_H
@@ -24,6 +24,7 @@
 #include <utils/compiler.h>
 
 namespace filament {
+    class Camera;
     class Engine;
 }
 
@@ -31,6 +32,7 @@ namespace filament::gltfio {
 
 struct FFilamentAsset;
 class AssetPool;
+class ResourceCache;
 class TextureProvider;
 
 /**
@@ -57,6 +59,10 @@ struct ResourceConfiguration {
     //! If true, ignores skinning when computing bounding boxes. Implicitly true for instanced
     //! assets. Only applicable when recomputeBoundingBoxes is set to true.
     bool ignoreBindTransform;
+
+    //! Optional cache that allows textures and material instances to be shared with other assets,
+    //! including assets that are loaded by other ResourceLoader instances. See ResourceCache.
+    ResourceCache* cache = nullptr;
 };
 
 /**
@@ -148,9 +154,26 @@ public:
      *
      * Clients must periodically call this until #asyncGetLoadProgress returns 100%.
      * After progress reaches 100%, calling this is harmless; it just does nothing.
+     *
+     * With the built-in texture providers, renderables can become ready before their textures are
+     * complete: every texture first gets a low resolution preview, and its full resolution
+     * miplevels are added by subsequent calls.
      */
     void asyncUpdateLoad();
 
+    /**
+     * Reorders pending texture decoding work for an asynchronous load, such that textures which
+     * cover the largest portion of the screen when seen from the given camera are decoded first.
+     * This also determines the order in which the previews of textures are refined.
+     *
+     * The screen coverage of each texture is estimated from the bounding boxes of the renderables
+     * whose materials reference it. Clients that stream large scenes can call this whenever the
+     * camera moves significantly, and can combine it with TextureProvider::setDecoderBudget() to
+     * bound peak memory usage. Calling this is optional; without it textures are decoded in the
+     * order they were pushed.
+     */
+    void asyncPrioritizeTextures(const filament::Camera& camera);
+
     /**
      * Cancels pending decoder jobs, frees all CPU-side texel data, and flushes the Engine.
      *
@@ -60,6 +60,11 @@ namespace filament::gltfio {
  *         // background decoder work that has been completed (e.g. by calling Texture::setImage).
  *         provider->updateQueue();
  *
+ *         // Check for textures whose smallest miplevels can already be sampled.
+ *         while (Texture* texture = provider->popPreviewTexture()) {
+ *             printf("%p has a low resolution preview.\n", texture);
+ *         }
+ *
  *         // Check for textures that now have all their miplevels initialized.
  *         while (Texture* texture = provider->popTexture()) {
  *             printf("%p has all its miplevels ready.\n", texture);
@@ -101,6 +106,21 @@ public:
      */
     virtual Texture* popTexture() = 0;
 
+    /**
+     * Pops a texture whose smallest miplevels have been uploaded while its larger miplevels are
+     * still pending.
+     *
+     * Providers that load progressively first upload a few low resolution miplevels of each
+     * texture, and restrict sampling to them with Texture::setMinMaxLevels(). The remaining levels
+     * are uploaded later, in priority order. The texture can be used as soon as it is returned by
+     * this method, but it stays in the queue until it is returned by popTexture(), and must not
+     * be freed before then.
+     *
+     * Each texture is returned at most once. Returns null if there are no such textures, which is
+     * always the case for providers that do not load progressively.
+     */
+    virtual Texture* popPreviewTexture() { return nullptr; }
+
     /**
      * Polls textures in the queue and uploads mipmap images if any have emerged from the decoder.
      *
@@ -160,6 +180,27 @@ public:
     /** Total number of textures that have become ready-to-pop since the provider was created. */
     virtual size_t getDecodedCount() const = 0;
 
+    /**
+     * Sets the decoding priority of a texture that was returned by pushTexture().
+     *
+     * Textures with higher priority values are decoded before textures with lower values; the
+     * default priority is zero. Providers that load progressively also use the priority to order
+     * the upload of the larger miplevels. This has no effect on textures whose decoding has already
+     * started. Providers that decode in push order can ignore this.
+     */
+    virtual void setPriority(Texture* texture, float priority) {}
+
+    /**
+     * Limits the amount of CPU memory that can be held by decoded texels that have not yet been
+     * uploaded to the GPU.
+     *
+     * When the budget is exhausted, no new decoding work is started until updateQueue() uploads
+     * some of the pending textures, which bounds peak memory usage while loading large scenes.
+     * Note that at least one texture is always decoded at a time, and that waitForCompletion()
+     * ignores the budget. Zero means unlimited, which is the default.
+     */
+    virtual void setDecoderBudget(size_t byteCount) {}
+
     virtual ~TextureProvider() = default;
 };
 
@@ -23,9 +23,12 @@
 
 #include <filament/VertexBuffer.h>
 #include <filament/RenderableManager.h>
+#include <filament/SkinningBuffer.h>
 #include <filament/TransformManager.h>
 
+#include <utils/JobSystem.h>
 #include <utils/Log.h>
+#include <utils/Systrace.h>
 
 #include <math/mat4.h>
 #include <math/quat.h>
@@ -33,7 +36,8 @@
 #include <math/vec3.h>
 #include <math/vec4.h>
 
-#include <map>
+#include <algorithm>
+#include <cmath>
 #include <string>
 #include <vector>
 
@@ -44,14 +48,15 @@ using namespace utils;
 
 namespace filament::gltfio {
 
-using TimeValues = map<float, size_t>;
+using TimeValues = vector<float>;
 using SourceValues = vector<float>;
 using BoneVector = vector<mat4f>;
 
 struct Sampler {
-    TimeValues times;
+    TimeValues times; // sorted in ascending order
     SourceValues values;
     enum { LINEAR, STEP, CUBIC } interpolation;
+    enum { SCALAR, VEC3, VEC4 } type;
 };
 
 struct Channel {
@@ -60,14 +65,93 @@ struct Channel {
     enum { TRANSLATION, ROTATION, SCALE, WEIGHTS } transformType;
 };
 
+// Keyframe pair and interpolant for a sampler at the most recently applied time. The cursor
+// (index of the first keyframe at or after that time) lets the next lookup start from where the
+// previous one left off, which is almost always the same keyframe or the one after it.
+struct Keyframe {
+    uint32_t cursor = 0;
+    uint32_t prevIndex = 0;
+    uint32_t nextIndex = 0;
+    float t = 0.0f;
+};
+
+// All of the TRS channels that target a single node. Each field is a sampler index, or -1 if the
+// node is not animated along that path.
+struct Track {
+    Entity targetEntity;
+    int32_t translation = -1;
+    int32_t rotation = -1;
+    int32_t scale = -1;
+};
+
 struct Animation {
     float duration;
     std::string name;
     vector<Sampler> samplers;
     vector<Channel> channels;
+
+    // Samplers are evaluated only once per call to applyAnimation, regardless of how many
+    // channels (e.g. across instances) refer to them. They are grouped by value type and
+    // interpolation mode, such that each group is interpolated by a branch-free loop. STEP
+    // samplers are interpolated linearly with an interpolant of zero.
+    vector<Keyframe> keyframes;
+    vector<uint32_t> linearVec3Samplers;
+    vector<uint32_t> cubicVec3Samplers;
+    vector<uint32_t> linearVec4Samplers;
+    vector<uint32_t> cubicVec4Samplers;
+    vector<float3> vec3Values; // indexed by sampler
+    vector<quatf> vec4Values;  // indexed by sampler
+
+    // Derived from channels, rebuilt lazily after instances are added.
+    vector<Track> tracks;
+    vector<const Channel*> weightChannels;
+    bool tracksDirty = true;
+};
+
+// Skins are evaluated in two passes. The first pass computes the joint matrices of every skin
+// (global joint transform times inverse bind matrix), which is independent of the renderables
+// that use the skin. The second pass computes the bone palette of every skinned renderable.
+// Both passes are parallelized over the JobSystem and write into disjoint ranges.
+struct SkinJoints {
+    const Skin* skin;
+    uint32_t offset; // first element in AnimatorImpl::jointMatrices
+};
+
+struct BoneTarget {
+    Entity entity;
+    uint32_t skin;   // index into AnimatorImpl::skinJoints
+    uint32_t offset; // first element in AnimatorImpl::boneMatrices
+};
+
+// Keyframe values of a group of linearly interpolated samplers, gathered into one array per
+// component such that the interpolation loops run over contiguous memory and auto-vectorize.
+// The results are written back into the first endpoint.
+struct LerpBatch {
+    vector<float> t;
+    vector<float> a[4];
+    vector<float> b[4];
+
+    void resize(size_t count) {
+        t.resize(count);
+        for (size_t c = 0; c < 4; ++c) {
+            a[c].resize(count);
+            b[c].resize(count);
+        }
+    }
+};
+
+// Contiguous range of the bone palette that is uploaded with a single call. If buffer is null,
+// the range is uploaded via RenderableManager::setBones.
+struct BoneUpload {
+    SkinningBuffer* buffer;
+    Entity entity;
+    uint32_t bufferOffset;
+    uint32_t offset;
+    uint32_t count;
 };
 
 struct AnimatorImpl {
+    ~AnimatorImpl();
     vector<Animation> animations;
     BoneVector boneMatrices;
     FFilamentAsset* asset = nullptr;
@@ -76,34 +160,49 @@ struct AnimatorImpl {
     TransformManager* transformManager;
     vector<float> weights;
     FixedCapacityVector<mat4f> crossFade;
+    LerpBatch lerpBatch;
+
+    // Skinning plan, rebuilt whenever instances are added or skin targets change.
+    vector<uint32_t> skinsVersions;
+    vector<SkinJoints> skinJoints;
+    vector<BoneTarget> boneTargets;
+    vector<BoneUpload> boneUploads;
+    BoneVector jointMatrices;
+    tsl::robin_map<Entity, SkinningBuffer*, Entity::Hasher> overflowBuffers;
+
     void addChannels(const NodeMap& nodeMap, const cgltf_animation& srcAnim, Animation& dst);
-    void applyAnimation(const Channel& channel, float t, size_t prevIndex, size_t nextIndex);
+    void updateTracks(Animation& anim);
+    void sampleAnimation(Animation& anim, float time);
+    void applyWeights(const Channel& channel, const Keyframe& keyframe);
     void stashCrossFade();
     void applyCrossFade(float alpha);
+    void prepareSkinning();
+    void uploadBoneMatrices();
 };
 
 static void createSampler(const cgltf_animation_sampler& src, Sampler& dst) {
-    // Copy the time values into a red-black tree.
+    // Copy the time values into a flat array.
     const cgltf_accessor* timelineAccessor = src.input;
     const uint8_t* timelineBlob = (const uint8_t*) timelineAccessor->buffer_view->buffer->data;
     const float* timelineFloats = (const float*) (timelineBlob + timelineAccessor->offset +
             timelineAccessor->buffer_view->offset);
-    for (size_t i = 0, len = timelineAccessor->count; i < len; ++i) {
-        dst.times[timelineFloats[i]] = i;
-    }
+    dst.times.assign(timelineFloats, timelineFloats + timelineAccessor->count);
 
     // Convert source data to float.
     const cgltf_accessor* valuesAccessor = src.output;
     switch (valuesAccessor->type) {
         case cgltf_type_scalar:
+            dst.type = Sampler::SCALAR;
             dst.values.resize(valuesAccessor->count);
             cgltf_accessor_unpack_floats(src.output, &dst.values[0], valuesAccessor->count);
             break;
         case cgltf_type_vec3:
+            dst.type = Sampler::VEC3;
             dst.values.resize(valuesAccessor->count * 3);
             cgltf_accessor_unpack_floats(src.output, &dst.values[0], valuesAccessor->count * 3);
             break;
         case cgltf_type_vec4:
+            dst.type = Sampler::VEC4;
             dst.values.resize(valuesAccessor->count * 4);
             cgltf_accessor_unpack_floats(src.output, &dst.values[0], valuesAccessor->count * 4);
             break;
@@ -125,6 +224,47 @@ static void createSampler(const cgltf_animation_sampler& src, Sampler& dst) {
         case cgltf_interpolation_type_max_enum:
             break;
     }
+
+    // The glTF spec requires strictly increasing keyframe times, but in case they are not, sort
+    // the keyframes and their values together.
+    if (!std::is_sorted(dst.times.begin(), dst.times.end()) && !dst.times.empty()) {
+        GLTFIO_WARN("Animation sampler has unsorted keyframes.");
+        const size_t count = dst.times.size();
+        const size_t stride = dst.values.size() / count;
+        vector<size_t> order(count);
+        for (size_t i = 0; i < count; ++i) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [&dst](size_t a, size_t b) {
+            return dst.times[a] < dst.times[b];
+        });
+        TimeValues times(count);
+        SourceValues values(dst.values.size());
+        for (size_t i = 0; i < count; ++i) {
+            times[i] = dst.times[order[i]];
+            std::copy_n(dst.values.data() + order[i] * stride, stride, values.data() + i * stride);
+        }
+        dst.times.swap(times);
+        dst.values.swap(values);
+    }
+}
+
+// Returns the index of the first keyframe at or after the given time, starting the search from
+// the given cursor.
+static uint32_t findKeyframe(const TimeValues& times, float time, uint32_t cursor) {
+    const uint32_t count = uint32_t(times.size());
+
+    // Playback usually advances by less than a keyframe per call, so try a short linear scan.
+    if (cursor <= count && (cursor == 0 || times[cursor - 1] < time)) {
+        for (uint32_t end = std::min(count, cursor + 4); cursor <= end; ++cursor) {
+            if (cursor == count || times[cursor] >= time) {
+                return cursor;
+            }
+        }
+    }
+
+    // Fall back to a binary search, e.g. when the animation loops or jumps.
+    return uint32_t(std::lower_bound(times.begin(), times.end(), time) - times.begin());
 }
 
 static void setTransformType(const cgltf_animation_channel& src, Channel& dst) {
@@ -209,10 +349,21 @@ Animator::Animator(FFilamentAsset* asset, FFilamentInstance* instance) {
             Sampler& dstSampler = dstAnim.samplers[j];
             createSampler(srcSampler, dstSampler);
             if (dstSampler.times.size() > 1) {
-                float maxtime = (--dstSampler.times.end())->first;
+                float maxtime = dstSampler.times.back();
                 dstAnim.duration = std::max(dstAnim.duration, maxtime);
+                const bool cubic = dstSampler.interpolation == Sampler::CUBIC;
+                if (dstSampler.type == Sampler::VEC3) {
+                    (cubic ? dstAnim.cubicVec3Samplers : dstAnim.linearVec3Samplers)
+                            .push_back(uint32_t(j));
+                } else if (dstSampler.type == Sampler::VEC4) {
+                    (cubic ? dstAnim.cubicVec4Samplers : dstAnim.linearVec4Samplers)
+                            .push_back(uint32_t(j));
+                }
             }
         }
+        dstAnim.keyframes.resize(srcAnim.samplers_count);
+        dstAnim.vec3Values.resize(srcAnim.samplers_count);
+        dstAnim.vec4Values.resize(srcAnim.samplers_count);
 
         // Import each glTF channel into a custom data structure.
         if (instance) {
@@ -250,128 +401,244 @@ size_t Animator::getAnimationCount() const {
 }
 
 void Animator::applyAnimation(size_t animationIndex, float time) const {
-    const Animation& anim = mImpl->animations[animationIndex];
+    Animation& anim = mImpl->animations[animationIndex];
     time = fmod(time, anim.duration);
+    mImpl->updateTracks(anim);
+    mImpl->sampleAnimation(anim, time);
+
     TransformManager& transformManager = *mImpl->transformManager;
     transformManager.openLocalTransformTransaction();
-    for (const auto& channel : anim.channels) {
-        const Sampler* sampler = channel.sourceData;
-        if (sampler->times.size() < 2) {
-            continue;
+    for (const Track& track : anim.tracks) {
+        TransformManager::Instance node = transformManager.getInstance(track.targetEntity);
+
+        // Filament stores transforms as mat4's but glTF animation is based on TRS (translation
+        // rotation scale), so paths that are not animated come from the current transform.
+        float3 translation;
+        quatf rotation;
+        float3 scale;
+        if (track.translation < 0 || track.rotation < 0 || track.scale < 0) {
+            decomposeMatrix(transformManager.getTransform(node), &translation, &rotation, &scale);
         }
-
-        const TimeValues& times = sampler->times;
-
-        // Find the first keyframe after the given time, or the keyframe that matches it exactly.
-        TimeValues::const_iterator iter = times.lower_bound(time);
-
-        // Compute the interpolant (between 0 and 1) and determine the keyframe pair.
-        float t = 0.0f;
-        size_t nextIndex;
-        size_t prevIndex;
-        if (iter == times.end()) {
-            nextIndex = times.size() - 1;
-            prevIndex = nextIndex;
-        } else if (iter == times.begin()) {
-            nextIndex = 0;
-            prevIndex = 0;
-        } else {
-            TimeValues::const_iterator prev = iter; --prev;
-            nextIndex = iter->second;
-            prevIndex = prev->second;
-            const float nextTime = iter->first;
-            const float prevTime = prev->first;
-            float deltaTime = nextTime - prevTime;
-            assert(deltaTime >= 0);
-            if (deltaTime > 0) {
-                t = (time - prevTime) / deltaTime;
-            }
+        if (track.translation >= 0) {
+            translation = anim.vec3Values[track.translation];
         }
-
-        if (sampler->interpolation == Sampler::STEP) {
-            t = 0.0f;
+        if (track.rotation >= 0) {
+            rotation = anim.vec4Values[track.rotation];
         }
-
-        mImpl->applyAnimation(channel, t, prevIndex, nextIndex);
+        if (track.scale >= 0) {
+            scale = anim.vec3Values[track.scale];
+        }
+        transformManager.setTransform(node, composeMatrix(translation, rotation, scale));
     }
     transformManager.commitLocalTransformTransaction();
+
+    for (const Channel* channel : anim.weightChannels) {
+        const size_t samplerIndex = channel->sourceData - anim.samplers.data();
+        mImpl->applyWeights(*channel, anim.keyframes[samplerIndex]);
+    }
 }
 
 void Animator::resetBoneMatrices() {
-    auto renderableManager = mImpl->renderableManager;
-
-    auto update = [=](const SkinVector& skins, BoneVector& boneVector) {
-        for (const auto& skin : skins) {
-            size_t njoints = skin.joints.size();
-            boneVector.resize(njoints);
-            for (const auto& entity : skin.targets) {
-                auto renderable = renderableManager->getInstance(entity);
-                if (renderable) {
-                    for (size_t boneIndex = 0; boneIndex < njoints; ++boneIndex) {
-                        boneVector[boneIndex] = mat4f();
-                    }
-                    renderableManager->setBones(renderable, boneVector.data(), boneVector.size());
-                }
+    mImpl->prepareSkinning();
+    std::fill(mImpl->boneMatrices.begin(), mImpl->boneMatrices.end(), mat4f());
+    mImpl->uploadBoneMatrices();
+}
+
+void Animator::updateBoneMatrices() {
+    SYSTRACE_CALL();
+    AnimatorImpl* impl = mImpl;
+    impl->prepareSkinning();
+    if (impl->boneTargets.empty()) {
+        return;
+    }
+
+    JobSystem& js = impl->asset->mEngine->getJobSystem();
+
+    // TransformManager is only read from here, so its getters are safe to call from any thread.
+    auto computeJointMatrices = [impl](const SkinJoints* skins, uint32_t count) {
+        const TransformManager& tm = *impl->transformManager;
+        for (uint32_t s = 0; s < count; ++s) {
+            const Skin& skin = *skins[s].skin;
+            mat4f* UTILS_RESTRICT out = impl->jointMatrices.data() + skins[s].offset;
+            for (size_t i = 0, n = skin.joints.size(); i < n; ++i) {
+                const auto joint = tm.getInstance(skin.joints[i]);
+                out[i] = tm.getWorldTransform(joint) * skin.inverseBindMatrices[i];
             }
         }
     };
 
-    if (mImpl->instance) {
-        update(mImpl->instance->skins, mImpl->boneMatrices);
-    } else {
-        for (FFilamentInstance* instance : mImpl->asset->mInstances) {
-            update(instance->skins, mImpl->boneMatrices);
+    auto computeBoneMatrices = [impl](const BoneTarget* targets, uint32_t count) {
+        const TransformManager& tm = *impl->transformManager;
+        for (uint32_t t = 0; t < count; ++t) {
+            const BoneTarget& target = targets[t];
+            const SkinJoints& skinJoints = impl->skinJoints[target.skin];
+            mat4f inverseGlobalTransform;
+            if (auto xformable = tm.getInstance(target.entity)) {
+                inverseGlobalTransform = inverse(tm.getWorldTransform(xformable));
+            }
+            const mat4f* UTILS_RESTRICT in = impl->jointMatrices.data() + skinJoints.offset;
+            mat4f* UTILS_RESTRICT out = impl->boneMatrices.data() + target.offset;
+            for (size_t i = 0, n = skinJoints.skin->joints.size(); i < n; ++i) {
+                out[i] = inverseGlobalTransform * in[i];
+            }
         }
+    };
+
+    JobSystem::Job* job = jobs::parallel_for(js, nullptr, impl->skinJoints.data(),
+            uint32_t(impl->skinJoints.size()), computeJointMatrices, jobs::CountSplitter<4, 8>());
+    js.runAndWait(job);
+
+    job = jobs::parallel_for(js, nullptr, impl->boneTargets.data(),
+            uint32_t(impl->boneTargets.size()), computeBoneMatrices, jobs::CountSplitter<4, 8>());
+    js.runAndWait(job);
+
+    impl->uploadBoneMatrices();
+}
+
+float Animator::getAnimationDuration(size_t animationIndex) const {
+    return mImpl->animations[animationIndex].duration;
+}
+
+const char* Animator::getAnimationName(size_t animationIndex) const {
+    return mImpl->animations[animationIndex].name.c_str();
+}
+
+AnimatorImpl::~AnimatorImpl() {
+    for (const auto& [entity, buffer] : overflowBuffers) {
+        asset->mEngine->destroy(buffer);
     }
 }
 
-void Animator::updateBoneMatrices() {
-    auto renderableManager = mImpl->renderableManager;
-    auto transformManager = mImpl->transformManager;
+void AnimatorImpl::prepareSkinning() {
+    // Gather the instances that this animator is responsible for.
+    FFilamentInstance* const* instances = &instance;
+    size_t instanceCount = 1;
+    if (!instance) {
+        instances = asset->mInstances.data();
+        instanceCount = asset->mInstances.size();
+    }
 
-    auto update = [=](const SkinVector& skins, BoneVector& boneVector) {
-        for (const Skin& skin : skins) {
-            size_t njoints = skin.joints.size();
-            boneVector.resize(njoints);
+    // Check if the plan is still valid.
+    bool valid = skinsVersions.size() == instanceCount;
+    for (size_t i = 0; valid && i < instanceCount; ++i) {
+        valid = skinsVersions[i] == instances[i]->skinsVersion;
+    }
+    if (valid) {
+        return;
+    }
+    skinsVersions.resize(instanceCount);
+
+    skinJoints.clear();
+    boneTargets.clear();
+    boneUploads.clear();
+
+    // If several skins target the same renderable, the last one wins.
+    tsl::robin_map<Entity, size_t, Entity::Hasher> targetIndices;
+    uint32_t jointCount = 0;
+    for (size_t i = 0; i < instanceCount; ++i) {
+        skinsVersions[i] = instances[i]->skinsVersion;
+        for (const Skin& skin : instances[i]->skins) {
+            const uint32_t skinIndex = uint32_t(skinJoints.size());
+            bool used = false;
             for (Entity entity : skin.targets) {
-                auto renderable = renderableManager->getInstance(entity);
-                if (!renderable) {
+                if (!renderableManager->getInstance(entity)) {
                     continue;
                 }
-                mat4f inverseGlobalTransform;
-                auto xformable = transformManager->getInstance(entity);
-                if (xformable) {
-                    inverseGlobalTransform = inverse(transformManager->getWorldTransform(xformable));
-                }
-                for (size_t boneIndex = 0; boneIndex < njoints; ++boneIndex) {
-                    const auto& joint = skin.joints[boneIndex];
-                    TransformManager::Instance jointInstance = transformManager->getInstance(joint);
-                    mat4f globalJointTransform = transformManager->getWorldTransform(jointInstance);
-                    boneVector[boneIndex] =
-                            inverseGlobalTransform *
-                            globalJointTransform *
-                            skin.inverseBindMatrices[boneIndex];
+                auto [iter, inserted] = targetIndices.insert({ entity, boneTargets.size() });
+                if (inserted) {
+                    boneTargets.push_back({ entity, skinIndex, 0 });
+                } else {
+                    boneTargets[iter->second].skin = skinIndex;
                 }
-                renderableManager->setBones(renderable, boneVector.data(), boneVector.size());
+                used = true;
+            }
+            if (used) {
+                skinJoints.push_back({ &skin, jointCount });
+                jointCount += uint32_t(skin.joints.size());
             }
         }
+    }
+    jointMatrices.resize(jointCount);
+
+    // Renderables that were created by AssetLoader have a slot in a shared skinning buffer. Sort
+    // the targets by slot so that neighboring slots can be uploaded together.
+    auto getSlot = [this](Entity entity) -> const FFilamentAsset::SkinningSlot* {
+        auto iter = asset->mSkinningSlots.find(entity);
+        return iter == asset->mSkinningSlots.end() ? nullptr : &iter->second;
+    };
+    auto getBufferOffset = [&getSlot](const BoneTarget& target) {
+        const FFilamentAsset::SkinningSlot* slot = getSlot(target.entity);
+        return std::make_pair(slot ? slot->buffer : nullptr, slot ? slot->offset : 0u);
     };
+    std::sort(boneTargets.begin(), boneTargets.end(),
+            [&getBufferOffset](const BoneTarget& a, const BoneTarget& b) {
+        return getBufferOffset(a) < getBufferOffset(b);
+    });
+
+    uint32_t boneCount = 0;
+    for (BoneTarget& target : boneTargets) {
+        const uint32_t count = uint32_t(skinJoints[target.skin].skin->joints.size());
+        const FFilamentAsset::SkinningSlot* slot = getSlot(target.entity);
+
+        // Renderables without a slot (e.g. those that are not owned by the asset) are updated
+        // individually, just like renderables whose slot is too small for the attached skin. The
+        // latter are given their own skinning buffer.
+        if (!slot) {
+            target.offset = boneCount;
+            boneUploads.push_back({ nullptr, target.entity, 0, boneCount, count });
+            boneCount += count;
+            continue;
+        }
+        if (count > slot->capacity) {
+            SkinningBuffer*& buffer = overflowBuffers[target.entity];
+            if (!buffer) {
+                buffer = SkinningBuffer::Builder()
+                        .boneCount(FFilamentAsset::SkinningSlot::WINDOW_SIZE)
+                        .initialize()
+                        .build(*asset->mEngine);
+                renderableManager->setSkinningBuffer(renderableManager->getInstance(target.entity),
+                        buffer, count, 0);
+            }
+            target.offset = boneCount;
+            boneUploads.push_back({ buffer, target.entity, 0, boneCount, count });
+            boneCount += count;
+            continue;
+        }
 
-    if (mImpl->instance) {
-        update(mImpl->instance->skins, mImpl->boneMatrices);
-    } else {
-        for (FFilamentInstance* instance : mImpl->asset->mInstances) {
-            update(instance->skins, mImpl->boneMatrices);
+        // Extend the previous upload if this slot immediately follows it, skipping over the
+        // alignment padding.
+        if (!boneUploads.empty()) {
+            BoneUpload& previous = boneUploads.back();
+            const uint32_t end = previous.bufferOffset + previous.count;
+            if (previous.buffer == slot->buffer && slot->offset >= end &&
+                    slot->offset - end < FFilamentAsset::SkinningSlot::ALIGNMENT) {
+                target.offset = previous.offset + (slot->offset - previous.bufferOffset);
+                previous.count = slot->offset + count - previous.bufferOffset;
+                boneCount = previous.offset + previous.count;
+                continue;
+            }
         }
+        target.offset = boneCount;
+        boneUploads.push_back({ slot->buffer, target.entity, slot->offset, boneCount, count });
+        boneCount += count;
     }
-}
 
-float Animator::getAnimationDuration(size_t animationIndex) const {
-    return mImpl->animations[animationIndex].duration;
+    // Padding between slots is never read by the shader, but it is uploaded nonetheless.
+    boneMatrices.clear();
+    boneMatrices.resize(boneCount);
 }
 
-const char* Animator::getAnimationName(size_t animationIndex) const {
-    return mImpl->animations[animationIndex].name.c_str();
+void AnimatorImpl::uploadBoneMatrices() {
+    Engine& engine = *asset->mEngine;
+    for (const BoneUpload& upload : boneUploads) {
+        const mat4f* bones = boneMatrices.data() + upload.offset;
+        if (upload.buffer) {
+            upload.buffer->setBones(engine, bones, upload.count, upload.bufferOffset);
+        } else {
+            renderableManager->setBones(renderableManager->getInstance(upload.entity), bones,
+                    upload.count);
+        }
+    }
 }
 
 void AnimatorImpl::stashCrossFade() {
@@ -455,105 +722,240 @@ void AnimatorImpl::addChannels(const NodeMap& nodeMap, const cgltf_animation& sr
         dstChannel.targetEntity = targetEntity;
         setTransformType(srcChannel, dstChannel);
         dst.channels.push_back(dstChannel);
+        dst.tracksDirty = true;
     }
 }
 
-void AnimatorImpl::applyAnimation(const Channel& channel, float t, size_t prevIndex,
-        size_t nextIndex) {
-    const Sampler* sampler = channel.sourceData;
-    const TimeValues& times = sampler->times;
-    TransformManager::Instance node = transformManager->getInstance(channel.targetEntity);
-
-    // Perform the interpolation. This is a simple but inefficient implementation; Filament
-    // stores transforms as mat4's but glTF animation is based on TRS (translation rotation
-    // scale).
-    mat4f xform = transformManager->getTransform(node);
-    float3 scale;
-    quatf rotation;
-    float3 translation;
-    decomposeMatrix(xform, &translation, &rotation, &scale);
-
-    switch (channel.transformType) {
-
-        case Channel::SCALE: {
-            const float3* srcVec3 = (const float3*) sampler->values.data();
-            if (sampler->interpolation == Sampler::CUBIC) {
-                float3 vert0 = srcVec3[prevIndex * 3 + 1];
-                float3 tang0 = srcVec3[prevIndex * 3 + 2];
-                float3 tang1 = srcVec3[nextIndex * 3];
-                float3 vert1 = srcVec3[nextIndex * 3 + 1];
-                scale = cubicSpline(vert0, tang0, vert1, tang1, t);
-            } else {
-                scale = ((1 - t) * srcVec3[prevIndex]) + (t * srcVec3[nextIndex]);
-            }
-            break;
+void AnimatorImpl::updateTracks(Animation& anim) {
+    if (!anim.tracksDirty) {
+        return;
+    }
+    anim.tracksDirty = false;
+    anim.tracks.clear();
+    anim.weightChannels.clear();
+
+    // Channels are grouped by target node, in order of first appearance. If several channels
+    // animate the same path of the same node, the last one wins.
+    tsl::robin_map<Entity, size_t, Entity::Hasher> trackIndices;
+    for (const Channel& channel : anim.channels) {
+        const Sampler* sampler = channel.sourceData;
+        if (sampler->times.size() < 2) {
+            continue;
+        }
+        if (channel.transformType == Channel::WEIGHTS) {
+            anim.weightChannels.push_back(&channel);
+            continue;
+        }
+        auto [iter, inserted] = trackIndices.insert({ channel.targetEntity, anim.tracks.size() });
+        if (inserted) {
+            anim.tracks.push_back({ channel.targetEntity });
         }
+        Track& track = anim.tracks[iter->second];
+        const int32_t samplerIndex = int32_t(sampler - anim.samplers.data());
+        switch (channel.transformType) {
+            case Channel::TRANSLATION:
+                track.translation = sampler->type == Sampler::VEC3 ? samplerIndex : -1;
+                break;
+            case Channel::ROTATION:
+                track.rotation = sampler->type == Sampler::VEC4 ? samplerIndex : -1;
+                break;
+            case Channel::SCALE:
+                track.scale = sampler->type == Sampler::VEC3 ? samplerIndex : -1;
+                break;
+            case Channel::WEIGHTS:
+                break;
+        }
+    }
+}
 
-        case Channel::TRANSLATION: {
-            const float3* srcVec3 = (const float3*) sampler->values.data();
-            if (sampler->interpolation == Sampler::CUBIC) {
-                float3 vert0 = srcVec3[prevIndex * 3 + 1];
-                float3 tang0 = srcVec3[prevIndex * 3 + 2];
-                float3 tang1 = srcVec3[nextIndex * 3];
-                float3 vert1 = srcVec3[nextIndex * 3 + 1];
-                translation = cubicSpline(vert0, tang0, vert1, tang1, t);
-            } else {
-                translation = ((1 - t) * srcVec3[prevIndex]) + (t * srcVec3[nextIndex]);
-            }
-            break;
+// Linearly interpolates the first three components of a batch.
+static void lerpVec3(LerpBatch& batch, size_t count) noexcept {
+    const float* UTILS_RESTRICT t = batch.t.data();
+    for (size_t c = 0; c < 3; ++c) {
+        float* UTILS_RESTRICT a = batch.a[c].data();
+        const float* UTILS_RESTRICT b = batch.b[c].data();
+        for (size_t i = 0; i < count; ++i) {
+            a[i] = a[i] + t[i] * (b[i] - a[i]);
         }
+    }
+}
 
-        case Channel::ROTATION: {
-            const quatf* srcQuat = (const quatf*) sampler->values.data();
-            if (sampler->interpolation == Sampler::CUBIC) {
-                quatf vert0 = srcQuat[prevIndex * 3 + 1];
-                quatf tang0 = srcQuat[prevIndex * 3 + 2];
-                quatf tang1 = srcQuat[nextIndex * 3];
-                quatf vert1 = srcQuat[nextIndex * 3 + 1];
-                rotation = normalize(cubicSpline(vert0, tang0, vert1, tang1, t));
-            } else {
-                rotation = slerp(srcQuat[prevIndex], srcQuat[nextIndex], t);
+// Spherically interpolates a batch of quaternions (stored as x, y, z, w), taking the short side.
+// Rather than slerp, which needs acos and sin, this normalizes a linear interpolation whose
+// interpolant has been corrected with a polynomial in the cosine of the angle, which is within
+// about 1e-3 radians of slerp (see "Approximating slerp", A. Kapoulkine). The loop is branch-free
+// and auto-vectorizes.
+static void slerpQuat(size_t count, const float* UTILS_RESTRICT t,
+        float* UTILS_RESTRICT ax, float* UTILS_RESTRICT ay,
+        float* UTILS_RESTRICT az, float* UTILS_RESTRICT aw,
+        const float* UTILS_RESTRICT bx, const float* UTILS_RESTRICT by,
+        const float* UTILS_RESTRICT bz, const float* UTILS_RESTRICT bw) noexcept {
+    for (size_t i = 0; i < count; ++i) {
+        const float d = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i] + aw[i] * bw[i];
+        const float sign = d < 0.0f ? -1.0f : 1.0f;
+        const float absd = d * sign;
+        const float u = t[i] - 0.5f;
+        const float A = 1.0904f + absd * (-3.2452f + absd * (3.55645f - absd * 1.43519f));
+        const float B = 0.848013f + absd * (-1.06021f + absd * 0.215638f);
+        const float k = A * u * u + B;
+        const float s = t[i] + t[i] * u * (t[i] - 1.0f) * k;
+        const float x = ax[i] + s * (sign * bx[i] - ax[i]);
+        const float y = ay[i] + s * (sign * by[i] - ay[i]);
+        const float z = az[i] + s * (sign * bz[i] - az[i]);
+        const float w = aw[i] + s * (sign * bw[i] - aw[i]);
+        const float n = 1.0f / std::sqrt(x * x + y * y + z * z + w * w);
+        ax[i] = x * n;
+        ay[i] = y * n;
+        az[i] = z * n;
+        aw[i] = w * n;
+    }
+}
+
+static void slerpQuat(LerpBatch& batch, size_t count) noexcept {
+    slerpQuat(count, batch.t.data(),
+            batch.a[0].data(), batch.a[1].data(), batch.a[2].data(), batch.a[3].data(),
+            batch.b[0].data(), batch.b[1].data(), batch.b[2].data(), batch.b[3].data());
+}
+
+void AnimatorImpl::sampleAnimation(Animation& anim, float time) {
+    // Find the keyframe pair and interpolant of every sampler.
+    for (size_t i = 0, n = anim.samplers.size(); i < n; ++i) {
+        const Sampler& sampler = anim.samplers[i];
+        const TimeValues& times = sampler.times;
+        Keyframe& keyframe = anim.keyframes[i];
+        if (times.size() < 2) {
+            continue;
+        }
+        keyframe.cursor = findKeyframe(times, time, keyframe.cursor);
+        keyframe.t = 0.0f;
+        if (keyframe.cursor == times.size()) {
+            keyframe.nextIndex = keyframe.cursor - 1;
+            keyframe.prevIndex = keyframe.nextIndex;
+        } else if (keyframe.cursor == 0) {
+            keyframe.nextIndex = 0;
+            keyframe.prevIndex = 0;
+        } else {
+            keyframe.nextIndex = keyframe.cursor;
+            keyframe.prevIndex = keyframe.cursor - 1;
+            const float nextTime = times[keyframe.nextIndex];
+            const float prevTime = times[keyframe.prevIndex];
+            float deltaTime = nextTime - prevTime;
+            assert(deltaTime >= 0);
+            if (deltaTime > 0) {
+                keyframe.t = (time - prevTime) / deltaTime;
             }
-            break;
         }
+        if (sampler.interpolation == Sampler::STEP) {
+            keyframe.t = 0.0f;
+        }
+    }
 
-        case Channel::WEIGHTS: {
-            const float* const samplerValues = sampler->values.data();
-            assert(sampler->values.size() % times.size() == 0);
-            const int valuesPerKeyframe = sampler->values.size() / times.size();
-
-            if (sampler->interpolation == Sampler::CUBIC) {
-                assert(valuesPerKeyframe % 3 == 0);
-                const int numMorphTargets = valuesPerKeyframe / 3;
-                const float* const inTangents = samplerValues;
-                const float* const splineVerts = samplerValues + numMorphTargets;
-                const float* const outTangents = samplerValues + numMorphTargets * 2;
-
-                weights.resize(numMorphTargets);
-                for (int comp = 0; comp < numMorphTargets; ++comp) {
-                    float vert0 = splineVerts[comp + prevIndex * valuesPerKeyframe];
-                    float tang0 = outTangents[comp + prevIndex * valuesPerKeyframe];
-                    float tang1 = inTangents[comp + nextIndex * valuesPerKeyframe];
-                    float vert1 = splineVerts[comp + nextIndex * valuesPerKeyframe];
-                    weights[comp] = cubicSpline(vert0, tang0, vert1, tang1, t);
-                }
-            } else {
-                weights.resize(valuesPerKeyframe);
-                for (int comp = 0; comp < valuesPerKeyframe; ++comp) {
-                    float previous = samplerValues[comp + prevIndex * valuesPerKeyframe];
-                    float current = samplerValues[comp + nextIndex * valuesPerKeyframe];
-                    weights[comp] = (1 - t) * previous + t * current;
-                }
-            }
+    LerpBatch& batch = lerpBatch;
+
+    // Interpolate linear translation and scale values.
+    const size_t vec3Count = anim.linearVec3Samplers.size();
+    batch.resize(vec3Count);
+    for (size_t i = 0; i < vec3Count; ++i) {
+        const uint32_t index = anim.linearVec3Samplers[i];
+        const Keyframe& keyframe = anim.keyframes[index];
+        const float3* srcVec3 = (const float3*) anim.samplers[index].values.data();
+        const float3 a = srcVec3[keyframe.prevIndex];
+        const float3 b = srcVec3[keyframe.nextIndex];
+        batch.t[i] = keyframe.t;
+        for (size_t c = 0; c < 3; ++c) {
+            batch.a[c][i] = a[c];
+            batch.b[c][i] = b[c];
+        }
+    }
+    lerpVec3(batch, vec3Count);
+    for (size_t i = 0; i < vec3Count; ++i) {
+        anim.vec3Values[anim.linearVec3Samplers[i]] =
+                float3{ batch.a[0][i], batch.a[1][i], batch.a[2][i] };
+    }
 
-            auto ci = renderableManager->getInstance(channel.targetEntity);
-            renderableManager->setMorphWeights(ci, weights.data(), weights.size());
-            return;
+    // Interpolate linear rotation values.
+    const size_t vec4Count = anim.linearVec4Samplers.size();
+    batch.resize(vec4Count);
+    for (size_t i = 0; i < vec4Count; ++i) {
+        const uint32_t index = anim.linearVec4Samplers[i];
+        const Keyframe& keyframe = anim.keyframes[index];
+        const quatf* srcQuat = (const quatf*) anim.samplers[index].values.data();
+        const quatf a = srcQuat[keyframe.prevIndex];
+        const quatf b = srcQuat[keyframe.nextIndex];
+        batch.t[i] = keyframe.t;
+        for (size_t c = 0; c < 4; ++c) {
+            batch.a[c][i] = a[c];
+            batch.b[c][i] = b[c];
+        }
+    }
+    slerpQuat(batch, vec4Count);
+    for (size_t i = 0; i < vec4Count; ++i) {
+        anim.vec4Values[anim.linearVec4Samplers[i]] =
+                quatf{ batch.a[3][i], batch.a[0][i], batch.a[1][i], batch.a[2][i] };
+    }
+
+    // Cubic splines are rare, so these are interpolated one sampler at a time.
+    for (uint32_t index : anim.cubicVec3Samplers) {
+        const Keyframe& keyframe = anim.keyframes[index];
+        const float3* srcVec3 = (const float3*) anim.samplers[index].values.data();
+        const size_t prevIndex = keyframe.prevIndex;
+        const size_t nextIndex = keyframe.nextIndex;
+        float3 vert0 = srcVec3[prevIndex * 3 + 1];
+        float3 tang0 = srcVec3[prevIndex * 3 + 2];
+        float3 tang1 = srcVec3[nextIndex * 3];
+        float3 vert1 = srcVec3[nextIndex * 3 + 1];
+        anim.vec3Values[index] = cubicSpline(vert0, tang0, vert1, tang1, keyframe.t);
+    }
+    for (uint32_t index : anim.cubicVec4Samplers) {
+        const Keyframe& keyframe = anim.keyframes[index];
+        const quatf* srcQuat = (const quatf*) anim.samplers[index].values.data();
+        const size_t prevIndex = keyframe.prevIndex;
+        const size_t nextIndex = keyframe.nextIndex;
+        quatf vert0 = srcQuat[prevIndex * 3 + 1];
+        quatf tang0 = srcQuat[prevIndex * 3 + 2];
+        quatf tang1 = srcQuat[nextIndex * 3];
+        quatf vert1 = srcQuat[nextIndex * 3 + 1];
+        anim.vec4Values[index] = normalize(cubicSpline(vert0, tang0, vert1, tang1, keyframe.t));
+    }
+}
+
+void AnimatorImpl::applyWeights(const Channel& channel, const Keyframe& keyframe) {
+    const Sampler* sampler = channel.sourceData;
+    const TimeValues& times = sampler->times;
+    const size_t prevIndex = keyframe.prevIndex;
+    const size_t nextIndex = keyframe.nextIndex;
+    const float t = keyframe.t;
+
+    const float* const samplerValues = sampler->values.data();
+    assert(sampler->values.size() % times.size() == 0);
+    const int valuesPerKeyframe = sampler->values.size() / times.size();
+
+    if (sampler->interpolation == Sampler::CUBIC) {
+        assert(valuesPerKeyframe % 3 == 0);
+        const int numMorphTargets = valuesPerKeyframe / 3;
+        const float* const inTangents = samplerValues;
+        const float* const splineVerts = samplerValues + numMorphTargets;
+        const float* const outTangents = samplerValues + numMorphTargets * 2;
+
+        weights.resize(numMorphTargets);
+        for (int comp = 0; comp < numMorphTargets; ++comp) {
+            float vert0 = splineVerts[comp + prevIndex * valuesPerKeyframe];
+            float tang0 = outTangents[comp + prevIndex * valuesPerKeyframe];
+            float tang1 = inTangents[comp + nextIndex * valuesPerKeyframe];
+            float vert1 = splineVerts[comp + nextIndex * valuesPerKeyframe];
+            weights[comp] = cubicSpline(vert0, tang0, vert1, tang1, t);
+        }
+    } else {
+        weights.resize(valuesPerKeyframe);
+        for (int comp = 0; comp < valuesPerKeyframe; ++comp) {
+            float previous = samplerValues[comp + prevIndex * valuesPerKeyframe];
+            float current = samplerValues[comp + nextIndex * valuesPerKeyframe];
+            weights[comp] = (1 - t) * previous + t * current;
         }
     }
 
-    xform = composeMatrix(translation, rotation, scale);
-    transformManager->setTransform(node, xform);
+    auto ci = renderableManager->getInstance(channel.targetEntity);
+    renderableManager->setMorphWeights(ci, weights.data(), weights.size());
 }
 
 } // namespace filament::gltfio
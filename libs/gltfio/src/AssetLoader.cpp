@@ -33,6 +33,7 @@
 #include <filament/MorphTargetBuffer.h>
 #include <filament/RenderableManager.h>
 #include <filament/Scene.h>
+#include <filament/SkinningBuffer.h>
 #include <filament/TextureSampler.h>
 #include <filament/TransformManager.h>
 #include <filament/VertexBuffer.h>
@@ -82,6 +83,25 @@ uint32_t computeBindingOffset(const cgltf_accessor* accessor) {
     return uint32_t(accessor->offset + accessor->buffer_view->offset);
 }
 
+using SkinningSlot = FFilamentAsset::SkinningSlot;
+
+static uint32_t getSkinningSlotSize(const cgltf_node* node) {
+    const uint32_t count = uint32_t(node->skin->joints_count);
+    return (count + SkinningSlot::ALIGNMENT - 1) & ~(SkinningSlot::ALIGNMENT - 1);
+}
+
+// Computes the number of bones that are required for a single instance of the given asset.
+static uint32_t computeSkinningBoneCount(const cgltf_data* srcAsset) {
+    uint32_t count = 0;
+    for (cgltf_size i = 0, n = srcAsset->nodes_count; i < n; ++i) {
+        const cgltf_node& node = srcAsset->nodes[i];
+        if (node.mesh && node.skin) {
+            count += getSkinningSlotSize(&node);
+        }
+    }
+    return count;
+}
+
 static const char* getNodeName(const cgltf_node* node, const char* defaultNodeName) {
     if (node->name) return node->name;
     if (node->mesh && node->mesh->name) return node->mesh->name;
@@ -136,6 +156,8 @@ struct FAssetLoader : public AssetLoader {
             Entity parent, bool enableLight, FFilamentInstance* instance);
     void createRenderable(const cgltf_data* srcAsset, const cgltf_node* node, Entity entity,
             const char* name);
+    void reserveSkinningBones(const cgltf_data* srcAsset, size_t numInstances);
+    FFilamentAsset::SkinningSlot allocateSkinningSlot(uint32_t capacity);
     bool createPrimitive(const cgltf_primitive* inPrim, Primitive* outPrim, const UvMap& uvmap,
             const char* name, MaterialInstance* mi);
     void createLight(const cgltf_light* light, Entity entity);
@@ -167,6 +189,9 @@ struct FAssetLoader : public AssetLoader {
 
     // Weak reference to the largest dummy buffer so far in the current loading phase.
     BufferObject* mDummyBufferObject;
+
+    // Number of bones to reserve in the next skinning buffer that is created for the current asset.
+    uint32_t mSkinningBoneReserve = 0;
 };
 
 FILAMENT_UPCAST(AssetLoader)
@@ -228,6 +253,10 @@ FilamentInstance* FAssetLoader::createInstance(FFilamentAsset* primary) {
         slog.e << "There is no scene in the asset." << io::endl;
         return nullptr;
     }
+    mResult = primary;
+    // If the current skinning buffer is full, the next one has room for as many instances as
+    // there are already, such that the number of buffers grows logarithmically.
+    reserveSkinningBones(srcAsset, std::max(size_t(1), primary->mInstances.size()));
     FFilamentInstance* instance = createInstance(primary, srcAsset);
 
     // Import the skin data. This is normally done by ResourceLoader but dynamically created
@@ -308,7 +337,8 @@ void FAssetLoader::createAsset(const cgltf_data* srcAsset, size_t numInstances)
 
     // Create a separate entity hierarchy for each instance. Note that MeshCache (vertex
     // buffers and index buffers) and MatInstanceCache (materials and textures) help avoid
-    // needless duplication of resources.
+    // needless duplication of resources. The bones of all instances are packed into shared buffers.
+    reserveSkinningBones(srcAsset, numInstances);
     for (size_t index = 0; index < numInstances; ++index) {
         if (createInstance(mResult, srcAsset) == nullptr) {
             mError = true;
@@ -535,7 +565,12 @@ void FAssetLoader::createRenderable(const cgltf_data* srcAsset, const cgltf_node
     mResult->mBoundingBox.max = max(mResult->mBoundingBox.max, transformed.max);
 
     if (node->skin) {
-       builder.skinning(node->skin->joints_count);
+        // The window that is bound for this renderable may overlap the slots of subsequent
+        // renderables, but it only reads the bones in its own slot.
+        const SkinningSlot slot = allocateSkinningSlot(getSkinningSlotSize(node));
+        builder.enableSkinningBuffers()
+                .skinning(slot.buffer, node->skin->joints_count, slot.offset);
+        mResult->mSkinningSlots[entity] = slot;
     }
 
     // Per the spec, glTF models must have valid mix / max annotations for position attributes.
@@ -573,6 +608,37 @@ void FAssetLoader::createRenderable(const cgltf_data* srcAsset, const cgltf_node
     ++mResult->mRenderableCount;
 }
 
+void FAssetLoader::reserveSkinningBones(const cgltf_data* srcAsset, size_t numInstances) {
+    mSkinningBoneReserve = uint32_t(std::min(size_t(SkinningSlot::MAX_BONE_COUNT),
+            computeSkinningBoneCount(srcAsset) * numInstances));
+}
+
+FFilamentAsset::SkinningSlot FAssetLoader::allocateSkinningSlot(uint32_t capacity) {
+    // Slots are taken from the most recent buffer of the asset, which persists across calls to
+    // createInstance. Every slot must leave room for an entire window after its offset.
+    SkinningBuffer* buffer = mResult->mSkinningBuffers.empty() ?
+            nullptr : mResult->mSkinningBuffers.back();
+    uint32_t offset = mResult->mSkinningBufferOffset;
+    const uint32_t size = std::max(capacity, SkinningSlot::WINDOW_SIZE);
+    if (!buffer || offset + size > buffer->getBoneCount()) {
+        // Note that the buffer starts out with identity bones, just like the per-renderable bones
+        // that it replaces.
+        const uint32_t boneCount = std::min(SkinningSlot::MAX_BONE_COUNT,
+                std::max(capacity, mSkinningBoneReserve) + SkinningSlot::WINDOW_SIZE);
+        buffer = SkinningBuffer::Builder()
+                .boneCount(boneCount)
+                .initialize()
+                .build(mEngine);
+        mResult->mSkinningBuffers.push_back(buffer);
+        offset = 0;
+    }
+    // RenderableManager stores bone offsets in 16 bits.
+    assert_invariant(offset <= std::numeric_limits<uint16_t>::max());
+    mSkinningBoneReserve -= std::min(capacity, mSkinningBoneReserve);
+    mResult->mSkinningBufferOffset = offset + capacity;
+    return { buffer, offset, capacity };
+}
+
 void FAssetLoader::createMaterialVariants(const cgltf_data* srcAsset, const cgltf_mesh* mesh,
         Entity entity, FFilamentInstance* instance) {
     UvMap uvmap {};
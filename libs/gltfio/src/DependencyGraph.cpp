@@ -16,6 +16,8 @@
 
 #include "DependencyGraph.h"
 
+#include <utility>
+
 using namespace filament;
 using namespace utils;
 
@@ -49,6 +51,45 @@ void DependencyGraph::addEdge(MaterialInstance* mi, const char* parameter) {
     mMaterialToTexture[mi].params[parameter] = nullptr;
 }
 
+void DependencyGraph::replaceMaterial(Material* from, Material* to) {
+    assert(!mFinalized && from != to);
+
+    // Inserting into a robin_map invalidates its iterators, so the old entries are moved out first.
+    if (auto iter = mMaterialToEntity.find(from); iter != mMaterialToEntity.end()) {
+        const auto entities = std::move(iter.value());
+        mMaterialToEntity.erase(iter);
+        auto& target = mMaterialToEntity[to];
+        for (auto entity : entities) {
+            auto& materials = mEntityToMaterial.at(entity).materials;
+            materials.erase(from);
+            materials.insert(to);
+            target.insert(entity);
+        }
+    }
+
+    auto iter = mMaterialToTexture.find(from);
+    if (iter == mMaterialToTexture.end()) {
+        return;
+    }
+    for (const auto& pair : iter->second.params) {
+        if (pair.second) {
+            auto& materials = mTextureToMaterial.at(pair.second->texture);
+            materials.erase(from);
+            materials.insert(to);
+        }
+    }
+
+    // Equivalent material instances have the same texture parameters, so if "to" is already known
+    // then its node can be kept as is. Otherwise it takes over the node of "from".
+    if (mMaterialToTexture.find(to) == mMaterialToTexture.end()) {
+        MaterialNode node = std::move(iter.value());
+        mMaterialToTexture.erase(iter);
+        mMaterialToTexture[to] = std::move(node);
+    } else {
+        mMaterialToTexture.erase(iter);
+    }
+}
+
 // During finalization, the structure of the glTF is known but we have not yet created texture
 // objects. Find all non-textured entities and immediately add mark them as ready.
 void DependencyGraph::finalize() {
@@ -101,7 +142,13 @@ void DependencyGraph::checkReadiness(Material* material) {
 
 void DependencyGraph::markAsReady(Texture* texture) {
     assert(texture && mFinalized);
-    mTextureNodes.at(texture)->ready = true;
+    TextureNode* node = mTextureNodes.at(texture).get();
+
+    // A texture can be reported twice, once for its preview and once when it is complete.
+    if (node->ready) {
+        return;
+    }
+    node->ready = true;
 
     // Iterate over the materials associated with this texture to check if any have become ready.
     // This is O(n2) but the inner loop is always small.
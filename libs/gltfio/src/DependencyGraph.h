@@ -73,6 +73,13 @@ public:
     void addEdge(Material* material, const char* parameter);
     void addEdge(filament::Texture* texture, Material* material, const char* parameter);
 
+    // Moves every edge of "from" to "to", merging them if both are already in the graph. This is
+    // used when a material instance is replaced by an equivalent one from a ResourceCache, after
+    // which the graph no longer refers to "from".
+    //
+    // This can only be called before finalization.
+    void replaceMaterial(Material* from, Material* to);
+
     // Marks the end of synchronous asset loading.
     //
     // At this point, the graph enters a finalized state and all non-textured entities are
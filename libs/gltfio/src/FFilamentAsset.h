@@ -24,6 +24,7 @@
 #include <filament/IndexBuffer.h>
 #include <filament/MaterialInstance.h>
 #include <filament/RenderableManager.h>
+#include <filament/SkinningBuffer.h>
 #include <filament/Texture.h>
 #include <filament/TextureSampler.h>
 #include <filament/TransformManager.h>
@@ -72,6 +73,7 @@ namespace filament::gltfio {
 
 class Animator;
 class Wireframe;
+struct FResourceCache;
 
 // Encapsulates VertexBuffer::setBufferAt() or IndexBuffer::setBuffer().
 struct BufferSlot {
@@ -284,7 +286,39 @@ struct FFilamentAsset : public FilamentAsset {
     std::vector<filament::BufferObject*> mBufferObjects;
     std::vector<filament::IndexBuffer*> mIndexBuffers;
     std::vector<filament::MorphTargetBuffer*> mMorphTargetBuffers;
+    std::vector<filament::SkinningBuffer*> mSkinningBuffers;
     std::vector<filament::Texture*> mTextures;
+
+    // Region of a SkinningBuffer that holds the bones of a skinned renderable. The renderables of
+    // an asset and its instances are packed into as few buffers as possible.
+    struct SkinningSlot {
+        // Every skinned renderable binds a window of this many bones, regardless of its actual
+        // joint count, due to GLSL limitations.
+        static constexpr uint32_t WINDOW_SIZE = 256;
+
+        // RenderableManager stores bone offsets in 16 bits, so a new buffer is started once a
+        // buffer reaches this many bones.
+        static constexpr uint32_t MAX_BONE_COUNT = 65536;
+
+        // Slots start at multiples of this count, which keeps them 256-byte aligned for the sake
+        // of uniform buffer binding offsets.
+        static constexpr uint32_t ALIGNMENT = 4;
+
+        filament::SkinningBuffer* buffer;
+        uint32_t offset;
+        uint32_t capacity;
+    };
+    tsl::robin_map<utils::Entity, SkinningSlot, utils::Entity::Hasher> mSkinningSlots;
+
+    // Offset of the next available slot in the last element of mSkinningBuffers.
+    uint32_t mSkinningBufferOffset = 0;
+
+    // Objects that are owned by a ResourceCache rather than by this asset. Each entry holds one
+    // reference, which is released when the asset is destroyed.
+    FResourceCache* mResourceCache = nullptr;
+    std::vector<filament::Texture*> mSharedTextures;
+    std::vector<filament::MaterialInstance*> mSharedMaterialInstances;
+
     utils::FixedCapacityVector<Variant> mVariants;
     utils::FixedCapacityVector<utils::CString> mScenes;
     filament::Aabb mBoundingBox;
@@ -80,6 +80,11 @@ struct FFilamentInstance : public FilamentInstance {
     FFilamentAsset* owner;
     SkinVector skins;
     NodeMap nodeMap;
+
+    // Incremented whenever the set of skin targets changes, which lets animators know when to
+    // rebuild their skinning plan.
+    uint32_t skinsVersion = 0;
+
     void createAnimator();
     Animator* getAnimator() const noexcept;
     size_t getSkinCount() const noexcept;
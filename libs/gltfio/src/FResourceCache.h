@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLTFIO_FRESOURCECACHE_H
+#define GLTFIO_FRESOURCECACHE_H
+
+#include <gltfio/ResourceCache.h>
+
+#include "upcast.h"
+
+#include <utils/compiler.h>
+#include <utils/Hash.h>
+
+#include <tsl/robin_map.h>
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+namespace filament {
+    class Engine;
+    class Material;
+    class MaterialInstance;
+    class Texture;
+}
+
+namespace filament::gltfio {
+
+// Identifies an encoded image by content. The flags distinguish between different decodings of the
+// same content, e.g. sRGB versus linear.
+struct TextureKey {
+    uint64_t contentHash;
+    uint64_t byteCount;
+    uint64_t flags;
+    bool operator==(const TextureKey& rhs) const noexcept {
+        return contentHash == rhs.contentHash && byteCount == rhs.byteCount && flags == rhs.flags;
+    }
+};
+
+// Identifies a material instance by everything that gltfio applies to it: the material, the glTF
+// parameter values (flattened to 32-bit words, along with the UV map and vertex color usage), and
+// the bound textures. Since every texture is owned by the cache, two textures with the same content
+// are the same object, which allows texture bindings to be compared by pointer.
+struct MaterialInstanceKey {
+    struct TextureBinding {
+        std::string parameter;
+        const filament::Texture* texture;
+        uint32_t sampler;
+        bool operator==(const TextureBinding& rhs) const noexcept {
+            return texture == rhs.texture && sampler == rhs.sampler && parameter == rhs.parameter;
+        }
+        bool operator<(const TextureBinding& rhs) const noexcept {
+            return parameter < rhs.parameter;
+        }
+    };
+    const filament::Material* material = nullptr;
+    std::vector<uint32_t> parameters;
+    std::vector<TextureBinding> textures;
+    bool operator==(const MaterialInstanceKey& rhs) const noexcept {
+        return material == rhs.material && parameters == rhs.parameters &&
+                textures == rhs.textures;
+    }
+};
+
+struct FResourceCache : public ResourceCache {
+    explicit FResourceCache(filament::Engine* engine) noexcept : mEngine(engine) {}
+    ~FResourceCache();
+
+    // Computes a content key for an encoded image.
+    static TextureKey getTextureKey(const uint8_t* data, size_t byteCount, uint64_t flags);
+
+    // The acquire methods return null if the key is not in the cache, otherwise they increment the
+    // reference count of the cached object and return it.
+    filament::Texture* acquireTexture(const TextureKey& key) noexcept;
+    filament::MaterialInstance* acquireMaterialInstance(const MaterialInstanceKey& key) noexcept;
+
+    // Transfers ownership of a newly created object to the cache, with a reference count of 1.
+    void addTexture(const TextureKey& key, filament::Texture* texture);
+    void addMaterialInstance(const MaterialInstanceKey& key,
+            filament::MaterialInstance* materialInstance);
+
+    // Decrements the reference count of a cached object, destroying it if it drops to zero.
+    void release(filament::Texture* texture) noexcept;
+    void release(filament::MaterialInstance* materialInstance) noexcept;
+
+    size_t getTextureCount() const noexcept { return mTextures.size(); }
+    size_t getMaterialInstanceCount() const noexcept { return mMaterialInstances.size(); }
+
+    filament::Engine* getEngine() const noexcept { return mEngine; }
+
+private:
+    template<typename K>
+    struct Entry {
+        K key;
+        uint32_t refCount;
+    };
+
+    struct TextureKeyHasher {
+        size_t operator()(const TextureKey& key) const noexcept {
+            size_t seed = key.contentHash;
+            utils::hash::combine(seed, key.byteCount);
+            utils::hash::combine(seed, key.flags);
+            return seed;
+        }
+    };
+
+    struct MaterialInstanceKeyHasher {
+        size_t operator()(const MaterialInstanceKey& key) const noexcept {
+            size_t seed = std::hash<const void*>{}(key.material);
+            for (uint32_t word : key.parameters) {
+                utils::hash::combine(seed, word);
+            }
+            for (const auto& binding : key.textures) {
+                utils::hash::combine(seed, binding.parameter);
+                utils::hash::combine(seed, binding.texture);
+                utils::hash::combine(seed, binding.sampler);
+            }
+            return seed;
+        }
+    };
+
+    filament::Engine* const mEngine;
+    tsl::robin_map<TextureKey, filament::Texture*, TextureKeyHasher> mTextureKeys;
+    tsl::robin_map<filament::Texture*, Entry<TextureKey>> mTextures;
+    tsl::robin_map<MaterialInstanceKey, filament::MaterialInstance*, MaterialInstanceKeyHasher>
+            mMaterialInstanceKeys;
+    tsl::robin_map<filament::MaterialInstance*, Entry<MaterialInstanceKey>> mMaterialInstances;
+};
+
+FILAMENT_UPCAST(ResourceCache)
+
+} // namespace filament::gltfio
+
+#endif // GLTFIO_FRESOURCECACHE_H
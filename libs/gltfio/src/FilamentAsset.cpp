@@ -25,6 +25,7 @@
 #include <utils/Log.h>
 #include <utils/NameComponentManager.h>
 
+#include "FResourceCache.h"
 #include "Wireframe.h"
 
 using namespace filament;
@@ -73,6 +74,10 @@ FFilamentAsset::~FFilamentAsset() {
     for (auto mi : mMaterialInstances) {
         mEngine->destroy(mi);
     }
+    // Shared material instances are owned by the cache, so we merely release our reference.
+    for (auto mi : mSharedMaterialInstances) {
+        mResourceCache->release(mi);
+    }
     for (auto vb : mVertexBuffers) {
         mEngine->destroy(vb);
     }
@@ -85,9 +90,15 @@ FFilamentAsset::~FFilamentAsset() {
     for (auto tx : mTextures) {
         mEngine->destroy(tx);
     }
+    for (auto tx : mSharedTextures) {
+        mResourceCache->release(tx);
+    }
     for (auto tb : mMorphTargetBuffers) {
         mEngine->destroy(tb);
     }
+    for (auto sb : mSkinningBuffers) {
+        mEngine->destroy(sb);
+    }
 }
 
 const char* FFilamentAsset::getExtras(utils::Entity entity) const noexcept {
@@ -66,6 +66,7 @@ void FFilamentInstance::attachSkin(size_t skinIndex, Entity target) noexcept {
         return;
     }
     skins[skinIndex].targets.insert(target);
+    skinsVersion++;
 }
 
 void FFilamentInstance::detachSkin(size_t skinIndex, Entity target) noexcept {
@@ -73,6 +74,7 @@ void FFilamentInstance::detachSkin(size_t skinIndex, Entity target) noexcept {
         return;
     }
     skins[skinIndex].targets.erase(target);
+    skinsVersion++;
 }
 
 void FFilamentInstance::applyMaterialVariant(size_t variantIndex) noexcept {
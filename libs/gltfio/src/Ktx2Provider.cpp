@@ -16,6 +16,7 @@
 
 #include <gltfio/TextureProvider.h>
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -26,6 +27,8 @@
 
 #include <ktxreader/Ktx2Reader.h>
 
+#include <tsl/robin_map.h>
+
 using namespace filament;
 using namespace utils;
 
@@ -44,6 +47,7 @@ public:
             const char* mimeType, uint64_t flags) final;
 
     Texture* popTexture() final;
+    Texture* popPreviewTexture() final;
     void updateQueue() final;
     void waitForCompletion() final;
     void cancelDecoding() final;
@@ -52,10 +56,14 @@ public:
     size_t getPushedCount() const final { return mPushedCount; }
     size_t getPoppedCount() const final { return mPoppedCount; }
     size_t getDecodedCount() const final { return mDecodedCount; }
+    void setPriority(Texture* texture, float priority) final;
+    void setDecoderBudget(size_t byteCount) final { mDecoderBudget = byteCount; }
 
 private:
     enum class QueueItemState {
-        TRANSCODING, // Texture has been pushed, mipmap levels are not yet complete.
+        QUEUED,      // Texture has been pushed, but its transcoder job has not been started yet.
+        TRANSCODING, // Transcoder job has been started, mipmap levels are not yet complete.
+        PREVIEW,     // Preview levels have been uploaded, the others have not been started yet.
         READY,       // Mipmap levels are available but texture has not been popped yet.
         POPPED,      // Client has popped the texture from the queue.
     };
@@ -71,14 +79,36 @@ private:
         QueueItemState state;
         atomic<TranscoderState> transcoderState;
         JobSystem::Job* job;
+        Texture* texture;
+        size_t transcodedSize;
+        size_t jobSize;
+        float priority;
+        uint8_t previewLevel;
+        bool previewJob;
+        bool previewPending;
+        bool previewReported;
     };
 
-    void transcodeSingleTexture();
+    // Miplevels that fit in this size are transcoded and uploaded for every texture before the
+    // larger levels of any texture, which are then transcoded in priority order.
+    static constexpr uint32_t PREVIEW_SIZE = 64;
+
+    void transcodeSingleTexture(bool allowPreview);
+    void startTranscoderJobs(bool unlimited);
+    void startTranscoderJob(QueueItem* item, bool allowPreview);
+    uint32_t beginTranscoding(QueueItem* item, bool allowPreview);
+    void finishTranscoderJob(QueueItem* item);
+    void reportPreview(QueueItem* item);
+    QueueItem* getNextItem() const;
 
     size_t mPushedCount = 0;
     size_t mPoppedCount = 0;
     size_t mDecodedCount = 0;
+    size_t mTranscodingCount = 0;
+    size_t mTranscodingBytes = 0;
+    size_t mDecoderBudget = 0;
     vector<unique_ptr<QueueItem> > mQueueItems;
+    tsl::robin_map<Texture*, QueueItem*> mQueueItemsByTexture;
     JobSystem::Job* mDecoderRootJob;
     std::string mRecentPushMessage;
     std::string mRecentPopMessage;
@@ -103,27 +133,148 @@ Texture* Ktx2Provider::pushTexture(const uint8_t* data, size_t byteCount,
     QueueItem* item = mQueueItems.emplace_back(new QueueItem).get();
     ++mPushedCount;
 
+    Texture* texture = async->getTexture();
+    mQueueItemsByTexture[texture] = item;
+
+    // The preview starts at the largest miplevel that fits in PREVIEW_SIZE. Textures that are
+    // small, or that do not have such a miplevel, do not have a preview.
+    const size_t levelCount = texture->getLevels();
+    uint8_t previewLevel = 0;
+    while (previewLevel < levelCount &&
+            std::max(texture->getWidth(previewLevel), texture->getHeight(previewLevel)) >
+            PREVIEW_SIZE) {
+        ++previewLevel;
+    }
+    if (previewLevel == levelCount) {
+        previewLevel = 0;
+    }
+
     item->async = async;
-    item->state = QueueItemState::TRANSCODING;
+    item->state = QueueItemState::QUEUED;
     item->transcoderState.store(TranscoderState::NOT_STARTED);
+    item->job = nullptr;
+    item->texture = texture;
+    item->jobSize = 0;
+    item->priority = 0.0f;
+    item->previewLevel = previewLevel;
+    item->previewJob = false;
+    item->previewPending = false;
+    item->previewReported = false;
+
+    // The transcoded size is not known until transcoding is done, so we conservatively estimate
+    // a full miplevel chain of uncompressed RGBA8 texels.
+    item->transcodedSize = texture->getWidth() * texture->getHeight() * 4 * 4 / 3;
 
     // On single threaded systems, it is usually fine to create jobs because the job system will
     // simply execute serially. However in our case, we wish to amortize the decoder cost across
     // several frames, so we instead use the updateQueue() method to perform decoding.
-    if constexpr (!UTILS_HAS_THREADING) {
-        item->job = nullptr;
-        return async->getTexture();
+    if constexpr (UTILS_HAS_THREADING) {
+        startTranscoderJobs(false);
+    }
+    return texture;
+}
+
+void Ktx2Provider::setPriority(Texture* texture, float priority) {
+    auto iter = mQueueItemsByTexture.find(texture);
+    if (iter != mQueueItemsByTexture.end()) {
+        iter.value()->priority = priority;
+    }
+}
+
+// The preview levels of all textures are transcoded before the remaining levels of any texture.
+// Within each of these two passes, textures are picked in priority order.
+Ktx2Provider::QueueItem* Ktx2Provider::getNextItem() const {
+    for (QueueItemState state : { QueueItemState::QUEUED, QueueItemState::PREVIEW }) {
+        QueueItem* next = nullptr;
+        for (auto& item : mQueueItems) {
+            if (item->state == state && (!next || item->priority > next->priority)) {
+                next = item.get();
+            }
+        }
+        if (next) {
+            return next;
+        }
+    }
+    return nullptr;
+}
+
+// Transcoder jobs are started lazily, in priority order, such that the number of jobs in flight
+// does not exceed the number of worker threads and the transcoded texels that are waiting to be
+// uploaded fit within the decoder budget. This also allows pending textures to be cancelled.
+void Ktx2Provider::startTranscoderJobs(bool unlimited) {
+    const size_t maxJobCount = std::max(size_t(1), mEngine->getJobSystem().getThreadCount());
+    while (unlimited || mTranscodingCount < maxJobCount) {
+        QueueItem* next = getNextItem();
+        if (!next) {
+            return;
+        }
+        const bool overBudget = mDecoderBudget && mTranscodingBytes &&
+                mTranscodingBytes + next->transcodedSize > mDecoderBudget;
+        if (!unlimited && overBudget) {
+            return;
+        }
+        // Waiting for completion does not leave any texture with only its preview.
+        startTranscoderJob(next, !unlimited);
     }
+}
+
+// Returns the first miplevel to transcode. The first job of a texture that has a preview only
+// transcodes the preview levels, and accounts for a proportional fraction of the estimated size.
+uint32_t Ktx2Provider::beginTranscoding(QueueItem* item, bool allowPreview) {
+    const size_t previewSize = item->state == QueueItemState::PREVIEW ?
+            item->transcodedSize >> (2 * item->previewLevel) : 0;
+    item->previewJob = allowPreview && item->state == QueueItemState::QUEUED &&
+            item->previewLevel > 0;
+    item->jobSize = item->previewJob ? item->transcodedSize >> (2 * item->previewLevel) :
+            item->transcodedSize - previewSize;
+
+    item->state = QueueItemState::TRANSCODING;
+    item->transcoderState.store(TranscoderState::NOT_STARTED);
+    ++mTranscodingCount;
+    mTranscodingBytes += item->jobSize;
+    return item->previewJob ? item->previewLevel : 0;
+}
 
+void Ktx2Provider::startTranscoderJob(QueueItem* item, bool allowPreview) {
+    const uint32_t firstLevel = beginTranscoding(item, allowPreview);
     JobSystem* js = &mEngine->getJobSystem();
-    item->job = jobs::createJob(*js, mDecoderRootJob, [this, item] {
+    item->job = jobs::createJob(*js, mDecoderRootJob, [item, js, firstLevel] {
         using Result = ktxreader::Ktx2Reader::Result;
-        const bool success = Result::SUCCESS == item->async->doTranscoding();
+        const bool success = Result::SUCCESS == item->async->doTranscoding(*js, firstLevel);
         item->transcoderState.store(success ? TranscoderState::SUCCESS : TranscoderState::ERROR);
     });
 
     js->runAndRetain(item->job);
-    return async->getTexture();
+}
+
+void Ktx2Provider::finishTranscoderJob(QueueItem* item) {
+    --mTranscodingCount;
+    mTranscodingBytes -= item->jobSize;
+    item->jobSize = 0;
+    if (item->transcoderState.load() == TranscoderState::ERROR) {
+        item->previewPending = false;
+        item->state = QueueItemState::READY;
+        ++mDecodedCount;
+        return;
+    }
+    item->async->uploadImages();
+    if (item->previewJob) {
+        reportPreview(item);
+        item->state = QueueItemState::PREVIEW;
+        return;
+    }
+    item->previewPending = false;
+    item->state = QueueItemState::READY;
+    ++mDecodedCount;
+}
+
+// Ktx2Reader restricts sampling to the levels that have been uploaded so far, so a texture can be
+// used as soon as its smallest levels are in, even before its preview job is done.
+void Ktx2Provider::reportPreview(QueueItem* item) {
+    if (!item->previewReported && item->async->getUploadedLevelCount() > 0) {
+        item->previewReported = true;
+        item->previewPending = true;
+    }
 }
 
 Texture* Ktx2Provider::popTexture() {
@@ -149,29 +300,37 @@ Texture* Ktx2Provider::popTexture() {
     return nullptr;
 }
 
+Texture* Ktx2Provider::popPreviewTexture() {
+    for (auto& item : mQueueItems) {
+        if (item->previewPending) {
+            item->previewPending = false;
+            return item->texture;
+        }
+    }
+    return nullptr;
+}
+
 void Ktx2Provider::updateQueue() {
     if (!UTILS_HAS_THREADING) {
-        transcodeSingleTexture();
+        transcodeSingleTexture(true);
     }
     JobSystem* js = &mEngine->getJobSystem();
     for (auto& item : mQueueItems) {
         if (item->state != QueueItemState::TRANSCODING) {
             continue;
         }
-        item->async->getTexture();
         const TranscoderState state = item->transcoderState.load();
-        if (state != TranscoderState::NOT_STARTED) {
+        if (state == TranscoderState::NOT_STARTED) {
+            // Miplevels are transcoded smallest first, so upload the ones that are already done
+            // rather than uploading the entire chain in the frame that transcoding finishes.
+            item->async->uploadImages();
+            reportPreview(item.get());
+        } else {
             if (item->job) {
                 js->waitAndRelease(item->job);
+                item->job = nullptr;
             }
-            if (state == TranscoderState::ERROR) {
-                item->state = QueueItemState::READY;
-                ++mDecodedCount;
-                continue;
-            }
-            item->async->uploadImages();
-            item->state = QueueItemState::READY;
-            ++mDecodedCount;
+            finishTranscoderJob(item.get());
         }
     }
 
@@ -179,24 +338,70 @@ void Ktx2Provider::updateQueue() {
     // items from the front. This might ignore a popped texture that occurs in the middle of the
     // vector, but that's okay, it will be cleaned up eventually.
     decltype(mQueueItems)::iterator last = mQueueItems.begin();
-    while (last != mQueueItems.end() && (*last)->state == QueueItemState::POPPED) ++last;
+    while (last != mQueueItems.end() && (*last)->state == QueueItemState::POPPED) {
+        // The client might have freed a popped texture, and a new one might have been pushed at
+        // the same address since, so only erase lookup entries that refer to this item.
+        auto iter = mQueueItemsByTexture.find((*last)->texture);
+        if (iter != mQueueItemsByTexture.end() && iter->second == last->get()) {
+            mQueueItemsByTexture.erase(iter);
+        }
+        ++last;
+    }
     mQueueItems.erase(mQueueItems.begin(), last);
+
+    // Now that some texels have been uploaded, there may be room for more transcoder jobs.
+    if constexpr (UTILS_HAS_THREADING) {
+        startTranscoderJobs(false);
+    }
 }
 
 void Ktx2Provider::waitForCompletion() {
+    // Waiting for completion implies that every queued texture gets transcoded, regardless of the
+    // decoder budget.
+    if constexpr (UTILS_HAS_THREADING) {
+        startTranscoderJobs(true);
+    } else {
+        while (getNextItem()) {
+            transcodeSingleTexture(false);
+        }
+    }
+    using Result = ktxreader::Ktx2Reader::Result;
     JobSystem& js = mEngine->getJobSystem();
     for (auto& item : mQueueItems) {
         if (item->job) {
             js.waitAndRelease(item->job);
+            item->job = nullptr;
+        }
+        // Preview jobs that were already running are completed here, such that every texture is
+        // complete after the next call to updateQueue().
+        if (item->state == QueueItemState::TRANSCODING && item->previewJob &&
+                item->transcoderState.load() == TranscoderState::SUCCESS) {
+            item->previewJob = false;
+            if (item->async->doTranscoding(js, 0) != Result::SUCCESS) {
+                item->transcoderState.store(TranscoderState::ERROR);
+            }
         }
     }
 }
 
 void Ktx2Provider::cancelDecoding() {
-    // TODO: Currently, Ktx2Provider runs jobs eagerly and JobSystem does not allow cancellation of
-    // in-flight jobs. We should consider throttling the number of simultaneous decoder jobs, which
-    // would allow for actual cancellation.
-    waitForCompletion();
+    // JobSystem does not allow cancellation of in-flight jobs, but textures whose transcoder job
+    // has not started yet can be cancelled. They become poppable on the next call to updateQueue().
+    // This includes textures that only have their preview levels.
+    for (auto& item : mQueueItems) {
+        if (item->state == QueueItemState::QUEUED || item->state == QueueItemState::PREVIEW) {
+            item->transcoderState.store(TranscoderState::ERROR);
+            item->state = QueueItemState::TRANSCODING;
+            ++mTranscodingCount;
+        }
+    }
+    JobSystem& js = mEngine->getJobSystem();
+    for (auto& item : mQueueItems) {
+        if (item->job) {
+            js.waitAndRelease(item->job);
+            item->job = nullptr;
+        }
+    }
 }
 
 const char* Ktx2Provider::getPushMessage() const {
@@ -207,15 +412,14 @@ const char* Ktx2Provider::getPopMessage() const {
     return mRecentPopMessage.empty() ? nullptr : mRecentPopMessage.c_str();
 }
 
-void Ktx2Provider::transcodeSingleTexture() {
+void Ktx2Provider::transcodeSingleTexture(bool allowPreview) {
     assert_invariant(!UTILS_HAS_THREADING);
-    for (auto& item : mQueueItems) {
-        if (item->state == QueueItemState::TRANSCODING) {
-            using Result = ktxreader::Ktx2Reader::Result;
-            bool success = Result::SUCCESS == item->async->doTranscoding();
-            item->transcoderState.store(success ? TranscoderState::SUCCESS : TranscoderState::ERROR);
-            break;
-        }
+    if (QueueItem* next = getNextItem()) {
+        using Result = ktxreader::Ktx2Reader::Result;
+        const uint32_t firstLevel = beginTranscoding(next, allowPreview);
+        bool success = Result::SUCCESS ==
+                next->async->doTranscoding(mEngine->getJobSystem(), firstLevel);
+        next->transcoderState.store(success ? TranscoderState::SUCCESS : TranscoderState::ERROR);
     }
 }
 
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FResourceCache.h"
+
+#include <filament/Engine.h>
+#include <filament/MaterialInstance.h>
+#include <filament/Texture.h>
+
+#include <utils/Log.h>
+
+using namespace filament;
+using namespace utils;
+
+namespace filament::gltfio {
+
+FResourceCache::~FResourceCache() {
+    if (!mTextures.empty() || !mMaterialInstances.empty()) {
+        slog.w << "ResourceCache destroyed while still in use by one or more assets." << io::endl;
+    }
+    for (const auto& iter : mMaterialInstances) {
+        mEngine->destroy(iter.first);
+    }
+    for (const auto& iter : mTextures) {
+        mEngine->destroy(iter.first);
+    }
+}
+
+TextureKey FResourceCache::getTextureKey(const uint8_t* data, size_t byteCount, uint64_t flags) {
+    // Two independent 32-bit hashes make accidental collisions between distinct images unlikely
+    // enough in practice, given that the byte count must also match.
+    const uint64_t lo = hash::murmurSlow(data, byteCount, 0);
+    const uint64_t hi = hash::murmurSlow(data, byteCount, 0x9e3779b9u);
+    return { (hi << 32u) | lo, byteCount, flags };
+}
+
+Texture* FResourceCache::acquireTexture(const TextureKey& key) noexcept {
+    auto iter = mTextureKeys.find(key);
+    if (iter == mTextureKeys.end()) {
+        return nullptr;
+    }
+    mTextures[iter->second].refCount++;
+    return iter->second;
+}
+
+MaterialInstance* FResourceCache::acquireMaterialInstance(
+        const MaterialInstanceKey& key) noexcept {
+    auto iter = mMaterialInstanceKeys.find(key);
+    if (iter == mMaterialInstanceKeys.end()) {
+        return nullptr;
+    }
+    mMaterialInstances[iter->second].refCount++;
+    return iter->second;
+}
+
+void FResourceCache::addTexture(const TextureKey& key, Texture* texture) {
+    assert_invariant(mTextureKeys.find(key) == mTextureKeys.end());
+    mTextureKeys[key] = texture;
+    mTextures[texture] = { key, 1 };
+}
+
+void FResourceCache::addMaterialInstance(const MaterialInstanceKey& key,
+        MaterialInstance* materialInstance) {
+    assert_invariant(mMaterialInstanceKeys.find(key) == mMaterialInstanceKeys.end());
+    mMaterialInstanceKeys[key] = materialInstance;
+    mMaterialInstances[materialInstance] = { key, 1 };
+}
+
+void FResourceCache::release(Texture* texture) noexcept {
+    auto iter = mTextures.find(texture);
+    assert_invariant(iter != mTextures.end());
+    if (--iter.value().refCount == 0) {
+        mTextureKeys.erase(iter->second.key);
+        mTextures.erase(iter);
+        mEngine->destroy(texture);
+    }
+}
+
+void FResourceCache::release(MaterialInstance* materialInstance) noexcept {
+    auto iter = mMaterialInstances.find(materialInstance);
+    assert_invariant(iter != mMaterialInstances.end());
+    if (--iter.value().refCount == 0) {
+        mMaterialInstanceKeys.erase(iter->second.key);
+        mMaterialInstances.erase(iter);
+        mEngine->destroy(materialInstance);
+    }
+}
+
+ResourceCache* ResourceCache::create(Engine* engine) {
+    return new FResourceCache(engine);
+}
+
+void ResourceCache::destroy(ResourceCache** cache) {
+    delete upcast(*cache);
+    *cache = nullptr;
+}
+
+size_t ResourceCache::getTextureCount() const noexcept {
+    return upcast(this)->getTextureCount();
+}
+
+size_t ResourceCache::getMaterialInstanceCount() const noexcept {
+    return upcast(this)->getMaterialInstanceCount();
+}
+
+} // namespace filament::gltfio
@@ -19,19 +19,24 @@
 
 #include "GltfEnums.h"
 #include "FFilamentAsset.h"
+#include "FResourceCache.h"
 #include "TangentsJob.h"
 #include "upcast.h"
 
 #include <filament/BufferObject.h>
+#include <filament/Camera.h>
 #include <filament/Engine.h>
 #include <filament/IndexBuffer.h>
 #include <filament/MaterialInstance.h>
 #include <filament/Texture.h>
 #include <filament/VertexBuffer.h>
 #include <filament/MorphTargetBuffer.h>
+#include <filament/RenderableManager.h>
+#include <filament/TransformManager.h>
 
 #include <geometry/Transcoder.h>
 
+#include <utils/Hash.h>
 #include <utils/JobSystem.h>
 #include <utils/Log.h>
 #include <utils/Systrace.h>
@@ -44,9 +49,17 @@
 #include <math/vec4.h>
 
 #include <tsl/robin_map.h>
+#include <tsl/robin_set.h>
 
-#include <string>
+#include <algorithm>
+#include <atomic>
 #include <fstream>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include <string.h>
 
 using namespace filament;
 using namespace filament::math;
@@ -69,13 +82,15 @@ struct ResourceLoader::Impl {
         mNormalizeSkinningWeights(config.normalizeSkinningWeights),
         mRecomputeBoundingBoxes(config.recomputeBoundingBoxes),
         mGltfPath(config.gltfPath ? config.gltfPath : ""),
-        mIgnoreBindTransform(config.ignoreBindTransform) {}
+        mIgnoreBindTransform(config.ignoreBindTransform),
+        mCache(config.cache ? upcast(config.cache) : nullptr) {}
 
     Engine* const mEngine;
     const bool mNormalizeSkinningWeights;
     const bool mRecomputeBoundingBoxes;
     const std::string mGltfPath;
     const bool mIgnoreBindTransform;
+    FResourceCache* const mCache;
 
     // User-provided resource data with URI string keys, populated with addResourceData().
     // This is used on platforms without traditional file systems, such as Android, iOS, and WebGL.
@@ -91,9 +106,26 @@ struct ResourceLoader::Impl {
     FFilamentAsset* mAsyncAsset = nullptr;
     size_t mRemainingTextureDownloads = 0;
 
+    // Every texture that has been bound to a material instance by createTextures, which allows
+    // textures to be prioritized according to the screen coverage of their material instances.
+    struct TextureBinding {
+        Texture* texture;
+        MaterialInstance* materialInstance;
+        const char* parameter;
+        TextureSampler sampler;
+    };
+    std::vector<TextureBinding> mTextureBindings;
+
+    // Textures that were found in the shared cache. These will never be popped from our texture
+    // providers, so they are marked as ready once the dependency graph has been finalized.
+    std::vector<Texture*> mCachedTextures;
+
     void addResourceData(const char* uri, BufferDescriptor&& buffer);
+    void uploadBuffers(FFilamentAsset* asset);
     void computeTangents(FFilamentAsset* asset);
     void createTextures(FFilamentAsset* asset, bool async);
+    void markCachedTexturesAsReady(FFilamentAsset* asset);
+    void shareMaterialInstances(FFilamentAsset* asset);
     void cancelTextureDecoding();
     Texture* getOrCreateTexture(FFilamentAsset* asset, const TextureSlot& tb);
     ~Impl();
@@ -197,6 +229,64 @@ static bool requiresPacking(const cgltf_accessor* accessor) {
     }
 }
 
+// Holds the results of every vertex and index conversion for a single asset in one contiguous
+// block, which avoids a malloc per buffer slot. Each BufferDescriptor that points into the arena
+// holds a reference to it, and the block is freed when the last of these has been consumed.
+class ConversionArena {
+public:
+    static ConversionArena* create(size_t size) {
+        return new ConversionArena(size);
+    }
+
+    uint8_t* data() const noexcept { return mData; }
+
+    ConversionArena* acquire() noexcept {
+        mRefCount.fetch_add(1, std::memory_order_relaxed);
+        return this;
+    }
+
+    static void release(void*, size_t, void* user) {
+        auto* arena = (ConversionArena*) user;
+        if (arena->mRefCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete arena;
+        }
+    }
+
+private:
+    explicit ConversionArena(size_t size) : mData((uint8_t*) malloc(size)) {}
+    ~ConversionArena() { free(mData); }
+    uint8_t* const mData;
+    std::atomic<uint32_t> mRefCount = { 1 };
+};
+
+// Describes the CPU-side work that must be done to a single buffer slot before it can be uploaded.
+struct SlotConversion {
+    enum class Kind : uint8_t { NONE, UNPACK_FLOATS, BYTES_TO_SHORTS };
+    const cgltf_accessor* accessor;
+    uint8_t* dst;
+    size_t offset; // into the arena
+    uint32_t size;
+    Kind kind;
+};
+
+static void convertSlot(const SlotConversion& conversion) {
+    const cgltf_accessor* accessor = conversion.accessor;
+    switch (conversion.kind) {
+        case SlotConversion::Kind::UNPACK_FLOATS:
+            cgltf_accessor_unpack_floats(accessor, (float*) conversion.dst,
+                    conversion.size / sizeof(float));
+            break;
+        case SlotConversion::Kind::BYTES_TO_SHORTS: {
+            auto bufferData = (const uint8_t*) accessor->buffer_view->buffer->data;
+            convertBytesToShorts((uint16_t*) conversion.dst,
+                    computeBindingOffset(accessor) + bufferData, conversion.size / 2);
+            break;
+        }
+        case SlotConversion::Kind::NONE:
+            break;
+    }
+}
+
 static void decodeDracoMeshes(FFilamentAsset* asset) {
     DracoCache* dracoCache = &asset->mSourceAsset->dracoCache;
 
@@ -344,6 +434,7 @@ void ResourceLoader::Impl::addResourceData(const char* uri, BufferDescriptor&& b
     // If this is a texture and async loading has already started, add a new decoder job.
     if (isTexture(uri) && mAsyncAsset && mRemainingTextureDownloads > 0) {
         createTextures(mAsyncAsset, true);
+        markCachedTexturesAsReady(mAsyncAsset);
     }
 }
 
@@ -369,6 +460,7 @@ bool ResourceLoader::loadResources(FFilamentAsset* asset, bool async) {
         return false;
     }
     asset->mResourcesLoaded = true;
+    asset->mResourceCache = pImpl->mCache;
 
     // Clear our texture caches. Previous calls to loadResources may have populated these, but the
     // Texture objects could have since been destroyed.
@@ -450,78 +542,8 @@ bool ResourceLoader::loadResources(FFilamentAsset* asset, bool async) {
         updateBoundingBoxes(asset);
     }
 
-    Engine& engine = *pImpl->mEngine;
-
-    // Upload VertexBuffer and IndexBuffer data to the GPU.
-    for (auto slot : asset->mBufferSlots) {
-        const cgltf_accessor* accessor = slot.accessor;
-        if (!accessor->buffer_view) {
-            continue;
-        }
-        auto bufferData = (const uint8_t*) accessor->buffer_view->buffer->data;
-        const uint8_t* data = computeBindingOffset(accessor) + bufferData;
-        const uint32_t size = computeBindingSize(accessor);
-        if (slot.vertexBuffer) {
-            if (requiresConversion(accessor)) {
-                const size_t floatsCount = accessor->count * cgltf_num_components(accessor->type);
-                const size_t floatsByteCount = sizeof(float) * floatsCount;
-                float* floatsData = (float*) malloc(floatsByteCount);
-                cgltf_accessor_unpack_floats(accessor, floatsData, floatsCount);
-                BufferObject* bo = BufferObject::Builder().size(floatsByteCount).build(engine);
-                asset->mBufferObjects.push_back(bo);
-                bo->setBuffer(engine, BufferDescriptor(floatsData, floatsByteCount, FREE_CALLBACK));
-                slot.vertexBuffer->setBufferObjectAt(engine, slot.bufferIndex, bo);
-                continue;
-            }
-            BufferObject* bo = BufferObject::Builder().size(size).build(engine);
-            asset->mBufferObjects.push_back(bo);
-            bo->setBuffer(engine, BufferDescriptor(data, size,
-                    uploadCallback, uploadUserdata(asset)));
-            slot.vertexBuffer->setBufferObjectAt(engine, slot.bufferIndex, bo);
-            continue;
-        } else if (slot.indexBuffer) {
-            if (accessor->component_type == cgltf_component_type_r_8u) {
-                const size_t size16 = size * 2;
-                uint16_t* data16 = (uint16_t*) malloc(size16);
-                convertBytesToShorts(data16, data, size);
-                IndexBuffer::BufferDescriptor bd(data16, size16, FREE_CALLBACK);
-                slot.indexBuffer->setBuffer(engine, std::move(bd));
-                continue;
-            }
-            IndexBuffer::BufferDescriptor bd(data, size, uploadCallback, uploadUserdata(asset));
-            slot.indexBuffer->setBuffer(engine, std::move(bd));
-            continue;
-        }
-
-        // If the buffer slot does not have an associated VertexBuffer or IndexBuffer, then this
-        // must be a morph target.
-        assert(slot.morphTargetBuffer);
-
-        if (requiresPacking(accessor)) {
-            const size_t floatsCount = accessor->count * cgltf_num_components(accessor->type);
-            const size_t floatsByteCount = sizeof(float) * floatsCount;
-            float* floatsData = (float*) malloc(floatsByteCount);
-            cgltf_accessor_unpack_floats(accessor, floatsData, floatsCount);
-            if (accessor->type == cgltf_type_vec3) {
-                slot.morphTargetBuffer->setPositionsAt(engine, slot.bufferIndex,
-                        (const float3*) floatsData, slot.morphTargetBuffer->getVertexCount());
-            } else {
-                slot.morphTargetBuffer->setPositionsAt(engine, slot.bufferIndex,
-                        (const float4*) data, slot.morphTargetBuffer->getVertexCount());
-            }
-            free(floatsData);
-            continue;
-        }
-
-        if (accessor->type == cgltf_type_vec3) {
-            slot.morphTargetBuffer->setPositionsAt(engine, slot.bufferIndex,
-                    (const float3*) data, slot.morphTargetBuffer->getVertexCount());
-        } else {
-            assert_invariant(accessor->type == cgltf_type_vec4);
-            slot.morphTargetBuffer->setPositionsAt(engine, slot.bufferIndex,
-                    (const float4*) data, slot.morphTargetBuffer->getVertexCount());
-        }
-    }
+    // Upload VertexBuffer and IndexBuffer data to the GPU, converting it first if necessary.
+    pImpl->uploadBuffers(asset);
 
     // Compute surface orientation quaternions if necessary. This is similar to sparse data in that
     // we need to generate the contents of a GPU buffer by processing one or more CPU buffer(s).
@@ -536,9 +558,15 @@ bool ResourceLoader::loadResources(FFilamentAsset* asset, bool async) {
     // Finally, create Filament Textures and begin loading image files.
     pImpl->createTextures(asset, async);
 
+    // Material instances can be shared only once all of their textures are known.
+    if (pImpl->mCache && pImpl->mRemainingTextureDownloads == 0) {
+        pImpl->shareMaterialInstances(asset);
+    }
+
     // Non-textured renderables are now considered ready, and we can guarantee that no new
     // materials or textures will be added. notify the dependency graph.
     asset->mDependencyGraph.finalize();
+    pImpl->markCachedTexturesAsReady(asset);
 
     asset->createAnimators();
 
@@ -580,12 +608,76 @@ void ResourceLoader::asyncUpdateLoad() {
     }
     for (const auto& iter : pImpl->mTextureProviders) {
         iter.second->updateQueue();
+
+        // Textures can be used as soon as their low resolution preview is available, if the
+        // provider supports progressive loading.
+        while (Texture* texture = iter.second->popPreviewTexture()) {
+            pImpl->mAsyncAsset->mDependencyGraph.markAsReady(texture);
+        }
         while (Texture* texture = iter.second->popTexture()) {
             pImpl->mAsyncAsset->mDependencyGraph.markAsReady(texture);
         }
     }
 }
 
+// Estimates the fraction of the viewport that is covered by the given object-space box.
+static float computeScreenCoverage(const Box& box, const mat4f& worldViewProjection) {
+    float2 lo(std::numeric_limits<float>::max());
+    float2 hi(std::numeric_limits<float>::lowest());
+    for (int i = 0; i < 8; i++) {
+        const float3 corner = box.center + box.halfExtent *
+                float3(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, i & 4 ? 1.0f : -1.0f);
+        const float4 clip = worldViewProjection * float4(corner, 1.0f);
+        // If the box straddles the camera plane, consider that it covers the whole viewport.
+        if (clip.w <= std::numeric_limits<float>::epsilon()) {
+            return 1.0f;
+        }
+        const float2 ndc = clip.xy / clip.w;
+        lo = min(lo, ndc);
+        hi = max(hi, ndc);
+    }
+    const float2 extent = max(clamp(hi, -1.0f, 1.0f) - clamp(lo, -1.0f, 1.0f), 0.0f);
+    return extent.x * extent.y * 0.25f;
+}
+
+void ResourceLoader::asyncPrioritizeTextures(const Camera& camera) {
+    FFilamentAsset* asset = pImpl->mAsyncAsset;
+    if (!asset || pImpl->mTextureBindings.empty()) {
+        return;
+    }
+    auto& rm = pImpl->mEngine->getRenderableManager();
+    auto& tm = pImpl->mEngine->getTransformManager();
+    const mat4f viewProjection = mat4f(camera.getProjectionMatrix() * camera.getViewMatrix());
+
+    // Accumulate the screen coverage of every material instance in the asset.
+    tsl::robin_map<const MaterialInstance*, float> coverage;
+    const Entity* entities = asset->getRenderableEntities();
+    for (size_t i = 0, n = asset->getRenderableEntityCount(); i < n; ++i) {
+        const auto renderable = rm.getInstance(entities[i]);
+        if (!renderable) {
+            continue;
+        }
+        const mat4f worldTransform = tm.getWorldTransform(tm.getInstance(entities[i]));
+        const float area = computeScreenCoverage(rm.getAxisAlignedBoundingBox(renderable),
+                viewProjection * worldTransform);
+        for (size_t p = 0, np = rm.getPrimitiveCount(renderable); p < np; ++p) {
+            coverage[rm.getMaterialInstanceAt(renderable, p)] += area;
+        }
+    }
+
+    // Each texture is as important as the sum of the material instances that reference it.
+    tsl::robin_map<Texture*, float> priorities;
+    for (const auto& binding : pImpl->mTextureBindings) {
+        auto iter = coverage.find(binding.materialInstance);
+        priorities[binding.texture] += iter == coverage.end() ? 0.0f : iter->second;
+    }
+    for (const auto& provider : pImpl->mTextureProviders) {
+        for (const auto& [texture, priority] : priorities) {
+            provider.second->setPriority(texture, priority);
+        }
+    }
+}
+
 Texture* ResourceLoader::Impl::getOrCreateTexture(FFilamentAsset* asset, const TextureSlot& tb) {
     const cgltf_texture* srcTexture = tb.texture;
     const cgltf_image* image = srcTexture->basisu_image ?
@@ -615,6 +707,24 @@ Texture* ResourceLoader::Impl::getOrCreateTexture(FFilamentAsset* asset, const T
         return nullptr;
     }
 
+    // When a shared cache is present, it is consulted before handing the content to the provider.
+    bool cacheHit = false;
+    auto pushTexture = [&](const uint8_t* data, size_t byteCount) -> Texture* {
+        if (!mCache) {
+            return provider->pushTexture(data, byteCount, mime.c_str(), flags);
+        }
+        const TextureKey key = FResourceCache::getTextureKey(data, byteCount, flags);
+        if (Texture* texture = mCache->acquireTexture(key)) {
+            cacheHit = true;
+            return texture;
+        }
+        Texture* texture = provider->pushTexture(data, byteCount, mime.c_str(), flags);
+        if (texture) {
+            mCache->addTexture(key, texture);
+        }
+        return texture;
+    };
+
     Texture* texture = nullptr;
 
     // Check if the texture slot uses BufferView data.
@@ -626,7 +736,7 @@ Texture* ResourceLoader::Impl::getOrCreateTexture(FFilamentAsset* asset, const T
             return iter->second;
         }
         const uint32_t totalSize = uint32_t(bv ? bv->size : 0);
-        if ((texture = provider->pushTexture(sourceData, totalSize, mime.c_str(), flags))) {
+        if ((texture = pushTexture(sourceData, totalSize))) {
             mBufferTextureCache[sourceData] = texture;
         }
     }
@@ -639,7 +749,7 @@ Texture* ResourceLoader::Impl::getOrCreateTexture(FFilamentAsset* asset, const T
             free((void*)dataUriContent);
             return iter->second;
         }
-        if ((texture = provider->pushTexture(dataUriContent, dataUriSize, mime.c_str(), flags))) {
+        if ((texture = pushTexture(dataUriContent, dataUriSize))) {
             mBufferTextureCache[uri] = texture;
         }
         free((void*)dataUriContent);
@@ -651,7 +761,7 @@ Texture* ResourceLoader::Impl::getOrCreateTexture(FFilamentAsset* asset, const T
         if (auto iter = mBufferTextureCache.find(sourceData); iter != mBufferTextureCache.end()) {
             return iter->second;
         }
-        if ((texture = provider->pushTexture(sourceData, iter->second.size, mime.c_str(), flags))) {
+        if ((texture = pushTexture(sourceData, iter->second.size))) {
             mBufferTextureCache[sourceData] = texture;
         }
     }
@@ -674,7 +784,7 @@ Texture* ResourceLoader::Impl::getOrCreateTexture(FFilamentAsset* asset, const T
         buffer.reserve((size_t) filest.tellg());
         filest.seekg(0, ios::beg);
         buffer.assign((istreambuf_iterator<char>(filest)), istreambuf_iterator<char>());
-        if ((texture = provider->pushTexture(buffer.data(), buffer.size(), mime.c_str(), flags))) {
+        if ((texture = pushTexture(buffer.data(), buffer.size()))) {
             mFilepathTextureCache[uri] = texture;
         }
 
@@ -690,6 +800,11 @@ Texture* ResourceLoader::Impl::getOrCreateTexture(FFilamentAsset* asset, const T
         slog.e << "Unable to create texture " << name << ": "
                 << provider->getPushMessage() << io::endl;
         asset->mDependencyGraph.markAsError(tb.materialInstance);
+    } else if (mCache) {
+        asset->mSharedTextures.push_back(texture);
+        if (cacheHit) {
+            mCachedTextures.push_back(texture);
+        }
     } else {
         asset->attachTexture(texture);
     }
@@ -707,9 +822,12 @@ void ResourceLoader::Impl::cancelTextureDecoding() {
 void ResourceLoader::Impl::createTextures(FFilamentAsset* asset, bool async) {
     // Create new texture objects if they are not cached and kick off decoding jobs.
     mRemainingTextureDownloads = 0;
+    mTextureBindings.clear();
     for (auto slot : asset->mTextureSlots) {
         if (Texture* texture = getOrCreateTexture(asset, slot)) {
             asset->bindTexture(slot, texture);
+            mTextureBindings.push_back({ texture, slot.materialInstance, slot.materialParameter,
+                    slot.sampler });
         }
     }
 
@@ -726,6 +844,314 @@ void ResourceLoader::Impl::createTextures(FFilamentAsset* asset, bool async) {
     }
 }
 
+void ResourceLoader::Impl::uploadBuffers(FFilamentAsset* asset) {
+    SYSTRACE_CALL();
+    using Kind = SlotConversion::Kind;
+    Engine& engine = *mEngine;
+    const std::vector<BufferSlot>& slots = asset->mBufferSlots;
+
+    // Determine which slots need to be converted and reserve space for them in the arena. The
+    // offsets are padded to keep every converted buffer suitably aligned.
+    auto conversions = FixedCapacityVector<SlotConversion>(slots.size());
+    size_t arenaSize = 0;
+    size_t conversionCount = 0;
+    for (size_t i = 0, n = slots.size(); i < n; ++i) {
+        const BufferSlot& slot = slots[i];
+        const cgltf_accessor* accessor = slot.accessor;
+        SlotConversion& conversion = conversions[i];
+        conversion = { accessor, nullptr, 0, 0, Kind::NONE };
+        if (!accessor->buffer_view) {
+            continue;
+        }
+        if (slot.indexBuffer) {
+            if (accessor->component_type == cgltf_component_type_r_8u) {
+                conversion.kind = Kind::BYTES_TO_SHORTS;
+                conversion.size = computeBindingSize(accessor) * sizeof(uint16_t);
+            }
+        } else if (slot.vertexBuffer ? requiresConversion(accessor) : requiresPacking(accessor)) {
+            conversion.kind = Kind::UNPACK_FLOATS;
+            conversion.size = sizeof(float) * accessor->count * cgltf_num_components(accessor->type);
+        }
+        if (conversion.kind != Kind::NONE) {
+            conversion.offset = arenaSize;
+            arenaSize += (conversion.size + 15) & ~size_t(15);
+            conversionCount++;
+        }
+    }
+
+    // Gather the slots that need work into a dense list and convert them in parallel.
+    ConversionArena* arena = arenaSize ? ConversionArena::create(arenaSize) : nullptr;
+    auto pending = FixedCapacityVector<SlotConversion*>::with_capacity(conversionCount);
+    for (SlotConversion& conversion : conversions) {
+        if (conversion.kind != Kind::NONE) {
+            conversion.dst = arena->data() + conversion.offset;
+            pending.push_back(&conversion);
+        }
+    }
+    if (!pending.empty()) {
+        JobSystem& js = mEngine->getJobSystem();
+        JobSystem::Job* job = jobs::parallel_for(js, nullptr, pending.data(),
+                uint32_t(pending.size()), [](SlotConversion** items, uint32_t count) {
+                    for (uint32_t i = 0; i < count; ++i) {
+                        convertSlot(*items[i]);
+                    }
+                }, jobs::CountSplitter<1, 8>());
+        js.runAndWait(job);
+    }
+
+    // Finally, create buffer objects and submit them to the engine from the calling thread.
+    for (size_t i = 0, n = slots.size(); i < n; ++i) {
+        const BufferSlot& slot = slots[i];
+        const cgltf_accessor* accessor = slot.accessor;
+        if (!accessor->buffer_view) {
+            continue;
+        }
+        const SlotConversion& conversion = conversions[i];
+        const bool converted = conversion.kind != Kind::NONE;
+        const uint8_t* data = converted ? conversion.dst :
+                computeBindingOffset(accessor) + (const uint8_t*) accessor->buffer_view->buffer->data;
+        const uint32_t size = converted ? conversion.size : computeBindingSize(accessor);
+
+        if (slot.vertexBuffer) {
+            BufferObject* bo = BufferObject::Builder().size(size).build(engine);
+            asset->mBufferObjects.push_back(bo);
+            bo->setBuffer(engine, converted ?
+                    BufferDescriptor(data, size, ConversionArena::release, arena->acquire()) :
+                    BufferDescriptor(data, size, uploadCallback, uploadUserdata(asset)));
+            slot.vertexBuffer->setBufferObjectAt(engine, slot.bufferIndex, bo);
+            continue;
+        } else if (slot.indexBuffer) {
+            slot.indexBuffer->setBuffer(engine, converted ?
+                    IndexBuffer::BufferDescriptor(data, size,
+                            ConversionArena::release, arena->acquire()) :
+                    IndexBuffer::BufferDescriptor(data, size,
+                            uploadCallback, uploadUserdata(asset)));
+            continue;
+        }
+
+        // If the buffer slot does not have an associated VertexBuffer or IndexBuffer, then this
+        // must be a morph target. Note that MorphTargetBuffer makes its own copy of the data.
+        assert(slot.morphTargetBuffer);
+
+        if (accessor->type == cgltf_type_vec3) {
+            slot.morphTargetBuffer->setPositionsAt(engine, slot.bufferIndex,
+                    (const float3*) data, slot.morphTargetBuffer->getVertexCount());
+        } else {
+            assert_invariant(accessor->type == cgltf_type_vec4);
+            slot.morphTargetBuffer->setPositionsAt(engine, slot.bufferIndex,
+                    (const float4*) data, slot.morphTargetBuffer->getVertexCount());
+        }
+    }
+
+    // Drop the reference that was held during conversion; this frees the arena immediately if no
+    // BufferDescriptor refers to it.
+    if (arena) {
+        ConversionArena::release(nullptr, 0, arena);
+    }
+}
+
+void ResourceLoader::Impl::markCachedTexturesAsReady(FFilamentAsset* asset) {
+    // Note that a cached texture could still be decoding on behalf of another asset, in which case
+    // it might be rendered for a few frames before all of its miplevels are populated.
+    for (Texture* texture : mCachedTextures) {
+        asset->mDependencyGraph.markAsReady(texture);
+    }
+    mCachedTextures.clear();
+}
+
+// Flattens the glTF material parameters that AssetLoader applies to a material instance into
+// 32-bit words. Textures are not included here because they are accounted for separately.
+static void appendMaterialParameters(const cgltf_material* mat, std::vector<uint32_t>& words) {
+    if (!mat) {
+        return;
+    }
+    auto add = [&words](auto value) {
+        if constexpr (std::is_floating_point_v<decltype(value)>) {
+            static_assert(sizeof(value) == sizeof(uint32_t));
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            words.push_back(bits);
+        } else {
+            words.push_back(uint32_t(value));
+        }
+    };
+    auto addFloats = [&add](const cgltf_float* values, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            add(values[i]);
+        }
+    };
+    auto addView = [&](const cgltf_texture_view& view) {
+        add(view.texture != nullptr);
+        add(view.texcoord);
+        add(view.scale);
+        add(view.has_transform);
+        if (view.has_transform) {
+            addFloats(view.transform.offset, 2);
+            add(view.transform.rotation);
+            addFloats(view.transform.scale, 2);
+            add(view.transform.has_texcoord);
+            add(view.transform.texcoord);
+        }
+    };
+
+    const auto& mr = mat->pbr_metallic_roughness;
+    addView(mr.base_color_texture);
+    addView(mr.metallic_roughness_texture);
+    addFloats(mr.base_color_factor, 4);
+    add(mr.metallic_factor);
+    add(mr.roughness_factor);
+
+    add(mat->has_pbr_specular_glossiness);
+    const auto& sg = mat->pbr_specular_glossiness;
+    addView(sg.diffuse_texture);
+    addView(sg.specular_glossiness_texture);
+    addFloats(sg.diffuse_factor, 4);
+    addFloats(sg.specular_factor, 3);
+    add(sg.glossiness_factor);
+
+    add(mat->has_clearcoat);
+    addView(mat->clearcoat.clearcoat_texture);
+    addView(mat->clearcoat.clearcoat_roughness_texture);
+    addView(mat->clearcoat.clearcoat_normal_texture);
+    add(mat->clearcoat.clearcoat_factor);
+    add(mat->clearcoat.clearcoat_roughness_factor);
+
+    add(mat->has_transmission);
+    addView(mat->transmission.transmission_texture);
+    add(mat->transmission.transmission_factor);
+
+    add(mat->has_volume);
+    addView(mat->volume.thickness_texture);
+    add(mat->volume.thickness_factor);
+    addFloats(mat->volume.attenuation_color, 3);
+    add(mat->volume.attenuation_distance);
+
+    add(mat->has_sheen);
+    addView(mat->sheen.sheen_color_texture);
+    addFloats(mat->sheen.sheen_color_factor, 3);
+    addView(mat->sheen.sheen_roughness_texture);
+    add(mat->sheen.sheen_roughness_factor);
+
+    add(mat->has_ior);
+    add(mat->ior.ior);
+    add(mat->has_emissive_strength);
+    add(mat->emissive_strength.emissive_strength);
+
+    addView(mat->normal_texture);
+    addView(mat->occlusion_texture);
+    addView(mat->emissive_texture);
+    addFloats(mat->emissive_factor, 3);
+    add(int(mat->alpha_mode));
+    add(mat->alpha_cutoff);
+    add(mat->double_sided);
+    add(mat->unlit);
+}
+
+void ResourceLoader::Impl::shareMaterialInstances(FFilamentAsset* asset) {
+    SYSTRACE_CALL();
+    assert_invariant(mCache);
+
+    // Material variants refer to specific material instances, so we leave these assets alone.
+    if (!asset->mVariants.empty()) {
+        return;
+    }
+
+    // Every texture is owned by the cache, so two textures with the same content are the same
+    // object. This allows texture bindings to be compared by pointer.
+    tsl::robin_map<const MaterialInstance*, std::vector<MaterialInstanceKey::TextureBinding>>
+            textureBindings;
+    for (const TextureBinding& binding : mTextureBindings) {
+        textureBindings[binding.materialInstance].push_back({ binding.parameter,
+                binding.texture, binding.sampler.getSamplerParams().u });
+    }
+
+    // Find or register a shared instance for every material instance in the asset.
+    tsl::robin_map<MaterialInstance*, MaterialInstance*> replacements;
+    for (auto iter = asset->mMatInstanceCache.begin(); iter != asset->mMatInstanceCache.end();
+            ++iter) {
+        MaterialEntry& entry = iter.value();
+        MaterialInstance* mi = entry.instance;
+        if (!mi) {
+            continue;
+        }
+        // The asset key is the source material pointer, with the low bit indicating vertex color.
+        const intptr_t assetKey = iter->first;
+        MaterialInstanceKey key;
+        key.material = mi->getMaterial();
+        appendMaterialParameters((const cgltf_material*) (assetKey & ~intptr_t(1)),
+                key.parameters);
+        key.parameters.push_back(uint32_t(assetKey & 1));
+        for (UvSet uvset : entry.uvmap) {
+            key.parameters.push_back(uint32_t(uvset));
+        }
+        if (auto textures = textureBindings.find(mi); textures != textureBindings.end()) {
+            key.textures = std::move(textures.value());
+            std::sort(key.textures.begin(), key.textures.end());
+        }
+
+        if (MaterialInstance* shared = mCache->acquireMaterialInstance(key)) {
+            replacements[mi] = shared;
+            entry.instance = shared;
+            asset->mSharedMaterialInstances.push_back(shared);
+        } else {
+            mCache->addMaterialInstance(key, mi);
+            asset->mSharedMaterialInstances.push_back(mi);
+        }
+    }
+
+    // Cache-owned instances must not be listed by the asset, otherwise a client could take
+    // ownership of them with detachMaterialInstances() and destroy them.
+    tsl::robin_set<MaterialInstance*> cacheOwned(asset->mSharedMaterialInstances.begin(),
+            asset->mSharedMaterialInstances.end());
+    auto& materialInstances = asset->mMaterialInstances;
+    materialInstances.erase(std::remove_if(materialInstances.begin(), materialInstances.end(),
+            [&](MaterialInstance* mi) {
+                return cacheOwned.find(mi) != cacheOwned.end() ||
+                        replacements.find(mi) != replacements.end();
+            }), materialInstances.end());
+
+    if (replacements.empty()) {
+        return;
+    }
+
+    // Point every renderable (including those of instances) to the shared material instances.
+    auto& rm = mEngine->getRenderableManager();
+    for (Entity entity : asset->mEntities) {
+        const auto renderable = rm.getInstance(entity);
+        if (!renderable) {
+            continue;
+        }
+        for (size_t p = 0, n = rm.getPrimitiveCount(renderable); p < n; ++p) {
+            auto iter = replacements.find(rm.getMaterialInstanceAt(renderable, p));
+            if (iter != replacements.end()) {
+                rm.setMaterialInstanceAt(renderable, p, iter->second);
+            }
+        }
+    }
+
+    // Update the remaining references, including the dependency graph, which would otherwise
+    // report errors for the shared instances and keep the replaced ones as keys.
+    for (const auto& [replaced, shared] : replacements) {
+        asset->mDependencyGraph.replaceMaterial(replaced, shared);
+    }
+    for (TextureSlot& slot : asset->mTextureSlots) {
+        if (auto iter = replacements.find(slot.materialInstance); iter != replacements.end()) {
+            slot.materialInstance = iter->second;
+        }
+    }
+    for (TextureBinding& binding : mTextureBindings) {
+        if (auto iter = replacements.find(binding.materialInstance); iter != replacements.end()) {
+            binding.materialInstance = iter->second;
+        }
+    }
+
+    // Nothing refers to the replaced instances anymore. They were never added to the cache, so the
+    // asset held the only reference to each of them.
+    for (const auto& [replaced, shared] : replacements) {
+        mEngine->destroy(replaced);
+    }
+}
+
 void ResourceLoader::Impl::computeTangents(FFilamentAsset* asset) {
     SYSTRACE_CALL();
 
@@ -16,15 +16,20 @@
 
 #include <gltfio/TextureProvider.h>
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
+#include <stdlib.h>
+
 #include <utils/JobSystem.h>
 #include <utils/Log.h>
 
 #include <filament/Engine.h>
 #include <filament/Texture.h>
 
+#include <tsl/robin_map.h>
+
 #include <stb_image.h>
 
 using namespace filament;
@@ -45,6 +50,7 @@ public:
             const char* mimeType, uint64_t flags) final;
 
     Texture* popTexture() final;
+    Texture* popPreviewTexture() final;
     void updateQueue() final;
     void waitForCompletion() final;
     void cancelDecoding() final;
@@ -53,10 +59,14 @@ public:
     size_t getPushedCount() const final { return mPushedCount; }
     size_t getPoppedCount() const final { return mPoppedCount; }
     size_t getDecodedCount() const final { return mDecodedCount; }
+    void setPriority(Texture* texture, float priority) final;
+    void setDecoderBudget(size_t byteCount) final { mDecoderBudget = byteCount; }
 
 private:
     enum class TextureState {
-        DECODING, // Texture has been pushed, mipmap levels are not yet complete.
+        QUEUED,   // Texture has been pushed, but its decoder job has not been started yet.
+        DECODING, // Decoder job has been started, mipmap levels are not yet complete.
+        DECODED,  // Texels are decoded, but only the preview levels (if any) have been uploaded.
         READY,    // Mipmap levels are available but texture has not been popped yet.
         POPPED,   // Client has popped the texture from the queue.
     };
@@ -67,6 +77,11 @@ private:
         atomic<intptr_t> decodedTexelsBaseMipmap;
         vector<uint8_t> sourceBuffer;
         JobSystem::Job*  decoderJob;
+        size_t decodedSize;
+        float priority;
+        uint8_t previewLevel;
+        bool previewPending;
+        uint8_t* previewTexels;
     };
 
     // Declare some sentinel values for the "decodedTexelsBaseMipmap" field.
@@ -74,12 +89,31 @@ private:
     static const intptr_t DECODING_NOT_READY = 0x0;
     static const intptr_t DECODING_ERROR = 0x1;
 
+    // Miplevels that fit in this size are uploaded as soon as a texture is decoded, the larger
+    // levels are uploaded later, in priority order.
+    static constexpr uint32_t PREVIEW_SIZE = 64;
+
+    // Amount of full resolution texels uploaded by a single call to updateQueue(). At least one
+    // texture is uploaded per call.
+    static constexpr size_t UPLOAD_BYTES_PER_UPDATE = 16 * 1024 * 1024;
+
+    static void decode(TextureInfo* info);
     void decodeSingleTexture();
+    void startDecoderJobs(bool unlimited);
+    void startDecoderJob(TextureInfo* info);
+    void uploadPreview(TextureInfo* info);
+    void uploadFullResolution(TextureInfo* info);
+    TextureInfo* getHighestPriority(TextureState state) const;
 
     size_t mPushedCount = 0;
     size_t mPoppedCount = 0;
     size_t mDecodedCount = 0;
+    size_t mDecodingCount = 0;
+    size_t mDecodingBytes = 0;
+    size_t mDecoderBudget = 0;
+    bool mUploadAll = false;
     vector<unique_ptr<TextureInfo> > mTextures;
+    tsl::robin_map<Texture*, TextureInfo*> mTextureInfos;
     JobSystem::Job* mDecoderRootJob;
     std::string mRecentPushMessage;
     std::string mRecentPopMessage;
@@ -111,38 +145,150 @@ Texture* StbProvider::pushTexture(const uint8_t* data, size_t byteCount,
 
     mRecentPushMessage.clear();
     TextureInfo* info = mTextures.emplace_back(new TextureInfo).get();
+    mTextureInfos[texture] = info;
     ++mPushedCount;
 
+    // The preview starts at the largest miplevel that fits in PREVIEW_SIZE. Small textures do not
+    // have a preview, since they are cheap to upload anyway.
+    uint8_t previewLevel = 0;
+    while (std::max(width >> previewLevel, height >> previewLevel) > int(PREVIEW_SIZE)) {
+        ++previewLevel;
+    }
+
     info->texture = texture;
-    info->state = TextureState::DECODING;
+    info->state = TextureState::QUEUED;
     info->sourceBuffer.assign(data, data + byteCount);
     info->decodedTexelsBaseMipmap.store(DECODING_NOT_READY);
+    info->decoderJob = nullptr;
+    info->decodedSize = size_t(width) * height * 4;
+    info->priority = 0.0f;
+    info->previewLevel = previewLevel;
+    info->previewPending = false;
+    info->previewTexels = nullptr;
 
     // On single threaded systems, it is usually fine to create jobs because the job system will
     // simply execute serially. However in our case, we wish to amortize the decoder cost across
     // several frames, so we instead use the updateQueue() method to perform decoding.
-    if constexpr (!UTILS_HAS_THREADING) {
-        info->decoderJob = nullptr;
-        return texture;
+    if constexpr (UTILS_HAS_THREADING) {
+        startDecoderJobs(false);
     }
+    return texture;
+}
 
-    JobSystem* js = &mEngine->getJobSystem();
-    info->decoderJob = jobs::createJob(*js, mDecoderRootJob, [this, info] {
-        auto& source = info->sourceBuffer;
-        int width, height, comp;
+void StbProvider::setPriority(Texture* texture, float priority) {
+    auto iter = mTextureInfos.find(texture);
+    if (iter != mTextureInfos.end()) {
+        iter.value()->priority = priority;
+    }
+}
+
+StbProvider::TextureInfo* StbProvider::getHighestPriority(TextureState state) const {
+    TextureInfo* next = nullptr;
+    for (auto& info : mTextures) {
+        if (info->state == state && (!next || info->priority > next->priority)) {
+            next = info.get();
+        }
+    }
+    return next;
+}
+
+// Decoder jobs are started lazily, in priority order, such that the number of jobs in flight does
+// not exceed the number of worker threads and the decoded texels that are waiting to be uploaded
+// fit within the decoder budget. This also allows pending textures to be cancelled.
+void StbProvider::startDecoderJobs(bool unlimited) {
+    const size_t maxJobCount = std::max(size_t(1), mEngine->getJobSystem().getThreadCount());
+    while (unlimited || mDecodingCount < maxJobCount) {
+        TextureInfo* next = getHighestPriority(TextureState::QUEUED);
+        if (!next) {
+            return;
+        }
+        const bool overBudget = mDecoderBudget && mDecodingBytes &&
+                mDecodingBytes + next->decodedSize > mDecoderBudget;
+        if (!unlimited && overBudget) {
+            return;
+        }
+        startDecoderJob(next);
+    }
+}
+
+void StbProvider::startDecoderJob(TextureInfo* info) {
+    info->state = TextureState::DECODING;
+    ++mDecodingCount;
+    mDecodingBytes += info->decodedSize;
 
+    JobSystem* js = &mEngine->getJobSystem();
+    info->decoderJob = jobs::createJob(*js, mDecoderRootJob, [info] {
         // Test asynchronous loading by uncommenting this line.
         // std::this_thread::sleep_for(std::chrono::milliseconds(rand() % 10000));
-
-        stbi_uc* texels = stbi_load_from_memory(source.data(), source.size(),
-                &width, &height, &comp, 4);
-        source.clear();
-        source.shrink_to_fit();
-        info->decodedTexelsBaseMipmap.store(texels ? intptr_t(texels) : DECODING_ERROR);
+        decode(info);
     });
 
     js->runAndRetain(info->decoderJob);
-    return texture;
+}
+
+// Decodes the source image and downsamples it into the preview levels. This runs on a worker
+// thread and publishes its results through the "decodedTexelsBaseMipmap" field.
+void StbProvider::decode(TextureInfo* info) {
+    auto& source = info->sourceBuffer;
+    int width, height, comp;
+    stbi_uc* texels = stbi_load_from_memory(source.data(), source.size(),
+            &width, &height, &comp, 4);
+    source.clear();
+    source.shrink_to_fit();
+    if (!texels) {
+        info->decodedTexelsBaseMipmap.store(DECODING_ERROR);
+        return;
+    }
+
+    if (info->previewLevel > 0) {
+        // Compute the size of all preview levels, down to 1x1.
+        size_t previewSize = 0;
+        for (uint32_t w = width >> info->previewLevel, h = height >> info->previewLevel;;
+                w >>= 1, h >>= 1) {
+            previewSize += size_t(std::max(w, 1u)) * std::max(h, 1u) * 4;
+            if (w <= 1 && h <= 1) {
+                break;
+            }
+        }
+
+        // Repeatedly apply a 2x2 box filter. The intermediate levels above the preview are not
+        // kept, and the preview levels are written back to back into a single allocation.
+        uint8_t* const preview = (uint8_t*) malloc(previewSize);
+        vector<uint8_t> scratch[2];
+        const uint8_t* src = texels;
+        uint8_t* dst = preview;
+        uint32_t srcw = width, srch = height;
+        for (uint32_t level = 1; srcw > 1 || srch > 1; ++level) {
+            const uint32_t dstw = std::max(srcw >> 1, 1u);
+            const uint32_t dsth = std::max(srch >> 1, 1u);
+            uint8_t* out = dst;
+            if (level < info->previewLevel) {
+                scratch[level & 1].resize(size_t(dstw) * dsth * 4);
+                out = scratch[level & 1].data();
+            }
+            for (uint32_t y = 0; y < dsth; ++y) {
+                const uint8_t* row0 = src + size_t(std::min(2 * y, srch - 1)) * srcw * 4;
+                const uint8_t* row1 = src + size_t(std::min(2 * y + 1, srch - 1)) * srcw * 4;
+                for (uint32_t x = 0; x < dstw; ++x) {
+                    const uint32_t x0 = std::min(2 * x, srcw - 1) * 4;
+                    const uint32_t x1 = std::min(2 * x + 1, srcw - 1) * 4;
+                    for (uint32_t c = 0; c < 4; ++c) {
+                        *out++ = uint8_t((row0[x0 + c] + row0[x1 + c] +
+                                row1[x0 + c] + row1[x1 + c] + 2) / 4);
+                    }
+                }
+            }
+            src = out - size_t(dstw) * dsth * 4;
+            if (level >= info->previewLevel) {
+                dst = out;
+            }
+            srcw = dstw;
+            srch = dsth;
+        }
+        info->previewTexels = preview;
+    }
+
+    info->decodedTexelsBaseMipmap.store(intptr_t(texels));
 }
 
 Texture* StbProvider::popTexture() {
@@ -165,6 +311,16 @@ Texture* StbProvider::popTexture() {
     return nullptr;
 }
 
+Texture* StbProvider::popPreviewTexture() {
+    for (auto& texture : mTextures) {
+        if (texture->previewPending) {
+            texture->previewPending = false;
+            return texture->texture;
+        }
+    }
+    return nullptr;
+}
+
 void StbProvider::updateQueue() {
     if (!UTILS_HAS_THREADING) {
         decodeSingleTexture();
@@ -174,52 +330,151 @@ void StbProvider::updateQueue() {
         if (info->state != TextureState::DECODING) {
             continue;
         }
-        Texture* texture = info->texture;
         if (intptr_t data = info->decodedTexelsBaseMipmap.load()) {
             if (info->decoderJob) {
                 js->waitAndRelease(info->decoderJob);
+                info->decoderJob = nullptr;
             }
+            --mDecodingCount;
             if (data == DECODING_ERROR) {
+                mDecodingBytes -= info->decodedSize;
                 info->state = TextureState::READY;
                 ++mDecodedCount;
                 continue;
             }
-            Texture::PixelBufferDescriptor pbd((uint8_t*) data,
-                    texture->getWidth() * texture->getHeight() * 4, Texture::Format::RGBA,
-                    Texture::Type::UBYTE, [](void* mem, size_t, void*) { stbi_image_free(mem); });
-            texture->setImage(*mEngine, 0, std::move(pbd));
-
-            // Call generateMipmaps unconditionally to fulfill the promise of the TextureProvider
-            // interface. Providers of hierarchical images (e.g. KTX) call this only if needed.
-            texture->generateMipmaps(*mEngine);
+            uploadPreview(info.get());
+            info->state = TextureState::DECODED;
+        }
+    }
 
-            info->state = TextureState::READY;
-            ++mDecodedCount;
+    // The full resolution texels are uploaded most important first, and are spread over several
+    // calls to bound the amount of data that is uploaded per frame. Their decoded texels keep
+    // counting against the decoder budget until then.
+    size_t uploadedBytes = 0;
+    while (mUploadAll || uploadedBytes < UPLOAD_BYTES_PER_UPDATE) {
+        TextureInfo* next = getHighestPriority(TextureState::DECODED);
+        if (!next) {
+            break;
         }
+        uploadFullResolution(next);
+        uploadedBytes += next->decodedSize;
     }
+    mUploadAll = false;
 
     // Here we periodically clean up the "queue" (which is really just a vector) by removing unused
     // items from the front. This might ignore a popped texture that occurs in the middle of the
     // vector, but that's okay, it will be cleaned up eventually.
     decltype(mTextures)::iterator last = mTextures.begin();
-    while (last != mTextures.end() && (*last)->state == TextureState::POPPED) ++last;
+    while (last != mTextures.end() && (*last)->state == TextureState::POPPED) {
+        // The client might have freed a popped texture, and a new one might have been pushed at
+        // the same address since, so only erase lookup entries that refer to this item.
+        auto iter = mTextureInfos.find((*last)->texture);
+        if (iter != mTextureInfos.end() && iter->second == last->get()) {
+            mTextureInfos.erase(iter);
+        }
+        ++last;
+    }
     mTextures.erase(mTextures.begin(), last);
+
+    // Now that some texels have been uploaded, there may be room for more decoder jobs.
+    if constexpr (UTILS_HAS_THREADING) {
+        startDecoderJobs(false);
+    }
+}
+
+void StbProvider::uploadPreview(TextureInfo* info) {
+    if (!info->previewTexels) {
+        return;
+    }
+    using Callback = Texture::PixelBufferDescriptor::Callback;
+    const Callback freePreview = [](void*, size_t, void* user) { free(user); };
+    Texture* texture = info->texture;
+    const uint8_t levelCount = uint8_t(texture->getLevels());
+    const uint8_t* texels = info->previewTexels;
+    for (uint8_t level = info->previewLevel; level < levelCount; ++level) {
+        const size_t size = texture->getWidth(level) * texture->getHeight(level) * 4;
+        // All preview levels share a single allocation, which is freed after the last upload.
+        const bool last = level == levelCount - 1;
+        Texture::PixelBufferDescriptor pbd(texels, size, Texture::Format::RGBA,
+                Texture::Type::UBYTE, last ? freePreview : nullptr,
+                last ? info->previewTexels : nullptr);
+        texture->setImage(*mEngine, level, std::move(pbd));
+        texels += size;
+    }
+    info->previewTexels = nullptr;
+
+    // Until the larger levels are uploaded, sampling is restricted to the preview.
+    texture->setMinMaxLevels(*mEngine, info->previewLevel, levelCount - 1);
+    info->previewPending = true;
+}
+
+void StbProvider::uploadFullResolution(TextureInfo* info) {
+    Texture* texture = info->texture;
+    const intptr_t data = info->decodedTexelsBaseMipmap.load();
+    Texture::PixelBufferDescriptor pbd((uint8_t*) data,
+            texture->getWidth() * texture->getHeight() * 4, Texture::Format::RGBA,
+            Texture::Type::UBYTE, [](void* mem, size_t, void*) { stbi_image_free(mem); });
+    texture->setImage(*mEngine, 0, std::move(pbd));
+
+    // Call generateMipmaps unconditionally to fulfill the promise of the TextureProvider
+    // interface. Providers of hierarchical images (e.g. KTX) call this only if needed.
+    texture->generateMipmaps(*mEngine);
+    if (info->previewLevel > 0) {
+        texture->setMinMaxLevels(*mEngine, 0, uint8_t(texture->getLevels() - 1));
+    }
+
+    mDecodingBytes -= info->decodedSize;
+    info->previewPending = false;
+    info->state = TextureState::READY;
+    ++mDecodedCount;
 }
 
 void StbProvider::waitForCompletion() {
+    // Waiting for completion implies that every queued texture gets decoded, regardless of the
+    // decoder budget, and that the next call to updateQueue() uploads all of them.
+    if constexpr (UTILS_HAS_THREADING) {
+        startDecoderJobs(true);
+    } else {
+        while (std::any_of(mTextures.begin(), mTextures.end(), [](auto const& info) {
+            return info->state == TextureState::QUEUED;
+        })) {
+            decodeSingleTexture();
+        }
+    }
     JobSystem& js = mEngine->getJobSystem();
     for (auto& info : mTextures) {
         if (info->decoderJob) {
             js.waitAndRelease(info->decoderJob);
+            info->decoderJob = nullptr;
         }
     }
+    mUploadAll = true;
 }
 
 void StbProvider::cancelDecoding() {
-    // TODO: Currently, StbProvider runs jobs eagerly and JobSystem does not allow cancellation of
-    // in-flight jobs. We should consider throttling the number of simultaneous decoder jobs, which
-    // would allow for actual cancellation.
-    waitForCompletion();
+    // JobSystem does not allow cancellation of in-flight jobs, but textures whose decoder job has
+    // not started yet can be cancelled. They become poppable on the next call to updateQueue().
+    for (auto& info : mTextures) {
+        if (info->state == TextureState::QUEUED) {
+            info->sourceBuffer.clear();
+            info->sourceBuffer.shrink_to_fit();
+            info->decodedTexelsBaseMipmap.store(DECODING_ERROR);
+            info->state = TextureState::DECODING;
+            ++mDecodingCount;
+            mDecodingBytes += info->decodedSize;
+        }
+    }
+    JobSystem& js = mEngine->getJobSystem();
+    for (auto& info : mTextures) {
+        if (info->decoderJob) {
+            js.waitAndRelease(info->decoderJob);
+            info->decoderJob = nullptr;
+        }
+    }
+
+    // Textures that have already been decoded are not cancelled, their full resolution levels are
+    // uploaded by the next call to updateQueue().
+    mUploadAll = true;
 }
 
 const char* StbProvider::getPushMessage() const {
@@ -232,17 +487,11 @@ const char* StbProvider::getPopMessage() const {
 
 void StbProvider::decodeSingleTexture() {
     assert_invariant(!UTILS_HAS_THREADING);
-    for (auto& info : mTextures) {
-        if (info->state == TextureState::DECODING) {
-            auto& source = info->sourceBuffer;
-            int width, height, comp;
-            stbi_uc* texels = stbi_load_from_memory(source.data(), source.size(),
-                    &width, &height, &comp, 4);
-            source.clear();
-            source.shrink_to_fit();
-            info->decodedTexelsBaseMipmap.store(texels ? intptr_t(texels) : DECODING_ERROR);
-            break;
-        }
+    if (TextureInfo* next = getHighestPriority(TextureState::QUEUED)) {
+        decode(next);
+        next->state = TextureState::DECODING;
+        ++mDecodingCount;
+        mDecodingBytes += next->decodedSize;
     }
 }
 
@@ -257,6 +506,16 @@ StbProvider::StbProvider(Engine* engine) : mEngine(engine) {
 
 StbProvider::~StbProvider() {
     cancelDecoding();
+
+    // Free the texels that were decoded but never uploaded.
+    for (auto& info : mTextures) {
+        const intptr_t data = info->decodedTexelsBaseMipmap.load();
+        if (info->state != TextureState::READY && info->state != TextureState::POPPED &&
+                data != DECODING_ERROR && data != DECODING_NOT_READY) {
+            stbi_image_free((void*) data);
+            free(info->previewTexels);
+        }
+    }
     mEngine->getJobSystem().release(mDecoderRootJob);
 }
 
@@ -0,0 +1,319 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gltfio/AssetLoader.h>
+#include <gltfio/MaterialProvider.h>
+#include <gltfio/ResourceCache.h>
+#include <gltfio/ResourceLoader.h>
+#include <gltfio/TextureProvider.h>
+
+#include <filament/Engine.h>
+#include <filament/MaterialInstance.h>
+#include <filament/RenderableManager.h>
+#include <filament/Texture.h>
+
+#include <math/vec4.h>
+
+#include <utils/EntityManager.h>
+#include <utils/NameComponentManager.h>
+
+#include <gtest/gtest.h>
+
+#include "materials/uberarchive.h"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace filament;
+using namespace filament::gltfio;
+using namespace utils;
+
+using std::vector;
+
+class TextureProviderTest : public testing::Test {
+protected:
+    void SetUp() override {
+        engine = Engine::create(Engine::Backend::NOOP);
+    }
+
+    void TearDown() override {
+        Engine::destroy(&engine);
+    }
+
+    // Calls updateQueue() until every pushed texture has been popped, and returns them in the
+    // order they were popped. The given function is called after each update.
+    template<typename F>
+    vector<Texture*> popAll(TextureProvider* provider, F&& afterUpdate) {
+        vector<Texture*> popped;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        while (provider->getPoppedCount() < provider->getPushedCount() &&
+                std::chrono::steady_clock::now() < deadline) {
+            provider->updateQueue();
+            afterUpdate();
+            while (Texture* texture = provider->popTexture()) {
+                popped.push_back(texture);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return popped;
+    }
+
+    Engine* engine = nullptr;
+};
+
+static vector<uint8_t> encodePng(int width, int height) {
+    vector<uint8_t> texels(size_t(width) * height * 4);
+    for (size_t i = 0; i < texels.size(); ++i) {
+        texels[i] = uint8_t(i / 4 + i % 4);
+    }
+    vector<uint8_t> png;
+    stbi_write_png_to_func([](void* context, void* data, int size) {
+        auto* png = (vector<uint8_t>*) context;
+        png->insert(png->end(), (uint8_t*) data, (uint8_t*) data + size);
+    }, &png, width, height, 4, texels.data(), width * 4);
+    return png;
+}
+
+TEST_F(TextureProviderTest, DecoderBudget) {
+    TextureProvider* provider = createStbProvider(engine);
+
+    // A budget that is smaller than any texture allows a single texture to be decoded at a time,
+    // so each update can complete at most one texture.
+    provider->setDecoderBudget(1);
+    const vector<uint8_t> png = encodePng(256, 256);
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_NE(provider->pushTexture(png.data(), png.size(), "image/png", 0), nullptr);
+    }
+
+    size_t decodedCount = 0;
+    vector<Texture*> popped = popAll(provider, [&] {
+        EXPECT_LE(provider->getDecodedCount(), decodedCount + 1);
+        decodedCount = provider->getDecodedCount();
+    });
+
+    ASSERT_EQ(popped.size(), 4);
+    EXPECT_EQ(provider->getDecodedCount(), 4);
+    EXPECT_EQ(provider->getPopMessage(), nullptr);
+    for (Texture* texture : popped) {
+        engine->destroy(texture);
+    }
+    delete provider;
+}
+
+TEST_F(TextureProviderTest, PriorityScheduling) {
+    TextureProvider* provider = createStbProvider(engine);
+    provider->setDecoderBudget(1);
+    const vector<uint8_t> png = encodePng(256, 256);
+
+    // The first texture starts decoding as soon as it is pushed, the others wait for the budget
+    // and are decoded by decreasing priority.
+    Texture* a = provider->pushTexture(png.data(), png.size(), "image/png", 0);
+    Texture* b = provider->pushTexture(png.data(), png.size(), "image/png", 0);
+    Texture* c = provider->pushTexture(png.data(), png.size(), "image/png", 0);
+    Texture* d = provider->pushTexture(png.data(), png.size(), "image/png", 0);
+    provider->setPriority(b, 1.0f);
+    provider->setPriority(c, 3.0f);
+    provider->setPriority(d, 2.0f);
+
+    vector<Texture*> popped = popAll(provider, [] {});
+    EXPECT_EQ(popped, vector<Texture*>({ a, c, d, b }));
+    for (Texture* texture : popped) {
+        engine->destroy(texture);
+    }
+    delete provider;
+}
+
+TEST_F(TextureProviderTest, PreviewsComeFirst) {
+    TextureProvider* provider = createStbProvider(engine);
+    const vector<uint8_t> large = encodePng(1024, 512);
+    const vector<uint8_t> small = encodePng(32, 32);
+    Texture* textures[] = {
+        provider->pushTexture(large.data(), large.size(), "image/png", 0),
+        provider->pushTexture(large.data(), large.size(), "image/png", 0),
+        provider->pushTexture(large.data(), large.size(), "image/png", 0),
+        provider->pushTexture(small.data(), small.size(), "image/png", 0),
+    };
+
+    // A texture can only be reported as a preview once, and only before it is complete. Small
+    // textures do not have a preview.
+    vector<Texture*> previews;
+    vector<Texture*> popped = popAll(provider, [&] {
+        while (Texture* texture = provider->popPreviewTexture()) {
+            EXPECT_NE(texture, textures[3]);
+            EXPECT_EQ(std::count(previews.begin(), previews.end(), texture), 0);
+            previews.push_back(texture);
+        }
+    });
+    ASSERT_EQ(popped.size(), 4);
+    for (Texture* texture : previews) {
+        EXPECT_NE(std::find(popped.begin(), popped.end(), texture), popped.end());
+    }
+    for (Texture* texture : textures) {
+        engine->destroy(texture);
+    }
+    delete provider;
+}
+
+TEST_F(TextureProviderTest, WaitForCompletion) {
+    TextureProvider* provider = createStbProvider(engine);
+    provider->setDecoderBudget(1);
+    const vector<uint8_t> png = encodePng(2048, 2048);
+    vector<Texture*> textures;
+    for (int i = 0; i < 3; ++i) {
+        textures.push_back(provider->pushTexture(png.data(), png.size(), "image/png", 0));
+    }
+
+    // Waiting ignores the decoder budget, and the following update uploads every texture in full
+    // rather than spreading the uploads over several updates.
+    provider->waitForCompletion();
+    provider->updateQueue();
+    EXPECT_EQ(provider->getDecodedCount(), 3);
+    EXPECT_EQ(provider->popPreviewTexture(), nullptr);
+    for (Texture* texture : textures) {
+        EXPECT_NE(provider->popTexture(), nullptr);
+        engine->destroy(texture);
+    }
+    delete provider;
+}
+
+// A single triangle drawn three times. The first two primitives use materials with identical
+// parameters, the third one uses a different base color.
+static const char* const kTriangles = R"({
+    "asset": { "version": "2.0" },
+    "scene": 0,
+    "scenes": [ { "nodes": [ 0 ] } ],
+    "nodes": [ { "mesh": 0 } ],
+    "meshes": [ { "primitives": [
+        { "attributes": { "POSITION": 0 }, "material": 0 },
+        { "attributes": { "POSITION": 0 }, "material": 1 },
+        { "attributes": { "POSITION": 0 }, "material": 2 }
+    ] } ],
+    "materials": [
+        { "pbrMetallicRoughness": { "baseColorFactor": [ 1, 0, 0, 1 ] } },
+        { "pbrMetallicRoughness": { "baseColorFactor": [ 1, 0, 0, 1 ] } },
+        { "pbrMetallicRoughness": { "baseColorFactor": [ 0, 1, 0, 1 ] } }
+    ],
+    "accessors": [ { "bufferView": 0, "componentType": 5126, "count": 3, "type": "VEC3",
+            "min": [ 0, 0, 0 ], "max": [ 1, 1, 0 ] } ],
+    "bufferViews": [ { "buffer": 0, "byteLength": 36 } ],
+    "buffers": [ { "byteLength": 36,
+            "uri": "data:application/octet-stream;base64,AAAAAAAAAAAAAAAAAACAPwAAAAAAAAAAAAAAAAAAgD8AAAAA" } ]
+})";
+
+class ResourceCacheTest : public testing::Test {
+protected:
+    void SetUp() override {
+        engine = Engine::create(Engine::Backend::NOOP);
+        names = new NameComponentManager(EntityManager::get());
+        materials = createUbershaderProvider(engine,
+                UBERARCHIVE_DEFAULT_DATA, UBERARCHIVE_DEFAULT_SIZE);
+        assetLoader = AssetLoader::create({ engine, materials, names });
+        cache = ResourceCache::create(engine);
+    }
+
+    void TearDown() override {
+        ResourceCache::destroy(&cache);
+        AssetLoader::destroy(&assetLoader);
+        materials->destroyMaterials();
+        delete materials;
+        delete names;
+        Engine::destroy(&engine);
+    }
+
+    // Loads the test asset with its own ResourceLoader, which is destroyed before returning.
+    FilamentAsset* loadAsset() {
+        FilamentAsset* asset = assetLoader->createAsset((const uint8_t*) kTriangles,
+                uint32_t(strlen(kTriangles)));
+        EXPECT_NE(asset, nullptr);
+        ResourceConfiguration configuration = {};
+        configuration.engine = engine;
+        configuration.normalizeSkinningWeights = true;
+        configuration.cache = cache;
+        ResourceLoader resourceLoader(configuration);
+        EXPECT_TRUE(resourceLoader.loadResources(asset));
+        return asset;
+    }
+
+    MaterialInstance* getMaterialInstance(FilamentAsset* asset, size_t primitiveIndex) {
+        auto& rm = engine->getRenderableManager();
+        EXPECT_EQ(asset->getRenderableEntityCount(), 1);
+        auto renderable = rm.getInstance(asset->getRenderableEntities()[0]);
+        return rm.getMaterialInstanceAt(renderable, primitiveIndex);
+    }
+
+    Engine* engine = nullptr;
+    NameComponentManager* names = nullptr;
+    MaterialProvider* materials = nullptr;
+    AssetLoader* assetLoader = nullptr;
+    ResourceCache* cache = nullptr;
+};
+
+TEST_F(ResourceCacheTest, HitAndMiss) {
+    // The first material misses and the second one hits, while the third one has a different
+    // color and misses again.
+    FilamentAsset* asset = loadAsset();
+    EXPECT_EQ(cache->getMaterialInstanceCount(), 2);
+    EXPECT_EQ(getMaterialInstance(asset, 0), getMaterialInstance(asset, 1));
+    EXPECT_NE(getMaterialInstance(asset, 0), getMaterialInstance(asset, 2));
+
+    // Shared instances belong to the cache, so the asset does not list them.
+    EXPECT_EQ(asset->getMaterialInstanceCount(), 0);
+
+    // The dependency graph follows the replacement, so the renderable still becomes ready.
+    EXPECT_EQ(asset->popRenderables(nullptr, 0), 1);
+
+    assetLoader->destroyAsset(asset);
+    EXPECT_EQ(cache->getMaterialInstanceCount(), 0);
+}
+
+TEST_F(ResourceCacheTest, SharedAcrossLoaders) {
+    FilamentAsset* first = loadAsset();
+    FilamentAsset* second = loadAsset();
+    EXPECT_EQ(cache->getMaterialInstanceCount(), 2);
+    for (size_t i = 0; i < 3; ++i) {
+        EXPECT_EQ(getMaterialInstance(first, i), getMaterialInstance(second, i));
+    }
+    EXPECT_EQ(second->popRenderables(nullptr, 0), 1);
+    assetLoader->destroyAsset(first);
+    assetLoader->destroyAsset(second);
+}
+
+TEST_F(ResourceCacheTest, ReleaseOnLastReference) {
+    FilamentAsset* first = loadAsset();
+    FilamentAsset* second = loadAsset();
+    MaterialInstance* red = getMaterialInstance(second, 0);
+
+    // Destroying one of the assets releases its references but the instances stay alive for the
+    // other one.
+    assetLoader->destroyAsset(first);
+    EXPECT_EQ(cache->getMaterialInstanceCount(), 2);
+    EXPECT_EQ(getMaterialInstance(second, 0), red);
+    red->setParameter("baseColorFactor", math::float4(0.5f));
+
+    assetLoader->destroyAsset(second);
+    EXPECT_EQ(cache->getMaterialInstanceCount(), 0);
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ibl/Cubemap.h>
+#include <ibl/CubemapIBL.h>
+#include <ibl/CubemapUtils.h>
+#include <ibl/Image.h>
+
+#include <utils/JobSystem.h>
+
+#include <math/vec3.h>
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+using namespace filament::ibl;
+using namespace filament::math;
+using namespace utils;
+
+// Creates a noisy environment of the given face size and its box-filtered mip chain.
+static void createEnvironment(JobSystem& js, size_t dim,
+        std::vector<Cubemap>& levels, std::vector<Image>& images) {
+    Image temp;
+    Cubemap base = CubemapUtils::create(temp, dim);
+    uint32_t seed = 1;
+    for (size_t f = 0; f < 6; f++) {
+        Image& image = base.getImageForFace((Cubemap::Face)f);
+        for (size_t y = 0; y < dim; y++) {
+            for (size_t x = 0; x < dim; x++) {
+                float3 c;
+                for (size_t i = 0; i < 3; i++) {
+                    seed = seed * 1664525u + 1013904223u;
+                    c[i] = float(seed >> 8u) / float(1u << 24u);
+                }
+                Cubemap::writeAt(image.getPixelRef(x, y), c);
+            }
+        }
+    }
+    base.makeSeamless();
+    images.push_back(std::move(temp));
+    levels.push_back(std::move(base));
+
+    while (dim > 1) {
+        dim >>= 1u;
+        Cubemap dst = CubemapUtils::create(temp, dim);
+        CubemapUtils::downsampleCubemapLevelBoxFilter(js, dst, levels.back());
+        dst.makeSeamless();
+        images.push_back(std::move(temp));
+        levels.push_back(std::move(dst));
+    }
+}
+
+// Arguments: face size, sample count.
+static void BM_roughnessFilter(benchmark::State& state) {
+    JobSystem js;
+    js.adopt();
+
+    const size_t dim = size_t(state.range(0));
+    const size_t numSamples = size_t(state.range(1));
+
+    std::vector<Cubemap> levels;
+    std::vector<Image> images;
+    createEnvironment(js, dim, levels, images);
+
+    Image image;
+    Cubemap dst = CubemapUtils::create(image, dim);
+    for (auto _ : state) {
+        CubemapIBL::roughnessFilter(js, dst, levels, 0.5f, numSamples,
+                float3{ 1, 1, 1 }, true);
+        benchmark::DoNotOptimize(image.getData());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * 6 * dim * dim);
+
+    js.emancipate();
+}
+
+BENCHMARK(BM_roughnessFilter)
+        ->ArgNames({ "size", "samples" })
+        ->Args({ 256, 64 })
+        ->Args({ 512, 64 })
+        ->Args({ 1024, 64 })
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+
+// Arguments: LUT size, variant (0: single scattering, 1: multiscattering, 2: with cloth).
+static void BM_DFG(benchmark::State& state) {
+    JobSystem js;
+    js.adopt();
+
+    const size_t size = size_t(state.range(0));
+    const bool multiscatter = state.range(1) == 1;
+    const bool cloth = state.range(1) == 2;
+
+    Image image(size, size);
+    for (auto _ : state) {
+        CubemapIBL::DFG(js, image, multiscatter, cloth);
+        benchmark::DoNotOptimize(image.getData());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * size * size);
+
+    js.emancipate();
+}
+
+BENCHMARK(BM_DFG)
+        ->ArgNames({ "size", "variant" })
+        ->Args({ 64, 0 })
+        ->Args({ 128, 0 })
+        ->Args({ 128, 1 })
+        ->Args({ 128, 2 })
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
@@ -74,6 +74,67 @@ public:
         return SHindex(m, l);
     }
 
+    /**
+     * Incrementally computes the spherical harmonics decomposition of a cubemap.
+     *
+     * The cubemap is split into square tiles, which can be integrated over several calls, e.g.
+     * a few tiles per frame for a cubemap that changes gradually. The decomposition always
+     * reflects the last integration of each tile. Integrating a lower mip level of the cubemap
+     * is much faster and, because texels are weighted by their solid angle, gives a
+     * close approximation of the low bands.
+     */
+    class UTILS_PUBLIC Accumulator {
+    public:
+        /**
+         * @param numBands  number of SH bands to compute
+         * @param dim       face size of the cubemaps that will be integrated
+         * @param tileSize  size of the square tiles faces are split into
+         */
+        Accumulator(size_t numBands, size_t dim, size_t tileSize = 32);
+
+        //! Number of tiles, tiles are ordered by face.
+        size_t getTileCount() const noexcept { return mTileCount; }
+
+        //! Whether every tile has been integrated at least once since the last reset().
+        bool isComplete() const noexcept { return mIntegratedCount == mTileCount; }
+
+        //! Forgets all integrated tiles.
+        void reset() noexcept;
+
+        /**
+         * Integrates tiles [first, first + count) of the given cubemap, replacing their
+         * previous contribution. The cubemap must have the dimension given at construction.
+         */
+        void accumulate(utils::JobSystem& js, const Cubemap& cm, size_t first, size_t count);
+
+        /**
+         * Integrates the next count tiles, wrapping around to the first tile after the last.
+         * Calling this every frame amortizes the decomposition over several frames.
+         */
+        void update(utils::JobSystem& js, const Cubemap& cm, size_t count);
+
+        /**
+         * Returns the SH coefficients, with the same scaling as computeSH().
+         * Optionally calculates irradiance by convolving with truncated cos.
+         */
+        std::unique_ptr<math::float3[]> getSH(bool irradiance) const;
+
+    private:
+        void integrateTile(const Cubemap& cm, size_t tile) noexcept;
+
+        size_t mNumBands;
+        size_t mNumCoefs;
+        size_t mDim;
+        size_t mTileSize;
+        size_t mTilesPerSide;
+        size_t mTileCount;
+        size_t mCursor = 0;
+        size_t mIntegratedCount = 0;
+        std::vector<float> mSolidAngles;        // per texel of a face, identical for all faces
+        std::vector<math::float3> mTileSH;      // mNumCoefs per tile
+        std::vector<bool> mIntegrated;          // per tile
+    };
+
 private:
     class float5 {
         float v[5];
@@ -101,6 +162,8 @@ private:
 
     static void computeShBasis(float* SHb, size_t numBands, const math::float3& s);
 
+    static void scaleSH(math::float3* sh, size_t numBands, bool irradiance);
+
     static float Kml(ssize_t m, size_t l);
 
     static std::vector<float> Ki(size_t numBands);
@@ -41,7 +41,8 @@ inline bool isPOT(size_t x) {
     return !(x & (x - 1));
 }
 
-inline filament::math::float2 hammersley(uint32_t i, float iN) {
+// base-2 radical inverse of i, i.e. the second coordinate of the Hammersley sequence
+constexpr float radicalInverse(uint32_t i) {
     constexpr float tof = 0.5f / 0x80000000U;
     uint32_t bits = i;
     bits = (bits << 16u) | (bits >> 16u);
@@ -49,9 +50,30 @@ inline filament::math::float2 hammersley(uint32_t i, float iN) {
     bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
     bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
     bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
-    return { i * iN, bits * tof };
+    return bits * tof;
 }
 
+constexpr filament::math::float2 hammersley(uint32_t i, float iN) {
+    return { i * iN, radicalInverse(i) };
+}
+
+/**
+ * The first COUNT points of the Hammersley sequence, in SoA form. This is meant to be
+ * instantiated as a constexpr for small sample counts, so the table is built at compile time.
+ */
+template<size_t COUNT>
+struct HammersleyTable {
+    constexpr HammersleyTable() noexcept {
+        for (uint32_t i = 0; i < COUNT; i++) {
+            u[i] = i * (1.0f / COUNT);
+            v[i] = radicalInverse(i);
+        }
+    }
+    static constexpr size_t size() noexcept { return COUNT; }
+    float u[COUNT] = {};
+    float v[COUNT] = {};
+};
+
 } // namespace ibl
 } // namespace filament
 #endif /* IBL_UTILITIES_H */
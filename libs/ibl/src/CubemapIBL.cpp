@@ -23,12 +23,13 @@
 
 #include "CubemapUtilsImpl.h"
 
+#include <utils/debug.h>
 #include <utils/JobSystem.h>
 
 #include <math/mat3.h>
 #include <math/scalar.h>
 
-#include <random>
+#include <algorithm>
 #include <vector>
 
 using namespace filament::math;
@@ -56,6 +57,94 @@ static float3 hemisphereImportanceSampleDggx(float2 u, float a) { // pdf = D(a)
     return { sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta };
 }
 
+// size of the square tiles roughnessFilter() partitions the destination into
+static constexpr size_t TILE_SIZE = 16;
+
+// number of output texels roughnessFilter() and DFG() process together in their inner loop
+static constexpr size_t LANE_COUNT = 8;
+
+// roughnessFilter()'s importance samples, in SoA form
+struct SampleTable {
+    explicit SampleTable(size_t count)
+            : x(count), y(count), z(count), weight(count), lerp(count), l0(count), l1(count) {}
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    std::vector<float> weight;
+    std::vector<float> lerp;
+    std::vector<uint8_t> l0;
+    std::vector<uint8_t> l1;
+};
+
+// addressing data of one of roughnessFilter()'s source levels
+struct SourceLevel {
+    uint8_t const* faces[6];
+    size_t bytesPerRow;     // all faces are backed by the same image
+    float dim;
+    float upperBound;
+};
+
+// Accumulates, for every lane, the bilinearly filtered texel of the given source level at the
+// face and coordinates (in [0, 1]) of the lane, multiplied by the given weight.
+// Addresses and filter weights are computed across lanes, then the texels are gathered one lane
+// at a time into SoA arrays, so that the accumulation is again done across lanes.
+// This is equivalent to Cubemap::filterAt() for each lane.
+UTILS_ALWAYS_INLINE
+static inline void accumulateBilinear(SourceLevel const& level, float weight,
+        uint8_t const* face, float const* s, float const* t,
+        float* UTILS_RESTRICT r, float* UTILS_RESTRICT g, float* UTILS_RESTRICT b) {
+    size_t offset[LANE_COUNT];
+    float w00[LANE_COUNT], w10[LANE_COUNT], w01[LANE_COUNT], w11[LANE_COUNT];
+    for (size_t i = 0; i < LANE_COUNT; i++) {
+        const float x = std::min(s[i] * level.dim, level.upperBound);
+        const float y = std::min(t[i] * level.dim, level.upperBound);
+        const uint32_t x0 = uint32_t(x);
+        const uint32_t y0 = uint32_t(y);
+        const float u = x - float(x0);
+        const float v = y - float(y0);
+        w00[i] = (1 - u) * (1 - v) * weight;
+        w10[i] = u * (1 - v) * weight;
+        w01[i] = (1 - u) * v * weight;
+        w11[i] = u * v * weight;
+        offset[i] = y0 * level.bytesPerRow + x0 * sizeof(Cubemap::Texel);
+    }
+
+    // we allow ourselves to read past the width/height of a face because the data is valid
+    // and contains the "seamless" data.
+    float c00[3][LANE_COUNT], c10[3][LANE_COUNT], c01[3][LANE_COUNT], c11[3][LANE_COUNT];
+    for (size_t i = 0; i < LANE_COUNT; i++) {
+        uint8_t const* const p = level.faces[face[i]] + offset[i];
+        auto const* const row0 = reinterpret_cast<Cubemap::Texel const*>(p);
+        auto const* const row1 = reinterpret_cast<Cubemap::Texel const*>(p + level.bytesPerRow);
+        for (size_t c = 0; c < 3; c++) {
+            c00[c][i] = row0[0][c];
+            c10[c][i] = row0[1][c];
+            c01[c][i] = row1[0][c];
+            c11[c][i] = row1[1][c];
+        }
+    }
+
+    for (size_t i = 0; i < LANE_COUNT; i++) {
+        r[i] += w00[i] * c00[0][i] + w10[i] * c10[0][i] + w01[i] * c01[0][i] + w11[i] * c11[0][i];
+        g[i] += w00[i] * c00[1][i] + w10[i] * c10[1][i] + w01[i] * c01[1][i] + w11[i] * c11[1][i];
+        b[i] += w00[i] * c00[2][i] + w10[i] * c10[2][i] + w01[i] * c01[2][i] + w11[i] * c11[2][i];
+    }
+}
+
+// Returns a random angle in [-pi, pi] derived from a texel's coordinates. Unlike a
+// random engine, this doesn't depend on the order texels are processed in, so the result
+// is the same regardless of how the work is split between threads.
+static float randomAngle(uint32_t face, uint32_t x, uint32_t y) {
+    // murmur3 finalizer
+    uint32_t h = x * 0x9E3779B1u ^ y * 0x85EBCA77u ^ face * 0xC2B2AE3Du;
+    h ^= h >> 16u;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13u;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16u;
+    return (float(h >> 8u) * (1.0f / float(1u << 24u))) * (2.0f * (float) F_PI) - (float) F_PI;
+}
+
 static float3 UTILS_UNUSED hemisphereCosSample(float2 u) {  // pdf = cosTheta / F_PI;
     const float phi = 2.0f * (float) F_PI * u.x;
     const float cosTheta2 = 1 - u.y;
@@ -416,51 +505,147 @@ void CubemapIBL::roughnessFilter(
     });
 
 
-    struct State {
-        // maybe blue-noise instead would look even better
-        std::default_random_engine gen;
-        std::uniform_real_distribution<float> distribution{ -F_PI, F_PI };
-    };
+    // The sample table is transposed to SoA, so that the inner loop below can rotate one sample
+    // for several output texels at once with straight vector arithmetic.
+    const size_t sampleCount = cache.size();
+    SampleTable table(sampleCount);
+    for (size_t i = 0; i < sampleCount; i++) {
+        const CacheEntry& e = cache[i];
+        table.x[i] = e.L.x;
+        table.y[i] = e.L.y;
+        table.z[i] = e.L.z;
+        table.weight[i] = e.brdf_NoL;
+        table.lerp[i] = e.lerp;
+        table.l0[i] = e.l0;
+        table.l1[i] = e.l1;
+    }
 
-    auto scanline = [&](State& state, size_t y,
-            Cubemap::Face f, Cubemap::Texel* data, size_t dim) {
-        if (UTILS_UNLIKELY(updater)) {
-            size_t p = progress.fetch_add(1, std::memory_order_relaxed) + 1;
-            updater(0, (float) p / ((float) dim * 6.0f), userdata);
+    std::vector<SourceLevel> sourceLevels(levels.size());
+    for (size_t i = 0; i < levels.size(); i++) {
+        const Cubemap& cm = levels[i];
+        SourceLevel& level = sourceLevels[i];
+        for (size_t f = 0; f < 6; f++) {
+            level.faces[f] = static_cast<uint8_t const*>(
+                    cm.getImageForFace((Cubemap::Face)f).getData());
         }
-        mat3 R;
-        const size_t numSamples = cache.size();
-        for (size_t x = 0; x < dim; ++x, ++data) {
-            const float2 p(Cubemap::center(x, y));
-            const float3 N(dst.getDirectionFor(f, p.x, p.y) * mirror);
+        level.bytesPerRow = cm.getImageForFace(Cubemap::Face::PX).getBytesPerRow();
+        level.dim = float(cm.getDimensions());
+        level.upperBound = std::nextafter(level.dim, 0.0f);
+    }
 
-            // center the cone around the normal (handle case of normal close to up)
-            const float3 up = std::abs(N.z) < 0.999 ? float3(0, 0, 1) : float3(1, 0, 0);
-            R[0] = normalize(cross(up, N));
-            R[1] = cross(N, R[0]);
-            R[2] = N;
+    // The destination is processed in square tiles rather than scanlines: neighboring texels
+    // sample neighboring regions of the source levels, so a tile keeps its working set
+    // in cache. Tiles are independent, which also lets all faces run in parallel.
+    const size_t dim = dst.getDimensions();
+    const size_t tilesPerSide = (dim + TILE_SIZE - 1) / TILE_SIZE;
+    const size_t tilesPerFace = tilesPerSide * tilesPerSide;
+    const size_t tileCount = 6 * tilesPerFace;
+
+    auto processTile = [&](size_t tileIndex) {
+        const auto f = (Cubemap::Face)(tileIndex / tilesPerFace);
+        const size_t tile = tileIndex % tilesPerFace;
+        const size_t x0 = (tile % tilesPerSide) * TILE_SIZE;
+        const size_t y0 = (tile / tilesPerSide) * TILE_SIZE;
+        const size_t x1 = std::min(x0 + TILE_SIZE, dim);
+        const size_t y1 = std::min(y0 + TILE_SIZE, dim);
+        Image& image(dst.getImageForFace(f));
+
+        for (size_t y = y0; y < y1; y++) {
+            Cubemap::Texel* data = static_cast<Cubemap::Texel*>(image.getPixelRef(0, y));
+            for (size_t x = x0; x < x1; x += LANE_COUNT) {
+                const size_t laneCount = std::min(LANE_COUNT, x1 - x);
+
+                // tangent frame of each lane, stored as rows of R so that R * L is computed
+                // across lanes with one multiply-add per component
+                float rxx[LANE_COUNT], rxy[LANE_COUNT], rxz[LANE_COUNT];
+                float ryx[LANE_COUNT], ryy[LANE_COUNT], ryz[LANE_COUNT];
+                float rzx[LANE_COUNT], rzy[LANE_COUNT], rzz[LANE_COUNT];
+                for (size_t i = 0; i < LANE_COUNT; i++) {
+                    // unused lanes duplicate the last texel, their result is discarded
+                    const size_t lx = x + std::min(i, laneCount - 1);
+                    const float2 p(Cubemap::center(lx, y));
+                    const float3 N(dst.getDirectionFor(f, p.x, p.y) * mirror);
+
+                    // center the cone around the normal (handle case of normal close to up)
+                    const float3 up = std::abs(N.z) < 0.999 ? float3(0, 0, 1) : float3(1, 0, 0);
+                    mat3 R;
+                    R[0] = normalize(cross(up, N));
+                    R[1] = cross(N, R[0]);
+                    R[2] = N;
+                    R *= mat3f::rotation(randomAngle(uint32_t(f), uint32_t(lx), uint32_t(y)),
+                            float3{ 0, 0, 1 });
+
+                    rxx[i] = R[0].x; rxy[i] = R[1].x; rxz[i] = R[2].x;
+                    ryx[i] = R[0].y; ryy[i] = R[1].y; ryz[i] = R[2].y;
+                    rzx[i] = R[0].z; rzy[i] = R[1].z; rzz[i] = R[2].z;
+                }
 
-            R *= mat3f::rotation(state.distribution(state.gen), float3{0,0,1});
+                float Lr[LANE_COUNT] = {};
+                float Lg[LANE_COUNT] = {};
+                float Lb[LANE_COUNT] = {};
+                for (size_t sample = 0; sample < sampleCount; sample++) {
+                    const float sx = table.x[sample];
+                    const float sy = table.y[sample];
+                    const float sz = table.z[sample];
+
+                    // rotate the sample for each lane, and find where it lands in the cubemap;
+                    // this is Cubemap::getAddressFor() without branches
+                    uint8_t face[LANE_COUNT];
+                    float s[LANE_COUNT], t[LANE_COUNT];
+                    for (size_t i = 0; i < LANE_COUNT; i++) {
+                        const float lx = rxx[i] * sx + rxy[i] * sy + rxz[i] * sz;
+                        const float ly = ryx[i] * sx + ryy[i] * sy + ryz[i] * sz;
+                        const float lz = rzx[i] * sx + rzy[i] * sy + rzz[i] * sz;
+                        const float ax = std::abs(lx);
+                        const float ay = std::abs(ly);
+                        const float az = std::abs(lz);
+                        const bool isX = ax >= ay && ax >= az;
+                        const bool isY = !isX && ay >= az;
+                        const float ma = 1.0f / (isX ? ax : (isY ? ay : az));
+                        const float sc = isX ? (lx >= 0 ? -lz : lz) : (isY || lz >= 0 ? lx : -lx);
+                        const float tc = isY ? (ly >= 0 ? lz : -lz) : -ly;
+                        face[i] = isX ? (lx >= 0 ? 0 : 1) : isY ? (ly >= 0 ? 2 : 3) : (lz >= 0 ? 4 : 5);
+                        s[i] = (sc * ma + 1.0f) * 0.5f;
+                        t[i] = (tc * ma + 1.0f) * 0.5f;
+                    }
 
-            float3 Li = 0;
-            for (size_t sample = 0; sample < numSamples; sample++) {
-                const CacheEntry& e = cache[sample];
-                const float3 L(R * e.L);
-                const Cubemap& cmBase = levels[e.l0];
-                const Cubemap& next = levels[e.l1];
-                const float3 c0 = Cubemap::trilinearFilterAt(cmBase, next, e.lerp, L);
-                Li += c0 * e.brdf_NoL;
+                    // trilinear filtering, see Cubemap::trilinearFilterAt()
+                    const float w = table.weight[sample];
+                    const float lerp = table.lerp[sample];
+                    accumulateBilinear(sourceLevels[table.l0[sample]], w * (1 - lerp),
+                            face, s, t, Lr, Lg, Lb);
+                    if (lerp > 0) {
+                        accumulateBilinear(sourceLevels[table.l1[sample]], w * lerp,
+                                face, s, t, Lr, Lg, Lb);
+                    }
+                }
+                for (size_t i = 0; i < laneCount; i++) {
+                    Cubemap::writeAt(data + x + i, Cubemap::Texel{ Lr[i], Lg[i], Lb[i] });
+                }
             }
-            Cubemap::writeAt(data, Cubemap::Texel(Li));
+        }
+
+        if (UTILS_UNLIKELY(updater)) {
+            size_t p = progress.fetch_add(1, std::memory_order_relaxed) + 1;
+            updater(0, (float) p / (float) tileCount, userdata);
         }
     };
 
-    // don't use the jobsystem unless we have enough work per scanline -- or the overhead of
+    // don't use the jobsystem unless we have enough work -- or the overhead of
     // launching jobs will prevail.
-    if (dst.getDimensions() * maxNumSamples <= 256) {
-        CubemapUtils::processSingleThreaded<State>(dst, js, std::ref(scanline));
+    if (dim * maxNumSamples <= 256) {
+        for (size_t i = 0; i < tileCount; i++) {
+            processTile(i);
+        }
     } else {
-        CubemapUtils::process<State>(dst, js, std::ref(scanline));
+        auto tiles = [&processTile](uint32_t start, uint32_t count) {
+            for (uint32_t i = start; i < start + count; i++) {
+                processTile(i);
+            }
+        };
+        auto job = jobs::parallel_for(js, nullptr, 0, uint32_t(tileCount),
+                std::cref(tiles), jobs::CountSplitter<1, 12>());
+        js.runAndWait(job);
     }
 }
 
@@ -745,91 +930,120 @@ static float2 UTILS_UNUSED DFV_NoIS(float NoV, float roughness, size_t numSample
  *
  */
 
-static float2 DFV(float NoV, float linearRoughness, size_t numSamples) {
-    float2 r = 0;
-    const float3 V(std::sqrt(1 - NoV * NoV), 0, NoV);
-    for (size_t i = 0; i < numSamples; i++) {
-        const float2 u = hammersley(uint32_t(i), 1.0f / numSamples);
+// number of samples used to integrate the GGX terms of the DFG
+static constexpr size_t DFV_SAMPLE_COUNT = 1024;
+
+// number of samples used to integrate the cloth term of the DFG
+static constexpr size_t DFV_CLOTH_SAMPLE_COUNT = 4096;
+
+// the GGX terms use few enough samples that the Hammersley sequence is built at compile time
+static constexpr HammersleyTable<DFV_SAMPLE_COUNT> sDFVHammersley{};
+
+/*
+ * DFG() integrates LANE_COUNT texels of a row at once. All texels of a row share the same
+ * roughness, and therefore the same samples, so these are computed once per row and stored
+ * below. The loop over the lanes is branchless so that it can be vectorized.
+ *
+ * Since v = [sqrt(1 - (n•v)^2) 0 n•v], only h.x and h.z are needed to compute v•h and n•l.
+ */
+struct DFVSampleTable {
+    explicit DFVSampleTable(size_t count) : x(count), z(count), d(count) {}
+    size_t size() const noexcept { return x.size(); }
+    std::vector<float> x;   // h.x
+    std::vector<float> z;   // h.z, i.e. n•h
+    std::vector<float> d;   // distribution term, when it doesn't cancel out with the pdf
+};
+
+static void importanceSampleDggx(DFVSampleTable& samples, float linearRoughness) {
+    assert_invariant(samples.size() == DFV_SAMPLE_COUNT);
+    for (size_t i = 0; i < DFV_SAMPLE_COUNT; i++) {
+        const float2 u{ sDFVHammersley.u[i], sDFVHammersley.v[i] };
         const float3 H = hemisphereImportanceSampleDggx(u, linearRoughness);
-        const float3 L = 2 * dot(V, H) * H - V;
-        const float VoH = saturate(dot(V, H));
-        const float NoL = saturate(L.z);
-        const float NoH = saturate(H.z);
-        if (NoL > 0) {
-            /*
-             * Fc = (1 - V•H)^5
-             * F(h) = f0*(1 - Fc) + f90*Fc
-             *
-             * f0 and f90 are known at runtime, but thankfully can be factored out, allowing us
-             * to split the integral in two terms and store both terms separately in a LUT.
-             *
-             * At runtime, we can reconstruct Er() exactly as below:
-             *
-             *            4                      <v•h>
-             *   DFV.x = --- ∑ (1 - Fc) V(v, l) ------- <n•l>
-             *            N  h                   <n•h>
-             *
-             *
-             *            4                      <v•h>
-             *   DFV.y = --- ∑ (    Fc) V(v, l) ------- <n•l>
-             *            N  h                   <n•h>
-             *
-             *
-             *   Er() = f0 * DFV.x + f90 * DFV.y
-             *
-             */
-            const float v = Visibility(NoV, NoL, linearRoughness) * NoL * (VoH / NoH);
-            const float Fc = pow5(1 - VoH);
-            r.x += v * (1.0f - Fc);
-            r.y += v * Fc;
-        }
+        samples.x[i] = H.x;
+        samples.z[i] = saturate(H.z);
     }
-    return r * (4.0f / numSamples);
 }
 
-static float2 DFV_Multiscatter(float NoV, float linearRoughness, size_t numSamples) {
-    float2 r = 0;
-    const float3 V(std::sqrt(1 - NoV * NoV), 0, NoV);
+template<bool MULTISCATTER>
+static void DFV(float2* UTILS_RESTRICT out, float const* UTILS_RESTRICT NoV,
+        float linearRoughness, DFVSampleTable const& samples) {
+    float sinV[LANE_COUNT];
+    float rx[LANE_COUNT] = {};
+    float ry[LANE_COUNT] = {};
+    for (size_t l = 0; l < LANE_COUNT; l++) {
+        sinV[l] = std::sqrt(1 - NoV[l] * NoV[l]);
+    }
+    const size_t numSamples = samples.size();
     for (size_t i = 0; i < numSamples; i++) {
-        const float2 u = hammersley(uint32_t(i), 1.0f / numSamples);
-        const float3 H = hemisphereImportanceSampleDggx(u, linearRoughness);
-        const float3 L = 2 * dot(V, H) * H - V;
-        const float VoH = saturate(dot(V, H));
-        const float NoL = saturate(L.z);
-        const float NoH = saturate(H.z);
-        if (NoL > 0) {
-            const float v = Visibility(NoV, NoL, linearRoughness) * NoL * (VoH / NoH);
+        const float Hx = samples.x[i];
+        const float NoH = samples.z[i];
+        for (size_t l = 0; l < LANE_COUNT; l++) {
+            // l = 2 * v•h * h - v
+            const float VdotH = sinV[l] * Hx + NoV[l] * NoH;
+            const float VoH = saturate(VdotH);
+            const float NoL = saturate(2 * VdotH * NoH - NoV[l]);
             const float Fc = pow5(1 - VoH);
-            /*
-             * Assuming f90 = 1
-             *   Fc = (1 - V•H)^5
-             *   F(h) = f0*(1 - Fc) + Fc
-             *
-             * f0 and f90 are known at runtime, but thankfully can be factored out, allowing us
-             * to split the integral in two terms and store both terms separately in a LUT.
-             *
-             * At runtime, we can reconstruct Er() exactly as below:
-             *
-             *            4                <v•h>
-             *   DFV.x = --- ∑ Fc V(v, l) ------- <n•l>
-             *            N  h             <n•h>
-             *
-             *
-             *            4                <v•h>
-             *   DFV.y = --- ∑    V(v, l) ------- <n•l>
-             *            N  h             <n•h>
-             *
-             *
-             *   Er() = (1 - f0) * DFV.x + f0 * DFV.y
-             *
-             *        = mix(DFV.xxx, DFV.yyy, f0)
-             *
-             */
-            r.x += v * Fc;
-            r.y += v;
+            float v = Visibility(NoV[l], NoL, linearRoughness) * NoL * (VoH / NoH);
+            v = NoL > 0 ? v : 0.0f;
+            if (MULTISCATTER) {
+                /*
+                 * Assuming f90 = 1
+                 *   Fc = (1 - V•H)^5
+                 *   F(h) = f0*(1 - Fc) + Fc
+                 *
+                 * f0 and f90 are known at runtime, but thankfully can be factored out, allowing us
+                 * to split the integral in two terms and store both terms separately in a LUT.
+                 *
+                 * At runtime, we can reconstruct Er() exactly as below:
+                 *
+                 *            4                <v•h>
+                 *   DFV.x = --- ∑ Fc V(v, l) ------- <n•l>
+                 *            N  h             <n•h>
+                 *
+                 *
+                 *            4                <v•h>
+                 *   DFV.y = --- ∑    V(v, l) ------- <n•l>
+                 *            N  h             <n•h>
+                 *
+                 *
+                 *   Er() = (1 - f0) * DFV.x + f0 * DFV.y
+                 *
+                 *        = mix(DFV.xxx, DFV.yyy, f0)
+                 *
+                 */
+                rx[l] += v * Fc;
+                ry[l] += v;
+            } else {
+                /*
+                 * Fc = (1 - V•H)^5
+                 * F(h) = f0*(1 - Fc) + f90*Fc
+                 *
+                 * f0 and f90 are known at runtime, but thankfully can be factored out, allowing us
+                 * to split the integral in two terms and store both terms separately in a LUT.
+                 *
+                 * At runtime, we can reconstruct Er() exactly as below:
+                 *
+                 *            4                      <v•h>
+                 *   DFV.x = --- ∑ (1 - Fc) V(v, l) ------- <n•l>
+                 *            N  h                   <n•h>
+                 *
+                 *
+                 *            4                      <v•h>
+                 *   DFV.y = --- ∑ (    Fc) V(v, l) ------- <n•l>
+                 *            N  h                   <n•h>
+                 *
+                 *
+                 *   Er() = f0 * DFV.x + f90 * DFV.y
+                 *
+                 */
+                rx[l] += v * (1.0f - Fc);
+                ry[l] += v * Fc;
+            }
         }
     }
-    return r * (4.0f / numSamples);
+    for (size_t l = 0; l < LANE_COUNT; l++) {
+        out[l] = float2{ rx[l], ry[l] } * (4.0f / numSamples);
+    }
 }
 
 static float UTILS_UNUSED DFV_LazanyiTerm(float NoV, float linearRoughness, size_t numSamples) {
@@ -853,24 +1067,40 @@ static float UTILS_UNUSED DFV_LazanyiTerm(float NoV, float linearRoughness, size
     return r * (4.0f / numSamples);
 }
 
-static float DFV_Charlie_Uniform(float NoV, float linearRoughness, size_t numSamples) {
-    float r = 0.0;
-    const float3 V(std::sqrt(1 - NoV * NoV), 0, NoV);
+static void uniformSample(DFVSampleTable& samples) {
+    const size_t numSamples = samples.size();
     for (size_t i = 0; i < numSamples; i++) {
-        const float2 u = hammersley(uint32_t(i), 1.0f / numSamples);
-        const float3 H = hemisphereUniformSample(u);
-        const float3 L = 2 * dot(V, H) * H - V;
-        const float VoH = saturate(dot(V, H));
-        const float NoL = saturate(L.z);
-        const float NoH = saturate(H.z);
-        if (NoL > 0) {
-            const float v = VisibilityAshikhmin(NoV, NoL, linearRoughness);
-            const float d = DistributionCharlie(NoH, linearRoughness);
-            r += v * d * NoL * VoH; // VoH comes from the Jacobian, 1/(4*VoH)
+        const float3 H = hemisphereUniformSample(hammersley(uint32_t(i), 1.0f / numSamples));
+        samples.x[i] = H.x;
+        samples.z[i] = saturate(H.z);
+    }
+}
+
+static void DFV_Charlie_Uniform(float* UTILS_RESTRICT out, float const* UTILS_RESTRICT NoV,
+        float linearRoughness, DFVSampleTable const& samples) {
+    float sinV[LANE_COUNT];
+    float r[LANE_COUNT] = {};
+    for (size_t l = 0; l < LANE_COUNT; l++) {
+        sinV[l] = std::sqrt(1 - NoV[l] * NoV[l]);
+    }
+    const size_t numSamples = samples.size();
+    for (size_t i = 0; i < numSamples; i++) {
+        const float Hx = samples.x[i];
+        const float NoH = samples.z[i];
+        const float d = samples.d[i];
+        for (size_t l = 0; l < LANE_COUNT; l++) {
+            const float VdotH = sinV[l] * Hx + NoV[l] * NoH;
+            const float VoH = saturate(VdotH);
+            const float NoL = saturate(2 * VdotH * NoH - NoV[l]);
+            const float v = VisibilityAshikhmin(NoV[l], NoL, linearRoughness);
+            // VoH comes from the Jacobian, 1/(4*VoH)
+            r[l] += NoL > 0 ? v * d * NoL * VoH : 0.0f;
         }
     }
-    // uniform sampling, the PDF is 1/2pi, 4 comes from the Jacobian
-    return r * (4.0f * 2.0f * (float) F_PI / numSamples);
+    for (size_t l = 0; l < LANE_COUNT; l++) {
+        // uniform sampling, the PDF is 1/2pi, 4 comes from the Jacobian
+        out[l] = r[l] * (4.0f * 2.0f * (float) F_PI / numSamples);
+    }
 }
 
 /*
@@ -1006,11 +1236,16 @@ void CubemapIBL::brdf(utils::JobSystem& js, Cubemap& dst, float linearRoughness)
 }
 
 void CubemapIBL::DFG(JobSystem& js, Image& dst, bool multiscatter, bool cloth) {
-    auto dfvFunction = multiscatter ? DFV_Multiscatter : DFV;
+    auto dfvFunction = multiscatter ? DFV<true> : DFV<false>;
     auto job = jobs::parallel_for<char>(js, nullptr, nullptr, uint32_t(dst.getHeight()),
             [&dst, dfvFunction, cloth](char const* d, size_t c) {
                 const size_t width = dst.getWidth();
                 const size_t height = dst.getHeight();
+
+                DFVSampleTable samples(DFV_SAMPLE_COUNT);
+                DFVSampleTable clothSamples(cloth ? DFV_CLOTH_SAMPLE_COUNT : 0);
+                uniformSample(clothSamples);
+
                 size_t y0 = size_t(d);
                 for (size_t y = y0; y < y0 + c; y++) {
                     Cubemap::Texel* UTILS_RESTRICT data =
@@ -1022,14 +1257,30 @@ void CubemapIBL::DFG(JobSystem& js, Image& dst, bool multiscatter, bool cloth) {
                     // here we're using ^2, but other mappings are possible.
                     // ==> coord = sqrt(linear_roughness)
                     const float linear_roughness = coord * coord;
-                    for (size_t x = 0; x < height; x++, data++) {
-                        // const float NoV = float(x) / (width-1);
-                        const float NoV = saturate((x + 0.5f) / width);
-                        float3 r = { dfvFunction(NoV, linear_roughness, 1024), 0 };
+
+                    importanceSampleDggx(samples, linear_roughness);
+                    for (size_t i = 0; i < clothSamples.size(); i++) {
+                        const float NoH = clothSamples.z[i];
+                        clothSamples.d[i] = DistributionCharlie(NoH, linear_roughness);
+                    }
+
+                    for (size_t x = 0; x < width; x += LANE_COUNT) {
+                        const size_t laneCount = std::min(LANE_COUNT, width - x);
+                        float NoV[LANE_COUNT];
+                        for (size_t i = 0; i < LANE_COUNT; i++) {
+                            // unused lanes duplicate the last texel, their result is discarded
+                            const size_t lx = x + std::min(i, laneCount - 1);
+                            NoV[i] = saturate((lx + 0.5f) / width);
+                        }
+                        float2 dfv[LANE_COUNT];
+                        float charlie[LANE_COUNT] = {};
+                        dfvFunction(dfv, NoV, linear_roughness, samples);
                         if (cloth) {
-                            r.b = float(DFV_Charlie_Uniform(NoV, linear_roughness, 4096));
+                            DFV_Charlie_Uniform(charlie, NoV, linear_roughness, clothSamples);
+                        }
+                        for (size_t i = 0; i < laneCount; i++) {
+                            data[x + i] = { dfv[i], charlie[i] };
                         }
-                        *data = r;
                     }
                 }
             }, jobs::CountSplitter<1, 8>());
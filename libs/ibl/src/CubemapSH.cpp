@@ -26,10 +26,13 @@
 
 #include <math/mat4.h>
 
+#include <algorithm>
 #include <array>
 #include <limits>
 #include <iomanip>
 
+#include <assert.h>
+
 using namespace filament::math;
 using namespace utils;
 
@@ -552,6 +555,13 @@ std::unique_ptr<float3[]> CubemapSH::computeSH(JobSystem& js, const Cubemap& cm,
         }
     }, prototype);
 
+    scaleSH(SH.get(), numBands, irradiance);
+    return SH;
+}
+
+void CubemapSH::scaleSH(float3* sh, size_t numBands, bool irradiance) {
+    const size_t numCoefs = numBands * numBands;
+
     // precompute the scaling factor K
     std::vector<float> K = Ki(numBands);
 
@@ -569,8 +579,226 @@ std::unique_ptr<float3[]> CubemapSH::computeSH(JobSystem& js, const Cubemap& cm,
 
     // apply all the scale factors
     for (size_t i = 0; i < numCoefs; i++) {
-        SH[i] *= K[i];
+        sh[i] *= K[i];
+    }
+}
+
+// -----------------------------------------------------------------------------------------------
+// Incremental decomposition
+// -----------------------------------------------------------------------------------------------
+
+// number of texels Accumulator processes together
+static constexpr size_t SH_LANE_COUNT = 8;
+
+/*
+ * Same as CubemapSH::computeShBasis(), for SH_LANE_COUNT directions at once. SHb holds one row
+ * of SH_LANE_COUNT lanes per coefficient, so that each step of the recursions below is a
+ * straight vector operation.
+ */
+static void computeShBasisLanes(float* UTILS_RESTRICT SHb, size_t numBands,
+        float const* UTILS_RESTRICT x, float const* UTILS_RESTRICT y,
+        float const* UTILS_RESTRICT z) {
+    constexpr size_t N = SH_LANE_COUNT;
+    auto row = [SHb](ssize_t m, size_t l) {
+        return SHb + CubemapSH::getShIndex(m, l) * N;
+    };
+
+    // handle m=0 separately, since it produces only one coefficient
+    float Pml_2[N];
+    float Pml_1[N];
+    float Pml[N];
+    for (size_t i = 0; i < N; i++) {
+        Pml_2[i] = 0;
+        Pml_1[i] = 1;
+        row(0, 0)[i] = 1;
+    }
+    for (size_t l = 1; l < numBands; l++) {
+        float* UTILS_RESTRICT r = row(0, l);
+        for (size_t i = 0; i < N; i++) {
+            Pml[i] = ((2 * l - 1.0f) * Pml_1[i] * z[i] - (l - 1.0f) * Pml_2[i]) / l;
+            Pml_2[i] = Pml_1[i];
+            Pml_1[i] = Pml[i];
+            r[i] = Pml[i];
+        }
+    }
+
+    // Pmm doesn't depend on the direction
+    float Pmm = 1;
+    for (size_t m = 1; m < numBands; m++) {
+        Pmm = (1.0f - 2 * m) * Pmm;
+        float* UTILS_RESTRICT rn = row(-m, m);
+        float* UTILS_RESTRICT rp = row( m, m);
+        for (size_t i = 0; i < N; i++) {
+            Pml_2[i] = Pmm;
+            Pml_1[i] = (2 * m + 1.0f) * Pmm * z[i];
+            rn[i] = Pmm;
+            rp[i] = Pmm;
+        }
+        if (m + 1 < numBands) {
+            rn = row(-m, m + 1);
+            rp = row( m, m + 1);
+            for (size_t i = 0; i < N; i++) {
+                rn[i] = Pml_1[i];
+                rp[i] = Pml_1[i];
+            }
+            for (size_t l = m + 2; l < numBands; l++) {
+                rn = row(-m, l);
+                rp = row( m, l);
+                for (size_t i = 0; i < N; i++) {
+                    Pml[i] = ((2 * l - 1.0f) * Pml_1[i] * z[i] - (l + m - 1.0f) * Pml_2[i])
+                            / (l - m);
+                    Pml_2[i] = Pml_1[i];
+                    Pml_1[i] = Pml[i];
+                    rn[i] = Pml[i];
+                    rp[i] = Pml[i];
+                }
+            }
+        }
+    }
+
+    // ( cos(m*phi), sin(m*phi) ) recursion, see computeShBasis()
+    float Cm[N];
+    float Sm[N];
+    for (size_t i = 0; i < N; i++) {
+        Cm[i] = x[i];
+        Sm[i] = y[i];
+    }
+    for (size_t m = 1; m < numBands; m++) {
+        for (size_t l = m; l < numBands; l++) {
+            float* UTILS_RESTRICT rn = row(-m, l);
+            float* UTILS_RESTRICT rp = row( m, l);
+            for (size_t i = 0; i < N; i++) {
+                rn[i] *= Sm[i];
+                rp[i] *= Cm[i];
+            }
+        }
+        for (size_t i = 0; i < N; i++) {
+            const float Cm1 = Cm[i] * x[i] - Sm[i] * y[i];
+            const float Sm1 = Sm[i] * x[i] + Cm[i] * y[i];
+            Cm[i] = Cm1;
+            Sm[i] = Sm1;
+        }
+    }
+}
+
+CubemapSH::Accumulator::Accumulator(size_t numBands, size_t dim, size_t tileSize)
+        : mNumBands(numBands),
+          mNumCoefs(numBands * numBands),
+          mDim(dim),
+          mTileSize(std::max(size_t(1), std::min(tileSize, dim))),
+          mTilesPerSide((dim + mTileSize - 1) / mTileSize),
+          mTileCount(6 * mTilesPerSide * mTilesPerSide),
+          mSolidAngles(dim * dim),
+          mTileSH(mTileCount * mNumCoefs),
+          mIntegrated(mTileCount) {
+    for (size_t y = 0; y < dim; y++) {
+        for (size_t x = 0; x < dim; x++) {
+            mSolidAngles[y * dim + x] = CubemapUtils::solidAngle(dim, x, y);
+        }
+    }
+}
+
+void CubemapSH::Accumulator::reset() noexcept {
+    std::fill(mTileSH.begin(), mTileSH.end(), float3{});
+    std::fill(mIntegrated.begin(), mIntegrated.end(), false);
+    mIntegratedCount = 0;
+    mCursor = 0;
+}
+
+void CubemapSH::Accumulator::integrateTile(const Cubemap& cm, size_t tile) noexcept {
+    constexpr size_t N = SH_LANE_COUNT;
+    const size_t tilesPerFace = mTilesPerSide * mTilesPerSide;
+    const auto f = (Cubemap::Face)(tile / tilesPerFace);
+    const size_t x0 = ((tile % tilesPerFace) % mTilesPerSide) * mTileSize;
+    const size_t y0 = ((tile % tilesPerFace) / mTilesPerSide) * mTileSize;
+    const size_t x1 = std::min(x0 + mTileSize, mDim);
+    const size_t y1 = std::min(y0 + mTileSize, mDim);
+    const Image& image = cm.getImageForFace(f);
+
+    float3* UTILS_RESTRICT SH = mTileSH.data() + tile * mNumCoefs;
+    std::fill_n(SH, mNumCoefs, float3{});
+
+    std::unique_ptr<float[]> SHb(new float[mNumCoefs * N]); // NOLINT(modernize-make-unique)
+    for (size_t y = y0; y < y1; y++) {
+        Cubemap::Texel const* data =
+                static_cast<Cubemap::Texel const*>(image.getPixelRef(0, y));
+        float const* solidAngles = mSolidAngles.data() + y * mDim;
+        for (size_t x = x0; x < x1; x += N) {
+            const size_t laneCount = std::min(N, x1 - x);
+            float dx[N], dy[N], dz[N];
+            float r[N], g[N], b[N];
+            for (size_t i = 0; i < N; i++) {
+                // unused lanes duplicate the last texel with a zero weight
+                const size_t lx = x + std::min(i, laneCount - 1);
+                const float3 s(cm.getDirectionFor(f, lx, y));
+                const float3 color(Cubemap::sampleAt(data + lx) *
+                        (i < laneCount ? solidAngles[lx] : 0.0f));
+                dx[i] = s.x;
+                dy[i] = s.y;
+                dz[i] = s.z;
+                r[i] = color.r;
+                g[i] = color.g;
+                b[i] = color.b;
+            }
+
+            computeShBasisLanes(SHb.get(), mNumBands, dx, dy, dz);
+
+            // apply coefficients to the sampled colors
+            for (size_t c = 0; c < mNumCoefs; c++) {
+                float const* UTILS_RESTRICT basis = SHb.get() + c * N;
+                float sr = 0, sg = 0, sb = 0;
+                for (size_t i = 0; i < N; i++) {
+                    sr += r[i] * basis[i];
+                    sg += g[i] * basis[i];
+                    sb += b[i] * basis[i];
+                }
+                SH[c] += float3{ sr, sg, sb };
+            }
+        }
+    }
+}
+
+void CubemapSH::Accumulator::accumulate(JobSystem& js, const Cubemap& cm,
+        size_t first, size_t count) {
+    assert(cm.getDimensions() == mDim);
+    count = std::min(count, mTileCount);
+
+    auto tiles = [this, &cm, first](uint32_t start, uint32_t c) {
+        for (uint32_t i = start; i < start + c; i++) {
+            integrateTile(cm, (first + i) % mTileCount);
+        }
+    };
+    if (count > 1) {
+        auto job = jobs::parallel_for(js, nullptr, 0, uint32_t(count),
+                std::cref(tiles), jobs::CountSplitter<1, 8>());
+        js.runAndWait(job);
+    } else {
+        tiles(0, uint32_t(count));
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const size_t tile = (first + i) % mTileCount;
+        if (!mIntegrated[tile]) {
+            mIntegrated[tile] = true;
+            mIntegratedCount++;
+        }
+    }
+}
+
+void CubemapSH::Accumulator::update(JobSystem& js, const Cubemap& cm, size_t count) {
+    accumulate(js, cm, mCursor, count);
+    mCursor = (mCursor + count) % mTileCount;
+}
+
+std::unique_ptr<float3[]> CubemapSH::Accumulator::getSH(bool irradiance) const {
+    std::unique_ptr<float3[]> SH(new float3[mNumCoefs]{}); // NOLINT(modernize-make-unique)
+    for (size_t tile = 0; tile < mTileCount; tile++) {
+        float3 const* tileSH = mTileSH.data() + tile * mNumCoefs;
+        for (size_t i = 0; i < mNumCoefs; i++) {
+            SH[i] += tileSH[i];
+        }
     }
+    scaleSH(SH.get(), mNumBands, irradiance);
     return SH;
 }
 
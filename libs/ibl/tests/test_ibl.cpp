@@ -0,0 +1,315 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ibl/Cubemap.h>
+#include <ibl/CubemapIBL.h>
+#include <ibl/CubemapSH.h>
+#include <ibl/CubemapUtils.h>
+#include <ibl/Image.h>
+#include <ibl/utilities.h>
+
+#include <utils/JobSystem.h>
+
+#include <math/mat3.h>
+#include <math/scalar.h>
+#include <math/vec3.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <vector>
+
+using namespace filament::ibl;
+using namespace filament::math;
+using namespace utils;
+
+static constexpr size_t NUM_BANDS = 3;
+static constexpr size_t NUM_COEFS = NUM_BANDS * NUM_BANDS;
+
+class IblTest : public testing::Test {
+protected:
+    void SetUp() override { mJobSystem.adopt(); }
+    void TearDown() override { mJobSystem.emancipate(); }
+    JobSystem mJobSystem;
+};
+
+// A sky-like environment: a vertical gradient and a bright sun.
+static float3 sky(float3 const& d) {
+    const float sun = std::pow(std::max(0.0f, dot(d, normalize(float3{ 1, 2, 1 }))), 64.0f);
+    return float3{ 0.2f, 0.4f, 0.8f } * (d.y * 0.5f + 0.5f) + float3{ 10, 9, 8 } * sun;
+}
+
+// The same sky, later in the day.
+static float3 sunset(float3 const& d) {
+    const float sun = std::pow(std::max(0.0f, dot(d, normalize(float3{ 2, 0.2f, -1 }))), 64.0f);
+    return float3{ 0.8f, 0.4f, 0.2f } * (d.y * 0.5f + 0.5f) + float3{ 10, 6, 3 } * sun;
+}
+
+// The sky without the sun, smooth enough for prefiltered results to not depend on the
+// orientation of the samples around the normal.
+static float3 gradient(float3 const& d) {
+    return float3{ 0.2f, 0.4f, 0.8f } * (d.y * 0.5f + 0.5f) + float3{ 0.1f, 0.05f, 0.0f } * d.x;
+}
+
+static Cubemap createCubemap(Image& image, size_t dim, std::function<float3(float3 const&)> f) {
+    Cubemap cm = CubemapUtils::create(image, dim);
+    for (size_t face = 0; face < 6; face++) {
+        Image& faceImage = cm.getImageForFace((Cubemap::Face)face);
+        for (size_t y = 0; y < dim; y++) {
+            for (size_t x = 0; x < dim; x++) {
+                const float3 d = cm.getDirectionFor((Cubemap::Face)face, x, y);
+                Cubemap::writeAt(faceImage.getPixelRef(x, y), f(d));
+            }
+        }
+    }
+    cm.makeSeamless();
+    return cm;
+}
+
+static void expectNear(std::unique_ptr<float3[]> const& expected,
+        std::unique_ptr<float3[]> const& actual, float tolerance) {
+    // tolerance is relative to the DC term, which dominates
+    const float scale = std::max(std::max(expected[0].r, expected[0].g), expected[0].b);
+    for (size_t i = 0; i < NUM_COEFS; i++) {
+        EXPECT_NEAR(expected[i].r, actual[i].r, tolerance * scale) << "coefficient " << i;
+        EXPECT_NEAR(expected[i].g, actual[i].g, tolerance * scale) << "coefficient " << i;
+        EXPECT_NEAR(expected[i].b, actual[i].b, tolerance * scale) << "coefficient " << i;
+    }
+}
+
+TEST_F(IblTest, AccumulatorMatchesComputeSH) {
+    Image image;
+    Cubemap cm = createCubemap(image, 64, sky);
+
+    CubemapSH::Accumulator accumulator(NUM_BANDS, cm.getDimensions());
+    accumulator.accumulate(mJobSystem, cm, 0, accumulator.getTileCount());
+    EXPECT_TRUE(accumulator.isComplete());
+
+    for (bool irradiance : { false, true }) {
+        auto expected = CubemapSH::computeSH(mJobSystem, cm, NUM_BANDS, irradiance);
+        expectNear(expected, accumulator.getSH(irradiance), 1e-4f);
+    }
+}
+
+TEST_F(IblTest, AccumulatorIncremental) {
+    Image image;
+    Cubemap cm = createCubemap(image, 64, sky);
+
+    // tiles that don't divide the face evenly
+    CubemapSH::Accumulator accumulator(NUM_BANDS, cm.getDimensions(), 24);
+    EXPECT_EQ(accumulator.getTileCount(), 6u * 3u * 3u);
+
+    size_t calls = 0;
+    while (!accumulator.isComplete()) {
+        accumulator.update(mJobSystem, cm, 5);
+        calls++;
+    }
+    EXPECT_EQ(calls, (accumulator.getTileCount() + 4) / 5);
+
+    auto expected = CubemapSH::computeSH(mJobSystem, cm, NUM_BANDS, true);
+    expectNear(expected, accumulator.getSH(true), 1e-4f);
+}
+
+TEST_F(IblTest, AccumulatorTracksChanges) {
+    Image image0;
+    Cubemap cm0 = createCubemap(image0, 32, sky);
+    Image image1;
+    Cubemap cm1 = createCubemap(image1, 32, sunset);
+
+    CubemapSH::Accumulator accumulator(NUM_BANDS, 32, 8);
+    accumulator.accumulate(mJobSystem, cm0, 0, accumulator.getTileCount());
+
+    // the environment changes, and is integrated again over several updates
+    for (size_t i = 0; i < accumulator.getTileCount(); i += 7) {
+        accumulator.update(mJobSystem, cm1, 7);
+    }
+
+    auto expected = CubemapSH::computeSH(mJobSystem, cm1, NUM_BANDS, false);
+    expectNear(expected, accumulator.getSH(false), 1e-4f);
+
+    accumulator.reset();
+    EXPECT_FALSE(accumulator.isComplete());
+}
+
+TEST_F(IblTest, AccumulatorLowerMip) {
+    Image image;
+    Cubemap cm = createCubemap(image, 128, sky);
+
+    // integrate a 16x16 mip level instead of the 128x128 base level
+    std::vector<Image> images;
+    std::vector<Cubemap> levels;
+    levels.reserve(3);
+    const Cubemap* src = &cm;
+    for (size_t dim = 64; dim >= 16; dim /= 2) {
+        images.emplace_back();
+        levels.push_back(CubemapUtils::create(images.back(), dim));
+        CubemapUtils::downsampleCubemapLevelBoxFilter(mJobSystem, levels.back(), *src);
+        levels.back().makeSeamless();
+        src = &levels.back();
+    }
+
+    CubemapSH::Accumulator accumulator(NUM_BANDS, src->getDimensions());
+    accumulator.accumulate(mJobSystem, *src, 0, accumulator.getTileCount());
+
+    auto expected = CubemapSH::computeSH(mJobSystem, cm, NUM_BANDS, true);
+    expectNear(expected, accumulator.getSH(true), 1e-2f);
+}
+
+// Straightforward scalar version of CubemapIBL::roughnessFilter(), one texel and one sample
+// at a time, without the per-texel rotation of the samples.
+static void roughnessFilterReference(Cubemap& dst, std::vector<Cubemap> const& levels,
+        float linearRoughness, size_t numSamples) {
+    const float maxLevel = float(levels.size() - 1);
+    const size_t dim0 = levels[0].getDimensions();
+    const float omegaP = (4.0f * f::PI) / float(6 * dim0 * dim0);
+
+    struct Sample {
+        float3 L;
+        float weight;
+        float lod;
+    };
+    std::vector<Sample> samples;
+    float weight = 0;
+    for (size_t i = 0; i < numSamples; i++) {
+        const float2 u = hammersley(uint32_t(i), 1.0f / float(numSamples));
+        const float a = linearRoughness;
+        const float phi = 2.0f * f::PI * u.x;
+        const float cosTheta2 = (1 - u.y) / (1 + (a + 1) * ((a - 1) * u.y));
+        const float sinTheta = std::sqrt(1 - cosTheta2);
+        const float3 H{ sinTheta * std::cos(phi), sinTheta * std::sin(phi), std::sqrt(cosTheta2) };
+        const float3 L = 2 * H.z * H - float3{ 0, 0, 1 };
+        if (L.z > 0) {
+            const float d = (a - 1) * ((a + 1) * (H.z * H.z)) + 1;
+            const float pdf = (a * a) / (f::PI * d * d) / 4;
+            const float omegaS = 1 / (float(numSamples) * pdf);
+            const float lod = log4(omegaS) - log4(omegaP) + log4(4.0f);
+            samples.push_back({ L, L.z, clamp(lod, 0.0f, maxLevel) });
+            weight += L.z;
+        }
+    }
+
+    const size_t dim = dst.getDimensions();
+    for (size_t face = 0; face < 6; face++) {
+        Image& image = dst.getImageForFace((Cubemap::Face)face);
+        for (size_t y = 0; y < dim; y++) {
+            for (size_t x = 0; x < dim; x++) {
+                const float2 p = Cubemap::center(x, y);
+                const float3 N = dst.getDirectionFor((Cubemap::Face)face, p.x, p.y);
+                const float3 up = std::abs(N.z) < 0.999f ? float3{ 0, 0, 1 } : float3{ 1, 0, 0 };
+                mat3f R;
+                R[0] = normalize(cross(up, N));
+                R[1] = cross(N, R[0]);
+                R[2] = N;
+                float3 Li = 0;
+                for (Sample const& sample : samples) {
+                    const size_t l0 = size_t(sample.lod);
+                    const size_t l1 = std::min(levels.size() - 1, l0 + 1);
+                    Li += Cubemap::trilinearFilterAt(levels[l0], levels[l1],
+                            sample.lod - float(l0), R * sample.L) * sample.weight;
+                }
+                Cubemap::writeAt(image.getPixelRef(x, y), Li / weight);
+            }
+        }
+    }
+}
+
+TEST_F(IblTest, RoughnessFilterMatchesScalar) {
+    // a mip chain of the environment, as cmgen builds it
+    std::vector<Image> images;
+    std::vector<Cubemap> levels;
+    levels.reserve(6);
+    images.reserve(6);
+    images.emplace_back();
+    levels.push_back(createCubemap(images.back(), 32, gradient));
+    for (size_t dim = 16; dim >= 1; dim /= 2) {
+        images.emplace_back();
+        levels.push_back(CubemapUtils::create(images.back(), dim));
+        CubemapUtils::downsampleCubemapLevelBoxFilter(mJobSystem, levels.back(),
+                levels[levels.size() - 2]);
+        levels.back().makeSeamless();
+    }
+
+    // 12 isn't a multiple of the number of texels processed together, 20 isn't a multiple of
+    // the tile size
+    for (size_t dim : { 12, 20 }) {
+        for (float roughness : { 0.25f, 0.64f }) {
+            Image expectedImage;
+            Cubemap expected = CubemapUtils::create(expectedImage, dim);
+            roughnessFilterReference(expected, levels, roughness, 64);
+
+            Image actualImage;
+            Cubemap actual = CubemapUtils::create(actualImage, dim);
+            CubemapIBL::roughnessFilter(mJobSystem, actual, levels, roughness, 64,
+                    float3{ 1 }, true);
+
+            // roughnessFilter() rotates the samples around the normal differently for each
+            // texel, with 64 samples this accounts for up to ~2% of the result
+            for (size_t face = 0; face < 6; face++) {
+                Image const& e = expected.getImageForFace((Cubemap::Face)face);
+                Image const& a = actual.getImageForFace((Cubemap::Face)face);
+                for (size_t y = 0; y < dim; y++) {
+                    for (size_t x = 0; x < dim; x++) {
+                        const float3 ce = *static_cast<float3 const*>(e.getPixelRef(x, y));
+                        const float3 ca = *static_cast<float3 const*>(a.getPixelRef(x, y));
+                        for (size_t c = 0; c < 3; c++) {
+                            EXPECT_NEAR(ce[c], ca[c], 0.025f)
+                                    << "dim " << dim << ", roughness " << roughness
+                                    << ", face " << face << ", " << x << ", " << y;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(IblUtilities, HammersleyTable) {
+    static constexpr HammersleyTable<256> table{};
+    static_assert(table.v[1] == 0.5f, "the table must be built at compile time");
+    for (uint32_t i = 0; i < table.size(); i++) {
+        const float2 p = hammersley(i, 1.0f / table.size());
+        EXPECT_EQ(p.x, table.u[i]);
+        EXPECT_EQ(p.y, table.v[i]);
+    }
+}
+
+TEST_F(IblTest, DFGNonSquare) {
+    // the LUT doesn't need to be square, each row is a roughness and each column a n•v
+    Image wide(48, 16);
+    Image square(16, 16);
+    CubemapIBL::DFG(mJobSystem, wide, false, false);
+    CubemapIBL::DFG(mJobSystem, square, false, false);
+    for (size_t y = 0; y < 16; y++) {
+        // n•v is sampled at texel centers: column x of the square LUT is column 3x+1 of the wide one
+        for (size_t x = 0; x < 16; x++) {
+            const float3 s = *static_cast<float3 const*>(square.getPixelRef(x, y));
+            const float3 w = *static_cast<float3 const*>(wide.getPixelRef(3 * x + 1, y));
+            EXPECT_EQ(s.x, w.x) << x << ", " << y;
+            EXPECT_EQ(s.y, w.y) << x << ", " << y;
+        }
+        // single scattering loses energy, but never creates any
+        const float3 r = *static_cast<float3 const*>(wide.getPixelRef(47, y));
+        EXPECT_GT(r.x + r.y, 0.0f);
+        EXPECT_LE(r.x + r.y, 1.01f);
+    }
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
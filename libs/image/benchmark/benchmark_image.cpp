@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <image/ImageOps.h>
+#include <image/ImageSampler.h>
+#include <image/LinearImage.h>
+
+#include <utils/JobSystem.h>
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+using namespace image;
+using namespace utils;
+
+static const Filter kFilters[] = { Filter::BOX, Filter::MITCHELL, Filter::LANCZOS };
+
+static LinearImage createNoise(uint32_t size, uint32_t channels) {
+    LinearImage image(size, size, channels);
+    float* data = image.getPixelRef();
+    uint32_t seed = 1;
+    for (size_t i = 0, n = size_t(size) * size * channels; i < n; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        data[i] = float(seed >> 8u) / float(1u << 24u);
+    }
+    return image;
+}
+
+// Arguments: filter index, channel count, cascade distance, parallel.
+static void BM_generateMipmaps(benchmark::State& state) {
+    JobSystem js;
+    js.adopt();
+
+    const Filter filter = kFilters[state.range(0)];
+    const uint32_t channels = uint32_t(state.range(1));
+    const LinearImage source = createNoise(1024, channels);
+    const MipmapSampler sampler {
+        .filter = filter,
+        .cascadeDistance = uint32_t(state.range(2)),
+        .jobSystem = state.range(3) ? &js : nullptr
+    };
+
+    const uint32_t count = getMipmapCount(source);
+    std::vector<LinearImage> mips(count);
+    for (auto _ : state) {
+        generateMipmaps(source, sampler, mips.data(), count);
+        benchmark::DoNotOptimize(mips.back().getPixelRef());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * source.getWidth() * source.getHeight());
+
+    js.emancipate();
+}
+
+static void mipmapArguments(benchmark::internal::Benchmark* b) {
+    for (int64_t filter = 0; filter < int64_t(sizeof(kFilters) / sizeof(kFilters[0])); ++filter) {
+        for (int64_t channels : { 1, 3, 4 }) {
+            for (int64_t cascade : { 0, 1 }) {
+                for (int64_t parallel : { 0, 1 }) {
+                    b->Args({ filter, channels, cascade, parallel });
+                }
+            }
+        }
+    }
+}
+
+BENCHMARK(BM_generateMipmaps)
+        ->ArgNames({ "filter", "channels", "cascade", "parallel" })
+        ->Apply(mipmapArguments)
+        ->Unit(benchmark::kMillisecond);
+
+// The following benchmarks use 4K images. Arguments: channel count, whether the result is written
+// into a preallocated image rather than a new one.
+
+static constexpr uint32_t kImageOpsSize = 4096;
+
+static void BM_transpose(benchmark::State& state) {
+    const uint32_t channels = uint32_t(state.range(0));
+    const bool reuse = state.range(1) != 0;
+    const LinearImage source = createNoise(kImageOpsSize, channels);
+    LinearImage target(kImageOpsSize, kImageOpsSize, channels);
+    for (auto _ : state) {
+        if (reuse) {
+            transpose(target, source);
+        } else {
+            target = transpose(source);
+        }
+        benchmark::DoNotOptimize(target.getPixelRef());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * kImageOpsSize * kImageOpsSize);
+}
+
+static void BM_horizontalFlip(benchmark::State& state) {
+    const uint32_t channels = uint32_t(state.range(0));
+    const bool reuse = state.range(1) != 0;
+    LinearImage image = createNoise(kImageOpsSize, channels);
+    for (auto _ : state) {
+        if (reuse) {
+            horizontalFlip(image, image);
+        } else {
+            image = horizontalFlip(image);
+        }
+        benchmark::DoNotOptimize(image.getPixelRef());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * kImageOpsSize * kImageOpsSize);
+}
+
+// Maps vectors to colors, clamps them and maps them back, either as three separate operations
+// that each allocate an image, or as a single fused pass in place.
+static void BM_transformValues(benchmark::State& state) {
+    const uint32_t channels = uint32_t(state.range(0));
+    const bool reuse = state.range(1) != 0;
+    const LinearImage source = createNoise(kImageOpsSize, channels);
+    LinearImage image(kImageOpsSize, kImageOpsSize, channels);
+    for (auto _ : state) {
+        if (reuse) {
+            transformValues(image, source,
+                    ScaleOffset{ 0.5f, 0.5f }, Clamp{ 0.0f, 1.0f }, ScaleOffset{ 2.0f, -1.0f });
+        } else {
+            image = vectorsToColors(source);
+            LinearImage clamped(kImageOpsSize, kImageOpsSize, channels);
+            transformValues(clamped, image, Clamp{ 0.0f, 1.0f });
+            image = colorsToVectors(clamped);
+        }
+        benchmark::DoNotOptimize(image.getPixelRef());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * kImageOpsSize * kImageOpsSize);
+}
+
+static void imageOpsArguments(benchmark::internal::Benchmark* b) {
+    for (int64_t channels : { 1, 3, 4 }) {
+        for (int64_t reuse : { 0, 1 }) {
+            b->Args({ channels, reuse });
+        }
+    }
+}
+
+BENCHMARK(BM_transpose)
+        ->ArgNames({ "channels", "reuse" })
+        ->Apply(imageOpsArguments)
+        ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_horizontalFlip)
+        ->ArgNames({ "channels", "reuse" })
+        ->Apply(imageOpsArguments)
+        ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_transformValues)
+        ->ArgNames({ "channels", "reuse" })
+        ->Apply(imageOpsArguments)
+        ->Unit(benchmark::kMillisecond);
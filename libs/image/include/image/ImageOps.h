@@ -21,6 +21,7 @@
 
 #include <utils/compiler.h>
 
+#include <algorithm>
 #include <cstddef>
 #include <initializer_list>
 
@@ -57,6 +58,67 @@ UTILS_PUBLIC LinearImage transpose(const LinearImage& image);
 UTILS_PUBLIC
 LinearImage cropRegion(const LinearImage& image, uint32_t l, uint32_t t, uint32_t r, uint32_t b);
 
+// The following overloads write into an existing target image rather than allocating a new one,
+// which lets clients reuse buffers across a chain of operations. The target must already have
+// the dimensions of the result. Unless noted otherwise, the target can also be the source, in
+// which case the operation is done in place.
+UTILS_PUBLIC void horizontalFlip(LinearImage& target, const LinearImage& source);
+UTILS_PUBLIC void verticalFlip(LinearImage& target, const LinearImage& source);
+UTILS_PUBLIC void vectorsToColors(LinearImage& target, const LinearImage& source);
+UTILS_PUBLIC void colorsToVectors(LinearImage& target, const LinearImage& source);
+
+// The target cannot be the source.
+UTILS_PUBLIC void extractChannel(LinearImage& target, const LinearImage& source, uint32_t channel);
+UTILS_PUBLIC void combineChannels(LinearImage& target, LinearImage const* img, size_t count);
+UTILS_PUBLIC void cropRegion(LinearImage& target, const LinearImage& source,
+        uint32_t l, uint32_t t, uint32_t r, uint32_t b);
+
+// The target cannot be the source. The copy is done in cache-sized blocks.
+UTILS_PUBLIC void transpose(LinearImage& target, const LinearImage& source);
+
+// Panics if the two images don't have the same width, height and channel count.
+UTILS_PUBLIC void checkSameDimensions(const LinearImage& a, const LinearImage& b);
+
+// Per-value operations that can be fused with transformValues().
+struct ScaleOffset {
+    float scale;
+    float offset;
+    void operator()(float* UTILS_RESTRICT data, size_t count) const noexcept {
+        for (size_t i = 0; i < count; ++i) {
+            data[i] = scale * data[i] + offset;
+        }
+    }
+};
+
+struct Clamp {
+    float min;
+    float max;
+    void operator()(float* UTILS_RESTRICT data, size_t count) const noexcept {
+        for (size_t i = 0; i < count; ++i) {
+            data[i] = std::min(std::max(data[i], min), max);
+        }
+    }
+};
+
+// Copies the source into the target one row at a time, and applies each of the given operations
+// to that row while it is still in cache. This fuses a chain of per-value operations into a
+// single pass without any intermediate image. Operations are callables with the signature
+// void(float* data, size_t count), count being width * channels. The target can be the source.
+template<typename ... Operations>
+void transformValues(LinearImage& target, const LinearImage& source,
+        Operations const& ... operations) {
+    checkSameDimensions(target, source);
+    const size_t count = size_t(source.getWidth()) * source.getChannels();
+    for (uint32_t row = 0, height = source.getHeight(); row < height; ++row) {
+        float* dst = target.getPixelRef(0, row);
+        float const* src = source.getPixelRef(0, row);
+        if (dst != src) {
+            std::copy_n(src, count, dst);
+        }
+        (operations(dst, count), ...);
+    }
+}
+
 // Lexicographically compares two images, similar to memcmp.
 UTILS_PUBLIC int compare(const LinearImage& a, const LinearImage& b, float epsilon = 0.0f);
 
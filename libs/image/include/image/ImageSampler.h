@@ -21,6 +21,10 @@
 
 #include <utils/compiler.h>
 
+namespace utils {
+class JobSystem;
+} // namespace utils
+
 namespace image {
 
 /**
@@ -98,6 +102,29 @@ struct ImageSampler {
     Boundary north;
     Boundary west;
     Boundary south;
+    utils::JobSystem* jobSystem = nullptr; // If non-null, rows are resampled in parallel.
+};
+
+/**
+ * Configuration for the generateMipmaps function. Provides reasonable defaults.
+ */
+struct MipmapSampler {
+    Filter filter = Filter::DEFAULT;
+
+    /**
+     * Controls the tradeoff between quality and speed. If zero, every miplevel is downsampled from
+     * the original image, which gives the best quality. Otherwise, every miplevel is downsampled
+     * from the miplevel that is this many levels larger. For example, 1 generates each level from
+     * the previous one, which is the fastest since each level only filters 4x as many pixels as
+     * it contains.
+     */
+    uint32_t cascadeDistance = 0;
+
+    /**
+     * Optional job system used to resample rows in parallel. The calling thread must be a thread
+     * of this job system (e.g. via JobSystem::adopt).
+     */
+    utils::JobSystem* jobSystem = nullptr;
 };
 
 /**
@@ -145,6 +172,14 @@ void computeSingleSample(const LinearImage& source, float x, float y, SingleSamp
 UTILS_PUBLIC
 void generateMipmaps(const LinearImage& source, Filter, LinearImage* result, uint32_t mipCount);
 
+/**
+ * Generates a sequence of miplevels according to the given configuration, which can trade quality
+ * for speed and distribute work across a job system. See MipmapSampler.
+ */
+UTILS_PUBLIC
+void generateMipmaps(const LinearImage& source, const MipmapSampler& sampler, LinearImage* result,
+        uint32_t mipCount);
+
 /**
  * Returns the number of miplevels it would take to downsample the given image down to 1x1. This
  * number does not include the original image (i.e. mip 0).
@@ -21,6 +21,7 @@
 #include <utils/Panic.h>
 
 #include <algorithm>
+#include <cstring>
 #include <memory>
 #include <ratio>
 
@@ -90,75 +91,98 @@ LinearImage verticalStack(const LinearImage* first, size_t count) {
 }
 
 LinearImage horizontalFlip(const LinearImage& image) {
-    const uint32_t width = image.getWidth();
-    const uint32_t height = image.getHeight();
-    const uint32_t channels = image.getChannels();
-    LinearImage result(width, height, channels);
+    LinearImage result(image.getWidth(), image.getHeight(), image.getChannels());
+    horizontalFlip(result, image);
+    return result;
+}
+
+void horizontalFlip(LinearImage& target, const LinearImage& source) {
+    checkSameDimensions(target, source);
+    const uint32_t width = source.getWidth();
+    const uint32_t height = source.getHeight();
+    const uint32_t channels = source.getChannels();
     for (uint32_t row = 0; row < height; ++row) {
-        for (uint32_t col = 0; col < width; ++col) {
-            float* dst = result.getPixelRef(width - 1 - col, row);
-            float const* src = image.getPixelRef(col, row);
+        float* dst = target.getPixelRef(0, row);
+        float const* src = source.getPixelRef(0, row);
+        // swap pixels from both ends, so that this also works in place
+        for (uint32_t l = 0, r = width - 1; l <= r && r < width; ++l, --r) {
             for (uint32_t c = 0; c < channels; ++c) {
-                dst[c] = src[c];
+                const float left = src[l * channels + c];
+                const float right = src[r * channels + c];
+                dst[l * channels + c] = right;
+                dst[r * channels + c] = left;
             }
         }
     }
-    return result;
 }
 
 LinearImage verticalFlip(const LinearImage& image) {
-    const uint32_t width = image.getWidth();
-    const uint32_t height = image.getHeight();
-    const uint32_t channels = image.getChannels();
-    LinearImage result(width, height, channels);
-    for (uint32_t row = 0; row < height; ++row) {
-        float const* src = image.getPixelRef(0, row);
-        float* dst = result.getPixelRef(0, height - 1 - row);
-        memcpy(dst, src, width * channels * sizeof(float));
-    }
+    LinearImage result(image.getWidth(), image.getHeight(), image.getChannels());
+    verticalFlip(result, image);
     return result;
 }
 
-template<class VecT>
-LinearImage applyScaleOffset(const LinearImage& image,
-        typename VecT::value_type scale, typename VecT::value_type offset) {
-    const uint32_t width = image.getWidth(), height = image.getHeight();
-    LinearImage result(width, height, image.getChannels());
-    auto src = (VecT const*) image.getPixelRef();
-    auto dst = (VecT*) result.getPixelRef();
-    for (uint32_t n = 0, end = width * height; n < end; ++n) {
-        dst[n] = scale * src[n] + VecT{offset};
+void verticalFlip(LinearImage& target, const LinearImage& source) {
+    checkSameDimensions(target, source);
+    const uint32_t width = source.getWidth();
+    const uint32_t height = source.getHeight();
+    const size_t count = size_t(width) * source.getChannels();
+    // swap rows from both ends, so that this also works in place
+    for (uint32_t top = 0, bottom = height - 1; top <= bottom && bottom < height; ++top, --bottom) {
+        float* dstTop = target.getPixelRef(0, top);
+        float* dstBottom = target.getPixelRef(0, bottom);
+        float const* srcTop = source.getPixelRef(0, top);
+        float const* srcBottom = source.getPixelRef(0, bottom);
+        if (dstTop == srcTop) {
+            std::swap_ranges(dstTop, dstTop + count, dstBottom);
+        } else {
+            memcpy(dstTop, srcBottom, count * sizeof(float));
+            memcpy(dstBottom, srcTop, count * sizeof(float));
+        }
     }
-    return result;
 }
 
 LinearImage vectorsToColors(const LinearImage& image) {
-    ASSERT_PRECONDITION(image.getChannels() == 3 || image.getChannels() == 4,
+    LinearImage result(image.getWidth(), image.getHeight(), image.getChannels());
+    vectorsToColors(result, image);
+    return result;
+}
+
+void vectorsToColors(LinearImage& target, const LinearImage& source) {
+    ASSERT_PRECONDITION(source.getChannels() == 3 || source.getChannels() == 4,
                         "Must be a 3 or 4 channel image");
-    return image.getChannels() == 3
-        ? applyScaleOffset<float3>(image, 0.5f, 0.5f)
-        : applyScaleOffset<float4>(image, 0.5f, 0.5f);
+    transformValues(target, source, ScaleOffset{ 0.5f, 0.5f });
 }
 
 LinearImage colorsToVectors(const LinearImage& image) {
-    ASSERT_PRECONDITION(image.getChannels() == 3 || image.getChannels() == 4,
+    LinearImage result(image.getWidth(), image.getHeight(), image.getChannels());
+    colorsToVectors(result, image);
+    return result;
+}
+
+void colorsToVectors(LinearImage& target, const LinearImage& source) {
+    ASSERT_PRECONDITION(source.getChannels() == 3 || source.getChannels() == 4,
                         "Must be a 3 or 4 channel image");
-    return image.getChannels() == 3
-        ? applyScaleOffset<float3>(image, 2.0f, -1.0f)
-        : applyScaleOffset<float4>(image, 2.0f, -1.0f);
+    transformValues(target, source, ScaleOffset{ 2.0f, -1.0f });
 }
 
 LinearImage extractChannel(const LinearImage& source, uint32_t channel) {
+    LinearImage result(source.getWidth(), source.getHeight(), 1);
+    extractChannel(result, source, channel);
+    return result;
+}
+
+void extractChannel(LinearImage& target, const LinearImage& source, uint32_t channel) {
     const uint32_t width = source.getWidth(), height = source.getHeight();
     const uint32_t nchan = source.getChannels();
     ASSERT_PRECONDITION(channel < nchan, "Channel is out of range.");
-    LinearImage result(width, height, 1);
-    auto src = source.getPixelRef();
-    auto dst = result.getPixelRef();
-    for (uint32_t n = 0, npixels = width * height; n < npixels; ++n, ++dst, src += nchan) {
-        dst[0] = src[channel];
+    ASSERT_PRECONDITION(target.getWidth() == width && target.getHeight() == height &&
+            target.getChannels() == 1, "Target must be a single channel image of the same size.");
+    float const* UTILS_RESTRICT src = source.getPixelRef() + channel;
+    float* UTILS_RESTRICT dst = target.getPixelRef();
+    for (size_t n = 0, npixels = size_t(width) * height; n < npixels; ++n) {
+        dst[n] = src[n * nchan];
     }
-    return result;
 }
 
 LinearImage combineChannels(std::initializer_list<LinearImage> images) {
@@ -167,6 +191,13 @@ LinearImage combineChannels(std::initializer_list<LinearImage> images) {
 }
 
 LinearImage combineChannels(LinearImage const* img, size_t count) {
+    ASSERT_PRECONDITION(count > 0, "Must supply one or more image planes for combining.");
+    LinearImage result(img[0].getWidth(), img[0].getHeight(), (uint32_t) count);
+    combineChannels(result, img, count);
+    return result;
+}
+
+void combineChannels(LinearImage& target, LinearImage const* img, size_t count) {
     ASSERT_PRECONDITION(count > 0, "Must supply one or more image planes for combining.");
     const uint32_t width = img[0].getWidth();
     const uint32_t height = img[0].getHeight();
@@ -176,18 +207,17 @@ LinearImage combineChannels(LinearImage const* img, size_t count) {
         ASSERT_PRECONDITION(plane.getHeight() == height, "Planes must all have same height.");
         ASSERT_PRECONDITION(plane.getChannels() == 1, "Planes must be single channel.");
     }
-    LinearImage result(width, height, (uint32_t) count);
-    float* dst = result.getPixelRef();
-    uint32_t sindex = 0, dindex = 0;
-    while (dindex < width * height * count) {
-        for (size_t c = 0; c < count; ++c, ++dindex) {
-            const LinearImage& plane = img[c];
-            float const* src = plane.getPixelRef();
-            dst[dindex] = src[sindex];
+    ASSERT_PRECONDITION(target.getWidth() == width && target.getHeight() == height &&
+            target.getChannels() == count, "Target must have one channel per plane.");
+    // interleave one plane at a time, which streams through each source only once
+    const size_t npixels = size_t(width) * height;
+    for (size_t c = 0; c < count; ++c) {
+        float const* UTILS_RESTRICT src = img[c].getPixelRef();
+        float* UTILS_RESTRICT dst = target.getPixelRef() + c;
+        for (size_t n = 0; n < npixels; ++n) {
+            dst[n * count] = src[n];
         }
-        ++sindex;
     }
-    return result;
 }
 
 // The transpose operation does not simply set a flag, it performs actual movement of data. This is
@@ -196,40 +226,65 @@ LinearImage combineChannels(LinearImage const* img, size_t count) {
 // implementation does not support in-place transposition but it is simple and robust for non-square
 // images.
 LinearImage transpose(const LinearImage& image) {
-    const uint32_t width = image.getWidth();
-    const uint32_t height = image.getHeight();
-    const uint32_t channels = image.getChannels();
-    LinearImage result(height, width, channels);
-    float const* source = image.getPixelRef();
-    float* target = result.getPixelRef();
-    for (uint32_t n = 0; n < width * height; ++n) {
-        const uint32_t i = n / width;
-        const uint32_t j = n % width;
-        float const* src = source + channels * n;
-        float* dst = target + channels * (height * j + i);
-        for (uint32_t c = 0; c < channels; ++c) {
-            dst[c] = src[c];
+    LinearImage result(image.getHeight(), image.getWidth(), image.getChannels());
+    transpose(result, image);
+    return result;
+}
+
+void transpose(LinearImage& target, const LinearImage& source) {
+    const uint32_t width = source.getWidth();
+    const uint32_t height = source.getHeight();
+    const uint32_t channels = source.getChannels();
+    ASSERT_PRECONDITION(target.getWidth() == height && target.getHeight() == width &&
+            target.getChannels() == channels, "Target must have the transposed dimensions.");
+    ASSERT_PRECONDITION(target.getPixelRef() != source.getPixelRef(),
+            "Transposition cannot be done in place.");
+
+    // Walking the source by rows writes the target by columns, which touches a new cache line for
+    // every pixel. Copying square blocks instead keeps both the rows being read and the rows being
+    // written in cache.
+    constexpr uint32_t BLOCK_SIZE = 32;
+    float const* UTILS_RESTRICT src = source.getPixelRef();
+    float* UTILS_RESTRICT dst = target.getPixelRef();
+    for (uint32_t i0 = 0; i0 < height; i0 += BLOCK_SIZE) {
+        const uint32_t i1 = std::min(i0 + BLOCK_SIZE, height);
+        for (uint32_t j0 = 0; j0 < width; j0 += BLOCK_SIZE) {
+            const uint32_t j1 = std::min(j0 + BLOCK_SIZE, width);
+            for (uint32_t j = j0; j < j1; ++j) {
+                float* d = dst + (size_t(j) * height + i0) * channels;
+                for (uint32_t i = i0; i < i1; ++i, d += channels) {
+                    float const* s = src + (size_t(i) * width + j) * channels;
+                    for (uint32_t c = 0; c < channels; ++c) {
+                        d[c] = s[c];
+                    }
+                }
+            }
         }
     }
-    return result;
 }
 
 LinearImage cropRegion(const LinearImage& image, uint32_t left, uint32_t top, uint32_t right,
         uint32_t bottom) {
-    uint32_t width = right - left;
-    uint32_t height = bottom - top;
-    uint32_t channels = image.getChannels();
-    LinearImage result(width, height, channels);
-    float const* source = image.getPixelRef(left, top);
-    float* target = result.getPixelRef();
-    for (int32_t row = 0; row < height; ++row) {
-        memcpy(target, source, width * channels * sizeof(float));
-        target += width * channels;
-        source += image.getWidth() * channels;
-    }
+    LinearImage result(right - left, bottom - top, image.getChannels());
+    cropRegion(result, image, left, top, right, bottom);
     return result;
 }
 
+void cropRegion(LinearImage& target, const LinearImage& source, uint32_t left, uint32_t top,
+        uint32_t right, uint32_t bottom) {
+    const uint32_t width = right - left;
+    const uint32_t height = bottom - top;
+    const uint32_t channels = source.getChannels();
+    ASSERT_PRECONDITION(target.getWidth() == width && target.getHeight() == height &&
+            target.getChannels() == channels, "Target must have the size of the crop window.");
+    ASSERT_PRECONDITION(target.getPixelRef() != source.getPixelRef(),
+            "Cropping cannot be done in place.");
+    for (uint32_t row = 0; row < height; ++row) {
+        memcpy(target.getPixelRef(0, row), source.getPixelRef(left, top + row),
+                width * channels * sizeof(float));
+    }
+}
+
 int compare(const LinearImage& a, const LinearImage& b, float epsilon) {
     auto w = a.getWidth();
     auto h = a.getHeight();
@@ -413,11 +468,15 @@ LinearImage voronoiFromCoordField(const LinearImage& coordField, const LinearIma
     return result;
 }
 
-void blitImage(LinearImage& target, const LinearImage& source) {
-    ASSERT_PRECONDITION(source.getWidth() == target.getWidth(), "Images must have same width.");
-    ASSERT_PRECONDITION(source.getHeight() == target.getHeight(), "Images must have same height.");
-    ASSERT_PRECONDITION(source.getChannels() == target.getChannels(),
+void checkSameDimensions(const LinearImage& a, const LinearImage& b) {
+    ASSERT_PRECONDITION(a.getWidth() == b.getWidth(), "Images must have same width.");
+    ASSERT_PRECONDITION(a.getHeight() == b.getHeight(), "Images must have same height.");
+    ASSERT_PRECONDITION(a.getChannels() == b.getChannels(),
             "Images must have same number of channels.");
+}
+
+void blitImage(LinearImage& target, const LinearImage& source) {
+    checkSameDimensions(target, source);
     memcpy(target.getPixelRef(), source.getPixelRef(),
             sizeof(float) * source.getWidth() * source.getHeight() * source.getChannels());
 }
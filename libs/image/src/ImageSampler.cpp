@@ -21,8 +21,10 @@
 #include <math/vec3.h>
 #include <math/vec4.h>
 
+#include <utils/JobSystem.h>
 #include <utils/Panic.h>
 
+#include <limits>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -172,24 +174,6 @@ void generateMadProgram(uint32_t ntarget, uint32_t nsource, float left, float ri
     }
 }
 
-// Transforms a MAD program intended for single-channel data into a program intended for
-// multi-channel data.
-void expandMadProgram(uint32_t nchannels, MadProgram* program) {
-    if (nchannels == 1) {
-        return;
-    }
-    MadProgram result;
-    result.reserve(program->size() * nchannels);
-    for (auto mad : *program) {
-        mad.sourceIndex *= nchannels;
-        mad.targetIndex *= nchannels;
-        for (uint32_t j = 0; j < nchannels; ++j, ++mad.sourceIndex, ++mad.targetIndex) {
-            result.push_back(mad);
-        }
-    }
-    program->swap(result);
-}
-
 FilterFunction createFilterFunction(Filter ftype) {
     FilterFunction fn;
     switch (ftype) {
@@ -226,8 +210,81 @@ void normalize(LinearImage& image) {
     }
 }
 
+// Executes a single-channel MAD program over a range of rows, treating each pixel as a VecT. Using
+// vector types for the common 3 and 4 channel cases allows the compiler to process all channels of
+// a pixel with a single SIMD multiply-add.
+template<typename VecT, bool MINIMUM>
+void executeMadProgram(const MadProgram& program, float const* source, float* target,
+        uint32_t swidth, uint32_t twidth, uint32_t firstRow, uint32_t rowCount) {
+    for (uint32_t row = firstRow, end = firstRow + rowCount; row < end; ++row) {
+        VecT const* UTILS_RESTRICT sourceRow = (VecT const*) source + size_t(row) * swidth;
+        VecT* UTILS_RESTRICT targetRow = (VecT*) target + size_t(row) * twidth;
+        if (MINIMUM) {
+            // The MIN filter is special because it starts with non-zero values and ignores
+            // filter weights.
+            std::fill_n(targetRow, twidth, VecT(std::numeric_limits<float>::max()));
+            for (auto mad : program) {
+                targetRow[mad.targetIndex] = min(targetRow[mad.targetIndex],
+                        sourceRow[mad.sourceIndex]);
+            }
+        } else {
+            for (auto mad : program) {
+                targetRow[mad.targetIndex] += sourceRow[mad.sourceIndex] * mad.weight;
+            }
+        }
+    }
+}
+
+// Fallback for an arbitrary number of channels.
+template<bool MINIMUM>
+void executeMadProgram(const MadProgram& program, float const* source, float* target,
+        uint32_t swidth, uint32_t twidth, uint32_t nchan, uint32_t firstRow, uint32_t rowCount) {
+    for (uint32_t row = firstRow, end = firstRow + rowCount; row < end; ++row) {
+        float const* UTILS_RESTRICT sourceRow = source + size_t(row) * swidth * nchan;
+        float* UTILS_RESTRICT targetRow = target + size_t(row) * twidth * nchan;
+        if (MINIMUM) {
+            std::fill_n(targetRow, twidth * nchan, std::numeric_limits<float>::max());
+        }
+        for (auto mad : program) {
+            float const* src = sourceRow + mad.sourceIndex * nchan;
+            float* dst = targetRow + mad.targetIndex * nchan;
+            for (uint32_t c = 0; c < nchan; ++c) {
+                dst[c] = MINIMUM ? std::min(dst[c], src[c]) : dst[c] + src[c] * mad.weight;
+            }
+        }
+    }
+}
+
+template<bool MINIMUM>
+void executeMadProgram(const MadProgram& program, const LinearImage& source, LinearImage& target,
+        uint32_t firstRow, uint32_t rowCount) {
+    float const* src = source.getPixelRef();
+    float* dst = target.getPixelRef();
+    const uint32_t swidth = source.getWidth();
+    const uint32_t twidth = target.getWidth();
+    switch (source.getChannels()) {
+        case 1:
+            executeMadProgram<float, MINIMUM>(program, src, dst, swidth, twidth,
+                    firstRow, rowCount);
+            break;
+        case 3:
+            executeMadProgram<float3, MINIMUM>(program, src, dst, swidth, twidth,
+                    firstRow, rowCount);
+            break;
+        case 4:
+            executeMadProgram<float4, MINIMUM>(program, src, dst, swidth, twidth,
+                    firstRow, rowCount);
+            break;
+        default:
+            executeMadProgram<MINIMUM>(program, src, dst, swidth, twidth, source.getChannels(),
+                    firstRow, rowCount);
+            break;
+    }
+}
+
 LinearImage resampleImage1D(const LinearImage& source, MadProgram* program,
-        uint32_t twidth, Filter filter, float left, float right, float filterRadiusMultiplier) {
+        uint32_t twidth, Filter filter, float left, float right, float filterRadiusMultiplier,
+        utils::JobSystem* js = nullptr) {
     const uint32_t swidth = source.getWidth();
     const uint32_t sheight = source.getHeight();
     const uint32_t nchan = source.getChannels();
@@ -235,40 +292,30 @@ LinearImage resampleImage1D(const LinearImage& source, MadProgram* program,
     if (filter == Filter::DEFAULT) filter = mag ? Filter::MITCHELL : Filter::LANCZOS;
     const FilterFunction hfn = createFilterFunction(filter);
 
-    // Generate a flat list of multiply-add (MAD) instructions.
+    // Generate a flat list of multiply-add (MAD) instructions. The same program is used for every
+    // row and every channel.
     program->clear();
     generateMadProgram(twidth, swidth, left, right, hfn, filterRadiusMultiplier, program);
-    expandMadProgram(nchan, program);
 
     // Allocate the target image.
     LinearImage result(twidth, sheight, nchan);
-    float const* sourceRow = source.getPixelRef();
-    float* targetRow = result.getPixelRef();
-
-    // The MIN filter is special because it starts with non-zero values and ignores filter weights.
-    if (filter == Filter::MINIMUM) {
-        for (uint32_t n = 0; n < twidth * sheight * nchan; ++n) {
-            targetRow[n] = std::numeric_limits<float>::max();
-        }
-        for (uint32_t row = 0; row < sheight; ++row) {
-            for (auto mad : *program) {
-                const float a = sourceRow[mad.sourceIndex];
-                const float b = targetRow[mad.targetIndex];
-                targetRow[mad.targetIndex] = std::min(a, b);
-            }
-            targetRow += twidth * nchan;
-            sourceRow += swidth * nchan;
-        }
-        return result;
-    }
 
-    // Resize the image horizontally by executing the MAD instructions over each row.
-    for (uint32_t row = 0; row < sheight; ++row) {
-        for (auto mad : *program) {
-            targetRow[mad.targetIndex] += sourceRow[mad.sourceIndex] * mad.weight;
+    // Resize the image horizontally by executing the MAD instructions over each row. Rows are
+    // independent, so large images are split across the job system.
+    auto execute = [&](uint32_t firstRow, uint32_t rowCount) {
+        if (filter == Filter::MINIMUM) {
+            executeMadProgram<true>(*program, source, result, firstRow, rowCount);
+        } else {
+            executeMadProgram<false>(*program, source, result, firstRow, rowCount);
         }
-        targetRow += twidth * nchan;
-        sourceRow += swidth * nchan;
+    };
+    constexpr size_t MIN_PARALLEL_WORK = 64 * 1024;
+    if (js && sheight > 1 && size_t(sheight) * program->size() * nchan >= MIN_PARALLEL_WORK) {
+        utils::JobSystem::Job* job = utils::jobs::parallel_for(*js, nullptr, 0, sheight,
+                std::cref(execute), utils::jobs::CountSplitter<16, 8>());
+        js->runAndWait(job);
+    } else {
+        execute(0, sheight);
     }
 
     // Perform post processing for the current pass.
@@ -300,10 +347,11 @@ LinearImage resampleImage(const LinearImage& source, uint32_t width, uint32_t he
     const float top = sampler.sourceRegion.top;
     const float right = sampler.sourceRegion.right;
     const float bottom = sampler.sourceRegion.bottom;
+    utils::JobSystem* js = sampler.jobSystem;
     MadProgram program;
     LinearImage result;
-    result = transpose(resampleImage1D(source, &program, width, hfilter, left, right, radius));
-    result = transpose(resampleImage1D(result, &program, height, vfilter, top, bottom, radius));
+    result = transpose(resampleImage1D(source, &program, width, hfilter, left, right, radius, js));
+    result = transpose(resampleImage1D(result, &program, height, vfilter, top, bottom, radius, js));
     return result;
 }
 
@@ -339,13 +387,29 @@ void computeSingleSample(const LinearImage& source, float x, float y, SingleSamp
 // Unlike traditional mipmap generation, our implementation generates all levels from the original
 // image, under the premise that this produces a higher quality result.
 void generateMipmaps(const LinearImage& source, Filter filter, LinearImage* result, uint32_t mips) {
+    generateMipmaps(source, MipmapSampler { .filter = filter }, result, mips);
+}
+
+void generateMipmaps(const LinearImage& source, const MipmapSampler& sampler,
+        LinearImage* result, uint32_t mips) {
     mips = std::min(mips, getMipmapCount(source));
+    const ImageSampler imageSampler {
+        .horizontalFilter = sampler.filter,
+        .verticalFilter = sampler.filter,
+        .jobSystem = sampler.jobSystem
+    };
     uint32_t width = source.getWidth();
     uint32_t height = source.getHeight();
     for (uint32_t n = 0; n < mips; ++n) {
         width = std::max(width >> 1u, 1u);
         height = std::max(height >> 1u, 1u);
-        result[n] = resampleImage(source, width, height, filter);
+
+        // Level n + 1 is downsampled from level n + 1 - cascadeDistance, where level 0 is the
+        // original image. Note that the result array does not contain level 0.
+        const uint32_t distance = sampler.cascadeDistance;
+        const LinearImage& parent = (distance == 0 || n < distance) ?
+                source : result[n - distance];
+        result[n] = resampleImage(parent, width, height, imageSampler);
     }
 }
 
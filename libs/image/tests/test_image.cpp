@@ -26,6 +26,7 @@
 
 #include <gtest/gtest.h>
 
+#include <utils/JobSystem.h>
 #include <utils/Panic.h>
 #include <utils/Path.h>
 
@@ -285,6 +286,54 @@ TEST_F(ImageTest, ImageOps) { // NOLINT
     updateOrCompare(atlas, "imageops.png");
 }
 
+TEST_F(ImageTest, ImageOpsInPlace) { // NOLINT
+    auto equal = [](const LinearImage& a, const LinearImage& b, float epsilon = 0.0f) {
+        return compare(a, b, epsilon) == 0 && compare(b, a, epsilon) == 0;
+    };
+
+    // Odd sizes exercise the middle row and column, and partial transpose blocks.
+    LinearImage src = createNormalMap(37);
+    src = cropRegion(src, 0, 0, 37, 35);
+
+    // Destination overloads produce the same results as the allocating versions, also in place.
+    LinearImage dst(src.getWidth(), src.getHeight(), src.getChannels());
+    horizontalFlip(dst, src);
+    ASSERT_TRUE(equal(dst, horizontalFlip(src)));
+    horizontalFlip(dst, dst);
+    ASSERT_TRUE(equal(dst, src));
+    verticalFlip(dst, src);
+    ASSERT_TRUE(equal(dst, verticalFlip(src)));
+    verticalFlip(dst, dst);
+    ASSERT_TRUE(equal(dst, src));
+
+    LinearImage transposed(src.getHeight(), src.getWidth(), src.getChannels());
+    transpose(transposed, src);
+    for (uint32_t row = 0; row < src.getHeight(); ++row) {
+        for (uint32_t col = 0; col < src.getWidth(); ++col) {
+            ASSERT_TRUE(std::equal(src.getPixelRef(col, row), src.getPixelRef(col, row) + 3,
+                    transposed.getPixelRef(row, col)));
+        }
+    }
+
+    LinearImage channels[3];
+    for (uint32_t c = 0; c < 3; ++c) {
+        channels[c] = LinearImage(src.getWidth(), src.getHeight(), 1);
+        extractChannel(channels[c], src, c);
+    }
+    combineChannels(dst, channels, 3);
+    ASSERT_TRUE(equal(dst, src));
+
+    // A fused chain matches the same operations applied one after the other.
+    LinearImage fused(src.getWidth(), src.getHeight(), src.getChannels());
+    transformValues(fused, src, ScaleOffset{ 0.5f, 0.5f }, Clamp{ 0.25f, 0.75f });
+    LinearImage chained = vectorsToColors(src);
+    transformValues(chained, chained, Clamp{ 0.25f, 0.75f });
+    ASSERT_TRUE(equal(fused, chained));
+    colorsToVectors(fused, fused);
+    vectorsToColors(fused, fused);
+    ASSERT_TRUE(equal(fused, chained, 1e-6f));
+}
+
 TEST_F(ImageTest, ColorTransformRGB) { // NOLINT
     constexpr size_t w = 2;
     constexpr size_t h = 3;
@@ -362,6 +411,48 @@ TEST_F(ImageTest, Mipmaps) { // NOLINT
     }
 }
 
+TEST_F(ImageTest, MipmapsParallelAndCascaded) { // NOLINT
+    utils::JobSystem js;
+    js.adopt();
+
+    // Large enough for the resampler to actually use the job system.
+    LinearImage src = createNormalMap(512);
+    const uint32_t count = getMipmapCount(src);
+    ASSERT_EQ(count, 9);
+
+    // Parallel resampling produces exactly the same result as serial resampling.
+    vector<LinearImage> serial(count);
+    vector<LinearImage> parallel(count);
+    generateMipmaps(src, MipmapSampler { .filter = Filter::LANCZOS }, serial.data(), count);
+    generateMipmaps(src, MipmapSampler { .filter = Filter::LANCZOS, .jobSystem = &js },
+            parallel.data(), count);
+    for (uint32_t index = 0; index < count; ++index) {
+        const LinearImage& a = serial[index];
+        const LinearImage& b = parallel[index];
+        ASSERT_EQ(a.getWidth(), b.getWidth());
+        ASSERT_EQ(a.getHeight(), b.getHeight());
+        const size_t n = size_t(a.getWidth()) * a.getHeight() * a.getChannels();
+        ASSERT_TRUE(std::equal(a.getPixelRef(), a.getPixelRef() + n, b.getPixelRef()));
+    }
+
+    // Cascaded levels have the expected dimensions and stay close to the exact result.
+    vector<LinearImage> cascaded(count);
+    generateMipmaps(src, MipmapSampler { .filter = Filter::BOX, .cascadeDistance = 1 },
+            cascaded.data(), count);
+    generateMipmaps(src, Filter::BOX, serial.data(), count);
+    for (uint32_t index = 0; index < count; ++index) {
+        ASSERT_EQ(cascaded[index].getWidth(), 256u >> index);
+        ASSERT_EQ(cascaded[index].getHeight(), 256u >> index);
+    }
+    const float* exact = serial[count - 1].getPixelRef();
+    const float* approx = cascaded[count - 1].getPixelRef();
+    for (uint32_t c = 0; c < src.getChannels(); ++c) {
+        ASSERT_NEAR(exact[c], approx[c], 0.01f);
+    }
+
+    js.emancipate();
+}
+
 TEST_F(ImageTest, Ktx) { // NOLINT
     uint8_t foo[] = {1, 2, 3};
     uint8_t* data;
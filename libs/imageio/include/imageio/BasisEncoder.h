@@ -27,6 +27,7 @@ namespace image {
 
 struct BasisEncoderBuilderImpl;
 struct BasisEncoderImpl;
+struct BasisJobPoolImpl;
 
 class UTILS_PUBLIC BasisEncoder {
 public:
@@ -35,6 +36,39 @@ public:
         ETC1S,
     };
 
+    /**
+     * Trades compression quality for encoding speed. DEFAULT matches the BasisU tool.
+     */
+    enum class Effort {
+        FASTEST,
+        FASTER,
+        DEFAULT,
+        SLOWER,
+        SLOWEST,
+    };
+
+    /**
+     * A pool of worker threads that can be shared by several encoders, see Builder::jobPool().
+     *
+     * Sharing a pool avoids creating threads for every encoder and bounds the total number of
+     * threads when many images are encoded at the same time. The pool must outlive the encoders
+     * that use it.
+     */
+    class UTILS_PUBLIC JobPool {
+    public:
+        /**
+         * @param threadCount total number of threads, including the thread calling encode().
+         */
+        explicit JobPool(size_t threadCount);
+        ~JobPool() noexcept;
+
+    private:
+        JobPool(const JobPool&) = delete;
+        JobPool& operator=(const JobPool&) = delete;
+        BasisJobPoolImpl* mImpl;
+        friend class BasisEncoder;
+    };
+
     class Builder {
     public:
         /**
@@ -100,10 +134,26 @@ public:
         /**
          * Initializes the basis encoder with the given number of jobs.
          *
+         * This is ignored when a job pool is provided.
+         *
          * default value: 4
          */
         Builder& jobs(size_t count) noexcept;
 
+        /**
+         * Runs the encoder on a shared pool of threads rather than on its own.
+         *
+         * default value: null
+         */
+        Builder& jobPool(JobPool* pool) noexcept;
+
+        /**
+         * Chooses how much time the encoder spends searching for the best encoding.
+         *
+         * default value: DEFAULT
+         */
+        Builder& effort(Effort effort) noexcept;
+
         /**
          * Supresses status messages.
          *
@@ -142,6 +192,20 @@ public:
      */
     bool encode();
 
+    /**
+     * Compresses several encoders concurrently and waits until all of them are done.
+     *
+     * This is most efficient when the encoders share a JobPool, in which case the pool's threads
+     * work on all the images, and on all the miplevels of each image, at once.
+     *
+     * @param encoders    encoders to compress
+     * @param count       number of encoders
+     * @param concurrency maximum number of encoders compressed at the same time, or 0 to use
+     *                    the number of hardware threads.
+     * @returns false if an error occurred with any of the encoders.
+     */
+    static bool encodeBatch(BasisEncoder* const* encoders, size_t count, size_t concurrency = 0);
+
     /**
      * Gets the number of bytes in the generated KTX2 file.
      *
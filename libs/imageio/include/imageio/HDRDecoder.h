@@ -35,6 +35,8 @@ private:
 
     // ImageDecoder::Decoder interface
     LinearImage decode() override;
+    bool decodeRows(ImageDecoder::RowConsumer& consumer, uint32_t maxRowCount,
+            utils::JobSystem* js) override;
 
     static const char sigRadiance[];
     static const char sigRGBE[];
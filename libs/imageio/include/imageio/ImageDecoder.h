@@ -17,6 +17,8 @@
 #ifndef IMAGE_IMAGEDECODER_H_
 #define IMAGE_IMAGEDECODER_H_
 
+#include <algorithm>
+#include <cstdint>
 #include <iosfwd>
 #include <string>
 
@@ -24,6 +26,10 @@
 
 #include <utils/compiler.h>
 
+namespace utils {
+class JobSystem;
+} // namespace utils
+
 namespace image {
 
 class UTILS_PUBLIC ImageDecoder {
@@ -37,11 +43,61 @@ public:
     static LinearImage decode(std::istream& stream, const std::string& sourceName,
             ColorSpace sourceSpace = ColorSpace::SRGB);
 
+    /**
+     * Receives the rows of an image while it is being decoded, see decodeRows().
+     */
+    class RowConsumer {
+    public:
+        virtual ~RowConsumer() = default;
+
+        // Called once before any rows are delivered. Returning false cancels decoding.
+        virtual bool begin(uint32_t width, uint32_t height, uint32_t channels) = 0;
+
+        // Receives rowCount consecutive rows starting at row y, as tightly packed linear floats.
+        // The data is only valid during the call. Returning false cancels decoding.
+        virtual bool consume(uint32_t y, uint32_t rowCount, float const* data) = 0;
+    };
+
+    /**
+     * Decodes the image in strips of at most maxRowCount rows and hands each strip to the
+     * consumer, in the order the rows are stored in the file.
+     *
+     * HDR images are read from the stream one strip at a time, so memory usage only depends on
+     * the width of the image. EXR images are kept in their native precision and converted one
+     * strip at a time. Other formats are decoded entirely before being handed out in strips.
+     *
+     * If a JobSystem is given, each strip is converted to floating point using its threads, in
+     * which case the calling thread must be adopted by the JobSystem.
+     *
+     * Returns false if an error occurred or if the consumer cancelled decoding.
+     */
+    static bool decodeRows(std::istream& stream, const std::string& sourceName,
+            RowConsumer& consumer, ColorSpace sourceSpace = ColorSpace::SRGB,
+            uint32_t maxRowCount = 64, utils::JobSystem* js = nullptr);
+
     class Decoder {
     public:
         virtual LinearImage decode() = 0;
         virtual ~Decoder() = default;
 
+        // The default implementation decodes the whole image and hands it out in strips.
+        virtual bool decodeRows(RowConsumer& consumer, uint32_t maxRowCount,
+                utils::JobSystem* js) {
+            LinearImage image = decode();
+            if (!image.isValid() ||
+                    !consumer.begin(image.getWidth(), image.getHeight(), image.getChannels())) {
+                return false;
+            }
+            maxRowCount = std::max(maxRowCount, 1u);
+            for (uint32_t y = 0, height = image.getHeight(); y < height; y += maxRowCount) {
+                if (!consumer.consume(y, std::min(maxRowCount, height - y),
+                        image.getPixelRef(0, y))) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
         ColorSpace getColorSpace() const noexcept {
             return mColorSpace;
         }
@@ -50,6 +106,24 @@ public:
             mColorSpace = colorSpace;
         }
 
+    protected:
+        // Gathers the rows produced by decodeRows() into a LinearImage.
+        LinearImage decodeFromRows() {
+            struct Gather : public RowConsumer {
+                LinearImage image;
+                bool begin(uint32_t width, uint32_t height, uint32_t channels) override {
+                    image = LinearImage(width, height, channels);
+                    return true;
+                }
+                bool consume(uint32_t y, uint32_t rowCount, float const* data) override {
+                    std::copy_n(data, size_t(image.getWidth()) * image.getChannels() * rowCount,
+                            image.getPixelRef(0, y));
+                    return true;
+                }
+            } gather;
+            return decodeRows(gather, 64, nullptr) ? gather.image : LinearImage();
+        }
+
     private:
         ColorSpace mColorSpace = ColorSpace::SRGB;
     };
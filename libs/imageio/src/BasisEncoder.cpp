@@ -25,6 +25,11 @@
 #include <basisu_comp.h>
 #pragma clang diagnostic pop
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
 namespace image {
 
 using Builder = BasisEncoder::Builder;
@@ -36,17 +41,38 @@ struct BasisEncoderBuilderImpl {
     bool normals = false;
     bool quiet = false;
     size_t jobs = 4;
+    BasisEncoder::JobPool* jobPool = nullptr;
+    BasisEncoder::Effort effort = BasisEncoder::Effort::DEFAULT;
     bool error = false;
 };
 
 struct BasisEncoderImpl {
     basisu::basis_compressor* encoder;
-    basisu::job_pool* jobs;
+    basisu::job_pool* jobs;     // owned only if ownsJobs is set
+    bool ownsJobs;
     bool quiet;
 };
 
+struct BasisJobPoolImpl {
+    basisu::job_pool jobs;
+};
+
+// Encoders that share a pool may run concurrently, so the pool rather than each encoder
+// initializes the BasisU globals.
+BasisEncoder::JobPool::JobPool(size_t threadCount)
+        : mImpl(new BasisJobPoolImpl{ basisu::job_pool(uint32_t(std::max(size_t(1), threadCount))) }) {
+    basisu::basisu_encoder_init();
+}
+
+BasisEncoder::JobPool::~JobPool() noexcept {
+    // basisu_encoder_deinit() is deliberately not called here nor in ~BasisEncoder(): it frees
+    // tables that are global to the process, which other encoders may still be using.
+    // basisu_encoder_init() is idempotent, so the tables simply live until exit.
+    delete mImpl;
+}
+
 Builder::Builder(size_t mipCount, size_t layerCount) noexcept : mImpl(new BasisEncoderBuilderImpl) {
-    const bool multiple = mImpl->params.m_source_images.size() > 1;
+    const bool multiple = layerCount > 1;
     mImpl->params.m_tex_type = multiple ? basist::cBASISTexType2DArray : basist::cBASISTexType2D;
     mImpl->params.m_uastc = true;
     mImpl->params.m_source_images.resize(layerCount);
@@ -146,6 +172,16 @@ Builder& Builder::jobs(size_t count) noexcept {
     return *this;
 }
 
+Builder& Builder::jobPool(BasisEncoder::JobPool* pool) noexcept {
+    mImpl->jobPool = pool;
+    return *this;
+}
+
+Builder& Builder::effort(BasisEncoder::Effort effort) noexcept {
+    mImpl->effort = effort;
+    return *this;
+}
+
 Builder& Builder::quiet(bool enabled) noexcept {
     mImpl->quiet = enabled;
     return *this;
@@ -161,7 +197,9 @@ BasisEncoder* Builder::build() {
     auto& params = mImpl->params;
 
     params.m_status_output = !mImpl->quiet;
-    params.m_pJob_pool = new basisu::job_pool(mImpl->jobs);
+    const bool ownsJobs = mImpl->jobPool == nullptr;
+    params.m_pJob_pool = ownsJobs ?
+            new basisu::job_pool(mImpl->jobs) : &mImpl->jobPool->mImpl->jobs;
     params.m_create_ktx2_file = true;
     params.m_ktx2_uastc_supercompression = basist::KTX2_SS_ZSTANDARD;
 
@@ -177,6 +215,20 @@ BasisEncoder* Builder::build() {
     // This is the default zstd compression level used by the basisu cmdline cool.
     params.m_ktx2_zstd_supercompression_level = 6;
 
+    // The effort maps to the UASTC pack level (FASTEST to SLOWEST match cPackUASTCLevelFastest
+    // to cPackUASTCLevelVerySlow), or to the ETC1S compression level which goes from 0 to
+    // BASISU_MAX_COMPRESSION_LEVEL (the default is 2).
+    constexpr int etc1sLevels[] = { 0, 1, 2, 4, 6 };
+    const uint32_t effort = uint32_t(mImpl->effort);
+    params.m_pack_uastc_flags = (params.m_pack_uastc_flags & ~basisu::cPackUASTCLevelMask) |
+            (basisu::cPackUASTCLevelFastest + effort);
+    params.m_compression_level = etc1sLevels[effort];
+    if (mImpl->effort <= Effort::FASTER) {
+        // skip the most expensive ETC1S refinements
+        params.m_no_selector_rdo = true;
+        params.m_no_endpoint_rdo = true;
+    }
+
     // We do not want basis to read from files, we want it to read from "m_source_images"
     params.m_read_source_images = false;
 
@@ -188,12 +240,16 @@ BasisEncoder* Builder::build() {
     if (!encoder->init(params)) {
         assert_invariant(false);
         delete encoder;
+        if (ownsJobs) {
+            delete params.m_pJob_pool;
+        }
         return nullptr;
     }
 
     return new BasisEncoder(new BasisEncoderImpl {
         .encoder = encoder,
         .jobs = params.m_pJob_pool,
+        .ownsJobs = ownsJobs,
         .quiet = mImpl->quiet,
     });
 }
@@ -202,9 +258,10 @@ BasisEncoder::BasisEncoder(BasisEncoderImpl* impl) noexcept : mImpl(impl) {}
 
 BasisEncoder::~BasisEncoder() noexcept {
     delete mImpl->encoder;
-    delete mImpl->jobs;
+    if (mImpl->ownsJobs) {
+        delete mImpl->jobs;
+    }
     delete mImpl;
-    basisu::basisu_encoder_deinit();
 }
 
 BasisEncoder::BasisEncoder(BasisEncoder&& that) noexcept  : mImpl(nullptr) {
@@ -263,6 +320,32 @@ bool BasisEncoder::encode() {
     return false;
 }
 
+bool BasisEncoder::encodeBatch(BasisEncoder* const* encoders, size_t count, size_t concurrency) {
+    if (concurrency == 0) {
+        concurrency = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::atomic<size_t> next = { 0 };
+    std::atomic<bool> success = { true };
+    auto work = [&]() {
+        for (size_t i = next++; i < count; i = next++) {
+            if (!encoders[i]->encode()) {
+                success = false;
+            }
+        }
+    };
+
+    // the calling thread is one of the workers
+    std::vector<std::thread> threads(std::min(concurrency, count) - (count ? 1 : 0));
+    for (std::thread& thread : threads) {
+        thread = std::thread(work);
+    }
+    work();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    return success;
+}
+
 size_t BasisEncoder::getKtx2ByteCount() const noexcept {
     return mImpl->encoder->get_output_ktx2_file().size();
 }
@@ -16,12 +16,13 @@
 
 #include <imageio/HDRDecoder.h>
 
-#include <image/ImageOps.h>
-
 #include <math/vec3.h>
 
+#include <utils/JobSystem.h>
 #include <utils/Log.h>
 
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <limits>
 #include <memory>
@@ -36,6 +37,7 @@
 #endif
 
 using namespace utils;
+using namespace filament::math;
 
 namespace image {
 
@@ -59,6 +61,63 @@ HDRDecoder::HDRDecoder(std::istream& stream)
 HDRDecoder::~HDRDecoder() = default;
 
 LinearImage HDRDecoder::decode() {
+    return decodeFromRows();
+}
+
+// Reads a flat scanline, stored as interleaved RGBE pixels.
+static bool readFlatScanline(std::istream& stream, uint8_t* rgbe, uint32_t width) {
+    stream.read((char*) rgbe, width * 4);
+    return bool(stream);
+}
+
+// Reads an RLE scanline, which stores each of the R, G, B and E planes separately.
+static bool readRleScanline(std::istream& stream, uint8_t* rgbe, uint32_t width) {
+    uint16_t magic;
+    stream.read((char*) &magic, 2);
+    if (magic != 0x0202) {
+        slog.e << "invalid scanline (magic)" << io::endl;
+        return false;
+    }
+
+    uint16_t w;
+    stream.read((char*) &w, 2);
+    if (ntohs(w) != width) {
+        slog.e << "invalid scanline (width)" << io::endl;
+        return false;
+    }
+
+    char* d = (char*) rgbe;
+    for (size_t p = 0; p < 4; p++) {
+        size_t num_bytes = 0;
+        while (num_bytes < width) {
+            uint8_t rle_count;
+            stream.read((char*) &rle_count, 1);
+            if (!stream) {
+                slog.e << "unexpected end of file" << io::endl;
+                return false;
+            }
+            if (rle_count > 128) {
+                char v;
+                stream.read(&v, 1);
+                memset(d, v, size_t(rle_count - 128));
+                d += rle_count - 128;
+                num_bytes += rle_count - 128;
+            } else {
+                if (rle_count == 0) {
+                    slog.e << "run length is zero" << io::endl;
+                    return false;
+                }
+                stream.read(d, rle_count);
+                d += rle_count;
+                num_bytes += rle_count;
+            }
+        }
+    }
+    return bool(stream);
+}
+
+bool HDRDecoder::decodeRows(ImageDecoder::RowConsumer& consumer, uint32_t maxRowCount,
+        JobSystem* js) {
     float gamma;
     float exposure;
     char sy, sx;
@@ -68,6 +127,10 @@ LinearImage HDRDecoder::decode() {
         do {
             char format[128];
             mStream.getline(buf, sizeof(buf), 0xa);
+            if (!mStream) {
+                slog.e << "invalid header" << io::endl;
+                return false;
+            }
             if (buf[0] == '#') continue;
             sscanf(buf, "FORMAT=%127s", format); // NOLINT
             sscanf(buf, "GAMMA=%f", &gamma); // NOLINT
@@ -78,92 +141,79 @@ LinearImage HDRDecoder::decode() {
             }
         } while (true);
     }
-    LinearImage image(width, height, 3);
 
-    if (sx == '-') image = (image);
-    if (sy == '+') image = verticalFlip(image);
+    if (!consumer.begin(width, height, 3)) {
+        return false;
+    }
 
-    // Allocate memory to hold one row of decoded pixel data.
-    std::unique_ptr<uint8_t[]> rgbe(new uint8_t[width * 4]);
+    // Rows are stored bottom to top when the Y axis is positive.
+    const bool bottomUp = sy == '+';
+    maxRowCount = std::max(1u, std::min(maxRowCount, height));
+
+    // Only one strip is held in memory at a time: its RGBE bytes and its decoded pixels.
+    std::unique_ptr<uint8_t[]> rgbe(new uint8_t[size_t(width) * 4 * maxRowCount]);
+    std::unique_ptr<float[]> rows(new float[size_t(width) * 3 * maxRowCount]);
 
     // First, test for non-RLE images.
     const auto pos = mStream.tellg();
     mStream.read((char*) rgbe.get(), 3);
     mStream.seekg(pos);
+    const bool rle = !(rgbe[0] != 0x2 || rgbe[1] != 0x2 || (rgbe[2] & 0x80) ||
+            width < 8 || width > 32767);
+
+    // (rgb/256) * 2^(e-128), with the exponent scale looked up rather than computed per pixel.
+    float scales[256];
+    scales[0] = 0.0f;
+    for (int e = 1; e < 256; e++) {
+        scales[e] = std::ldexp(1.0f, e - (128 + 8));
+    }
 
-    if (rgbe[0] != 0x2 || rgbe[1] != 0x2 || (rgbe[2] & 0x80) || width < 8 || width > 32767) {
-        for (uint32_t y = 0; y < height; y++) {
-            filament::math::float3* dst = reinterpret_cast<filament::math::float3*>(image.getPixelRef(0, y));
-            mStream.read((char*) rgbe.get(), width * 4);
-            // (rgb/256) * 2^(e-128)
-            size_t pixel = 0;
-            for (size_t x = 0; x < width; x++, pixel += 4) {
-                if (rgbe[pixel + 3] == 0.0f) {
-                    dst[x] = filament::math::float3{0.0f};
-                } else {
-                    filament::math::float3 v(rgbe[pixel], rgbe[pixel + 1], rgbe[pixel + 2]);
-                    dst[x] = (v + 0.5f) * std::ldexp(1.0f, rgbe[pixel + 3] - (128 + 8));
-                }
-            }
-        }
-    } else {
-        for (uint32_t y = 0; y < height; y++) {
-            uint16_t magic;
-            mStream.read((char*) &magic, 2);
-            if (magic != 0x0202) {
-                slog.e << "invalid scanline (magic)" << io::endl;
-                return {};
-            }
+    for (uint32_t y = 0; y < height; y += maxRowCount) {
+        const uint32_t rowCount = std::min(maxRowCount, height - y);
 
-            uint16_t w;
-            mStream.read((char*) &w, 2);
-            if (ntohs(w) != width) {
-                slog.e << "invalid scanline (width)" << io::endl;
-                return {};
+        // Reading the stream is sequential, but expanding the rows to floats is not.
+        for (uint32_t row = 0; row < rowCount; row++) {
+            uint8_t* const src = rgbe.get() + size_t(width) * 4 * row;
+            if (!(rle ? readRleScanline(mStream, src, width) :
+                    readFlatScanline(mStream, src, width))) {
+                return false;
             }
+        }
 
-            char* d = (char*) rgbe.get();
-            for (size_t p = 0; p < 4; p++) {
-                size_t num_bytes = 0;
-                while (num_bytes < width) {
-                    uint8_t rle_count;
-                    mStream.read((char*) &rle_count, 1);
-                    if (rle_count > 128) {
-                        char v;
-                        mStream.read(&v, 1);
-                        memset(d, v, size_t(rle_count - 128));
-                        d += rle_count - 128;
-                        num_bytes += rle_count - 128;
-                    } else {
-                        if (rle_count == 0) {
-                            slog.e << "run length is zero" << io::endl;
-                            return {};
-                        }
-                        mStream.read(d, rle_count);
-                        d += rle_count;
-                        num_bytes += rle_count;
-                    }
+        auto convert = [&](uint32_t first, uint32_t count) {
+            for (uint32_t row = first; row < first + count; row++) {
+                uint8_t const* src = rgbe.get() + size_t(width) * 4 * row;
+                const uint32_t dstRow = bottomUp ? rowCount - 1 - row : row;
+                float3* dst = reinterpret_cast<float3*>(rows.get() + size_t(width) * 3 * dstRow);
+                // In RLE scanlines each channel is a separate plane.
+                const size_t stride = rle ? 1 : 4;
+                uint8_t const* r = src;
+                uint8_t const* g = rle ? src + width : src + 1;
+                uint8_t const* b = rle ? src + 2 * width : src + 2;
+                uint8_t const* e = rle ? src + 3 * width : src + 3;
+                for (size_t x = 0, i = 0; x < width; x++, i += stride) {
+                    const float scale = scales[e[i]];
+                    dst[x] = scale == 0.0f ? float3{ 0.0f } :
+                            (float3{ r[i], g[i], b[i] } + 0.5f) * scale;
                 }
             }
+        };
+
+        if (js && rowCount > 1) {
+            auto* job = jobs::parallel_for(*js, nullptr, 0, rowCount, std::cref(convert),
+                    jobs::CountSplitter<4>());
+            js->runAndWait(job);
+        } else {
+            convert(0, rowCount);
+        }
 
-            uint8_t const* r = &rgbe[0];
-            uint8_t const* g = &rgbe[width];
-            uint8_t const* b = &rgbe[2 * width];
-            uint8_t const* e = &rgbe[3 * width];
-            filament::math::float3* dst = reinterpret_cast<filament::math::float3*>(image.getPixelRef(0, y));
-            // (rgb/256) * 2^(e-128)
-            for (size_t x = 0; x < width; x++, r++, g++, b++, e++) {
-                if (e[0] == 0.0f) {
-                    dst[x] = filament::math::float3{0.0f};
-                } else {
-                    filament::math::float3 v(r[0], g[0], b[0]);
-                    dst[x] = (v + 0.5f) * std::ldexp(1.0f, e[0] - (128 + 8));
-                }
-            }
+        const uint32_t firstRow = bottomUp ? height - y - rowCount : y;
+        if (!consumer.consume(firstRow, rowCount, rows.get())) {
+            return false;
         }
     }
 
-    return image;
+    return true;
 }
 
 #ifdef IMAGEIO_LITE
@@ -196,6 +246,21 @@ LinearImage ImageDecoder::decode(std::istream& stream, const std::string& source
     return decoder->decode();
 }
 
+bool ImageDecoder::decodeRows(std::istream& stream, const std::string& sourceName,
+        RowConsumer& consumer, ColorSpace sourceSpace, uint32_t maxRowCount, JobSystem* js) {
+    std::streampos pos = stream.tellg();
+    char buf[16];
+    stream.read(buf, sizeof(buf));
+    const bool isHDR = HDRDecoder::checkSignature(buf);
+    stream.seekg(pos);
+    if (!isHDR) {
+        return false;
+    }
+    std::unique_ptr<Decoder> decoder(HDRDecoder::create(stream));
+    decoder->setColorSpace(ColorSpace::LINEAR);
+    return decoder->decodeRows(consumer, maxRowCount, js);
+}
+
 #endif
 
 } // namespace image
@@ -35,6 +35,7 @@
 #    include <arpa/inet.h>
 #endif
 
+#include <math/half.h>
 #include <math/vec3.h>
 #include <math/vec4.h>
 
@@ -47,6 +48,8 @@
 
 #include <imageio/HDRDecoder.h>
 
+#include <utils/JobSystem.h>
+
 namespace image {
 
 class PNGDecoder : public ImageDecoder::Decoder {
@@ -116,6 +119,8 @@ private:
 
     // ImageDecoder::Decoder interface
     LinearImage decode() override;
+    bool decodeRows(ImageDecoder::RowConsumer& consumer, uint32_t maxRowCount,
+            utils::JobSystem* js) override;
 
     static const char sig[];
     std::istream& mStream;
@@ -125,52 +130,51 @@ private:
 
 // -----------------------------------------------------------------------------------------------
 
-LinearImage ImageDecoder::decode(std::istream& stream, const std::string& sourceName,
-        ColorSpace sourceSpace) {
-
-    Format format = Format::NONE;
+static ImageDecoder::Decoder* createDecoder(std::istream& stream, const std::string& sourceName,
+        ImageDecoder::ColorSpace sourceSpace) {
+    using ColorSpace = ImageDecoder::ColorSpace;
 
     std::streampos pos = stream.tellg();
     char buf[16];
     stream.read(buf, sizeof(buf));
+    stream.seekg(pos);
 
+    ImageDecoder::Decoder* decoder = nullptr;
     if (PNGDecoder::checkSignature(buf)) {
-        format = Format::PNG;
+        decoder = PNGDecoder::create(stream);
+        decoder->setColorSpace(sourceSpace);
     } else if (HDRDecoder::checkSignature(buf)) {
-        format = Format::HDR;
+        decoder = HDRDecoder::create(stream);
+        decoder->setColorSpace(ColorSpace::LINEAR);
     } else if (PSDDecoder::checkSignature(buf)) {
-        format = Format::PSD;
+        decoder = PSDDecoder::create(stream);
+        decoder->setColorSpace(ColorSpace::LINEAR);
     } else if (EXRDecoder::checkSignature(buf)) {
-        format = Format::EXR;
+        decoder = EXRDecoder::create(stream, sourceName);
+        decoder->setColorSpace(ColorSpace::LINEAR);
     }
+    return decoder;
+}
 
-    stream.seekg(pos);
-
-    std::unique_ptr<Decoder> decoder;
-    switch (format) {
-        case Format::NONE:
-            return LinearImage();
-        case Format::PNG:
-            decoder.reset(PNGDecoder::create(stream));
-            decoder->setColorSpace(sourceSpace);
-            break;
-        case Format::HDR:
-            decoder.reset(HDRDecoder::create(stream));
-            decoder->setColorSpace(ColorSpace::LINEAR);
-            break;
-        case Format::PSD:
-            decoder.reset(PSDDecoder::create(stream));
-            decoder->setColorSpace(ColorSpace::LINEAR);
-            break;
-        case Format::EXR:
-            decoder.reset(EXRDecoder::create(stream, sourceName));
-            decoder->setColorSpace(ColorSpace::LINEAR);
-            break;
+LinearImage ImageDecoder::decode(std::istream& stream, const std::string& sourceName,
+        ColorSpace sourceSpace) {
+    std::unique_ptr<Decoder> decoder(createDecoder(stream, sourceName, sourceSpace));
+    if (!decoder) {
+        return LinearImage();
     }
-
     return decoder->decode();
 }
 
+bool ImageDecoder::decodeRows(std::istream& stream, const std::string& sourceName,
+        RowConsumer& consumer, ColorSpace sourceSpace, uint32_t maxRowCount,
+        utils::JobSystem* js) {
+    std::unique_ptr<Decoder> decoder(createDecoder(stream, sourceName, sourceSpace));
+    if (!decoder) {
+        return false;
+    }
+    return decoder->decodeRows(consumer, maxRowCount, js);
+}
+
 // -----------------------------------------------------------------------------------------------
 
 static inline float read32(std::istream& istream) {
@@ -448,56 +452,159 @@ EXRDecoder::EXRDecoder(std::istream& stream, const std::string& sourceName)
 EXRDecoder::~EXRDecoder() = default;
 
 LinearImage EXRDecoder::decode() {
-    try {
-        // copy the EXR data in memory
-        std::vector<unsigned char> src;
-        unsigned char buffer[4096];
-        while (mStream.read(reinterpret_cast<char*>(buffer), sizeof(buffer))) {
-            src.insert(src.end(), &buffer[0], &buffer[4096]);
-        }
-        src.insert(src.end(), &buffer[0], &buffer[mStream.gcount()]);
+    return decodeFromRows();
+}
 
-        int width;
-        int height;
-        float* rgba;
-        const char* error;
+// Reads one pixel of a channel that was decoded by tinyexr in its native precision.
+static inline float readEXRChannel(unsigned char const* data, int type, size_t index) {
+    switch (type) {
+        case TINYEXR_PIXELTYPE_HALF:
+            return float(filament::math::makeHalf(
+                    reinterpret_cast<uint16_t const*>(data)[index]));
+        case TINYEXR_PIXELTYPE_UINT:
+            return float(reinterpret_cast<uint32_t const*>(data)[index]);
+        default:
+            return reinterpret_cast<float const*>(data)[index];
+    }
+}
 
-        int ret = LoadEXRFromMemory(&rgba, &width, &height, src.data(), src.size(), &error);
-        if (ret != TINYEXR_SUCCESS) {
-            std::cerr << "Could not decode OpenEXR: " << error << std::endl;
+bool EXRDecoder::decodeRows(ImageDecoder::RowConsumer& consumer, uint32_t maxRowCount,
+        utils::JobSystem* js) {
+    // copy the EXR data in memory
+    std::vector<unsigned char> src;
+    unsigned char buffer[4096];
+    while (mStream.read(reinterpret_cast<char*>(buffer), sizeof(buffer))) {
+        src.insert(src.end(), &buffer[0], &buffer[4096]);
+    }
+    src.insert(src.end(), &buffer[0], &buffer[mStream.gcount()]);
+
+    EXRVersion version;
+    EXRHeader header;
+    EXRImage exr;
+    InitEXRHeader(&header);
+    InitEXRImage(&exr);
+
+    auto fail = [&](const char* error) {
+        std::cerr << "Could not decode OpenEXR: " << (error ? error : "invalid file") << std::endl;
+        if (error) {
             FreeEXRErrorMessage(error);
-            mStream.seekg(mStreamStartPos);
-            return LinearImage();
         }
+        FreeEXRImage(&exr);
+        FreeEXRHeader(&header);
+        mStream.seekg(mStreamStartPos);
+        return false;
+    };
+
+    const char* error = nullptr;
+    if (ParseEXRVersionFromMemory(&version, src.data(), src.size()) != TINYEXR_SUCCESS) {
+        return fail(nullptr);
+    }
+    if (ParseEXRHeaderFromMemory(&header, &version, src.data(), src.size(), &error) !=
+            TINYEXR_SUCCESS) {
+        return fail(error);
+    }
+
+    // Channels are left in their native precision (i.e. typically half) rather than expanded to
+    // 32-bit floats, since only one strip at a time is converted. tinyexr decompresses the
+    // chunks of the file on multiple threads.
+    if (LoadEXRImageFromMemory(&exr, &header, src.data(), src.size(), &error) !=
+            TINYEXR_SUCCESS) {
+        return fail(error);
+    }
 
-        src.clear();
-        src.shrink_to_fit();
-
-        LinearImage image((uint32_t) width, (uint32_t) height, 3);
-
-        size_t i = 0;
-        for (uint32_t y = 0; y < height; y++) {
-            for (uint32_t x = 0; x < width; x++) {
-                filament::math::float3& pixel =
-                        *reinterpret_cast< filament::math::float3*>(image.getPixelRef(x, y));
-                pixel.r = rgba[i++];
-                pixel.g = rgba[i++];
-                pixel.b = rgba[i++];
-                // skip alpha
-                i++;
+    src.clear();
+    src.shrink_to_fit();
+
+    int channels[3] = { -1, -1, -1 };
+    for (int c = 0; c < header.num_channels; c++) {
+        const char* name = header.channels[c].name;
+        if (!strcmp(name, "R")) channels[0] = c;
+        if (!strcmp(name, "G")) channels[1] = c;
+        if (!strcmp(name, "B")) channels[2] = c;
+    }
+    if (header.num_channels == 1) {
+        // Grayscale channel only.
+        channels[0] = channels[1] = channels[2] = 0;
+    }
+    if (channels[0] < 0 || channels[1] < 0 || channels[2] < 0) {
+        return fail(nullptr);
+    }
+
+    const uint32_t width = uint32_t(exr.width);
+    const uint32_t height = uint32_t(exr.height);
+    if (!consumer.begin(width, height, 3)) {
+        FreeEXRImage(&exr);
+        FreeEXRHeader(&header);
+        return false;
+    }
+
+    // Tiled images are converted one row of tiles at a time, so we index tiles by their row.
+    const uint32_t tileWidth = header.tiled ? uint32_t(header.tile_size_x) : width;
+    const uint32_t tileHeight = header.tiled ? uint32_t(header.tile_size_y) : height;
+    std::vector<std::vector<EXRTile const*>> tileRows;
+    if (header.tiled) {
+        tileRows.resize((height + tileHeight - 1) / tileHeight);
+        for (int i = 0; i < exr.num_tiles; i++) {
+            EXRTile const& tile = exr.tiles[i];
+            if (tile.level_x == 0 && tile.level_y == 0 && size_t(tile.offset_y) < tileRows.size()) {
+                tileRows[tile.offset_y].push_back(&tile);
             }
         }
+    }
+
+    maxRowCount = std::max(1u, std::min(maxRowCount, height));
+    std::unique_ptr<float[]> rows(new float[size_t(width) * 3 * maxRowCount]);
+
+    for (uint32_t y = 0; y < height; y += maxRowCount) {
+        const uint32_t rowCount = std::min(maxRowCount, height - y);
+
+        auto convert = [&](uint32_t first, uint32_t count) {
+            for (uint32_t row = first; row < first + count; row++) {
+                const uint32_t srcRow = y + row;
+                float* dst = rows.get() + size_t(width) * 3 * row;
+                if (!header.tiled) {
+                    const size_t index = size_t(srcRow) * width;
+                    for (uint32_t x = 0; x < width; x++, dst += 3) {
+                        for (size_t c = 0; c < 3; c++) {
+                            dst[c] = readEXRChannel(exr.images[channels[c]],
+                                    header.pixel_types[channels[c]], index + x);
+                        }
+                    }
+                    continue;
+                }
+                const uint32_t j = srcRow % tileHeight;
+                for (EXRTile const* tile : tileRows[srcRow / tileHeight]) {
+                    const uint32_t x0 = uint32_t(tile->offset_x) * tileWidth;
+                    const uint32_t x1 = std::min(x0 + tileWidth, width);
+                    for (uint32_t x = x0; x < x1; x++) {
+                        const size_t index = size_t(j) * tileWidth + (x - x0);
+                        for (size_t c = 0; c < 3; c++) {
+                            dst[x * 3 + c] = readEXRChannel(tile->images[channels[c]],
+                                    header.pixel_types[channels[c]], index);
+                        }
+                    }
+                }
+            }
+        };
 
-        free(rgba);
+        if (js && rowCount > 1) {
+            auto* job = utils::jobs::parallel_for(*js, nullptr, 0, rowCount, std::cref(convert),
+                    utils::jobs::CountSplitter<4>());
+            js->runAndWait(job);
+        } else {
+            convert(0, rowCount);
+        }
 
-        return image;
-    } catch(std::runtime_error& e) {
-        // reset the stream, like we found it
-        std::cerr << "Runtime error while decoding OpenEXR: " << e.what() << std::endl;
-        mStream.seekg(mStreamStartPos);
+        if (!consumer.consume(y, rowCount, rows.get())) {
+            FreeEXRImage(&exr);
+            FreeEXRHeader(&header);
+            return false;
+        }
     }
 
-    return LinearImage();
+    FreeEXRImage(&exr);
+    FreeEXRHeader(&header);
+    return true;
 }
 
 } // namespace image
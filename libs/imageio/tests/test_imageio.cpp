@@ -0,0 +1,453 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <image/ImageSampler.h>
+#include <image/LinearImage.h>
+
+#include <imageio/BasisEncoder.h>
+#include <imageio/ImageDecoder.h>
+#include <imageio/ImageEncoder.h>
+
+#include <gtest/gtest.h>
+
+#include <utils/JobSystem.h>
+
+#include <math/half.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+using namespace image;
+
+class ImageIOTest : public testing::Test {};
+
+// Gathers the strips produced by decodeRows() into a LinearImage and checks that they are
+// delivered in file order, with no overlap, holes or oversized strips.
+struct RowCollector : public ImageDecoder::RowConsumer {
+    explicit RowCollector(uint32_t maxRowCount) : maxRowCount(maxRowCount) {}
+
+    bool begin(uint32_t width, uint32_t height, uint32_t channels) override {
+        image = LinearImage(width, height, channels);
+        return true;
+    }
+
+    bool consume(uint32_t y, uint32_t rowCount, float const* data) override {
+        EXPECT_GT(rowCount, 0u);
+        EXPECT_LE(rowCount, maxRowCount);
+        EXPECT_LE(y + rowCount, image.getHeight());
+        firstRows.push_back(y);
+        rowTotal += rowCount;
+        std::copy_n(data, size_t(image.getWidth()) * image.getChannels() * rowCount,
+                image.getPixelRef(0, y));
+        return true;
+    }
+
+    const uint32_t maxRowCount;
+    LinearImage image;
+    vector<uint32_t> firstRows;
+    uint32_t rowTotal = 0;
+};
+
+static LinearImage decode(const string& data, const string& name) {
+    std::istringstream stream(data);
+    return ImageDecoder::decode(stream, name, ImageDecoder::ColorSpace::LINEAR);
+}
+
+static void expectSameImage(const LinearImage& a, const LinearImage& b) {
+    ASSERT_TRUE(a.isValid());
+    ASSERT_TRUE(b.isValid());
+    ASSERT_EQ(a.getWidth(), b.getWidth());
+    ASSERT_EQ(a.getHeight(), b.getHeight());
+    ASSERT_EQ(a.getChannels(), b.getChannels());
+    const size_t n = size_t(a.getWidth()) * a.getHeight() * a.getChannels();
+    for (size_t i = 0; i < n; i++) {
+        ASSERT_EQ(a.getPixelRef()[i], b.getPixelRef()[i]) << "at float index " << i;
+    }
+}
+
+// Decodes the given file with several strip sizes, with and without a JobSystem, and checks that
+// the result always matches the expected image and that strips follow the storage order.
+static void checkDecodeRows(const string& data, const string& name, const LinearImage& expected,
+        bool bottomUp = false) {
+    utils::JobSystem js;
+    js.adopt();
+    for (utils::JobSystem* jobSystem : { (utils::JobSystem*) nullptr, &js }) {
+        for (uint32_t maxRowCount : { 1u, 3u, 4u, 64u }) {
+            SCOPED_TRACE(name + ", " + std::to_string(maxRowCount) + " rows per strip" +
+                    (jobSystem ? ", with JobSystem" : ""));
+            std::istringstream stream(data);
+            RowCollector collector(maxRowCount);
+            ASSERT_TRUE(ImageDecoder::decodeRows(stream, name, collector,
+                    ImageDecoder::ColorSpace::LINEAR, maxRowCount, jobSystem));
+            EXPECT_EQ(collector.rowTotal, expected.getHeight());
+            ASSERT_FALSE(collector.firstRows.empty());
+            if (bottomUp) {
+                EXPECT_TRUE(std::is_sorted(collector.firstRows.rbegin(),
+                        collector.firstRows.rend()));
+            } else {
+                EXPECT_TRUE(std::is_sorted(collector.firstRows.begin(),
+                        collector.firstRows.end()));
+            }
+            expectSameImage(collector.image, expected);
+        }
+    }
+    js.emancipate();
+}
+
+// HDR ---------------------------------------------------------------------------------------------
+
+// Produces distinct RGBE bytes for every pixel, with runs in the exponent and some black pixels.
+static void hdrTexel(uint32_t x, uint32_t y, uint8_t rgbe[4]) {
+    rgbe[0] = uint8_t(x * 16 + y);
+    rgbe[1] = uint8_t(200 - x - y * 3);
+    rgbe[2] = uint8_t(x * y);
+    rgbe[3] = (x / 5 + y) % 7 == 0 ? 0 : uint8_t(120 + (x / 5 + y) % 16);
+}
+
+static LinearImage createHdrReference(uint32_t width, uint32_t height) {
+    LinearImage image(width, height, 3);
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            uint8_t rgbe[4];
+            hdrTexel(x, y, rgbe);
+            const float scale = rgbe[3] ? std::ldexp(1.0f, int(rgbe[3]) - (128 + 8)) : 0.0f;
+            float* dst = image.getPixelRef(x, y);
+            for (int c = 0; c < 3; c++) {
+                dst[c] = scale == 0.0f ? 0.0f : (float(rgbe[c]) + 0.5f) * scale;
+            }
+        }
+    }
+    return image;
+}
+
+// Encodes one channel of an RLE scanline, using runs for 3 or more equal bytes.
+static void appendRlePlane(string& out, uint8_t const* plane, uint32_t width) {
+    for (uint32_t x = 0; x < width;) {
+        uint32_t run = 1;
+        while (x + run < width && run < 127 && plane[x + run] == plane[x]) run++;
+        if (run > 2) {
+            out += char(128 + run);
+            out += char(plane[x]);
+            x += run;
+            continue;
+        }
+        uint32_t count = 0;
+        while (x + count < width && count < 128 && !(x + count + 2 < width &&
+                plane[x + count] == plane[x + count + 1] &&
+                plane[x + count] == plane[x + count + 2])) {
+            count++;
+        }
+        out += char(count);
+        out.append((char const*) plane + x, count);
+        x += count;
+    }
+}
+
+static string createHdr(uint32_t width, uint32_t height, bool bottomUp, bool rle) {
+    string out = "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n";
+    out += (bottomUp ? "+Y " : "-Y ") + std::to_string(height) + " +X " +
+            std::to_string(width) + "\n";
+    vector<uint8_t> planes(width * 4);
+    for (uint32_t row = 0; row < height; row++) {
+        const uint32_t y = bottomUp ? height - 1 - row : row;
+        if (!rle) {
+            for (uint32_t x = 0; x < width; x++) {
+                uint8_t rgbe[4];
+                hdrTexel(x, y, rgbe);
+                out.append((char const*) rgbe, 4);
+            }
+            continue;
+        }
+        for (uint32_t x = 0; x < width; x++) {
+            uint8_t rgbe[4];
+            hdrTexel(x, y, rgbe);
+            for (uint32_t c = 0; c < 4; c++) {
+                planes[c * width + x] = rgbe[c];
+            }
+        }
+        out += { 2, 2, char(width >> 8), char(width & 0xff) };
+        for (uint32_t c = 0; c < 4; c++) {
+            appendRlePlane(out, planes.data() + c * width, width);
+        }
+    }
+    return out;
+}
+
+TEST_F(ImageIOTest, HdrRows) { // NOLINT
+    const uint32_t width = 37;
+    const uint32_t height = 23;
+    const LinearImage reference = createHdrReference(width, height);
+    for (bool rle : { false, true }) {
+        for (bool bottomUp : { false, true }) {
+            const string name = string(rle ? "rle" : "flat") + (bottomUp ? "_bottomup" : "") +
+                    ".hdr";
+            const string data = createHdr(width, height, bottomUp, rle);
+            {
+                SCOPED_TRACE(name);
+                expectSameImage(decode(data, name), reference);
+            }
+            checkDecodeRows(data, name, reference, bottomUp);
+        }
+    }
+}
+
+TEST_F(ImageIOTest, HdrCancel) { // NOLINT
+    struct Cancel : public ImageDecoder::RowConsumer {
+        bool begin(uint32_t, uint32_t, uint32_t) override { return true; }
+        bool consume(uint32_t, uint32_t, float const*) override { ++count; return false; }
+        int count = 0;
+    } cancel;
+    std::istringstream stream(createHdr(16, 16, false, true));
+    EXPECT_FALSE(ImageDecoder::decodeRows(stream, "cancel.hdr", cancel,
+            ImageDecoder::ColorSpace::LINEAR, 4));
+    EXPECT_EQ(cancel.count, 1);
+}
+
+// EXR ---------------------------------------------------------------------------------------------
+
+// Every value is an integer below 2048, so it is exactly representable as a half.
+static float exrTexel(uint32_t x, uint32_t y, uint32_t c) {
+    return float((x * 3 + y * 64 + c * 11) % 2048);
+}
+
+static LinearImage createExrReference(uint32_t width, uint32_t height) {
+    LinearImage image(width, height, 3);
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            for (uint32_t c = 0; c < 3; c++) {
+                image.getPixelRef(x, y)[c] = exrTexel(x, y, c);
+            }
+        }
+    }
+    return image;
+}
+
+template<typename T>
+static void append(string& out, T value) {
+    out.append((char const*) &value, sizeof(T));
+}
+
+static void appendAttribute(string& out, const char* name, const char* type, const string& value) {
+    out.append(name, strlen(name) + 1);
+    out.append(type, strlen(type) + 1);
+    append(out, int32_t(value.size()));
+    out += value;
+}
+
+// Writes an uncompressed, single level, tiled EXR with half R, G and B channels. tinyexr does not
+// write tiled files, hence this minimal writer. Tiles are stored in reverse order to check that
+// the decoder does not depend on it.
+static string createTiledExr(uint32_t width, uint32_t height, uint32_t tileWidth,
+        uint32_t tileHeight) {
+    string out = { 0x76, 0x2f, 0x31, 0x01, 2, 2, 0, 0 };
+
+    string channels;
+    for (char const* name : { "B", "G", "R" }) { // channels are sorted by name
+        channels.append(name, 2);
+        append(channels, int32_t(1)); // HALF
+        channels += { 0, 0, 0, 0 };   // pLinear and reserved
+        append(channels, int32_t(1)); // xSampling
+        append(channels, int32_t(1)); // ySampling
+    }
+    channels += '\0';
+
+    string window;
+    for (int32_t v : { 0, 0, int32_t(width) - 1, int32_t(height) - 1 }) {
+        append(window, v);
+    }
+
+    string tiles;
+    append(tiles, tileWidth);
+    append(tiles, tileHeight);
+    tiles += '\0'; // ONE_LEVEL, ROUND_DOWN
+
+    string aspect, center, windowWidth;
+    append(aspect, 1.0f);
+    append(center, 0.0f);
+    append(center, 0.0f);
+    append(windowWidth, 1.0f);
+
+    appendAttribute(out, "channels", "chlist", channels);
+    appendAttribute(out, "compression", "compression", string(1, '\0'));
+    appendAttribute(out, "dataWindow", "box2i", window);
+    appendAttribute(out, "displayWindow", "box2i", window);
+    appendAttribute(out, "lineOrder", "lineOrder", string(1, '\0'));
+    appendAttribute(out, "pixelAspectRatio", "float", aspect);
+    appendAttribute(out, "screenWindowCenter", "v2f", center);
+    appendAttribute(out, "screenWindowWidth", "float", windowWidth);
+    appendAttribute(out, "tiles", "tiledesc", tiles);
+    out += '\0';
+
+    const uint32_t tileCountX = (width + tileWidth - 1) / tileWidth;
+    const uint32_t tileCountY = (height + tileHeight - 1) / tileHeight;
+    const uint32_t tileCount = tileCountX * tileCountY;
+    const size_t offsetTable = out.size();
+    out.resize(out.size() + sizeof(uint64_t) * tileCount);
+
+    for (uint32_t i = tileCount; i-- > 0;) {
+        const uint32_t tx = i % tileCountX;
+        const uint32_t ty = i / tileCountX;
+        const uint64_t offset = out.size();
+        memcpy(&out[offsetTable + sizeof(uint64_t) * i], &offset, sizeof(offset));
+
+        const uint32_t x0 = tx * tileWidth;
+        const uint32_t y0 = ty * tileHeight;
+        const uint32_t w = std::min(tileWidth, width - x0);
+        const uint32_t h = std::min(tileHeight, height - y0);
+        append(out, int32_t(tx));
+        append(out, int32_t(ty));
+        append(out, int32_t(0));
+        append(out, int32_t(0));
+        append(out, int32_t(w * h * 3 * sizeof(uint16_t)));
+        for (uint32_t y = y0; y < y0 + h; y++) {
+            for (uint32_t c : { 2u, 1u, 0u }) {
+                for (uint32_t x = x0; x < x0 + w; x++) {
+                    append(out, getBits(filament::math::half(exrTexel(x, y, c))));
+                }
+            }
+        }
+    }
+    return out;
+}
+
+TEST_F(ImageIOTest, ExrScanlineRows) { // NOLINT
+    const LinearImage reference = createExrReference(29, 37);
+    for (const char* compression : { "RAW", "ZIP", "PIZ" }) {
+        std::ostringstream stream;
+        ASSERT_TRUE(ImageEncoder::encode(stream, ImageEncoder::Format::EXR, reference,
+                compression, "scanline.exr"));
+        const string name = string("scanline_") + compression + ".exr";
+        const string data = stream.str();
+        {
+            SCOPED_TRACE(name);
+            expectSameImage(decode(data, name), reference);
+        }
+        checkDecodeRows(data, name, reference);
+    }
+}
+
+TEST_F(ImageIOTest, ExrTiledRows) { // NOLINT
+    // The image size is not a multiple of the tile size, so the last row and column of tiles
+    // are partial.
+    const LinearImage reference = createExrReference(19, 13);
+    const string data = createTiledExr(19, 13, 8, 4);
+    {
+        SCOPED_TRACE("tiled.exr");
+        expectSameImage(decode(data, "tiled.exr"), reference);
+    }
+    checkDecodeRows(data, "tiled.exr", reference);
+}
+
+// PNG ---------------------------------------------------------------------------------------------
+
+TEST_F(ImageIOTest, PngRows) { // NOLINT
+    // Formats without a streaming decoder are decoded in full and handed out in strips.
+    LinearImage source(21, 17, 3);
+    for (uint32_t y = 0; y < source.getHeight(); y++) {
+        for (uint32_t x = 0; x < source.getWidth(); x++) {
+            for (uint32_t c = 0; c < 3; c++) {
+                source.getPixelRef(x, y)[c] = float((x * 11 + y * 7 + c * 50) % 256) / 255.0f;
+            }
+        }
+    }
+    std::ostringstream stream;
+    ASSERT_TRUE(ImageEncoder::encode(stream, ImageEncoder::Format::PNG_LINEAR, source, "",
+            "linear.png"));
+    const string data = stream.str();
+    checkDecodeRows(data, "linear.png", decode(data, "linear.png"));
+}
+
+// Basis ------------------------------------------------------------------------------------------
+
+// Creates an encoder for a small RGBA image and all its miplevels.
+static BasisEncoder* createEncoder(uint32_t seed, BasisEncoder::JobPool* pool) {
+    LinearImage source(32, 24, 4);
+    for (uint32_t y = 0; y < source.getHeight(); y++) {
+        for (uint32_t x = 0; x < source.getWidth(); x++) {
+            for (uint32_t c = 0; c < 4; c++) {
+                source.getPixelRef(x, y)[c] = float((x * 13 + y * 5 + c * 60 + seed * 37) % 256) /
+                        255.0f;
+            }
+        }
+    }
+    const uint32_t count = getMipmapCount(source);
+    vector<LinearImage> miplevels(count);
+    generateMipmaps(source, Filter::BOX, miplevels.data(), count);
+
+    BasisEncoder::Builder builder(count + 1, 1);
+    builder.intermediateFormat(BasisEncoder::IntermediateFormat::UASTC)
+            .effort(BasisEncoder::Effort::FASTEST)
+            .linear(true)
+            .quiet(true)
+            .jobPool(pool)
+            .miplevel(0, 0, source);
+    for (uint32_t i = 0; i < count; i++) {
+        builder.miplevel(i + 1, 0, miplevels[i]);
+    }
+    return builder.build();
+}
+
+TEST_F(ImageIOTest, BasisEncodeBatch) { // NOLINT
+    // Images encoded concurrently on a shared pool are identical to the ones encoded one by one.
+    constexpr uint32_t COUNT = 5;
+    BasisEncoder::JobPool pool(4);
+    vector<BasisEncoder*> batch;
+    vector<BasisEncoder*> single;
+    for (uint32_t i = 0; i < COUNT; i++) {
+        batch.push_back(createEncoder(i, &pool));
+        single.push_back(createEncoder(i, nullptr));
+        ASSERT_NE(batch.back(), nullptr);
+        ASSERT_NE(single.back(), nullptr);
+    }
+
+    EXPECT_TRUE(BasisEncoder::encodeBatch(batch.data(), batch.size(), 3));
+
+    const uint8_t ktx2Magic[] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB };
+    for (uint32_t i = 0; i < COUNT; i++) {
+        EXPECT_TRUE(single[i]->encode());
+        ASSERT_GT(batch[i]->getKtx2ByteCount(), sizeof(ktx2Magic));
+        EXPECT_EQ(memcmp(batch[i]->getKtx2Data(), ktx2Magic, sizeof(ktx2Magic)), 0);
+        ASSERT_EQ(batch[i]->getKtx2ByteCount(), single[i]->getKtx2ByteCount());
+        EXPECT_EQ(memcmp(batch[i]->getKtx2Data(), single[i]->getKtx2Data(),
+                batch[i]->getKtx2ByteCount()), 0);
+        if (i > 0) {
+            // each image has its own content
+            EXPECT_TRUE(batch[i]->getKtx2ByteCount() != batch[i - 1]->getKtx2ByteCount() ||
+                    memcmp(batch[i]->getKtx2Data(), batch[i - 1]->getKtx2Data(),
+                            batch[i]->getKtx2ByteCount()) != 0);
+        }
+    }
+
+    // an empty batch succeeds
+    EXPECT_TRUE(BasisEncoder::encodeBatch(nullptr, 0));
+
+    for (uint32_t i = 0; i < COUNT; i++) {
+        delete batch[i];
+        delete single[i];
+    }
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
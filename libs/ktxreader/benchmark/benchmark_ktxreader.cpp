@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ktxreader/Ktx2Reader.h>
+
+#include <filament/Engine.h>
+#include <filament/Texture.h>
+
+#include <image/ImageSampler.h>
+#include <image/LinearImage.h>
+
+#include <imageio/BasisEncoder.h>
+
+#include <utils/JobSystem.h>
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+using namespace filament;
+using namespace image;
+
+using ktxreader::Ktx2Reader;
+
+static constexpr uint32_t IMAGE_SIZE = 1024;
+
+// Basis encoding is far slower than transcoding, so each KTX2 blob is created only once.
+static std::vector<uint8_t> const& getKtx2Data(BasisEncoder::IntermediateFormat format) {
+    static std::vector<uint8_t> blobs[2];
+    std::vector<uint8_t>& blob = blobs[format == BasisEncoder::IntermediateFormat::UASTC];
+    if (!blob.empty()) {
+        return blob;
+    }
+
+    // A smooth gradient with some noise on top, which is representative of real textures and
+    // keeps the encoder from collapsing the image into a handful of blocks.
+    LinearImage source(IMAGE_SIZE, IMAGE_SIZE, 4);
+    float* texels = source.getPixelRef();
+    uint32_t seed = 1;
+    for (uint32_t y = 0; y < IMAGE_SIZE; y++) {
+        for (uint32_t x = 0; x < IMAGE_SIZE; x++, texels += 4) {
+            seed = seed * 1664525u + 1013904223u;
+            const float noise = float(seed >> 8u) / float(1u << 24u);
+            texels[0] = float(x) / IMAGE_SIZE;
+            texels[1] = float(y) / IMAGE_SIZE;
+            texels[2] = 0.75f * noise;
+            texels[3] = 1.0f;
+        }
+    }
+
+    const uint32_t mipCount = getMipmapCount(source);
+    std::vector<LinearImage> miplevels(mipCount);
+    generateMipmaps(source, Filter::BOX, miplevels.data(), mipCount);
+
+    BasisEncoder::Builder builder(mipCount + 1, 1);
+    builder.intermediateFormat(format)
+            .linear(false)
+            .quiet(true)
+            .effort(BasisEncoder::Effort::FASTEST)
+            .miplevel(0, 0, source);
+    for (uint32_t level = 0; level < mipCount; level++) {
+        builder.miplevel(level + 1, 0, miplevels[level]);
+    }
+
+    BasisEncoder* encoder = builder.build();
+    if (encoder && encoder->encode()) {
+        blob.assign(encoder->getKtx2Data(), encoder->getKtx2Data() + encoder->getKtx2ByteCount());
+    }
+    delete encoder;
+    return blob;
+}
+
+// Arguments: intermediate format (0 = ETC1S, 1 = UASTC), target format (0 = BC3, 1 = ETC2,
+// 2 = RGBA8), parallel (0 = single thread, 1 = one job per miplevel).
+static void BM_transcode(benchmark::State& state) {
+    static const Texture::InternalFormat targets[] = {
+            Texture::InternalFormat::DXT5_SRGBA,
+            Texture::InternalFormat::ETC2_EAC_SRGBA8,
+            Texture::InternalFormat::SRGB8_A8,
+    };
+
+    const auto format = state.range(0) ?
+            BasisEncoder::IntermediateFormat::UASTC : BasisEncoder::IntermediateFormat::ETC1S;
+    const Texture::InternalFormat target = targets[state.range(1)];
+    const bool parallel = state.range(2) != 0;
+
+    std::vector<uint8_t> const& blob = getKtx2Data(format);
+    if (blob.empty()) {
+        state.SkipWithError("Unable to encode the source image.");
+        return;
+    }
+
+    // The NOOP backend accepts every format and discards uploads, so this measures transcoding.
+    Engine* engine = Engine::create(Engine::Backend::NOOP);
+    utils::JobSystem& js = engine->getJobSystem();
+    {
+        Ktx2Reader reader(*engine, true);
+        reader.requestFormat(target);
+        for (auto _ : state) {
+            Ktx2Reader::Async* async = reader.asyncCreate(blob.data(), blob.size(),
+                    Ktx2Reader::TransferFunction::sRGB);
+            if (!async) {
+                state.SkipWithError("Unable to create the texture.");
+                break;
+            }
+            const Ktx2Reader::Result result = parallel ?
+                    async->doTranscoding(js) : async->doTranscoding();
+            benchmark::DoNotOptimize(result);
+            async->uploadImages();
+            Texture* texture = async->getTexture();
+            reader.asyncDestroy(&async);
+            engine->destroy(texture);
+        }
+    }
+    Engine::destroy(&engine);
+
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(blob.size()));
+}
+
+BENCHMARK(BM_transcode)
+        ->ArgNames({ "uastc", "target", "parallel" })
+        ->Apply([](benchmark::internal::Benchmark* b) {
+            for (int uastc = 0; uastc < 2; uastc++) {
+                for (int target = 0; target < 3; target++) {
+                    for (int parallel = 0; parallel < 2; parallel++) {
+                        b->Args({ uastc, target, parallel });
+                    }
+                }
+            }
+        })
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
@@ -32,6 +32,10 @@ namespace basist {
     class ktx2_transcoder;
 }
 
+namespace utils {
+    class JobSystem;
+}
+
 namespace ktxreader {
 
 class Ktx2Reader {
@@ -90,6 +94,9 @@ class Ktx2Reader {
          *   1) It is checked against the transfer function that was specified as metadata
          *      in the KTX2 blob. If they do not match, this method fails.
          *   2) It is used as a filter when determining the final internal format.
+         *
+         * Miplevels are transcoded concurrently using the engine's JobSystem, which requires this
+         * to be called from the thread that the Engine was created on.
          */
         Texture* load(const void* data, size_t size, TransferFunction transfer);
 
@@ -117,29 +124,63 @@ class Ktx2Reader {
              * Retrieves the Texture object.
              *
              * The texture is available immediately, but does not have its miplevels ready until
-             * after doTranscoding() and the subsequent uploadImages() have been completed. The
-             * caller has ownership over this texture and is responsible for freeing it after all
-             * miplevels have been uploaded.
+             * after doTranscoding() and the subsequent uploadImages() have been completed. It can
+             * be sampled as soon as getUploadedLevelCount() is not zero. The caller has ownership
+             * over this texture and is responsible for freeing it after all miplevels have been
+             * uploaded.
              */
             Texture* getTexture() const noexcept;
 
             /**
              * Loads all mipmaps from the KTX2 file and transcodes them to the resolved format.
              *
-             * This does not return until all mipmaps have been transcoded. This is typically
-             * called from a background thread.
+             * Miplevels are transcoded from the smallest to the largest, which lets uploadImages()
+             * start uploading before the largest levels are done. This does not return until all
+             * mipmaps have been transcoded. This is typically called from a background thread.
              */
             Result doTranscoding();
 
+            /**
+             * Same as doTranscoding() but each miplevel is transcoded in its own job.
+             *
+             * The calling thread must be either a worker of the given JobSystem or a thread that
+             * has been adopted by it. This does not return until all mipmaps have been transcoded.
+             */
+            Result doTranscoding(utils::JobSystem& js);
+
+            /**
+             * Same as doTranscoding(js) but stops at the given miplevel.
+             *
+             * Only the levels in [firstLevel, levelCount) that have not been transcoded by a
+             * previous call are transcoded, which allows the smallest levels of several textures
+             * to be transcoded before the larger ones. Transcoding can be resumed later with a
+             * smaller firstLevel, but never concurrently with another call to doTranscoding().
+             */
+            Result doTranscoding(utils::JobSystem& js, uint32_t firstLevel);
+
             /**
              * Uploads pending mipmaps to the texture.
              *
+             * Levels are uploaded from the smallest to the largest, and a level is uploaded only
+             * once all smaller levels have been uploaded. Calling this periodically while
+             * transcoding is in progress spreads the uploads over several calls. Sampling is
+             * restricted to the levels that have been uploaded with Texture::setMinMaxLevels(),
+             * and the range is widened by every call that uploads new levels.
+             *
              * This can safely be called while doTranscoding() is still working in another thread.
              * Since this calls Texture::setImage(), it should be called from the foreground thread;
              * see "Thread safety" in the documentation for filament::Engine.
              */
             void uploadImages();
 
+            /**
+             * Returns the number of miplevels that have been uploaded by uploadImages().
+             *
+             * These are always the smallest levels of the texture. Once this is not zero, the
+             * texture can be used, since sampling is restricted to the uploaded levels.
+             */
+            size_t getUploadedLevelCount() const noexcept;
+
         protected:
             Async() noexcept = default;
             ~Async() = default;
@@ -19,6 +19,7 @@
 #include <filament/Engine.h>
 #include <filament/Texture.h>
 
+#include <utils/JobSystem.h>
 #include <utils/Log.h>
 
 #include <atomic>
@@ -165,15 +166,31 @@ namespace ktxreader {
 class FAsync : public Async {
 public:
     FAsync(Texture* texture, Engine& engine, ktx2_transcoder* transcoder, Buffer&& buf) :
-            mTexture(texture), mEngine(engine), mTranscoder(transcoder),
-            mSourceBuffer(std::move(buf)) {}
+            mPendingLevelCount(transcoder->get_levels()),
+            mTranscodedLevel(transcoder->get_levels()), mTexture(texture), mEngine(engine),
+            mTranscoder(transcoder), mSourceBuffer(std::move(buf)) {}
+    ~FAsync();
     Texture* getTexture() const noexcept { return mTexture; }
+    size_t getUploadedLevelCount() const noexcept {
+        return mTranscoder->get_levels() - mPendingLevelCount;
+    }
     Result doTranscoding();
+    Result doTranscoding(utils::JobSystem& js, uint32_t firstLevel);
     void uploadImages();
 
 private:
     using TranscoderResult = std::atomic<Texture::PixelBufferDescriptor*>;
 
+    Result transcodeLevel(uint32_t levelIndex);
+
+    // Number of miplevels that have not been uploaded yet. Levels are uploaded from the smallest
+    // to the largest, so the uploaded range is always [mPendingLevelCount, levelCount).
+    uint32_t mPendingLevelCount;
+
+    // Smallest index of the levels that have been transcoded. Levels are transcoded from the
+    // smallest to the largest, so the transcoded range is always [mTranscodedLevel, levelCount).
+    uint32_t mTranscodedLevel;
+
     // After each level is transcoded, the results are stashed in the following array until the
     // foreground thread calls uploadImages(). Each slot in the array corresponds to a single
     // miplevel in the texture.
@@ -240,51 +257,123 @@ Texture* Ktx2Reader::load(const void* data, size_t size, TransferFunction transf
         return nullptr;
     }
 
-    ktx2_transcoder_state basisThreadState;
-    basisThreadState.clear();
+    // Each miplevel is transcoded in its own job. The BasisU transcoder is thread-safe at level
+    // granularity as long as each thread has its own transcoder state.
+    using namespace utils;
+    const uint32_t levelCount = mTranscoder->get_levels();
+    const Texture::InternalFormat format = texture->getFormat();
+    Texture::PixelBufferDescriptor* pbds[KTX2_MAX_SUPPORTED_LEVEL_COUNT] = {};
+    Result results[KTX2_MAX_SUPPORTED_LEVEL_COUNT] = {};
+
+    JobSystem& js = mEngine.getJobSystem();
+    JobSystem::Job* parent = js.createJob();
+    for (uint32_t levelIndex = levelCount; levelIndex-- > 0;) {
+        JobSystem::Job* job = jobs::createJob(js, parent,
+                [transcoder = mTranscoder, format, levelIndex, &pbds, &results]() {
+                    ktx2_transcoder_state basisThreadState;
+                    basisThreadState.clear();
+                    results[levelIndex] = transcodeImageLevel(*transcoder, basisThreadState,
+                            format, levelIndex, &pbds[levelIndex]);
+                });
+        js.run(job);
+    }
+    js.runAndWait(parent);
 
-    for (uint32_t levelIndex = 0, n = mTranscoder->get_levels(); levelIndex < n; levelIndex++) {
-        Texture::PixelBufferDescriptor* pbd;
-        Result result = transcodeImageLevel(*mTranscoder, basisThreadState, texture->getFormat(),
-                levelIndex, &pbd);
-        if (UTILS_UNLIKELY(result != Result::SUCCESS)) {
+    for (uint32_t levelIndex = 0; levelIndex < levelCount; levelIndex++) {
+        if (UTILS_UNLIKELY(results[levelIndex] != Result::SUCCESS)) {
+            for (Texture::PixelBufferDescriptor* pbd : pbds) {
+                delete pbd;
+            }
             mEngine.destroy(texture);
             if (!mQuiet) {
                 utils::slog.e << "Failed to transcode level " << levelIndex << utils::io::endl;
             }
             return nullptr;
         }
-        texture->setImage(mEngine, levelIndex, std::move(*pbd));
+    }
+
+    for (uint32_t levelIndex = 0; levelIndex < levelCount; levelIndex++) {
+        texture->setImage(mEngine, levelIndex, std::move(*pbds[levelIndex]));
+        delete pbds[levelIndex];
     }
     return texture;
 }
 
-Result FAsync::doTranscoding() {
+FAsync::~FAsync() {
+    // Release the levels that were transcoded but never uploaded.
+    for (TranscoderResult& level : mTranscoderResults) {
+        delete level.load();
+    }
+}
+
+Result FAsync::transcodeLevel(uint32_t levelIndex) {
     ktx2_transcoder_state basisThreadState;
     basisThreadState.clear();
-    for (uint32_t levelIndex = 0, n = mTranscoder->get_levels(); levelIndex < n; levelIndex++) {
-        Texture::PixelBufferDescriptor* pbd;
-        Result result = transcodeImageLevel(*mTranscoder, basisThreadState, mTexture->getFormat(),
-                levelIndex, &pbd);
+    Texture::PixelBufferDescriptor* pbd = nullptr;
+    Result result = transcodeImageLevel(*mTranscoder, basisThreadState, mTexture->getFormat(),
+            levelIndex, &pbd);
+    if (UTILS_LIKELY(result == Result::SUCCESS)) {
+        mTranscoderResults[levelIndex].store(pbd);
+    }
+    return result;
+}
+
+Result FAsync::doTranscoding() {
+    // Go from the smallest level to the largest so that uploadImages() can start uploading
+    // before the largest levels are done.
+    for (uint32_t levelIndex = mTranscodedLevel; levelIndex-- > 0;) {
+        Result result = transcodeLevel(levelIndex);
         if (UTILS_UNLIKELY(result != Result::SUCCESS)) {
             return result;
         }
-        mTranscoderResults[levelIndex].store(pbd);
+        mTranscodedLevel = levelIndex;
     }
     return Result::SUCCESS;
 }
 
+Result FAsync::doTranscoding(utils::JobSystem& js, uint32_t firstLevel) {
+    using namespace utils;
+    std::atomic<Result> status = { Result::SUCCESS };
+    if (firstLevel >= mTranscodedLevel) {
+        return Result::SUCCESS;
+    }
+
+    // Jobs are queued smallest level first; since the largest levels dominate the cost, the
+    // smaller ones are typically ready for upload long before the whole chain is.
+    JobSystem::Job* parent = js.createJob();
+    for (uint32_t levelIndex = mTranscodedLevel; levelIndex-- > firstLevel;) {
+        JobSystem::Job* job = jobs::createJob(js, parent, [this, levelIndex, &status]() {
+            Result result = transcodeLevel(levelIndex);
+            if (UTILS_UNLIKELY(result != Result::SUCCESS)) {
+                status.store(result, std::memory_order_relaxed);
+            }
+        });
+        js.run(job);
+    }
+    js.runAndWait(parent);
+    mTranscodedLevel = firstLevel;
+    return status.load(std::memory_order_relaxed);
+}
+
 void FAsync::uploadImages() {
-    size_t levelIndex = 0;
-    UTILS_NOUNROLL
-    for (TranscoderResult& level : mTranscoderResults) {
-        Texture::PixelBufferDescriptor* pbd = level.load();
-        if (pbd) {
-            level.store(nullptr);
-            mTexture->setImage(mEngine, levelIndex, std::move(*pbd));
-            delete pbd;
+    // Only upload a level once all smaller levels are in, so that the range of valid levels in
+    // the texture never has holes.
+    const uint32_t previousPendingLevelCount = mPendingLevelCount;
+    while (mPendingLevelCount > 0) {
+        const uint32_t levelIndex = mPendingLevelCount - 1;
+        Texture::PixelBufferDescriptor* pbd = mTranscoderResults[levelIndex].exchange(nullptr);
+        if (!pbd) {
+            break;
         }
-        ++levelIndex;
+        mTexture->setImage(mEngine, levelIndex, std::move(*pbd));
+        delete pbd;
+        mPendingLevelCount = levelIndex;
+    }
+
+    // Widen the range of levels that can be sampled to include the new ones.
+    if (mPendingLevelCount != previousPendingLevelCount) {
+        const uint32_t levelCount = mTranscoder->get_levels();
+        mTexture->setMinMaxLevels(mEngine, uint8_t(mPendingLevelCount), uint8_t(levelCount - 1));
     }
 }
 
@@ -308,7 +397,7 @@ Async* Ktx2Reader::asyncCreate(const void* data, size_t size, TransferFunction t
 }
 
 void Ktx2Reader::asyncDestroy(Async** async) {
-    delete *async;
+    delete static_cast<FAsync*>(*async);
     *async = nullptr;
 }
 
@@ -419,8 +508,20 @@ Result Async::doTranscoding() {
     return static_cast<FAsync*>(this)->doTranscoding();
 }
 
+Result Async::doTranscoding(utils::JobSystem& js) {
+    return static_cast<FAsync*>(this)->doTranscoding(js, 0);
+}
+
+Result Async::doTranscoding(utils::JobSystem& js, uint32_t firstLevel) {
+    return static_cast<FAsync*>(this)->doTranscoding(js, firstLevel);
+}
+
 void Async::uploadImages() {
     return static_cast<FAsync*>(this)->uploadImages();
 }
 
+size_t Async::getUploadedLevelCount() const noexcept {
+    return static_cast<FAsync const*>(this)->getUploadedLevelCount();
+}
+
 } // namespace ktxreader
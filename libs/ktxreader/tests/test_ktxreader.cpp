@@ -21,6 +21,7 @@
 #include <filament/Texture.h>
 
 #include <gtest/gtest.h>
+#include <utils/JobSystem.h>
 #include <utils/Path.h>
 
 #include <fstream>
@@ -90,6 +91,45 @@ TEST_F(KtxReaderTest, Ktx2) {
     engine->destroy(tex);
 }
 
+TEST_F(KtxReaderTest, Ktx2Async) {
+    using Result = ktxreader::Ktx2Reader::Result;
+    const utils::Path parent = Path::getCurrentExecutable().getParent();
+    const auto contents = readFile(parent + "color_grid_mips_etc1s.ktx2");
+    ASSERT_EQ(contents.size(), 10193);
+
+    ktxreader::Ktx2Reader reader(*engine);
+    reader.requestFormat(Texture::InternalFormat::SRGB8_A8);
+
+    ktxreader::Ktx2Reader::Async* async = reader.asyncCreate(contents.data(), contents.size(),
+            ktxreader::Ktx2Reader::TransferFunction::sRGB);
+    ASSERT_NE(async, nullptr);
+
+    Texture* tex = async->getTexture();
+    ASSERT_EQ(tex->getWidth(), 256);
+    ASSERT_EQ(tex->getLevels(), 9);
+    EXPECT_EQ(async->getUploadedLevelCount(), 0);
+
+    // Transcode and upload the three smallest levels only, which is enough to use the texture.
+    utils::JobSystem& js = engine->getJobSystem();
+    ASSERT_EQ(async->doTranscoding(js, 6), Result::SUCCESS);
+    async->uploadImages();
+    EXPECT_EQ(async->getUploadedLevelCount(), 3);
+
+    // Transcoding the same levels again is a no-op.
+    ASSERT_EQ(async->doTranscoding(js, 6), Result::SUCCESS);
+    async->uploadImages();
+    EXPECT_EQ(async->getUploadedLevelCount(), 3);
+
+    // Resuming transcodes the remaining levels.
+    ASSERT_EQ(async->doTranscoding(js), Result::SUCCESS);
+    async->uploadImages();
+    EXPECT_EQ(async->getUploadedLevelCount(), 9);
+
+    reader.asyncDestroy(&async);
+    EXPECT_EQ(async, nullptr);
+    engine->destroy(tex);
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
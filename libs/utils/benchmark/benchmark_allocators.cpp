@@ -40,6 +40,23 @@ protected:
     utils::Arena<utils::ObjectPoolAllocator<Payload>, utils::Mutex> mPoolAllocatorUtilsMutex;
     utils::Arena<utils::ObjectPoolAllocator<Payload>, LockingPolicy::SpinLock> mPoolAllocatorSpinlock;
     utils::Arena<utils::ThreadSafeObjectPoolAllocator<Payload>, LockingPolicy::NoLock> mPoolAllocatorAtomic;
+    utils::Arena<utils::ThreadCachedObjectPoolAllocator<Payload>, LockingPolicy::NoLock> mPoolAllocatorThreadCached;
+
+    // allocates then frees BATCH_SIZE objects, which is closer to how handles are used (e.g.
+    // when loading an asset) than an alloc() immediately followed by a free()
+    template<typename ARENA>
+    static void allocateBatch(ARENA& pool) noexcept {
+        Payload* p[BATCH_SIZE];
+        for (auto& item : p) {
+            item = pool.template alloc<Payload>(1);
+        }
+        benchmark::DoNotOptimize(p);
+        for (auto& item : p) {
+            pool.free(item);
+        }
+    }
+
+    static constexpr size_t BATCH_SIZE = 64;
 };
 
 static constexpr size_t POOL_ITEM_COUNT = 4096;
@@ -49,7 +66,8 @@ Allocators::Allocators()
           mPoolAllocatorStdMutex("std::mutex", POOL_ITEM_COUNT * sizeof(Payload)),
           mPoolAllocatorUtilsMutex("utils::Mutex", POOL_ITEM_COUNT * sizeof(Payload)),
           mPoolAllocatorSpinlock("spinlock", POOL_ITEM_COUNT * sizeof(Payload)),
-          mPoolAllocatorAtomic("atomic", POOL_ITEM_COUNT * sizeof(Payload)) {
+          mPoolAllocatorAtomic("atomic", POOL_ITEM_COUNT * sizeof(Payload)),
+          mPoolAllocatorThreadCached("thread-cached", POOL_ITEM_COUNT * sizeof(Payload)) {
 }
 
 Allocators::~Allocators() = default;
@@ -99,6 +117,55 @@ BENCHMARK_DEFINE_F(Allocators, poolAllocator_atomic)(benchmark::State& state) {
     }
 }
 
+BENCHMARK_DEFINE_F(Allocators, poolAllocator_thread_cached)(benchmark::State& state) {
+    auto& pool = mPoolAllocatorThreadCached;
+    PerformanceCounters pc(state);
+    for (auto _ : state) {
+        Payload* p = pool.alloc<Payload>(1);
+        pool.free(p);
+    }
+}
+
+BENCHMARK_DEFINE_F(Allocators, poolAllocator_spinlock_batch)(benchmark::State& state) {
+    auto& pool = mPoolAllocatorSpinlock;
+    PerformanceCounters pc(state);
+    for (auto _ : state) {
+        allocateBatch(pool);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations() * BATCH_SIZE));
+}
+
+BENCHMARK_DEFINE_F(Allocators, poolAllocator_atomic_batch)(benchmark::State& state) {
+    auto& pool = mPoolAllocatorAtomic;
+    PerformanceCounters pc(state);
+    for (auto _ : state) {
+        allocateBatch(pool);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations() * BATCH_SIZE));
+}
+
+BENCHMARK_DEFINE_F(Allocators, poolAllocator_thread_cached_batch)(benchmark::State& state) {
+    auto& pool = mPoolAllocatorThreadCached;
+    PerformanceCounters pc(state);
+    for (auto _ : state) {
+        allocateBatch(pool);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations() * BATCH_SIZE));
+}
+
+// same as above, but using the batch API
+BENCHMARK_DEFINE_F(Allocators, poolAllocator_thread_cached_batch_api)(benchmark::State& state) {
+    auto& pool = mPoolAllocatorThreadCached;
+    PerformanceCounters pc(state);
+    for (auto _ : state) {
+        void* p[BATCH_SIZE];
+        size_t const n = pool.alloc(p, BATCH_SIZE, sizeof(Payload), alignof(Payload));
+        benchmark::DoNotOptimize(p);
+        pool.free(p, n, sizeof(Payload));
+    }
+    state.SetItemsProcessed(int64_t(state.iterations() * BATCH_SIZE));
+}
+
 BENCHMARK_REGISTER_F(Allocators, poolAllocator_std_mutex)
         ->ThreadRange(1, 4)
         ->Threads(benchmark::CPUInfo::Get().num_cpus * 2);
@@ -114,3 +181,23 @@ BENCHMARK_REGISTER_F(Allocators, poolAllocator_spinlock)
 BENCHMARK_REGISTER_F(Allocators, poolAllocator_atomic)
         ->ThreadRange(1, 4)
         ->Threads(benchmark::CPUInfo::Get().num_cpus * 2);
+
+BENCHMARK_REGISTER_F(Allocators, poolAllocator_thread_cached)
+        ->ThreadRange(1, 4)
+        ->Threads(benchmark::CPUInfo::Get().num_cpus * 2);
+
+BENCHMARK_REGISTER_F(Allocators, poolAllocator_spinlock_batch)
+        ->ThreadRange(1, 4)
+        ->Threads(benchmark::CPUInfo::Get().num_cpus * 2);
+
+BENCHMARK_REGISTER_F(Allocators, poolAllocator_atomic_batch)
+        ->ThreadRange(1, 4)
+        ->Threads(benchmark::CPUInfo::Get().num_cpus * 2);
+
+BENCHMARK_REGISTER_F(Allocators, poolAllocator_thread_cached_batch)
+        ->ThreadRange(1, 4)
+        ->Threads(benchmark::CPUInfo::Get().num_cpus * 2);
+
+BENCHMARK_REGISTER_F(Allocators, poolAllocator_thread_cached_batch_api)
+        ->ThreadRange(1, 4)
+        ->Threads(benchmark::CPUInfo::Get().num_cpus * 2);
@@ -18,6 +18,7 @@
 #define TNT_UTILS_ALLOCATOR_H
 
 
+#include <utils/architecture.h>
 #include <utils/compiler.h>
 #include <utils/debug.h>
 #include <utils/memalign.h>
@@ -318,6 +319,89 @@ private:
     Node* mStorage = nullptr;
 };
 
+/*
+ * ThreadCachedFreeList is a thread-safe free list which keeps a small cache of elements for each
+ * thread. Most pop() and push() only touch the calling thread's cache and don't synchronize at
+ * all, the cache is refilled from (or spilled to) a shared free list BATCH_SIZE elements at a time,
+ * which amortizes the cost of the lock.
+ *
+ * Only MAX_THREAD_COUNT threads can have a cache at a given time, other threads use the shared
+ * free list directly. Elements cached by a thread are not available to other threads, so up to
+ * MAX_THREAD_COUNT * CACHE_CAPACITY elements may appear to be in use when they are not.
+ */
+class ThreadCachedFreeList {
+public:
+    static constexpr size_t MAX_THREAD_COUNT = 16;
+    static constexpr size_t CACHE_CAPACITY = 32;
+    static constexpr size_t BATCH_SIZE = CACHE_CAPACITY / 2;
+
+    ThreadCachedFreeList() noexcept = default;
+    ThreadCachedFreeList(void* begin, void* end,
+            size_t elementSize, size_t alignment, size_t extra) noexcept
+            : mFreeList(begin, end, elementSize, alignment, extra) {
+    }
+    ThreadCachedFreeList(const ThreadCachedFreeList& rhs) = delete;
+    ThreadCachedFreeList& operator=(const ThreadCachedFreeList& rhs) = delete;
+
+    void* pop() noexcept {
+        Cache* const cache = getCache();
+        if (UTILS_UNLIKELY(!cache)) {
+            std::lock_guard<SpinLock> guard(mLock);
+            return mFreeList.pop();
+        }
+        if (UTILS_UNLIKELY(!cache->count)) {
+            cache->count = uint32_t(popShared(cache->elements, BATCH_SIZE));
+            if (UTILS_UNLIKELY(!cache->count)) {
+                return nullptr;
+            }
+        }
+        return cache->elements[--cache->count];
+    }
+
+    void push(void* p) noexcept {
+        assert(p);
+        Cache* const cache = getCache();
+        if (UTILS_UNLIKELY(!cache)) {
+            std::lock_guard<SpinLock> guard(mLock);
+            mFreeList.push(p);
+            return;
+        }
+        if (UTILS_UNLIKELY(cache->count == CACHE_CAPACITY)) {
+            cache->count -= BATCH_SIZE;
+            pushShared(cache->elements + cache->count, BATCH_SIZE);
+        }
+        cache->elements[cache->count++] = p;
+    }
+
+    // pops up to count elements at once and returns how many were popped
+    size_t pop(void** elements, size_t count) noexcept;
+
+    // pushes count elements at once
+    void push(void* const* elements, size_t count) noexcept;
+
+private:
+    struct alignas(CACHELINE_SIZE) Cache {
+        uint32_t count = 0;
+        void* elements[CACHE_CAPACITY];
+    };
+
+    Cache* getCache() noexcept {
+        size_t const index = getThreadIndex();
+        return UTILS_LIKELY(index < MAX_THREAD_COUNT) ? &mCaches[index] : nullptr;
+    }
+
+    // Returns an index unique among the threads currently alive, or MAX_THREAD_COUNT if they're
+    // all taken. Indices are recycled when threads exit, along with the content of the caches.
+    static size_t getThreadIndex() noexcept;
+
+    size_t popShared(void** elements, size_t count) noexcept;
+    void pushShared(void* const* elements, size_t count) noexcept;
+
+    Cache mCaches[MAX_THREAD_COUNT];
+    alignas(CACHELINE_SIZE) SpinLock mLock;
+    FreeList mFreeList;
+};
+
 // ------------------------------------------------------------------------------------------------
 
 template <
@@ -341,6 +425,20 @@ public:
         mFreeList.push(p);
     }
 
+    // Allocates up to count elements at once and returns how many were allocated.
+    // This requires a FREELIST which supports batches (e.g. ThreadCachedFreeList).
+    size_t alloc(void** elements, size_t count, size_t size = ELEMENT_SIZE,
+            size_t alignment = ALIGNMENT, size_t offset = OFFSET) noexcept {
+        assert(size <= ELEMENT_SIZE);
+        assert(alignment <= ALIGNMENT);
+        assert(offset == OFFSET);
+        return mFreeList.pop(elements, count);
+    }
+
+    void free(void* const* elements, size_t count, size_t = ELEMENT_SIZE) noexcept {
+        mFreeList.push(elements, count);
+    }
+
     constexpr size_t getSize() const noexcept { return ELEMENT_SIZE; }
 
     PoolAllocator(void* begin, void* end) noexcept
@@ -383,6 +481,10 @@ template <typename T, size_t OFFSET = 0>
 using ThreadSafeObjectPoolAllocator = PoolAllocator<sizeof(T),
         UTILS_MAX(alignof(FreeList), alignof(T)), OFFSET, AtomicFreeList>;
 
+template <typename T, size_t OFFSET = 0>
+using ThreadCachedObjectPoolAllocator = PoolAllocator<sizeof(T),
+        UTILS_MAX(alignof(FreeList), alignof(T)), OFFSET, ThreadCachedFreeList>;
+
 
 // ------------------------------------------------------------------------------------------------
 // Areas
@@ -606,6 +708,18 @@ public:
         return (T*)alloc(count * sizeof(T), alignment, extra);
     }
 
+    // allocate up to count blocks of the same size at once, returns how many were allocated
+    // (only with allocators supporting batches)
+    size_t alloc(void** p, size_t count, size_t size,
+            size_t alignment = alignof(std::max_align_t), size_t extra = 0) noexcept {
+        std::lock_guard<LockingPolicy> guard(mLock);
+        size_t const n = mAllocator.alloc(p, count, size, alignment, extra);
+        for (size_t i = 0; i < n; i++) {
+            mListener.onAlloc(p[i], size, alignment, extra);
+        }
+        return n;
+    }
+
     // return memory pointed by p to the arena
     // (actual behaviour may depend on allocator provided)
     void free(void* p) noexcept {
@@ -625,6 +739,15 @@ public:
         }
     }
 
+    // return count blocks of the same size at once (only with allocators supporting batches)
+    void free(void* const* p, size_t count, size_t size) noexcept {
+        std::lock_guard<LockingPolicy> guard(mLock);
+        for (size_t i = 0; i < count; i++) {
+            mListener.onFree(p[i], size);
+        }
+        mAllocator.free(p, count, size);
+    }
+
     // some allocators don't have a free() call, but a single reset() or rewind() instead
     void reset() noexcept {
         std::lock_guard<LockingPolicy> guard(mLock);
@@ -19,6 +19,7 @@
 #include <utils/Log.h>
 
 #include <algorithm>
+#include <atomic>
 
 #include <stdlib.h>
 #include <assert.h>
@@ -126,6 +127,101 @@ AtomicFreeList::AtomicFreeList(void* begin, void* end,
     mHead.store({ int32_t(head - mStorage), 0 });
 }
 
+// ------------------------------------------------------------------------------------------------
+// ThreadCachedFreeList
+// ------------------------------------------------------------------------------------------------
+
+namespace {
+
+// bit i is set while a thread owns the cache index i
+std::atomic<uint32_t> sThreadCacheIndices{ 0 };
+
+static_assert(ThreadCachedFreeList::MAX_THREAD_COUNT <= 32);
+
+struct ThreadCacheIndex {
+    size_t index = ThreadCachedFreeList::MAX_THREAD_COUNT;
+
+    ThreadCacheIndex() noexcept {
+        constexpr size_t count = ThreadCachedFreeList::MAX_THREAD_COUNT;
+        uint32_t used = sThreadCacheIndices.load(std::memory_order_relaxed);
+        while (true) {
+            size_t i = 0;
+            while (i < count && (used & (1u << i))) {
+                i++;
+            }
+            if (i == count) {
+                // all indices are taken, this thread won't have a cache
+                break;
+            }
+            // acquire pairs with the release in the destructor, so we see what the previous
+            // owner of this index left in the caches. On failure, used is updated and we retry.
+            if (sThreadCacheIndices.compare_exchange_weak(used, used | (1u << i),
+                    std::memory_order_acquire, std::memory_order_relaxed)) {
+                index = i;
+                break;
+            }
+        }
+    }
+
+    ~ThreadCacheIndex() noexcept {
+        if (index < ThreadCachedFreeList::MAX_THREAD_COUNT) {
+            sThreadCacheIndices.fetch_and(~(1u << index), std::memory_order_release);
+            // this thread could still free elements from another thread_local destructor
+            index = ThreadCachedFreeList::MAX_THREAD_COUNT;
+        }
+    }
+};
+
+} // anonymous namespace
+
+size_t ThreadCachedFreeList::getThreadIndex() noexcept {
+    static thread_local ThreadCacheIndex threadCacheIndex;
+    return threadCacheIndex.index;
+}
+
+size_t ThreadCachedFreeList::popShared(void** elements, size_t count) noexcept {
+    std::lock_guard<SpinLock> guard(mLock);
+    size_t i = 0;
+    for (void* p; i < count && (p = mFreeList.pop()); i++) {
+        elements[i] = p;
+    }
+    return i;
+}
+
+void ThreadCachedFreeList::pushShared(void* const* elements, size_t count) noexcept {
+    std::lock_guard<SpinLock> guard(mLock);
+    for (size_t i = 0; i < count; i++) {
+        mFreeList.push(elements[i]);
+    }
+}
+
+size_t ThreadCachedFreeList::pop(void** elements, size_t count) noexcept {
+    size_t n = 0;
+    Cache* const cache = getCache();
+    if (UTILS_LIKELY(cache)) {
+        n = std::min(count, size_t(cache->count));
+        cache->count -= uint32_t(n);
+        std::copy_n(cache->elements + cache->count, n, elements);
+    }
+    if (n < count) {
+        n += popShared(elements + n, count - n);
+    }
+    return n;
+}
+
+void ThreadCachedFreeList::push(void* const* elements, size_t count) noexcept {
+    size_t n = 0;
+    Cache* const cache = getCache();
+    if (UTILS_LIKELY(cache)) {
+        n = std::min(count, CACHE_CAPACITY - cache->count);
+        std::copy_n(elements, n, cache->elements + cache->count);
+        cache->count += uint32_t(n);
+    }
+    if (n < count) {
+        pushShared(elements + n, count - n);
+    }
+}
+
 // ------------------------------------------------------------------------------------------------
 
 void TrackingPolicy::HighWatermark::onAlloc(
@@ -17,6 +17,7 @@
 #include <algorithm>
 #include <bitset>
 #include <functional>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -153,6 +154,62 @@ TEST(AllocatorTest, PoolAllocator) {
     }
 }
 
+TEST(AllocatorTest, ThreadCachedPoolAllocator) {
+    constexpr size_t COUNT = 4096;
+    constexpr size_t THREAD_COUNT = 4;
+    std::vector<char> scratch(COUNT * 64 + 63);
+    PoolAllocator<64, 64, 0, ThreadCachedFreeList> pa(scratch.data(), scratch.data() + scratch.size());
+
+    // all the elements can be allocated, including the ones in this thread's cache
+    std::vector<void*> elements(COUNT);
+    EXPECT_EQ(COUNT, pa.alloc(elements.data(), COUNT));
+    EXPECT_EQ(nullptr, pa.alloc());
+    std::sort(elements.begin(), elements.end());
+    EXPECT_TRUE(std::adjacent_find(elements.begin(), elements.end()) == elements.end());
+    pa.free(elements.data(), COUNT);
+
+    // elements are never handed out twice, even when freed by another thread
+    std::vector<std::thread> threads;
+    std::vector<std::vector<void*>> allocated(THREAD_COUNT);
+    for (size_t t = 0; t < THREAD_COUNT; t++) {
+        threads.emplace_back([&pa, &elements = allocated[t], t]() {
+            for (size_t i = 0; i < 100; i++) {
+                for (size_t j = 0; j < 32; j++) {
+                    void* p = pa.alloc();
+                    ASSERT_NE(nullptr, p);
+                    memset(p, int(t), 64);
+                    elements.push_back(p);
+                }
+                for (void* p : elements) {
+                    EXPECT_EQ(char(t), *static_cast<char*>(p));
+                    pa.free(p);
+                }
+                elements.clear();
+            }
+            for (size_t j = 0; j < COUNT / THREAD_COUNT / 2; j++) {
+                elements.push_back(pa.alloc());
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<void*> all;
+    for (auto const& list : allocated) {
+        all.insert(all.end(), list.begin(), list.end());
+    }
+    EXPECT_TRUE(std::find(all.begin(), all.end(), nullptr) == all.end());
+    std::sort(all.begin(), all.end());
+    EXPECT_TRUE(std::adjacent_find(all.begin(), all.end()) == all.end());
+
+    // at most CACHE_CAPACITY elements are stranded in the cache of each thread that exited
+    pa.free(all.data(), all.size());
+    size_t const count = pa.alloc(elements.data(), COUNT);
+    EXPECT_GE(count, COUNT - THREAD_COUNT * ThreadCachedFreeList::CACHE_CAPACITY);
+    pa.free(elements.data(), count);
+}
+
 
 TEST(AllocatorTest, CppAllocator) {
     struct Tracking {
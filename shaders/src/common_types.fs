@@ -47,5 +47,9 @@ struct PerRenderableData {
     highp uint flagsChannels;                   // see packFlags() below (0x00000fll)
     highp uint objectId;                        // used for picking
     highp float userData;   // TODO: We need a better solution, this currently holds the average local scale for the renderable
-    highp vec4 reserved[8];
+    highp uint textureArrayIndex;               // layer of the material's texture arrays
+    highp uint reserved0;
+    highp uint reserved1;
+    highp uint reserved2;
+    highp vec4 reserved[7];
 };
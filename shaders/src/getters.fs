@@ -149,3 +149,8 @@ PerRenderableData getObjectUniforms() {
     return objectUniforms.data[instance_index];
 #endif
 }
+
+/** @public-api */
+int getTextureArrayIndex() {
+    return int(getObjectUniforms().textureArrayIndex);
+}
@@ -37,6 +37,11 @@ mat3 getWorldFromModelNormalMatrix() {
     return getObjectUniforms().worldFromModelNormalMatrix;
 }
 
+/** @public-api */
+int getTextureArrayIndex() {
+    return int(getObjectUniforms().textureArrayIndex);
+}
+
 //------------------------------------------------------------------------------
 // Attributes access
 //------------------------------------------------------------------------------
@@ -0,0 +1,487 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "CommandStreamPlayer.h"
+
+#include <backend/SamplerDescriptor.h>
+
+#include <utils/FixedCapacityVector.h>
+#include <utils/Panic.h>
+#include <utils/ostream.h>
+
+#include <algorithm>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <stdlib.h>
+#include <string.h>
+
+using namespace filament;
+using namespace filament::backend;
+using namespace utils;
+
+// Size of the circular buffer the commands are decoded into. Commands are executed at the end
+// of each frame or when FLUSH_THRESHOLD bytes have been decoded, whichever comes first.
+static constexpr size_t COMMAND_BUFFER_SIZE = 8u * 1024u * 1024u;
+static constexpr size_t FLUSH_THRESHOLD = 1u * 1024u * 1024u;
+
+static void freeBuffer(void* buffer, size_t, void*) {
+    free(buffer);
+}
+
+static constexpr bool isDestroy(CommandId id) noexcept {
+    switch (id) {
+        case CommandId::destroyVertexBuffer:
+        case CommandId::destroyIndexBuffer:
+        case CommandId::destroyBufferObject:
+        case CommandId::destroyRenderPrimitive:
+        case CommandId::destroyProgram:
+        case CommandId::destroySamplerGroup:
+        case CommandId::destroyTexture:
+        case CommandId::destroyRenderTarget:
+        case CommandId::destroySwapChain:
+        case CommandId::destroyTimerQuery:
+        case CommandId::destroySync:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// These commands refer to callbacks, external images or streams of the captured process
+static constexpr bool isSkipped(CommandId id) noexcept {
+    switch (id) {
+        case CommandId::setFrameScheduledCallback:
+        case CommandId::setFrameCompletedCallback:
+        case CommandId::setExternalImage:
+        case CommandId::setExternalImagePlane:
+        case CommandId::setExternalStream:
+        case CommandId::destroyStream:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Objects left alive at the end of the capture are destroyed in this order, such that objects
+// are destroyed before the objects they reference.
+static int getDestroyOrder(CommandId creator) noexcept {
+    switch (creator) {
+        case CommandId::createRenderPrimitive:      return 0;
+        case CommandId::createProgram:              return 1;
+        case CommandId::createSamplerGroup:         return 1;
+        case CommandId::createDefaultRenderTarget:  return 2;
+        case CommandId::createRenderTarget:         return 2;
+        case CommandId::createTexture:              return 3;
+        case CommandId::createTextureSwizzled:      return 3;
+        case CommandId::importTexture:              return 3;
+        case CommandId::createVertexBuffer:         return 3;
+        case CommandId::createIndexBuffer:          return 3;
+        case CommandId::createBufferObject:         return 4;
+        case CommandId::createTimerQuery:           return 4;
+        case CommandId::createFence:                return 4;
+        case CommandId::createSync:                 return 4;
+        default:                                    return 5; // swap chains
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+CommandStreamPlayer::CommandStreamPlayer(Driver& driver, uint8_t const* data, size_t size)
+        : mDriver(driver),
+          mCircularBuffer(COMMAND_BUFFER_SIZE),
+          mDriverApi(driver, mCircularBuffer),
+          mData(data),
+          mEnd(data + size) {
+}
+
+CommandStreamPlayer::~CommandStreamPlayer() noexcept = default;
+
+bool CommandStreamPlayer::isValid(uint8_t const* data, size_t size) noexcept {
+    if (size < sizeof(CaptureHeader)) {
+        return false;
+    }
+    CaptureHeader header;
+    memcpy(&header, data, sizeof(header));
+    return !memcmp(header.magic, CaptureHeader::MAGIC, sizeof(header.magic)) &&
+            header.version == CaptureHeader::VERSION &&
+            header.commandCount == uint32_t(CommandId::COUNT);
+}
+
+void CommandStreamPlayer::play(std::vector<Duration>& frameTimes) {
+    mCursor = mData + sizeof(CaptureHeader);
+    mFrameTime = {};
+
+    while (size_t(mEnd - mCursor) >= sizeof(CommandId) + sizeof(uint32_t)) {
+        CommandId const id = readRaw<CommandId>();
+        uint32_t const size = readRaw<uint32_t>();
+        uint8_t const* const next = mCursor + size;
+        if (UTILS_UNLIKELY(id >= CommandId::COUNT || size > size_t(mEnd - mCursor))) {
+            // the capture was truncated (e.g. the application didn't exit cleanly)
+            break;
+        }
+
+        mCurrentId = id;
+        dispatch(id);
+        assert_invariant(isSkipped(id) || mCursor == next);
+        mCursor = next;
+
+        if (id == CommandId::endFrame) {
+            flush();
+            frameTimes.push_back(mFrameTime);
+            mFrameTime = {};
+        } else if (intptr_t(mCircularBuffer.getHead()) - intptr_t(mCircularBuffer.getTail())
+                >= intptr_t(FLUSH_THRESHOLD)) {
+            flush();
+        }
+    }
+
+    flush();
+    destroyObjects();
+}
+
+void CommandStreamPlayer::terminate() {
+    mDriverApi.terminate();
+    mDriver.purge();
+}
+
+void CommandStreamPlayer::flush() {
+    CircularBuffer& circularBuffer = mCircularBuffer;
+    if (circularBuffer.empty()) {
+        return;
+    }
+
+    new(circularBuffer.allocate(sizeof(NoopCommand))) NoopCommand(nullptr);
+
+    auto const start = std::chrono::steady_clock::now();
+    mDriverApi.execute(circularBuffer.getTail());
+    mDriver.purge();
+    mFrameTime += std::chrono::steady_clock::now() - start;
+
+    // the commands are executed, the buffer can be reused
+    circularBuffer.circularize();
+}
+
+void CommandStreamPlayer::destroyObjects() {
+    std::vector<Object> objects;
+    objects.reserve(mObjects.size());
+    for (auto const& item : mObjects) {
+        objects.push_back(item.second);
+    }
+    mObjects.clear();
+
+    std::stable_sort(objects.begin(), objects.end(), [](Object const& lhs, Object const& rhs) {
+        return getDestroyOrder(lhs.creator) < getDestroyOrder(rhs.creator);
+    });
+
+    for (Object const& object : objects) {
+        switch (object.creator) {
+            case CommandId::createVertexBuffer:
+                mDriverApi.destroyVertexBuffer(VertexBufferHandle(object.id));
+                break;
+            case CommandId::createIndexBuffer:
+                mDriverApi.destroyIndexBuffer(IndexBufferHandle(object.id));
+                break;
+            case CommandId::createBufferObject:
+                mDriverApi.destroyBufferObject(BufferObjectHandle(object.id));
+                break;
+            case CommandId::createTexture:
+            case CommandId::createTextureSwizzled:
+            case CommandId::importTexture:
+                mDriverApi.destroyTexture(TextureHandle(object.id));
+                break;
+            case CommandId::createSamplerGroup:
+                mDriverApi.destroySamplerGroup(SamplerGroupHandle(object.id));
+                break;
+            case CommandId::createRenderPrimitive:
+                mDriverApi.destroyRenderPrimitive(RenderPrimitiveHandle(object.id));
+                break;
+            case CommandId::createProgram:
+                mDriverApi.destroyProgram(ProgramHandle(object.id));
+                break;
+            case CommandId::createDefaultRenderTarget:
+            case CommandId::createRenderTarget:
+                mDriverApi.destroyRenderTarget(RenderTargetHandle(object.id));
+                break;
+            case CommandId::createFence:
+                // this is a synchronous call, but the fence's creation has been executed already
+                mDriverApi.destroyFence(FenceHandle(object.id));
+                break;
+            case CommandId::createSync:
+                mDriverApi.destroySync(SyncHandle(object.id));
+                break;
+            case CommandId::createSwapChain:
+            case CommandId::createSwapChainHeadless:
+                mDriverApi.destroySwapChain(SwapChainHandle(object.id));
+                break;
+            case CommandId::createTimerQuery:
+                mDriverApi.destroyTimerQuery(TimerQueryHandle(object.id));
+                break;
+            default:
+                break;
+        }
+    }
+
+    flush();
+}
+
+// ------------------------------------------------------------------------------------------------
+
+template<CommandId ID, typename F>
+void CommandStreamPlayer::replay(F const& f) {
+    if constexpr (isSkipped(ID)) {
+        return;
+    } else if constexpr (isDestroy(ID)) {
+        // the only parameter is the handle of the object
+        HandleId recorded;
+        memcpy(&recorded, mCursor, sizeof(recorded));
+        call(f);
+        mObjects.erase(recorded);
+    } else {
+        call(f);
+    }
+}
+
+template<CommandId ID, typename F>
+void CommandStreamPlayer::replayCreate(F const& f) {
+    HandleId const recorded = readRaw<HandleId>();
+
+    // Fences are destroyed synchronously, which isn't captured. The reuse of its recorded id is
+    // the only sign that a fence is gone. Its creation must be executed before it's destroyed.
+    auto const pos = mObjects.find(recorded);
+    if (pos != mObjects.end() && pos->second.creator == CommandId::createFence) {
+        flush();
+        mDriverApi.destroyFence(FenceHandle(pos->second.id));
+        mObjects.erase(pos);
+    }
+
+    HandleId id;
+    if constexpr (ID == CommandId::createSwapChain) {
+        // native windows can't be replayed, render offscreen instead
+        read<void*>();
+        uint64_t const flags = read<uint64_t>();
+        id = mDriverApi.createSwapChainHeadless(mSwapChainWidth, mSwapChainHeight, flags).getId();
+    } else if constexpr (ID == CommandId::importTexture) {
+        // the imported texture belongs to the captured process, replace it with a new one
+        read<intptr_t>();
+        id = call([this](SamplerType target, uint8_t levels, TextureFormat format,
+                uint8_t samples, uint32_t width, uint32_t height, uint32_t depth,
+                TextureUsage usage) {
+            return mDriverApi.createTexture(target, levels, format, samples,
+                    width, height, depth, usage);
+        }).getId();
+    } else {
+        id = call(f).getId();
+    }
+    mObjects[recorded] = { id, ID };
+}
+
+template<typename F>
+auto CommandStreamPlayer::call(F const& f) {
+    return call(f, &F::operator());
+}
+
+template<typename F, typename R, typename ... ARGS>
+R CommandStreamPlayer::call(F const& f, R (F::*)(ARGS...) const) {
+    // braced initialization guarantees that the parameters are read in order
+    std::tuple<std::decay_t<ARGS>...> args{ read<std::decay_t<ARGS>>()... };
+    return std::apply(f, std::move(args));
+}
+
+// ------------------------------------------------------------------------------------------------
+
+template<typename T>
+T CommandStreamPlayer::readRaw() noexcept {
+    static_assert(std::is_trivially_copyable_v<T>);
+    assert_invariant(mCursor + sizeof(T) <= mEnd);
+    T value;
+    memcpy(&value, mCursor, sizeof(T));
+    mCursor += sizeof(T);
+    return value;
+}
+
+template<typename T>
+T CommandStreamPlayer::read() {
+    if constexpr (std::is_same_v<T, const char*>) {
+        uint32_t const length = readRaw<uint32_t>();
+        const char* const string = reinterpret_cast<const char*>(mCursor);
+        mCursor += length + 1;
+        return string;
+    } else if constexpr (std::is_pointer_v<T>) {
+        // pointers are only meaningful in the captured process
+        mCursor += sizeof(T);
+        return nullptr;
+    } else if constexpr (std::is_base_of_v<HandleBase, T>) {
+        return remap(readRaw<T>());
+    } else if constexpr (std::is_same_v<T, PipelineState>) {
+        PipelineState state = readRaw<PipelineState>();
+        state.program = remap(state.program);
+        return state;
+    } else if constexpr (std::is_same_v<T, TargetBufferInfo>) {
+        TargetBufferInfo info = readRaw<TargetBufferInfo>();
+        info.handle = remap(info.handle);
+        return info;
+    } else if constexpr (std::is_same_v<T, MRT>) {
+        MRT mrt = readRaw<MRT>();
+        for (size_t i = 0; i < MRT::MAX_SUPPORTED_RENDER_TARGET_COUNT; i++) {
+            mrt[i].handle = remap(mrt[i].handle);
+        }
+        return mrt;
+    } else if constexpr (std::is_same_v<T, BufferDescriptor>) {
+        return readBufferDescriptor();
+    } else if constexpr (std::is_same_v<T, PixelBufferDescriptor>) {
+        return readPixelBufferDescriptor();
+    } else if constexpr (std::is_same_v<T, Program>) {
+        return readProgram();
+    } else {
+        return readRaw<T>();
+    }
+}
+
+template<typename T>
+Handle<T> CommandStreamPlayer::remap(Handle<T> handle) const noexcept {
+    if (!handle) {
+        return {};
+    }
+    // handles that weren't created by the capture (e.g. streams) become null handles
+    auto const pos = mObjects.find(handle.getId());
+    return pos != mObjects.end() ? Handle<T>(pos->second.id) : Handle<T>{};
+}
+
+void const* CommandStreamPlayer::readBuffer(uint32_t& size, BufferDescriptor::Callback& callback) {
+    size = readRaw<uint32_t>();
+    bool const hasContent = readRaw<bool>();
+    if (!hasContent) {
+        // e.g. the destination of readPixels
+        callback = &freeBuffer;
+        return malloc(size);
+    }
+
+    void const* const data = mCursor;
+    mCursor += size;
+
+    if (mCurrentId == CommandId::updateSamplerGroup) {
+        // the samplers reference textures, which need to be remapped
+        auto* const samplers = static_cast<SamplerDescriptor*>(malloc(size));
+        memcpy(samplers, data, size);
+        for (size_t i = 0, c = size / sizeof(SamplerDescriptor); i < c; i++) {
+            samplers[i].t = remap(samplers[i].t);
+        }
+        callback = &freeBuffer;
+        return samplers;
+    }
+
+    callback = nullptr;
+    return data;
+}
+
+BufferDescriptor CommandStreamPlayer::readBufferDescriptor() {
+    uint32_t size;
+    BufferDescriptor::Callback callback;
+    void const* const buffer = readBuffer(size, callback);
+    return BufferDescriptor(buffer, size, callback);
+}
+
+PixelBufferDescriptor CommandStreamPlayer::readPixelBufferDescriptor() {
+    uint32_t size;
+    BufferDescriptor::Callback callback;
+    void const* const buffer = readBuffer(size, callback);
+    uint32_t const left = readRaw<uint32_t>();
+    uint32_t const top = readRaw<uint32_t>();
+    PixelDataType const type = readRaw<PixelDataType>();
+    uint8_t const alignment = readRaw<uint8_t>();
+    if (type == PixelDataType::COMPRESSED) {
+        uint32_t const imageSize = readRaw<uint32_t>();
+        auto const format = readRaw<CompressedPixelDataType>();
+        return PixelBufferDescriptor(buffer, size, format, imageSize, callback);
+    }
+    uint32_t const stride = readRaw<uint32_t>();
+    PixelDataFormat const format = readRaw<PixelDataFormat>();
+    return PixelBufferDescriptor(buffer, size, format, type, alignment, left, top, stride,
+            callback);
+}
+
+CString CommandStreamPlayer::readCString() noexcept {
+    uint32_t const length = readRaw<uint32_t>();
+    CString string(reinterpret_cast<const char*>(mCursor), length);
+    mCursor += length + 1;
+    return string;
+}
+
+Program CommandStreamPlayer::readProgram() {
+    Program program;
+
+    CString const name = readCString();
+    program.diagnostics(name, [name](io::ostream& out) -> io::ostream& {
+        return out << name.c_str_safe();
+    });
+
+    for (size_t i = 0; i < Program::SHADER_TYPE_COUNT; i++) {
+        uint32_t const size = readRaw<uint32_t>();
+        program.shader(ShaderType(i), mCursor, size);
+        mCursor += size;
+    }
+
+    auto blocks = FixedCapacityVector<std::pair<const char*, uint8_t>>::with_capacity(
+            Program::UNIFORM_BINDING_COUNT);
+    for (size_t i = 0; i < Program::UNIFORM_BINDING_COUNT; i++) {
+        if (readRaw<bool>()) {
+            blocks.push_back({ read<const char*>(), uint8_t(i) });
+        }
+    }
+    program.uniformBlockBindings(blocks);
+
+    for (size_t i = 0; i < Program::SAMPLER_BINDING_COUNT; i++) {
+        ShaderStageFlags const stageFlags = readRaw<ShaderStageFlags>();
+        FixedCapacityVector<Program::Sampler> samplers(readRaw<uint32_t>());
+        for (Program::Sampler& sampler : samplers) {
+            sampler.name = readCString();
+            sampler.binding = readRaw<uint32_t>();
+        }
+        program.setSamplerGroup(i, stageFlags, samplers.data(), samplers.size());
+    }
+
+    return program;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+void CommandStreamPlayer::dispatch(CommandId id) {
+    switch (id) {
+#define DECL_DRIVER_API(methodName, paramsDecl, params)                                         \
+        case CommandId::methodName:                                                             \
+            replay<CommandId::methodName>([this](paramsDecl) {                                  \
+                mDriverApi.methodName(APPLY(std::move, params));                                \
+            });                                                                                 \
+            break;
+
+#define DECL_DRIVER_API_SYNCHRONOUS(RetType, methodName, paramsDecl, params)
+
+#define DECL_DRIVER_API_RETURN(RetType, methodName, paramsDecl, params)                         \
+        case CommandId::methodName:                                                             \
+            replayCreate<CommandId::methodName>([this](paramsDecl) {                            \
+                return mDriverApi.methodName(APPLY(std::move, params));                         \
+            });                                                                                 \
+            break;
+
+#include "private/backend/DriverAPI.inc"
+
+        default:
+            break;
+    }
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TNT_CMDREPLAY_COMMANDSTREAMPLAYER_H
+#define TNT_CMDREPLAY_COMMANDSTREAMPLAYER_H
+
+#include <private/backend/CircularBuffer.h>
+#include <private/backend/CommandStream.h>
+#include <private/backend/CommandStreamRecorder.h>
+#include <private/backend/Driver.h>
+
+#include <backend/BufferDescriptor.h>
+#include <backend/Handle.h>
+#include <backend/PixelBufferDescriptor.h>
+#include <backend/Program.h>
+
+#include <chrono>
+#include <unordered_map>
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * CommandStreamPlayer replays a capture written by CommandStreamRecorder on a Driver.
+ *
+ * The commands are decoded into a CommandStream and executed synchronously, on the calling
+ * thread, each time a frame ends. Handles recorded in the capture are remapped to the handles
+ * created during the replay. Objects that only make sense in the captured process (native
+ * windows, external images, streams and callbacks) are either replaced or skipped.
+ */
+class CommandStreamPlayer {
+public:
+    using Driver = filament::backend::Driver;
+    using CommandId = filament::backend::CommandId;
+    using Duration = std::chrono::duration<double>;
+
+    // data must outlive the player, buffer descriptors and strings point directly into it
+    CommandStreamPlayer(Driver& driver, uint8_t const* data, size_t size);
+    ~CommandStreamPlayer() noexcept;
+
+    CommandStreamPlayer(CommandStreamPlayer const&) = delete;
+    CommandStreamPlayer& operator=(CommandStreamPlayer const&) = delete;
+
+    // returns whether data is a capture that this build can replay
+    static bool isValid(uint8_t const* data, size_t size) noexcept;
+
+    // size of the headless swap chains replacing the captured ones
+    void setSwapChainSize(uint32_t width, uint32_t height) noexcept {
+        mSwapChainWidth = width;
+        mSwapChainHeight = height;
+    }
+
+    // Replays the whole capture once and destroys the objects it left alive. The time spent
+    // executing the commands of each frame is appended to frameTimes.
+    void play(std::vector<Duration>& frameTimes);
+
+    // must be called before the driver is destroyed
+    void terminate();
+
+private:
+    using HandleId = filament::backend::HandleBase::HandleId;
+
+    // an object created by the replay, and the command that created it
+    struct Object {
+        HandleId id;
+        CommandId creator;
+    };
+
+    void dispatch(CommandId id);
+
+    template<CommandId ID, typename F>
+    void replay(F const& f);
+
+    template<CommandId ID, typename F>
+    void replayCreate(F const& f);
+
+    // decodes the parameters of f from the capture and calls it
+    template<typename F>
+    auto call(F const& f);
+
+    template<typename F, typename R, typename ... ARGS>
+    R call(F const& f, R (F::*)(ARGS...) const);
+
+    template<typename T>
+    T read();
+
+    template<typename T>
+    T readRaw() noexcept;
+
+    void const* readBuffer(uint32_t& size, filament::backend::BufferDescriptor::Callback& callback);
+    filament::backend::BufferDescriptor readBufferDescriptor();
+    filament::backend::PixelBufferDescriptor readPixelBufferDescriptor();
+    filament::backend::Program readProgram();
+    utils::CString readCString() noexcept;
+
+    template<typename T>
+    filament::backend::Handle<T> remap(filament::backend::Handle<T> handle) const noexcept;
+
+    void flush();
+    void destroyObjects();
+
+    Driver& mDriver;
+    filament::backend::CircularBuffer mCircularBuffer;
+    filament::backend::CommandStream mDriverApi;
+
+    uint8_t const* const mData;
+    uint8_t const* const mEnd;
+    uint8_t const* mCursor = nullptr;
+    CommandId mCurrentId = CommandId::COUNT;
+
+    uint32_t mSwapChainWidth = 1920;
+    uint32_t mSwapChainHeight = 1080;
+
+    // recorded handle id -> replayed object
+    std::unordered_map<HandleId, Object> mObjects;
+
+    Duration mFrameTime{};
+};
+
+#endif // TNT_CMDREPLAY_COMMANDSTREAMPLAYER_H
@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "CommandStreamPlayer.h"
+
+#include <backend/Platform.h>
+
+#include <utils/Path.h>
+
+#include <getopt/getopt.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace filament::backend;
+using namespace utils;
+
+using Duration = CommandStreamPlayer::Duration;
+
+static Backend g_backend = Backend::DEFAULT;
+static uint32_t g_iterationCount = 10;
+static uint32_t g_width = 1920;
+static uint32_t g_height = 1080;
+
+static const char* USAGE = R"TXT(
+CMDREPLAY replays a command stream captured by Filament and reports how long the backend took
+to execute each frame.
+
+A capture is recorded by running any Filament application with the environment variable
+FILAMENT_CAPTURE_COMMAND_STREAM (or the debug.filament.capture property on Android) set to the
+path of the capture file.
+
+Usage:
+    CMDREPLAY [options] <capture>
+
+Options:
+   --help, -h
+       Print this message
+   --license, -L
+       Print copyright and license information
+   --api, -a
+       Specify the backend API: opengl, vulkan, metal or noop (default: platform's default)
+   --iterations=N, -n N
+       Number of times the capture is replayed (default: 10)
+   --size=WIDTHxHEIGHT, -s WIDTHxHEIGHT
+       Size of the swap chains, which are always offscreen (default: 1920x1080)
+)TXT";
+
+static void printUsage(const char* name) {
+    std::string execName(Path(name).getName());
+    const std::string from("CMDREPLAY");
+    std::string usage(USAGE);
+    for (size_t pos = usage.find(from); pos != std::string::npos; pos = usage.find(from, pos)) {
+        usage.replace(pos, from.length(), execName);
+    }
+    puts(usage.c_str());
+}
+
+static void license() {
+    static const char *license[] = {
+        #include "licenses/licenses.inc"
+        nullptr
+    };
+
+    const char **p = &license[0];
+    while (*p)
+        std::cout << *p++ << std::endl;
+}
+
+static int handleArguments(int argc, char* argv[]) {
+    static constexpr const char* OPTSTR = "hLa:n:s:";
+    static const struct option OPTIONS[] = {
+            { "help",       no_argument,       0, 'h' },
+            { "license",    no_argument,       0, 'L' },
+            { "api",        required_argument, 0, 'a' },
+            { "iterations", required_argument, 0, 'n' },
+            { "size",       required_argument, 0, 's' },
+            { 0, 0, 0, 0 }  // termination of the option list
+    };
+
+    int opt;
+    int optionIndex = 0;
+
+    while ((opt = getopt_long(argc, argv, OPTSTR, OPTIONS, &optionIndex)) >= 0) {
+        std::string arg(optarg ? optarg : "");
+        switch (opt) {
+            default:
+            case 'h':
+                printUsage(argv[0]);
+                exit(0);
+            case 'L':
+                license();
+                exit(0);
+            case 'a':
+                if (arg == "opengl") {
+                    g_backend = Backend::OPENGL;
+                } else if (arg == "vulkan") {
+                    g_backend = Backend::VULKAN;
+                } else if (arg == "metal") {
+                    g_backend = Backend::METAL;
+                } else if (arg == "noop") {
+                    g_backend = Backend::NOOP;
+                } else {
+                    std::cerr << "Unrecognized backend. Must be 'opengl'|'vulkan'|'metal'|'noop'."
+                            << std::endl;
+                    exit(1);
+                }
+                break;
+            case 'n':
+                g_iterationCount = std::max(1, atoi(optarg));
+                break;
+            case 's':
+                if (sscanf(optarg, "%ux%u", &g_width, &g_height) != 2 || !g_width || !g_height) {
+                    std::cerr << "Size must be of the form WIDTHxHEIGHT." << std::endl;
+                    exit(1);
+                }
+                break;
+        }
+    }
+
+    return optind;
+}
+
+static void printTimes(const char* label, std::vector<Duration> times) {
+    if (times.empty()) {
+        return;
+    }
+    std::sort(times.begin(), times.end());
+    Duration total{};
+    for (Duration const& time : times) {
+        total += time;
+    }
+    auto const ms = [](Duration d) { return d.count() * 1e3; };
+    std::cout << label << ": "
+            << "min " << ms(times.front()) << " ms, "
+            << "median " << ms(times[times.size() / 2]) << " ms, "
+            << "avg " << ms(total / times.size()) << " ms, "
+            << "max " << ms(times.back()) << " ms" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    const int optionIndex = handleArguments(argc, argv);
+    if (argc - optionIndex < 1) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // the replay would otherwise capture itself, over the capture being replayed
+    if (getenv("FILAMENT_CAPTURE_COMMAND_STREAM")) {
+        std::cerr << "FILAMENT_CAPTURE_COMMAND_STREAM must not be set when replaying." << std::endl;
+        return 1;
+    }
+
+    const Path capturePath(argv[optionIndex]);
+    std::ifstream in(capturePath.c_str(), std::ifstream::ate | std::ifstream::binary);
+    if (!in) {
+        std::cerr << "Unable to open " << capturePath << std::endl;
+        return 1;
+    }
+    std::vector<uint8_t> capture(size_t(in.tellg()));
+    in.seekg(0);
+    in.read(reinterpret_cast<char*>(capture.data()), std::streamsize(capture.size()));
+
+    if (!CommandStreamPlayer::isValid(capture.data(), capture.size())) {
+        std::cerr << capturePath << " is not a command stream capture, or was recorded with an "
+                "incompatible version of Filament." << std::endl;
+        return 1;
+    }
+
+    DefaultPlatform* platform = DefaultPlatform::create(&g_backend);
+    Driver* driver = platform ? platform->createDriver(nullptr, {}) : nullptr;
+    if (!driver) {
+        std::cerr << "Unable to create the " << backendToString(g_backend) << " driver."
+                << std::endl;
+        DefaultPlatform::destroy(&platform);
+        return 1;
+    }
+
+    std::vector<Duration> frameTimes;
+    std::vector<Duration> iterationTimes;
+    {
+        CommandStreamPlayer player(*driver, capture.data(), capture.size());
+        player.setSwapChainSize(g_width, g_height);
+
+        for (uint32_t i = 0; i < g_iterationCount; i++) {
+            size_t const first = frameTimes.size();
+            player.play(frameTimes);
+            Duration total{};
+            for (size_t j = first; j < frameTimes.size(); j++) {
+                total += frameTimes[j];
+            }
+            iterationTimes.push_back(total);
+            std::cout << "Iteration " << i << ": " << (frameTimes.size() - first) << " frames in "
+                    << total.count() * 1e3 << " ms" << std::endl;
+        }
+
+        player.terminate();
+    }
+
+    std::cout << "Backend: " << backendToString(g_backend) << std::endl;
+    printTimes("Frame", frameTimes);
+    printTimes("Iteration", iterationTimes);
+
+    delete driver;
+    DefaultPlatform::destroy(&platform);
+    return 0;
+}
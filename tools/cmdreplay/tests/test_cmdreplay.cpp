@@ -0,0 +1,228 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include "CommandStreamPlayer.h"
+
+#include <backend/Platform.h>
+#include <backend/SamplerDescriptor.h>
+
+#include <utils/Path.h>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <stdlib.h>
+#include <string.h>
+
+using namespace filament::backend;
+using namespace utils;
+
+using HandleId = HandleBase::HandleId;
+
+namespace {
+
+struct Command {
+    CommandId id;
+    std::vector<uint8_t> payload;
+
+    template<typename T>
+    T get(size_t offset) const {
+        EXPECT_LE(offset + sizeof(T), payload.size());
+        T value;
+        memcpy(&value, payload.data() + offset, sizeof(T));
+        return value;
+    }
+
+    std::vector<uint8_t> tail(size_t offset) const {
+        return { payload.begin() + ptrdiff_t(offset), payload.end() };
+    }
+};
+
+std::vector<uint8_t> readFile(Path const& path) {
+    std::ifstream in(path.c_str(), std::ifstream::ate | std::ifstream::binary);
+    std::vector<uint8_t> content(size_t(in.tellg()));
+    in.seekg(0);
+    in.read(reinterpret_cast<char*>(content.data()), std::streamsize(content.size()));
+    return content;
+}
+
+std::vector<Command> parse(std::vector<uint8_t> const& capture) {
+    std::vector<Command> commands;
+    size_t offset = sizeof(CaptureHeader);
+    while (offset < capture.size()) {
+        Command command;
+        uint32_t size;
+        memcpy(&command.id, capture.data() + offset, sizeof(CommandId));
+        memcpy(&size, capture.data() + offset + sizeof(CommandId), sizeof(uint32_t));
+        offset += sizeof(CommandId) + sizeof(uint32_t);
+        command.payload.assign(capture.begin() + ptrdiff_t(offset),
+                capture.begin() + ptrdiff_t(offset + size));
+        offset += size;
+        commands.push_back(std::move(command));
+    }
+    return commands;
+}
+
+} // anonymous namespace
+
+class CmdReplayTest : public testing::Test {
+protected:
+    ~CmdReplayTest() override {
+        delete driver;
+        DefaultPlatform::destroy(&platform);
+        remove(recordPath.c_str());
+        remove(replayPath.c_str());
+    }
+
+    // Executes the commands issued to stream so far
+    static void execute(CommandStream& stream, CircularBuffer& buffer) {
+        new(buffer.allocate(sizeof(NoopCommand))) NoopCommand(nullptr);
+        stream.execute(buffer.getTail());
+        buffer.circularize();
+    }
+
+    Backend backend = Backend::NOOP;
+    DefaultPlatform* platform = DefaultPlatform::create(&backend);
+    Driver* driver = platform->createDriver(nullptr, {});
+    Path const recordPath = Path::getTemporaryDirectory() + "test_cmdreplay_record.fcap";
+    Path const replayPath = Path::getTemporaryDirectory() + "test_cmdreplay_replay.fcap";
+};
+
+TEST_F(CmdReplayTest, RoundTrip) {
+    uint8_t bufferData[16];
+    for (uint8_t i = 0; i < sizeof(bufferData); i++) {
+        bufferData[i] = i;
+    }
+    const char vertexShader[] = "void main() { gl_Position = vec4(0.0); }";
+    const char fragmentShader[] = "void main() { }";
+    Program::Sampler const sampler{ CString("albedo"), 3 };
+
+    // Record a short sequence, the objects are left alive so that the replayed handles differ
+    // from the recorded ones.
+    {
+        setenv("FILAMENT_CAPTURE_COMMAND_STREAM", recordPath.c_str(), 1);
+        CircularBuffer buffer(1024 * 1024);
+        CommandStream driverApi(*driver, buffer);
+        unsetenv("FILAMENT_CAPTURE_COMMAND_STREAM");
+
+        auto bo = driverApi.createBufferObject(sizeof(bufferData),
+                BufferObjectBinding::UNIFORM, BufferUsage::STATIC);
+        driverApi.updateBufferObject(bo, { bufferData, sizeof(bufferData) }, 0);
+        auto texture = driverApi.createTexture(SamplerType::SAMPLER_2D, 1,
+                TextureFormat::RGBA8, 1, 4, 4, 1, TextureUsage::DEFAULT);
+        auto samplerGroup = driverApi.createSamplerGroup(1);
+        SamplerDescriptor const samplers[] = { { texture, {} } };
+        driverApi.updateSamplerGroup(samplerGroup, { samplers, sizeof(samplers) });
+        Program program;
+        program.diagnostics(CString("test"), [](io::ostream& out) -> io::ostream& {
+            return out << "test";
+        });
+        program.shader(ShaderType::VERTEX, vertexShader, sizeof(vertexShader));
+        program.shader(ShaderType::FRAGMENT, fragmentShader, sizeof(fragmentShader));
+        program.setSamplerGroup(0, ShaderStageFlags::FRAGMENT, &sampler, 1);
+        driverApi.createProgram(std::move(program));
+        driverApi.destroyBufferObject(bo);
+        bo = driverApi.createBufferObject(32, BufferObjectBinding::VERTEX, BufferUsage::DYNAMIC);
+        driverApi.updateBufferObject(bo, { bufferData + 8, 8 }, 16);
+        driverApi.endFrame(0);
+        execute(driverApi, buffer);
+    }
+
+    // Replay it on the same driver, while capturing the replay
+    std::vector<uint8_t> const capture = readFile(recordPath);
+    ASSERT_TRUE(CommandStreamPlayer::isValid(capture.data(), capture.size()));
+    {
+        setenv("FILAMENT_CAPTURE_COMMAND_STREAM", replayPath.c_str(), 1);
+        CommandStreamPlayer player(*driver, capture.data(), capture.size());
+        unsetenv("FILAMENT_CAPTURE_COMMAND_STREAM");
+        std::vector<CommandStreamPlayer::Duration> frameTimes;
+        player.play(frameTimes);
+        EXPECT_EQ(frameTimes.size(), 1);
+        player.terminate();
+    }
+
+    std::vector<Command> const recorded = parse(capture);
+    std::vector<Command> const replayed = parse(readFile(replayPath));
+    ASSERT_EQ(recorded.size(), 10);
+
+    // the replay ends with the destruction of the 4 objects left alive by the capture
+    ASSERT_EQ(replayed.size(), recorded.size() + 4);
+    for (size_t i = 0; i < recorded.size(); i++) {
+        EXPECT_EQ(replayed[i].id, recorded[i].id);
+    }
+
+    // created objects get new handles, which replace the recorded ones in the other commands
+    std::unordered_map<HandleId, HandleId> handles;
+    for (size_t i : { 0, 2, 3, 5, 7 }) {
+        HandleId const recordedId = recorded[i].get<HandleId>(0);
+        HandleId const replayedId = replayed[i].get<HandleId>(0);
+        EXPECT_NE(recordedId, replayedId);
+        handles[recordedId] = replayedId;
+        EXPECT_EQ(replayed[i].tail(sizeof(HandleId)), recorded[i].tail(sizeof(HandleId)));
+    }
+    for (size_t i : { 1, 4, 6, 8 }) {
+        EXPECT_EQ(replayed[i].get<HandleId>(0), handles[recorded[i].get<HandleId>(0)]);
+    }
+
+    // updateBufferObject: handle, size, hasContent, content, byteOffset
+    for (size_t i : { 1, 8 }) {
+        EXPECT_EQ(replayed[i].tail(sizeof(HandleId)), recorded[i].tail(sizeof(HandleId)));
+    }
+    constexpr size_t CONTENT = sizeof(HandleId) + sizeof(uint32_t) + sizeof(bool);
+    EXPECT_EQ(replayed[8].get<uint32_t>(sizeof(HandleId)), 8);
+    EXPECT_TRUE(replayed[8].get<bool>(sizeof(HandleId) + sizeof(uint32_t)));
+    EXPECT_EQ(memcmp(replayed[8].payload.data() + CONTENT, bufferData + 8, 8), 0);
+    EXPECT_EQ(replayed[8].get<uint32_t>(CONTENT + 8), 16);
+    EXPECT_EQ(memcmp(replayed[1].payload.data() + CONTENT, bufferData, sizeof(bufferData)), 0);
+
+    // updateSamplerGroup: the samplers' textures are remapped too
+    auto const samplerDescriptor = replayed[4].get<SamplerDescriptor>(CONTENT);
+    EXPECT_EQ(samplerDescriptor.t.getId(),
+            handles[recorded[4].get<SamplerDescriptor>(CONTENT).t.getId()]);
+
+    // createProgram: the name and shaders come first
+    Command const& program = replayed[5];
+    size_t offset = sizeof(HandleId);
+    EXPECT_EQ(program.get<uint32_t>(offset), 4);
+    EXPECT_EQ(memcmp(program.payload.data() + offset + sizeof(uint32_t), "test", 5), 0);
+    offset += sizeof(uint32_t) + 5;
+    for (const char* shader : { vertexShader, fragmentShader }) {
+        uint32_t const size = strlen(shader) + 1;
+        EXPECT_EQ(program.get<uint32_t>(offset), size);
+        EXPECT_EQ(memcmp(program.payload.data() + offset + sizeof(uint32_t), shader, size), 0);
+        offset += sizeof(uint32_t) + size;
+    }
+
+    // the objects left alive are destroyed, in dependency order
+    using Destroy = std::pair<CommandId, HandleId>;
+    std::vector<Destroy> destroyed;
+    for (size_t i = recorded.size(); i < replayed.size(); i++) {
+        destroyed.emplace_back(replayed[i].id, replayed[i].get<HandleId>(0));
+    }
+    Destroy const first[] = {
+            { CommandId::destroySamplerGroup, replayed[3].get<HandleId>(0) },
+            { CommandId::destroyProgram, replayed[5].get<HandleId>(0) }};
+    EXPECT_TRUE(std::is_permutation(std::begin(first), std::end(first), destroyed.begin()));
+    EXPECT_EQ(destroyed[2], Destroy(CommandId::destroyTexture, replayed[2].get<HandleId>(0)));
+    EXPECT_EQ(destroyed[3], Destroy(CommandId::destroyBufferObject, replayed[7].get<HandleId>(0)));
+}
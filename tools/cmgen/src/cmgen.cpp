@@ -36,8 +36,13 @@
 #include <math/scalar.h>
 #include <math/vec4.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <deque>
 #include <fstream>
+#include <future>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
@@ -108,6 +113,25 @@ static size_t g_num_samples = 1024;
 
 static bool g_mirror = false;
 
+static bool g_batch = false;
+static utils::Path g_batch_manifest;
+
+using Clock = std::chrono::steady_clock;
+
+// In batch mode, saveImage() hands images over to background threads, so that encoding
+// overlaps with filtering. Each encode is attributed to the batch entry that produced it, so that
+// failed entries can be reported once all encodes have completed.
+struct PendingEncode {
+    size_t entry;
+    std::future<bool> success;
+};
+static constexpr size_t MAX_PENDING_ENCODES = 8;
+static bool g_async_encode = false;
+static size_t g_encode_entry = 0;
+static std::deque<PendingEncode> g_pending_encodes;
+static std::vector<bool> g_failed_entries;
+static std::atomic<double> g_encode_time = { 0.0 };
+
 // -----------------------------------------------------------------------------------------------
 
 static void generateMipmaps(utils::JobSystem& js, std::vector<Cubemap>& levels,
@@ -134,6 +158,8 @@ static void saveImage(const std::string& path, ImageEncoder::Format format, cons
         const std::string& compression);
 static LinearImage toLinearImage(const Image& image);
 static void exportKtxFaces(Ktx1Bundle& container, uint32_t miplevel, const Cubemap& cm);
+static double secondsSince(Clock::time_point start);
+static void waitForEncodes(size_t maxPending);
 
 // -----------------------------------------------------------------------------------------------
 
@@ -147,6 +173,7 @@ static void printUsage(char* name) {
             "Usages:\n"
             "    CMGEN [options] <input-file>\n"
             "    CMGEN [options] <uv[N]>\n"
+            "    CMGEN [options] --batch=<manifest>\n"
             "\n"
             "Supported input formats:\n"
             "    PNG, 8 and 16 bits\n"
@@ -193,6 +220,12 @@ static void printUsage(char* name) {
             "       Number of samples to use for IBL integrations (default 1024)\n\n"
             "   --ibl-ld=dir\n"
             "       Roughness pre-filter into <dir>\n\n"
+            "   --batch=manifest, -B manifest\n"
+            "       Process all the inputs listed in <manifest>, one per line, as\n"
+            "       <input-file> [output-dir]. When present, output-dir replaces the directory\n"
+            "       of every output option for that input. Inputs are decoded and encoded\n"
+            "       while other inputs are filtered, and the time spent in each stage\n"
+            "       is reported\n\n"
             "   --sh-shader\n"
             "       Generate irradiance SH for shader code\n\n"
             "\n"
@@ -241,7 +274,7 @@ static void license() {
 }
 
 static int handleCommandLineArgments(int argc, char* argv[]) {
-    static constexpr const char* OPTSTR = "hqidt:f:c:s:x:w:S:";
+    static constexpr const char* OPTSTR = "hqidt:f:c:s:x:w:S:B:";
     static const struct option OPTIONS[] = {
             { "help",                       no_argument, nullptr, 'h' },
             { "license",                    no_argument, nullptr, 'l' },
@@ -269,6 +302,7 @@ static int handleCommandLineArgments(int argc, char* argv[]) {
             { "ibl-samples",          required_argument, nullptr, 'k' },
             { "deploy",               required_argument, nullptr, 'x' },
             { "no-mirror",                  no_argument, nullptr, 'm' },
+            { "batch",                required_argument, nullptr, 'B' },
             { "debug",                      no_argument, nullptr, 'd' },
             { nullptr, 0, nullptr, 0 }  // termination of the option list
     };
@@ -447,6 +481,10 @@ static int handleCommandLineArgments(int argc, char* argv[]) {
             case 'm':
                 g_mirror = true;
                 break;
+            case 'B':
+                g_batch = true;
+                g_batch_manifest = arg;
+                break;
         }
     }
 
@@ -469,85 +507,127 @@ static int handleCommandLineArgments(int argc, char* argv[]) {
     return optind;
 }
 
-int main(int argc, char* argv[]) {
-    utils::JobSystem js;
-    js.adopt();
+// Configures the outputs generated by --deploy for the given input.
+static void configureDeploy(const utils::Path& iname) {
+    utils::Path sh_dir = g_deploy_dir;
 
-    int option_index = handleCommandLineArgments(argc, argv);
-    int num_args = argc - option_index;
-    if (!g_dfg && num_args < 1) {
-        printUsage(argv[0]);
-        return 1;
+    // KTX files are self-contained and do not need to live in a subfolder.
+    if (g_type != OutputType::KTX) {
+        sh_dir += iname.getNameWithoutExtension();
     }
 
-    if (g_dfg) {
-        if (!g_quiet) {
-            std::cout << "Generating IBL DFG LUT..." << std::endl;
-        }
-        size_t size = g_output_size ? g_output_size : DFG_LUT_DEFAULT_SIZE;
-        iblLutDfg(js, g_dfg_filename, size, g_dfg_multiscatter, g_dfg_cloth);
-        if (num_args < 1) return 0;
-    }
+    // generate pre-scaled irradiance sh to text file
+    g_sh_compute = 3;
+    g_sh_shader = true;
+    g_sh_irradiance = true;
+    g_sh_filename = sh_dir + "sh.txt";
+    g_sh_file = ShFile::SH_TEXT;
+    g_sh_output = true;
+
+    // faces
+    g_extract_dir = g_deploy_dir;
+    g_extract_faces = true;
+
+    // prefilter
+    g_prefilter = true;
+    g_prefilter_dir = g_deploy_dir;
+}
 
-    std::string command(argv[option_index]);
-    utils::Path iname(command);
+// Gathers the rows of the environment while it is decoded and clamps them if requested.
+// Equirectangular images that are much larger than the cubemap they are converted to are
+// box-filtered on the fly, so that they never need to be held in memory at full resolution.
+class EnvironmentConsumer : public ImageDecoder::RowConsumer {
+public:
+    explicit EnvironmentConsumer(size_t dim) : mDim(dim) { }
 
-    if (g_deploy) {
-        utils::Path sh_dir = g_deploy_dir;
+    LinearImage const& getImage() const { return mImage; }
+    uint32_t getChannels() const { return mChannels; }
 
-        // KTX files are self-contained and do not need to live in a subfolder.
-        if (g_type != OutputType::KTX) {
-            sh_dir += iname.getNameWithoutExtension();
+    bool begin(uint32_t width, uint32_t height, uint32_t channels) override {
+        mChannels = channels;
+        if (channels != 3) {
+            return false;
         }
-
-        // generate pre-scaled irradiance sh to text file
-        g_sh_compute = 3;
-        g_sh_shader = true;
-        g_sh_irradiance = true;
-        g_sh_filename = sh_dir + "sh.txt";
-        g_sh_file = ShFile::SH_TEXT;
-        g_sh_output = true;
-
-        // faces
-        g_extract_dir = g_deploy_dir;
-        g_extract_faces = true;
-
-        // prefilter
-        g_prefilter = true;
-        g_prefilter_dir = g_deploy_dir;
+        // A width of 16 * dim leaves at least one source texel per cubemap texel, even at the
+        // corners of the faces where texels cover the smallest solid angle.
+        mFactor = 1;
+        if (width == 2 * height) {
+            while (height % (mFactor * 2) == 0 && width / (mFactor * 2) >= 16 * mDim) {
+                mFactor *= 2;
+            }
+        }
+        mImage = LinearImage(width / mFactor, height / mFactor, 3);
+        return true;
     }
 
-    // Images store the actual data
-    std::vector<Image> images;
-
-    // Cubemaps are just views on Images
-    std::vector<Cubemap> levels;
-
-    if (iname.exists()) {
-        if (!g_quiet) {
-            std::cout << "Decoding image..." << std::endl;
-        }
-        std::ifstream input_stream(iname.getPath(), std::ios::binary);
-        LinearImage linputImage = ImageDecoder::decode(input_stream, iname.getPath());
-        if (!linputImage.isValid()) {
-            std::cerr << "Unable to open image: " << iname.getPath() << std::endl;
-            exit(1);
+    bool consume(uint32_t y, uint32_t rowCount, float const* data) override {
+        const uint32_t width = mImage.getWidth() * mFactor;
+        float3 const* src = reinterpret_cast<float3 const*>(data);
+        if (!g_noclamp) {
+            // Clamp before filtering, so that the result doesn't depend on the input size.
+            if (mStrip.getWidth() != width || mStrip.getHeight() != rowCount) {
+                mStrip = Image(width, rowCount);
+            }
+            memcpy(mStrip.getData(), data, rowCount * mStrip.getBytesPerRow());
+            CubemapUtils::clamp(mStrip);
+            src = static_cast<float3 const*>(mStrip.getData());
         }
-        if (linputImage.getChannels() != 3) {
-            std::cerr << "Input image must be RGB (3 channels)! This image has "
-                      << linputImage.getChannels() << " channels." << std::endl;
-            exit(1);
+        const float weight = 1.0f / float(mFactor * mFactor);
+        for (uint32_t row = 0; row < rowCount; row++, src += width) {
+            float3* dst = mImage.get<float3>(0, (y + row) / mFactor);
+            if (mFactor == 1) {
+                std::copy_n(src, width, dst);
+                continue;
+            }
+            for (uint32_t x = 0; x < width; x++) {
+                dst[x / mFactor] += src[x] * weight;
+            }
         }
+        return true;
+    }
 
+private:
+    const size_t mDim;
+    uint32_t mFactor = 1;
+    uint32_t mChannels = 0;
+    LinearImage mImage;
+    Image mStrip;
+};
+
+// Decodes the input environment. This doesn't print progress, and only uses the JobSystem if one
+// is given, so that batch mode can run it on a separate thread. If iname doesn't exist, image is
+// left invalid and prepareEnvironment() generates a test pattern instead.
+static bool decodeEnvironment(const utils::Path& iname, LinearImage& image,
+        utils::JobSystem* js = nullptr) {
+    if (!iname.exists()) {
+        return true;
+    }
+    std::ifstream input_stream(iname.getPath(), std::ios::binary);
+    EnvironmentConsumer consumer(g_output_size ? g_output_size : IBL_DEFAULT_SIZE);
+    const bool success = ImageDecoder::decodeRows(input_stream, iname.getPath(), consumer,
+            ImageDecoder::ColorSpace::SRGB, 64, js);
+    if (consumer.getChannels() && consumer.getChannels() != 3) {
+        std::cerr << "Input image must be RGB (3 channels)! This image has "
+                  << consumer.getChannels() << " channels." << std::endl;
+        return false;
+    }
+    if (!success) {
+        std::cerr << "Unable to open image: " << iname.getPath() << std::endl;
+        return false;
+    }
+    image = consumer.getImage();
+    return true;
+}
+
+// Creates the base cubemap from the decoded input, and all its mipmap levels.
+static bool prepareEnvironment(utils::JobSystem& js, const utils::Path& iname,
+        const LinearImage& linputImage, std::vector<Image>& images, std::vector<Cubemap>& levels) {
+    if (linputImage.isValid()) {
         // Convert from LinearImage to the deprecated Image object which is used throughout cmgen.
         const size_t width = linputImage.getWidth(), height = linputImage.getHeight();
         Image inputImage(width, height);
         memcpy(inputImage.getData(), linputImage.getPixelRef(), height * inputImage.getBytesPerRow());
 
-        if (!g_noclamp) {
-            CubemapUtils::clamp(inputImage);
-        }
-
         if ((isPOT(width) && (width * 3 == height * 4)) ||
             (isPOT(height) && (height * 3 == width * 4))) {
             // This is cross cubemap
@@ -578,7 +658,7 @@ int main(int argc, char* argv[]) {
             std::cerr << "  2:1, lat/long or equirectangular" << std::endl;
             std::cerr << "  3:4, vertical cross (height must be power of two)" << std::endl;
             std::cerr << "  4:3, horizontal cross (width must be power of two)" << std::endl;
-            exit(0);
+            return false;
         }
     } else {
         if (!g_quiet) {
@@ -608,8 +688,6 @@ int main(int argc, char* argv[]) {
         levels.push_back(std::move(cml));
     }
 
-    // we mirror by default -- the mirror option in fact un-mirrors.
-    g_mirror = !g_mirror;
     if (g_mirror) {
         if (!g_quiet) {
             std::cout << "Mirroring..." << std::endl;
@@ -630,7 +708,12 @@ int main(int argc, char* argv[]) {
 
     // Now generate all the mipmap levels
     generateMipmaps(js, levels, images);
+    return true;
+}
 
+// Generates every requested output for a prepared environment.
+static void generateOutputs(utils::JobSystem& js, const utils::Path& iname,
+        const std::vector<Image>& images, const std::vector<Cubemap>& levels) {
     if (g_sh_compute) {
         if (!g_quiet) {
             std::cout << "Spherical harmonics..." << std::endl;
@@ -691,7 +774,195 @@ int main(int argc, char* argv[]) {
             extractCubemapFaces(js, iname, cm, g_extract_dir);
         }
     }
+}
+
+// Output locations set on the command line, which a batch manifest entry can redirect.
+struct OutputDirs {
+    utils::Path deploy;
+    utils::Path prefilter;
+    utils::Path irradiance;
+    utils::Path isMipmap;
+    utils::Path extract;
+    utils::Path shFilename;
+};
+
+static void setOutputDirs(const OutputDirs& dirs, const utils::Path& override) {
+    const bool redirect = !override.isEmpty();
+    g_deploy_dir = redirect ? override : dirs.deploy;
+    g_prefilter_dir = redirect ? override : dirs.prefilter;
+    g_ibl_irradiance_dir = redirect ? override : dirs.irradiance;
+    g_is_mipmap_dir = redirect ? override : dirs.isMipmap;
+    g_extract_dir = redirect ? override : dirs.extract;
+    g_sh_filename = redirect ? override + dirs.shFilename.getName() : dirs.shFilename;
+}
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Processes every environment listed in the manifest. The JobSystem and the DFG LUT are shared
+// by all entries; the next environment is decoded while the current one is filtered, and
+// images are encoded on background threads while filtering continues.
+static int runBatch(utils::JobSystem& js, const utils::Path& manifest) {
+    std::ifstream in(manifest.getPath());
+    if (!in) {
+        std::cerr << "Unable to open manifest: " << manifest.getPath() << std::endl;
+        return 1;
+    }
+
+    struct Entry {
+        utils::Path input;
+        utils::Path outputDir;
+    };
+    std::vector<Entry> entries;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string input, output;
+        if (!(fields >> input) || input[0] == '#') {
+            continue;
+        }
+        fields >> output;
+        entries.push_back({ input, output });
+    }
+
+    struct Decoded {
+        LinearImage image;
+        bool success;
+        double seconds;
+    };
+    auto decode = [](utils::Path input) {
+        const auto start = Clock::now();
+        Decoded decoded;
+        decoded.success = decodeEnvironment(input, decoded.image);
+        decoded.seconds = secondsSince(start);
+        return decoded;
+    };
+
+    const OutputDirs dirs = { g_deploy_dir, g_prefilter_dir, g_ibl_irradiance_dir,
+            g_is_mipmap_dir, g_extract_dir, g_sh_filename };
+
+    g_async_encode = true;
+    const auto batchStart = Clock::now();
+    double decodeTime = 0;
+    double filterTime = 0;
+    g_failed_entries.assign(entries.size(), false);
 
+    std::future<Decoded> next;
+    if (!entries.empty()) {
+        next = std::async(std::launch::async, decode, entries[0].input);
+    }
+    for (size_t i = 0; i < entries.size(); i++) {
+        const Entry& entry = entries[i];
+        Decoded decoded = next.get();
+        if (i + 1 < entries.size()) {
+            next = std::async(std::launch::async, decode, entries[i + 1].input);
+        }
+        decodeTime += decoded.seconds;
+
+        if (!g_quiet) {
+            std::cout << "[" << (i + 1) << "/" << entries.size() << "] "
+                      << entry.input << std::endl;
+        }
+
+        const auto filterStart = Clock::now();
+        g_encode_entry = i;
+        setOutputDirs(dirs, entry.outputDir);
+        if (g_deploy) {
+            configureDeploy(entry.input);
+        }
+        std::vector<Image> images;
+        std::vector<Cubemap> levels;
+        bool success = decoded.success &&
+                prepareEnvironment(js, entry.input, decoded.image, images, levels);
+        if (success) {
+            generateOutputs(js, entry.input, images, levels);
+        }
+        const double seconds = secondsSince(filterStart);
+        filterTime += seconds;
+
+        if (!success) {
+            std::cerr << "Skipping " << entry.input << std::endl;
+            g_failed_entries[i] = true;
+            continue;
+        }
+
+        if (!g_quiet) {
+            std::cout << std::fixed << std::setprecision(3)
+                      << "  decode: " << decoded.seconds << "s, filter: " << seconds << "s"
+                      << std::defaultfloat << std::endl;
+        }
+    }
+
+    waitForEncodes(0);
+    g_async_encode = false;
+    const size_t failures = std::count(g_failed_entries.begin(), g_failed_entries.end(), true);
+
+    if (!g_quiet) {
+        std::cout << std::fixed << std::setprecision(3)
+                  << "Processed " << (entries.size() - failures) << " of " << entries.size()
+                  << " environments in " << secondsSince(batchStart) << "s" << std::endl
+                  << "  decode: " << decodeTime << "s"
+                  << ", filter: " << filterTime << "s"
+                  << ", encode: " << g_encode_time.load() << "s" << std::endl
+                  << std::defaultfloat;
+    }
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char* argv[]) {
+    utils::JobSystem js;
+    js.adopt();
+
+    int option_index = handleCommandLineArgments(argc, argv);
+    int num_args = argc - option_index;
+    if (!g_dfg && !g_batch && num_args < 1) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // we mirror by default -- the mirror option in fact un-mirrors.
+    g_mirror = !g_mirror;
+
+    if (g_dfg) {
+        if (!g_quiet) {
+            std::cout << "Generating IBL DFG LUT..." << std::endl;
+        }
+        size_t size = g_output_size ? g_output_size : DFG_LUT_DEFAULT_SIZE;
+        iblLutDfg(js, g_dfg_filename, size, g_dfg_multiscatter, g_dfg_cloth);
+        if (!g_batch && num_args < 1) return 0;
+    }
+
+    if (g_batch) {
+        return runBatch(js, g_batch_manifest);
+    }
+
+    std::string command(argv[option_index]);
+    utils::Path iname(command);
+
+    if (g_deploy) {
+        configureDeploy(iname);
+    }
+
+    if (!g_quiet && iname.exists()) {
+        std::cout << "Decoding image..." << std::endl;
+    }
+    LinearImage linputImage;
+    if (!decodeEnvironment(iname, linputImage, &js)) {
+        exit(1);
+    }
+
+    // Images store the actual data
+    std::vector<Image> images;
+
+    // Cubemaps are just views on Images
+    std::vector<Cubemap> levels;
+
+    if (!prepareEnvironment(js, iname, linputImage, images, levels)) {
+        exit(0);
+    }
+
+    generateOutputs(js, iname, images, levels);
     return 0;
 }
 
@@ -1249,12 +1520,46 @@ static LinearImage toLinearImage(const Image& image) {
     return linearImage;
 }
 
+static bool encodeImage(const std::string& path, ImageEncoder::Format format,
+        const LinearImage& image, const std::string& compression) {
+    const auto start = Clock::now();
+    std::ofstream outputStream(path, std::ios::binary | std::ios::trunc);
+    const bool success = ImageEncoder::encode(outputStream, format, image, compression, path);
+    const double seconds = secondsSince(start);
+    double total = g_encode_time.load(std::memory_order_relaxed);
+    while (!g_encode_time.compare_exchange_weak(total, total + seconds,
+            std::memory_order_relaxed)) {
+    }
+    if (!success) {
+        std::cerr << "Unable to write image: " << path << std::endl;
+    }
+    return success;
+}
+
+static void waitForEncodes(size_t maxPending) {
+    while (g_pending_encodes.size() > maxPending) {
+        PendingEncode& encode = g_pending_encodes.front();
+        if (!encode.success.get()) {
+            g_failed_entries[encode.entry] = true;
+        }
+        g_pending_encodes.pop_front();
+    }
+}
+
 static void saveImage(const std::string& path, ImageEncoder::Format format, const Image& image,
         const std::string& compression) {
-    std::ofstream outputStream(path, std::ios::binary | std::ios::trunc);
-    if (!ImageEncoder::encode(outputStream, format, toLinearImage(image), compression, path)) {
-        exit(1);
+    if (!g_async_encode) {
+        if (!encodeImage(path, format, toLinearImage(image), compression)) {
+            exit(1);
+        }
+        return;
     }
+    // the image is copied, so the caller is free to reuse it as soon as we return
+    waitForEncodes(MAX_PENDING_ENCODES - 1);
+    g_pending_encodes.push_back({ g_encode_entry, std::async(std::launch::async,
+            [path, format, linear = toLinearImage(image), compression]() {
+                return encodeImage(path, format, linear, compression);
+            }) });
 }
 
 static void exportKtxFaces(Ktx1Bundle& container, uint32_t miplevel, const Cubemap& cm) {
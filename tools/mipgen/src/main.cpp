@@ -24,13 +24,17 @@
 #include <imageio/ImageDecoder.h>
 #include <imageio/ImageEncoder.h>
 
+#include <utils/JobSystem.h>
 #include <utils/Path.h>
 
 #include <getopt/getopt.h>
 
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <thread>
+#include <vector>
 
 using namespace image;
 using namespace std;
@@ -58,6 +62,9 @@ static bool g_ktx2Container = false;
 static bool g_sourceIsLinear = false;
 static bool g_quietMode = false;
 static uint32_t g_mipLevelCount = 0;
+static uint32_t g_cascadeDistance = 0;
+static bool g_directory = false;
+static BasisEncoder::Effort g_effort = BasisEncoder::Effort::DEFAULT;
 
 static const char* USAGE = R"TXT(
 MIPGEN generates mipmaps for an image down to the 1x1 level.
@@ -71,6 +78,7 @@ If the output format is a container format like KTX, then
 
 Usage:
     MIPGEN [options] <input_file> <output_pattern>
+    MIPGEN [options] --directory <input_dir> <output_pattern>
 
 Options:
    --help, -h
@@ -96,6 +104,12 @@ Options:
    --mip-levels=N, -m N
        specifies the number of mip levels to generate
        if 0 (default), all levels are generated
+   --cascade=N, -C N
+       generates each mip level from the level that is N levels larger, which is faster
+       if 0 (default), all levels are generated from the original image
+   --directory, -D
+       processes all the images in <input_dir>, several at a time, and prints the time spent
+       on each; {name} in <output_pattern> is replaced by the name of each image
    --compression=COMPRESSION, -c COMPRESSION
        format specific compression:
            KTX, PNG, Radiance: Ignored
@@ -103,11 +117,14 @@ Options:
            Photoshop: 16 (default), 32
            OpenEXR: RAW, RLE, ZIPS, ZIP, PIZ (default)
            DDS: 8, 16 (default), 32
+   --effort=[fastest|faster|default|slower|slowest], -e [effort]
+       KTX2 only: trades compression quality for encoding speed (defaults to default)
 
 Examples:
     MIPGEN -g --kernel=hermite grassland.png mip_%03d.png
     MIPGEN -f ktx2 --compression=uastc grassland.png mips.ktx
     MIPGEN -f ktx grassland.png mips.ktx
+    MIPGEN -D --compression=uastc textures out/{name}.ktx2
 )TXT";
 
 static const char* HTML_PREFIX = R"HTML(<!DOCTYPE html>
@@ -151,7 +168,7 @@ static void license() {
 }
 
 static int handleArguments(int argc, char* argv[]) {
-    static constexpr const char* OPTSTR = "hLlgpf:c:k:saqm:";
+    static constexpr const char* OPTSTR = "hLlgpf:c:k:saqm:C:De:";
     static const struct option OPTIONS[] = {
             { "help",                 no_argument, 0, 'h' },
             { "license",              no_argument, 0, 'L' },
@@ -165,6 +182,9 @@ static int handleArguments(int argc, char* argv[]) {
             { "add-alpha",            no_argument, 0, 'a' },
             { "quiet",                no_argument, 0, 'q' },
             { "mip-levels",     required_argument, 0, 'm' },
+            { "cascade",        required_argument, 0, 'C' },
+            { "directory",            no_argument, 0, 'D' },
+            { "effort",         required_argument, 0, 'e' },
             { 0, 0, 0, 0 }  // termination of the option list
     };
 
@@ -259,31 +279,58 @@ static int handleArguments(int argc, char* argv[]) {
                     // keep default value
                 }
                 break;
+            case 'C':
+                try {
+                    g_cascadeDistance = std::stoi(arg);
+                } catch (std::invalid_argument &e) {
+                    // keep default value
+                }
+                break;
+            case 'D':
+                g_directory = true;
+                break;
+            case 'e':
+                if (arg == "fastest") {
+                    g_effort = BasisEncoder::Effort::FASTEST;
+                } else if (arg == "faster") {
+                    g_effort = BasisEncoder::Effort::FASTER;
+                } else if (arg == "default") {
+                    g_effort = BasisEncoder::Effort::DEFAULT;
+                } else if (arg == "slower") {
+                    g_effort = BasisEncoder::Effort::SLOWER;
+                } else if (arg == "slowest") {
+                    g_effort = BasisEncoder::Effort::SLOWEST;
+                } else {
+                    cerr << "Warning: unrecognized effort, falling back to default." << endl;
+                }
+                break;
         }
     }
 
     return optind;
 }
 
-int main(int argc, char* argv[]) {
-    int optionIndex = handleArguments(argc, argv);
-    int numArgs = argc - optionIndex;
-    if (numArgs < 2) {
-        printUsage(argv[0]);
-        return 1;
+// Generates and writes the miplevels of one image. The calling thread must be adopted by js.
+static bool writeKtx2(BasisEncoder const* encoder, const std::string& outputPath) {
+    Path(outputPath).getParent().mkdirRecursive();
+    ofstream outputStream(outputPath, ios::out | ios::binary);
+    outputStream.write((const char*) encoder->getKtx2Data(), encoder->getKtx2ByteCount());
+    outputStream.close();
+    if (!outputStream) {
+        cerr << "An error occurred while writing the output file: " << outputPath << endl;
+        return false;
     }
-    Path inputPath(argv[optionIndex++]);
-    std::string outputPattern(argv[optionIndex]);
-    if (Path(outputPattern).getExtension() == "ktx") {
-        g_ktx1Container = true;
-        g_formatSpecified = true;
-    } else if (Path(outputPattern).getExtension() == "ktx2") {
-        g_ktx2Container = true;
-        g_formatSpecified = true;
-    } else if (!g_formatSpecified) {
-        g_format = ImageEncoder::chooseFormat(outputPattern, g_sourceIsLinear);
+    if (!g_quietMode) {
+        printf("Wrote %zu bytes to %s.\n", encoder->getKtx2ByteCount(), outputPath.c_str());
     }
+    return true;
+}
 
+// Decodes an image, generates its miplevels and writes them. When deferredEncoder is provided,
+// a KTX2 output isn't encoded: the encoder, which holds the whole mip chain, is returned instead
+// so that the caller can encode it along with other images.
+static bool processImage(const Path& inputPath, const std::string& outputPattern, JobSystem& js,
+        BasisEncoder::JobPool* jobPool, BasisEncoder** deferredEncoder = nullptr) {
     if (!g_quietMode) {
         puts("Reading image...");
     }
@@ -293,7 +340,7 @@ int main(int argc, char* argv[]) {
             g_sourceIsLinear ? ImageDecoder::ColorSpace::LINEAR : ImageDecoder::ColorSpace::SRGB);
     if (!sourceImage.isValid()) {
         cerr << "Unable to open image: " << inputPath.getPath() << endl;
-        return 1;
+        return false;
     }
     if (g_stripAlpha && sourceImage.getChannels() == 4) {
         auto r = extractChannel(sourceImage, 0);
@@ -324,7 +371,11 @@ int main(int argc, char* argv[]) {
     uint32_t count = getMipmapCount(sourceImage);
     count = g_mipLevelCount == 0 ? count : min(g_mipLevelCount - 1, count);
     vector<LinearImage> miplevels(count);
-    generateMipmaps(sourceImage, g_filter, miplevels.data(), count);
+    generateMipmaps(sourceImage, MipmapSampler {
+        .filter = g_filter,
+        .cascadeDistance = g_cascadeDistance,
+        .jobSystem = &js
+    }, miplevels.data(), count);
 
     if (g_ktx1Container) {
         if (!g_quietMode) {
@@ -363,11 +414,11 @@ int main(int argc, char* argv[]) {
             info.glInternalFormat = destIsLinear ? Ktx1Bundle::RGBA8 : Ktx1Bundle::SRGB8_ALPHA8;
         } else {
             cerr << "Bad component count." << endl;
-            return 1;
+            return false;
         }
         if (g_ktxCompression != NONE) {
             cerr << "Compression not supported with KTX1." << endl;
-            return 1;
+            return false;
         }
         uint32_t mip = 0;
         auto addLevel = [&](LinearImage image) {
@@ -408,7 +459,7 @@ int main(int argc, char* argv[]) {
         if (!g_quietMode) {
             puts("Done.");
         }
-        return 0;
+        return true;
     }
 
     if (g_ktx2Container) {
@@ -426,6 +477,8 @@ int main(int argc, char* argv[]) {
             .grayscale(g_grayscale)
             .linear(g_sourceIsLinear)
             .quiet(g_quietMode)
+            .jobPool(jobPool)
+            .effort(g_effort)
             .normals(g_ktxCompression == ETC1S_NORMALS || g_ktxCompression == UASTC_NORMALS)
             .miplevel(mipIndex++, 0, sourceImage);
 
@@ -436,24 +489,18 @@ int main(int argc, char* argv[]) {
         BasisEncoder* encoder = builder.build();
         if (!encoder) {
             puts("Error while creating BasisU encoder.");
-            return 1;
+            return false;
         }
 
-        bool success = encoder->encode();
-        if (!success) {
-            // Error message has already been printed.
-            return 1;
+        if (deferredEncoder) {
+            *deferredEncoder = encoder;
+            return true;
         }
 
-        Path(outputPattern).getParent().mkdirRecursive();
-        ofstream outputStream(outputPattern, ios::out | ios::binary);
-        outputStream.write((const char*) encoder->getKtx2Data(), encoder->getKtx2ByteCount());
-        outputStream.close();
-        if (!g_quietMode) {
-            printf("Wrote %zu bytes to %s.\n", encoder->getKtx2ByteCount(), outputPattern.c_str());
-        }
+        // Error messages have already been printed by the encoder.
+        const bool success = encoder->encode() && writeKtx2(encoder, outputPattern);
         delete encoder;
-        return 0;
+        return success;
     }
 
     if (!g_quietMode) {
@@ -466,7 +513,7 @@ int main(int argc, char* argv[]) {
         int result = snprintf(path, sizeof(path), outputPattern.c_str(), mip++);
         if (result < 0 || result >= sizeof(path)) {
             cerr << "Output pattern is too long." << endl;
-            return 1;
+            return false;
         }
         Path(path).getParent().mkdirRecursive();
         ofstream outputStream(path, ios::binary | ios::trunc);
@@ -478,12 +525,12 @@ int main(int argc, char* argv[]) {
             }
             if (!ImageEncoder::encode(outputStream, g_format, image, g_compressionString, path)) {
                 cerr << "An error occurred while encoding the image." << endl;
-                return 1;
+                return false;
             }
             outputStream.close();
             if (!outputStream) {
                 cerr << "An error occurred while writing the output file: " << path << endl;
-                return 1;
+                return false;
             }
         }
     }
@@ -503,7 +550,7 @@ int main(int argc, char* argv[]) {
         int result = snprintf(tag, sizeof(tag), pattern, inputPath.c_str(), width, height);
         if (result < 0 || result >= sizeof(tag)) {
             cerr << "Output pattern is too long." << endl;
-            return 1;
+            return false;
         }
         html << tag << std::endl;
         for (auto image: miplevels) {
@@ -511,7 +558,7 @@ int main(int argc, char* argv[]) {
             result = snprintf(tag, sizeof(tag), pattern, path, width, height);
             if (result < 0 || result >= sizeof(tag)) {
                 cerr << "Output pattern is too long." << endl;
-                return 1;
+                return false;
             }
             html << tag << std::endl;
         }
@@ -521,4 +568,138 @@ int main(int argc, char* argv[]) {
     if (!g_quietMode) {
         puts("Done.");
     }
+    return true;
+}
+
+static void resolveOutputFormat(const std::string& outputPattern) {
+    if (Path(outputPattern).getExtension() == "ktx") {
+        g_ktx1Container = true;
+        g_formatSpecified = true;
+    } else if (Path(outputPattern).getExtension() == "ktx2") {
+        g_ktx2Container = true;
+        g_formatSpecified = true;
+    } else if (!g_formatSpecified) {
+        g_format = ImageEncoder::chooseFormat(outputPattern, g_sourceIsLinear);
+    }
+}
+
+// Processes all the images of a directory, in batches. The images of a batch are decoded and
+// mipmapped by parallel jobs. Then their KTX2 encoders, each holding the mip chain of one image,
+// are compressed together by BasisEncoder::encodeBatch() on a shared pool of BasisU threads.
+static int processDirectory(const Path& inputDir, const std::string& outputPattern) {
+    const std::string token("{name}");
+    if (outputPattern.find(token) == std::string::npos) {
+        cerr << "The output pattern must contain " << token << " with --directory." << endl;
+        return 1;
+    }
+
+    vector<Path> inputs;
+    for (const Path& path : inputDir.listContents()) {
+        const std::string ext = path.getExtension();
+        if (!path.isDirectory() && (ext == "png" || ext == "hdr" || ext == "psd" || ext == "exr")) {
+            inputs.push_back(path);
+        }
+    }
+    if (inputs.empty()) {
+        cerr << "No images found in " << inputDir.getPath() << endl;
+        return 1;
+    }
+
+    // Progress messages of concurrent images would interleave, report one line per image instead.
+    const bool reportTiming = !g_quietMode;
+    g_quietMode = true;
+    if (g_createGallery) {
+        cerr << "Warning: --page is ignored with --directory." << endl;
+        g_createGallery = false;
+    }
+
+    struct Item {
+        Path inputPath;
+        std::string outputPath;
+        BasisEncoder* encoder = nullptr;    // only for KTX2 outputs
+        bool success = false;
+        chrono::duration<double> seconds{};
+    };
+
+    JobSystem js;
+    js.adopt();
+    BasisEncoder::JobPool jobPool(thread::hardware_concurrency());
+
+    // the batch size bounds the number of mip chains held in memory
+    const size_t batchSize = max(1u, thread::hardware_concurrency() / 2);
+    size_t failures = 0;
+    const auto start = chrono::steady_clock::now();
+    for (size_t first = 0; first < inputs.size(); first += batchSize) {
+        vector<Item> items(min(batchSize, inputs.size() - first));
+        JobSystem::Job* parent = js.createJob();
+        for (size_t i = 0; i < items.size(); i++) {
+            Item& item = items[i];
+            item.inputPath = inputs[first + i];
+            item.outputPath = outputPattern;
+            item.outputPath.replace(item.outputPath.find(token), token.size(),
+                    item.inputPath.getNameWithoutExtension());
+            js.run(jobs::createJob(js, parent, [&item, &js, &jobPool]() {
+                const auto itemStart = chrono::steady_clock::now();
+                item.success = processImage(item.inputPath, item.outputPath, js, &jobPool,
+                        &item.encoder);
+                item.seconds = chrono::steady_clock::now() - itemStart;
+            }));
+        }
+        js.runAndWait(parent);
+
+        vector<BasisEncoder*> encoders;
+        for (Item const& item : items) {
+            if (item.encoder) {
+                encoders.push_back(item.encoder);
+            }
+        }
+        const auto encodeStart = chrono::steady_clock::now();
+        BasisEncoder::encodeBatch(encoders.data(), encoders.size(), encoders.size());
+        const chrono::duration<double> encodeSeconds = chrono::steady_clock::now() - encodeStart;
+
+        for (Item& item : items) {
+            if (item.encoder) {
+                // an encoder that failed has no output
+                item.success = item.encoder->getKtx2ByteCount() > 0 &&
+                        writeKtx2(item.encoder, item.outputPath);
+                item.seconds += encodeSeconds;
+                delete item.encoder;
+            }
+            if (!item.success) {
+                failures++;
+                cerr << "Failed: " << item.inputPath.getPath() << endl;
+            } else if (reportTiming) {
+                printf("%s: %.3fs\n", item.inputPath.getName().c_str(), item.seconds.count());
+            }
+        }
+    }
+    js.emancipate();
+
+    if (reportTiming) {
+        const chrono::duration<double> seconds = chrono::steady_clock::now() - start;
+        printf("Processed %zu images in %.3fs.\n", inputs.size() - failures, seconds.count());
+    }
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char* argv[]) {
+    int optionIndex = handleArguments(argc, argv);
+    int numArgs = argc - optionIndex;
+    if (numArgs < 2) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    Path inputPath(argv[optionIndex++]);
+    std::string outputPattern(argv[optionIndex]);
+    resolveOutputFormat(outputPattern);
+
+    if (g_directory) {
+        return processDirectory(inputPath, outputPattern);
+    }
+
+    JobSystem js;
+    js.adopt();
+    const bool success = processImage(inputPath, outputPattern, js, nullptr);
+    js.emancipate();
+    return success ? 0 : 1;
 }